@@ -63,6 +63,7 @@ private:
     struct CtEmbFileOpened {
         fs::path tmp_filepath;
         time_t mod_time;
+        gint64 node_id;
     };
     std::unordered_map<size_t, CtEmbFileOpened> _embfiles_opened;
     sigc::connection _embfiles_timeout_connection;
@@ -82,6 +83,8 @@ private:
 public:
     CtMainWin*   getCtMainWin() { return _pCtMainWin; }
     bool         get_were_embfiles_opened() { return _embfiles_opened.size(); }
+    // the embedded files opened are matched with the widgets of the loaded text buffer of the node
+    bool         get_were_embfiles_opened_in_node(const gint64 node_id_data_holder) const;
 
 private:
     Glib::RefPtr<Gtk::TextBuffer> _curr_buffer() { return _pCtMainWin->get_text_view().get_buffer(); }
@@ -138,11 +141,9 @@ public:
                          bool set_first = false);
 
 private:
-    bool _need_node_swap(Gtk::TreeIter& leftIter,
-                         Gtk::TreeIter& rightIter,
-                         bool ascendings);
-    bool _tree_sort_level_and_sublevels(const Gtk::TreeNodeChildren& children,
-                                        bool ascending);
+    bool _tree_levels_sort(const std::vector<Gtk::TreeIter>& levelsParents,
+                           const bool ascending);
+    bool _tree_sort_level_and_sublevels(const bool ascending);
     void _node_date(const bool from_sel_not_root);
 
 public:
@@ -268,6 +269,7 @@ public:
     void find_back_iter(const bool fromIterativeDialog);
     void find_in_selected_node_ok_clicked();
     void find_in_multiple_nodes_ok_clicked();
+    int  find_in_all_nodes_auto(const std::string& str_find);
     void find_replace_in_selected_node();
     void find_replace_in_multiple_nodes();
 
@@ -536,7 +538,8 @@ public:
 
     void export_to_pdf_auto(const std::string& dir, bool overwrite);
     void export_to_html_auto(const std::string& dir, bool overwrite, bool single_file);
-    void export_to_txt_auto(const std::string& dir, bool overwrite, bool single_file);
+    void export_to_txt_auto(const std::string& dir, bool overwrite, bool single_file, int jobs = 0);
+    bool export_to_ct_auto(const std::string& filepath, bool overwrite, const Glib::ustring& password);
 
 private:
     // helpers for help actions
@@ -551,6 +554,7 @@ public:
     void online_issues();
     void folder_cfg_open();
     void dialog_about();
+    void trace_dialog();
 
 public:
     void terminal_copy();
@@ -219,11 +219,12 @@ void CtActions::embfile_insert_path(const std::string& filepath)
         }
     }
 
-    std::string blob = Glib::file_get_contents(filepath);
+    std::shared_ptr<const CtEmbFileBlob> pBlob = CtEmbFileBlob::create_from_file(filepath);
+    if (not pBlob) return;
     std::string name = Glib::path_get_basename(filepath);
     CtAnchoredWidget* pAnchoredWidget = new CtImageEmbFile{_pCtMainWin,
                                                            name,
-                                                           blob,
+                                                           pBlob,
                                                            std::time(nullptr),
                                                            _curr_buffer()->get_insert()->get_iter().get_offset(),
                                                            "",
@@ -172,14 +172,51 @@ void CtActions::export_to_html_auto(const std::string& dir, bool overwrite, bool
     _export_to_html(dir, overwrite);
 }
 
-void CtActions::export_to_txt_auto(const std::string& dir, bool overwrite, bool single_file)
+void CtActions::export_to_txt_auto(const std::string& dir, bool overwrite, bool single_file, int jobs)
 {
     spdlog::debug("txt export to: {}", dir);
-    spdlog::debug("overwrite: {} single_file: {}", overwrite, single_file);
+    spdlog::debug("overwrite: {} single_file: {} jobs: {}", overwrite, single_file, jobs);
     _export_options.single_file = single_file;
+    _export_options.jobs = jobs;
     _export_to_txt(dir, overwrite);
 }
 
+bool CtActions::export_to_ct_auto(const std::string& filepath, bool overwrite, const Glib::ustring& password)
+{
+    spdlog::debug("ct convert to: {}", filepath);
+    spdlog::debug("overwrite: {}", overwrite);
+    // the document type is taken from the extension, a path without a known one is a multifile directory
+    CtDocType docType = fs::get_doc_type_from_file_ext(filepath);
+    if (CtDocType::None == docType) {
+        docType = CtDocType::MultiFile;
+    }
+    const bool needEncrypt = CtDocEncrypt::True == fs::get_doc_encrypt_from_file_ext(filepath);
+    if (needEncrypt and password.empty()) {
+        spdlog::error("!! missing password to convert to {}", filepath);
+        return false;
+    }
+    if (Glib::file_test(filepath, Glib::FILE_TEST_EXISTS)) {
+        if (not overwrite) {
+            spdlog::info("{} exists, skipped (use --export_overwrite)", filepath);
+            return false;
+        }
+        (void)fs::remove_all(filepath);
+    }
+    Glib::ustring error;
+    std::unique_ptr<CtStorageControl> new_storage{
+        CtStorageControl::save_as(_pCtMainWin,
+                                  filepath,
+                                  docType,
+                                  needEncrypt ? password : Glib::ustring{},
+                                  error,
+                                  CtExporting::ALL_TREE)};
+    if (not new_storage) {
+        spdlog::error("!! convert to {}: {}", filepath, error.raw());
+        return false;
+    }
+    return true;
+}
+
 void CtActions::_export_print(bool save_to_pdf, const fs::path& auto_path, bool auto_overwrite)
 {
     CtExporting export_type;
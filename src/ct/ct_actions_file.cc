@@ -240,6 +240,8 @@ void CtActions::preferences_import()
     _pCtConfig->ptHighlCurrLine = ctConfigImported.ptHighlCurrLine;
     _pCtConfig->rtHighlMatchBra = ctConfigImported.rtHighlMatchBra;
     _pCtConfig->ptHighlMatchBra = ctConfigImported.ptHighlMatchBra;
+    _pCtConfig->ptLargeDocThreshold = ctConfigImported.ptLargeDocThreshold;
+    _pCtConfig->ptLargeDocNoHighlThreshold = ctConfigImported.ptLargeDocNoHighlThreshold;
     _pCtConfig->spaceAroundLines = ctConfigImported.spaceAroundLines;
     _pCtConfig->relativeWrappedSpace = ctConfigImported.relativeWrappedSpace;
     _pCtConfig->hRule = ctConfigImported.hRule;
@@ -351,6 +353,7 @@ void CtActions::preferences_import()
     _pCtConfig->autosaveOnQuit = ctConfigImported.autosaveOnQuit;
     _pCtConfig->customBackupDirOn = ctConfigImported.customBackupDirOn;
     _pCtConfig->customBackupDir = ctConfigImported.customBackupDir;
+    _pCtConfig->saveVerify = ctConfigImported.saveVerify;
     _pCtConfig->limitUndoableSteps = ctConfigImported.limitUndoableSteps;
     for (const auto& currPair : ctConfigImported.customKbShortcuts) {
         _pCtConfig->customKbShortcuts[currPair.first] = currPair.second;
@@ -29,6 +29,7 @@
 #include "ct_image.h"
 #include "ct_dialogs.h"
 #include "ct_logging.h"
+#include "ct_trace.h"
 
 void CtActions::find_matches_store_reset()
 {
@@ -170,6 +171,7 @@ void CtActions::find_replace_in_multiple_nodes()
 
 void CtActions::find_in_multiple_nodes_ok_clicked()
 {
+    CtTraceOperation traceOperation{"search"};
     Glib::RefPtr<Glib::Regex> re_pattern = _create_re_pattern(_s_state.curr_find_pattern);
     if (not re_pattern) return;
 
@@ -233,6 +235,8 @@ void CtActions::find_in_multiple_nodes_ok_clicked()
         }
         ++_s_state.processed_nodes;
         if (_s_state.matches_num > 0 and not all_matches) break;
+        // the buffers of the subtree just searched may be unloaded
+        (void)_pCtMainWin->get_nodes_buffers_lru().evict_over_budget();
         if (_s_options.only_sel_n_subnodes and not _s_state.from_find_iterated) break;
         Gtk::TreeIter last_top_node_iter = node_iter; // we need this if we start from a node that is not in top level
         if (forward) { ++node_iter; }
@@ -280,6 +284,22 @@ void CtActions::find_in_multiple_nodes_ok_clicked()
     }
 }
 
+// Search all the matches in all nodes with no dialog for the options, returns the number of matches
+int CtActions::find_in_all_nodes_auto(const std::string& str_find)
+{
+    _s_state.replace_active = false;
+    _s_state.from_find_iterated = false;
+    _s_state.from_find_back = false;
+    _s_options.str_find = str_find;
+    _s_options.all_firstsel_firstall = 0;
+    _s_options.only_sel_n_subnodes = false;
+    _s_options.node_content = true;
+    _s_state.curr_find_pattern = _s_options.str_find;
+    _s_state.curr_find_type = CtCurrFindType::MultipleNodes;
+    find_in_multiple_nodes_ok_clicked();
+    return _s_state.matches_num;
+}
+
 // Continue the previous search (a_node/in_selected_node/in_all_nodes)
 void CtActions::find_again_iter(const bool fromIterativeDialog)
 {
@@ -454,6 +474,7 @@ CtMatchType CtActions::_parse_given_node_content(CtTreeIter node_iter,
                     if (not all_matches or _pCtMainWin->get_status_bar().is_progress_stop()) break;
                 }
                 if (_s_state.matches_num > 0 and not all_matches) break;
+                (void)_pCtMainWin->get_nodes_buffers_lru().evict_over_budget();
                 if (forward) child_iter = ++child_iter;
                 else         child_iter = --child_iter;
                 _s_state.processed_nodes += 1;
@@ -626,14 +647,20 @@ bool CtActions::_find_pattern(CtTreeIter tree_iter,
     // Gtk::TextBuffer uses symbols positions
     // Glib::Regex uses byte positions
     Glib::ustring text = text_buffer->get_text();
+    // the folded text can be shorter than the original if it had combining marks
+    std::vector<int> origOffsets;
     if (_s_options.accent_insensitive) {
-        text = str::diacritical_to_ascii(text);
+        text = str::diacritical_to_ascii(text, &origOffsets);
     }
 
     const gint64 node_id = tree_iter.get_node_id();
     const int start_offset = start_iter.get_offset();
     const int num_objs_before_start = _get_num_objs_before_offset(text_buffer, start_offset);
-    const int position_fw_start_or_bw_end = str::symb_pos_to_byte_pos(text, std::max(0, start_offset - num_objs_before_start));
+    int text_start_offset = std::max(0, start_offset - num_objs_before_start);
+    if (not origOffsets.empty()) {
+        text_start_offset = str::diacritical_folded_offset(origOffsets, text_start_offset);
+    }
+    const int position_fw_start_or_bw_end = str::symb_pos_to_byte_pos(text, text_start_offset);
     std::pair<int, int> match_offsets{-1, -1};
     if (forward) {
         Glib::MatchInfo match_info;
@@ -676,8 +703,13 @@ bool CtActions::_find_pattern(CtTreeIter tree_iter,
     }
     _s_state.latest_node_offset_node_id = node_id;
     if (match_offsets.first != -1) {
+        CtTrace::counter_add(CtTraceCounter::RegexMatches, 1);
         match_offsets.first = str::byte_pos_to_symb_pos(text, match_offsets.first);
         match_offsets.second = str::byte_pos_to_symb_pos(text, match_offsets.second);
+        if (not origOffsets.empty()) {
+            match_offsets.first = origOffsets.at(match_offsets.first);
+            match_offsets.second = origOffsets.at(match_offsets.second);
+        }
     }
 
     CtAnchMatchList anchMatchList;
@@ -1076,8 +1108,9 @@ bool CtActions::_check_pattern_in_object(Glib::RefPtr<Glib::Regex> re_pattern,
         case CtAnchWidgType::CodeBox: {
             if (CtCodebox* pCodebox = dynamic_cast<CtCodebox*>(pAnchWidg)) {
                 Glib::ustring text = pCodebox->get_text_content();
+                std::vector<int> origOffsets;
                 if (_s_options.accent_insensitive) {
-                    text = str::diacritical_to_ascii(text);
+                    text = str::diacritical_to_ascii(text, &origOffsets);
                 }
                 Glib::MatchInfo match_info;
                 if (re_pattern->match(text, match_info)) {
@@ -1087,6 +1120,10 @@ bool CtActions::_check_pattern_in_object(Glib::RefPtr<Glib::Regex> re_pattern,
                         match_info.fetch_pos(0, match_start_offset, match_end_offset);
                         match_start_offset = str::byte_pos_to_symb_pos(text, match_start_offset);
                         match_end_offset = str::byte_pos_to_symb_pos(text, match_end_offset);
+                        if (not origOffsets.empty()) {
+                            match_start_offset = origOffsets.at(match_start_offset);
+                            match_end_offset = origOffsets.at(match_end_offset);
+                        }
                         auto pAnchMatch = std::make_shared<CtAnchMatch>();
                         pAnchMatch->start_offset = pAnchWidg->getOffset();
                         pAnchMatch->line_content = CtTextIterUtil::get_line_content(pCodebox->get_buffer(), match_end_offset);
@@ -1117,8 +1154,9 @@ bool CtActions::_check_pattern_in_object(Glib::RefPtr<Glib::Regex> re_pattern,
                 for (auto& row : rows) {
                     size_t colIdx{0u};
                     for (Glib::ustring& text : row) {
+                        std::vector<int> origOffsets;
                         if (_s_options.accent_insensitive) {
-                            text = str::diacritical_to_ascii(text);
+                            text = str::diacritical_to_ascii(text, &origOffsets);
                         }
                         Glib::MatchInfo match_info;
                         if (re_pattern->match(text, match_info)) {
@@ -1127,6 +1165,10 @@ bool CtActions::_check_pattern_in_object(Glib::RefPtr<Glib::Regex> re_pattern,
                                 match_info.fetch_pos(0, match_start_offset, match_end_offset);
                                 match_start_offset = str::byte_pos_to_symb_pos(text, match_start_offset);
                                 match_end_offset = str::byte_pos_to_symb_pos(text, match_end_offset);
+                                if (not origOffsets.empty()) {
+                                    match_start_offset = origOffsets.at(match_start_offset);
+                                    match_end_offset = origOffsets.at(match_end_offset);
+                                }
                                 auto pAnchMatch = std::make_shared<CtAnchMatch>();
                                 pAnchMatch->start_offset = pAnchWidg->getOffset();
                                 pAnchMatch->line_content = pTable->get_line_content(rowIdx, colIdx, match_end_offset);
@@ -22,6 +22,7 @@
  */
 
 #include "ct_actions.h"
+#include "ct_trace.h"
 #include <glib/gstdio.h>
 
 void CtActions::online_help()
@@ -54,6 +55,25 @@ void CtActions::folder_cfg_open()
     fs::open_folderpath(fs::get_cherrytree_configdir(), _pCtConfig);
 }
 
+void CtActions::trace_dialog()
+{
+    if (not CtDialogs::trace_dialog(_pCtMainWin)) {
+        return;
+    }
+    CtDialogs::CtFileSelectArgs args{};
+    args.curr_folder = _pCtConfig->pickDirExport;
+    args.curr_file_name = std::string{"cherrytree_trace_"} + str::time_format("%Y.%m.%d_%H.%M.%S", std::time(nullptr)) + ".json";
+    args.filter_name = _("Chrome Trace File");
+    args.filter_pattern.push_back("*.json");
+    const std::string filepath = CtDialogs::file_save_as_dialog(_pCtMainWin, args);
+    if (filepath.empty()) {
+        return;
+    }
+    if (not CtTrace::write_chrome_json(filepath)) {
+        CtDialogs::error_dialog(str::format(_("Failed to Write %s"), str::xml_escape(filepath)), *_pCtMainWin);
+    }
+}
+
 void CtActions::check_for_newer_version()
 {
     auto& statusbar = _pCtMainWin->get_status_bar();
@@ -280,7 +280,7 @@ void CtActions::_import_from_dir(CtImporterInterface* importer, const std::strin
         _pCtConfig->pickDirImport = import_dir;
     }
     try {
-        auto dir_node = CtImports::traverse_dir(import_dir, importer);
+        auto dir_node = CtImports::traverse_dir(import_dir, importer, &_pCtMainWin->get_status_bar());
         _create_imported_nodes(dir_node.get());
     }
     catch (std::exception& ex) {
@@ -320,6 +320,24 @@ void CtActions::_create_imported_nodes(CtImportedNode* imported_nodes, const boo
                     link_el->set_attribute(CtConst::TAG_LINK, "node " + std::to_string(node_ids[broken_link.first]));
     });
 
+    // the content as the first child of the document root, as expected by the delayed text buffer
+    auto f_content_doc = [](CtImportedNode* imported_node)->std::shared_ptr<xmlpp::Document> {
+        xmlpp::Element* p_root = imported_node->xml_content->get_root_node();
+        xmlpp::Node::NodeList slots = p_root->get_children("slot");
+        if (1 == slots.size() and p_root->get_first_child() == slots.front()) {
+            return imported_node->xml_content;
+        }
+        auto p_doc = std::make_shared<xmlpp::Document>();
+        xmlpp::Element* p_slot = p_doc->create_root_node("root")->add_child("slot");
+        for (xmlpp::Node* xml_slot : slots) {
+            for (xmlpp::Node* child: xml_slot->get_children()) {
+                p_slot->import_node(child);
+            }
+        }
+        return p_doc;
+    };
+
+    CtStorageControl* pCtStorageControl = _pCtMainWin->get_ct_storage();
     auto f_create_node = [&](CtImportedNode* imported_node, Gtk::TreeIter curr_iter, bool is_child) {
         CtNodeData node_data{};
         node_data.name = imported_node->node_name;
@@ -329,17 +347,8 @@ void CtActions::_create_imported_nodes(CtImportedNode* imported_nodes, const boo
         node_data.tsLastSave = node_data.tsCreation;
         node_data.sequence = -1;
         if (imported_node->has_content()) {
-            Glib::RefPtr<Gsv::Buffer> pBuffer = _pCtMainWin->get_new_text_buffer();
-            pBuffer->begin_not_undoable_action();
-            for (xmlpp::Node* xml_slot : imported_node->xml_content->get_root_node()->get_children("slot")) {
-                for (xmlpp::Node* child: xml_slot->get_children()) {
-                    Gtk::TextIter insert_iter = pBuffer->get_insert()->get_iter();
-                    CtStorageXmlHelper{_pCtMainWin}.get_text_buffer_one_slot_from_xml(pBuffer, child, node_data.anchoredWidgets, &insert_iter, -1, "");
-                }
-            }
-            pBuffer->end_not_undoable_action();
-            pBuffer->set_modified(false);
-            node_data.rTextBuffer = pBuffer;
+            // the text buffer is created when the node is first visited
+            pCtStorageControl->add_delayed_node_xml(node_data.nodeId, f_content_doc(imported_node));
         }
         else {
             node_data.rTextBuffer = _pCtMainWin->get_new_text_buffer();
@@ -371,12 +380,17 @@ void CtActions::_create_imported_nodes(CtImportedNode* imported_nodes, const boo
     if (not parent_iter.has_value()) {
         return;
     }
-    if (not dummy_root and imported_nodes->has_content()) {
-        f_create_nodes(parent_iter.value(), imported_nodes);
-    }
-    else { // skip top if it's dir
-        for (auto& child : imported_nodes->children) {
-            f_create_nodes(parent_iter.value(), child.get());
+    {
+        const bool user_active_restore = _pCtMainWin->user_active();
+        _pCtMainWin->user_active() = false;
+        auto on_scope_exit = scope_guard([&](void*) { _pCtMainWin->user_active() = user_active_restore; });
+        if (not dummy_root and imported_nodes->has_content()) {
+            f_create_nodes(parent_iter.value(), imported_nodes);
+        }
+        else { // skip top if it's dir
+            for (auto& child : imported_nodes->children) {
+                f_create_nodes(parent_iter.value(), child.get());
+            }
         }
     }
 
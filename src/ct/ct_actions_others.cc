@@ -134,7 +134,7 @@ void CtActions::embfile_save()
     if (filepath.empty()) return;
 
     _pCtConfig->pickDirFile = Glib::path_get_dirname(filepath);
-    g_file_set_contents(filepath.c_str(), curr_file_anchor->get_raw_blob().c_str(), (gssize)curr_file_anchor->get_raw_blob().size(), nullptr);
+    (void)curr_file_anchor->get_blob()->write_to_file(filepath);
 }
 
 void CtActions::embfile_open()
@@ -144,21 +144,23 @@ void CtActions::embfile_open()
     fs::path tmp_filepath;
     if (mapIter == _embfiles_opened.end()) {
         // the file was not opened yet
-        const fs::path filename = std::to_string(_pCtMainWin->curr_tree_iter().get_node_id_data_holder()) +
+        const gint64 node_id = _pCtMainWin->curr_tree_iter().get_node_id_data_holder();
+        const fs::path filename = std::to_string(node_id) +
                                                  CtConst::CHAR_MINUS + std::to_string(open_id) +
                                                  CtConst::CHAR_MINUS + std::to_string(getpid())+
                                                  CtConst::CHAR_MINUS + curr_file_anchor->get_file_name().string();
         tmp_filepath = _pCtMainWin->get_ct_tmp()->getHiddenFilePath(filename);
         _embfiles_opened[open_id] = CtEmbFileOpened{
             .tmp_filepath = tmp_filepath,
-            .mod_time = 0};
+            .mod_time = 0,
+            .node_id = node_id};
         mapIter = _embfiles_opened.find(open_id);
     }
     else {
         tmp_filepath = mapIter->second.tmp_filepath;
     }
 
-    g_file_set_contents(tmp_filepath.c_str(), curr_file_anchor->get_raw_blob().c_str(), (gssize)curr_file_anchor->get_raw_blob().size(), nullptr);
+    (void)curr_file_anchor->get_blob()->write_to_file(tmp_filepath.string());
     fs::open_filepath(tmp_filepath.c_str(), false, _pCtConfig);
     mapIter->second.mod_time = fs::getmtime(tmp_filepath);
 
@@ -749,12 +751,14 @@ void CtActions::table_row_copy()
 {
     if (not _is_there_anch_widg_selection_or_error('t')) return;
     auto table_state = std::dynamic_pointer_cast<CtAnchoredWidgetState_TableCommon>(curr_table_anchor->get_state());
+    auto rows = std::make_shared<std::vector<std::vector<Glib::ustring>>>(*table_state->pRows);
     // remove rows after current
-    while (table_state->rows.size() > curr_table_anchor->current_row() + 1)
-        table_state->rows.pop_back();
+    while (rows->size() > curr_table_anchor->current_row() + 1)
+        rows->pop_back();
     // remove rows between current and header
-    while (table_state->rows.size() > 2)
-        table_state->rows.erase(table_state->rows.begin() + 1);
+    while (rows->size() > 2)
+        rows->erase(rows->begin() + 1);
+    table_state->pRows = rows;
     auto new_table = dynamic_cast<CtTableCommon*>(table_state->to_widget(_pCtMainWin));
     CtClipboard{_pCtMainWin}.table_row_to_clipboard(new_table);
     delete new_table;
@@ -881,6 +885,16 @@ void CtActions::_anchor_edit_dialog(CtImageAnchor* anchor, Gtk::TextIter insert_
     image_insert_anchor(insert_iter, ret_anchor_name, image_justification);
 }
 
+bool CtActions::get_were_embfiles_opened_in_node(const gint64 node_id_data_holder) const
+{
+    for (const auto& item : _embfiles_opened) {
+        if (item.second.node_id == node_id_data_holder) {
+            return true;
+        }
+    }
+    return false;
+}
+
 bool CtActions::_on_embfiles_sentinel_timeout()
 {
     for (auto& item : _embfiles_opened) {
@@ -908,8 +922,11 @@ bool CtActions::_on_embfiles_sentinel_timeout()
             for (auto& widget : tree_iter.get_anchored_widgets_fast()) {
                 if (auto embFile = dynamic_cast<CtImageEmbFile*>(widget)) {
                     if (embFile->get_unique_id() == embfile_id) {
-                        std::string buffer = Glib::file_get_contents(tmp_filepath.string());
-                        embFile->set_raw_blob(buffer);
+                        std::shared_ptr<const CtEmbFileBlob> pBlob = CtEmbFileBlob::create_from_file(tmp_filepath.string());
+                        if (not pBlob) {
+                            break;
+                        }
+                        embFile->set_blob(pBlob);
                         embFile->set_time(std::time(nullptr));
                         embFile->update_tooltip();
 
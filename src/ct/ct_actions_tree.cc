@@ -25,6 +25,8 @@
 #include "ct_image.h"
 #include "ct_dialogs.h"
 #include "ct_clipboard.h"
+#include "ct_storage_control.h"
+#include "ct_storage_xml.h"
 #include <ctime>
 #include <gtkmm/dialog.h>
 #include <gtkmm/stock.h>
@@ -157,49 +159,79 @@ void CtActions::node_subnodes_paste()
 void CtActions::node_subnodes_paste2(CtTreeIter& other_ct_tree_iter,
                                      CtMainWin* pWinToCopyFrom)
 {
-    // create duplicate of the top node
-    _node_add(CtDuplicateShared::Duplicate, false/*add_as_child*/, &other_ct_tree_iter, pWinToCopyFrom);
-
-    Gtk::TreeIter new_top_iter = _pCtMainWin->curr_tree_iter();
-
-    // function to duplicate a node
-    auto duplicate_subnode = [&](CtTreeIter old_iter, Gtk::TreeIter new_parent) {
-        CtNodeData node_data{};
-        std::shared_ptr<CtNodeState> node_state;
-        pWinToCopyFrom->get_tree_store().get_node_data(old_iter, node_data, true/*loadTextBuffer*/);
-        if (node_data.syntax != CtConst::RICH_TEXT_ID) {
-            node_data.rTextBuffer = _pCtMainWin->get_new_text_buffer(node_data.rTextBuffer->get_text());
-            node_data.anchoredWidgets.clear();
-        }
-        else {
-            CtStateMachine& state_machine_from = pWinToCopyFrom->get_state_machine();
-            state_machine_from.update_state(old_iter);
-            node_state = state_machine_from.requested_state_current(old_iter.get_node_id_data_holder());
-            node_data.anchoredWidgets.clear();                          // node_state will be used instead
-            node_data.rTextBuffer = _pCtMainWin->get_new_text_buffer(); // node_state will be used instead
-        }
-        node_data.tsCreation = std::time(nullptr);
-        node_data.tsLastSave = node_data.tsCreation;
-        node_data.nodeId = _pCtMainWin->get_tree_store().node_id_get();
-        auto new_iter = _pCtMainWin->get_tree_store().append_node(&node_data, &new_parent/*as parent*/);
-        if (node_state) {
-           _pCtMainWin->load_buffer_from_state(node_state, _pCtMainWin->get_tree_store().to_ct_tree_iter(new_iter));
+    // serialise once the source subtree, the content as in the xml document with the binaries inline,
+    // taken from the source storage for the nodes never loaded
+    struct CtNodeCopy
+    {
+        CtNodeData                       nodeData;
+        std::shared_ptr<xmlpp::Document> pNodeDoc;
+        size_t                           parentIdx; // index in the copies of the parent, the top has none
+    };
+    std::vector<CtNodeCopy> nodesCopies;
+    CtTreeStore& ct_treestore_from = pWinToCopyFrom->get_tree_store();
+    CtStorageXmlHelper storageXmlHelperFrom{pWinToCopyFrom};
+    std::function<void(const CtTreeIter&, const size_t)> f_copy_subtree;
+    f_copy_subtree = [&](const CtTreeIter& ct_tree_iter_from, const size_t parentIdx) {
+        CtNodeCopy nodeCopy{};
+        ct_treestore_from.get_node_data(ct_tree_iter_from, nodeCopy.nodeData, false/*loadTextBuffer*/);
+        nodeCopy.pNodeDoc = std::make_shared<xmlpp::Document>();
+        storageXmlHelperFrom.node_to_xml(&ct_tree_iter_from,
+                                         nodeCopy.pNodeDoc->create_root_node("root"),
+                                         std::string{}/*multifile_dir*/,
+                                         nullptr/*storage_cache*/,
+                                         CtExporting::CURRENT_NODE/*drops the master*/,
+                                         nullptr/*pExpoMasterReassign*/,
+                                         0/*start_offset*/,
+                                         -1/*end_offset*/,
+                                         true/*from_storage*/);
+        nodeCopy.parentIdx = parentIdx;
+        nodesCopies.push_back(std::move(nodeCopy));
+        const size_t myIdx = nodesCopies.size() - 1;
+        for (auto child : ct_tree_iter_from->children()) {
+            f_copy_subtree(ct_treestore_from.to_ct_tree_iter(child), myIdx);
         }
-        _pCtMainWin->get_tree_store().to_ct_tree_iter(new_iter).pending_new_db_node();
-        return new_iter;
     };
+    f_copy_subtree(other_ct_tree_iter, 0u);
 
-    // function to duplicate all sub nodes
-    std::function<void(Gtk::TreeIter, Gtk::TreeIter)> duplicate_subnodes;
-    duplicate_subnodes = [&](Gtk::TreeIter old_parent, Gtk::TreeIter new_parent) {
-        for (auto child : old_parent->children()) {
-            auto new_child = duplicate_subnode(pWinToCopyFrom->get_tree_store().to_ct_tree_iter(child), new_parent);
-            duplicate_subnodes(child, new_child);
+    // build the destination rows, the text buffers are created only when the nodes are first visited
+    CtTreeStore& ct_treestore = _pCtMainWin->get_tree_store();
+    CtStorageControl* pCtStorageControl = _pCtMainWin->get_ct_storage();
+    Gtk::TreeIter curr_iter = _pCtMainWin->curr_tree_iter();
+    gint64 nextNodeId = ct_treestore.node_id_get();
+    const gint64 tsNow = std::time(nullptr);
+    std::vector<Gtk::TreeIter> newIters;
+    newIters.reserve(nodesCopies.size());
+    {
+        const bool user_active_restore = _pCtMainWin->user_active();
+        _pCtMainWin->user_active() = false;
+        auto on_scope_exit = scope_guard([&](void*) { _pCtMainWin->user_active() = user_active_restore; });
+        for (CtNodeCopy& nodeCopy : nodesCopies) {
+            CtNodeData& nodeData = nodeCopy.nodeData;
+            nodeData.nodeId = nextNodeId++;
+            nodeData.sharedNodesMasterId = 0;
+            nodeData.rTextBuffer.reset();
+            nodeData.anchoredWidgets.clear();
+            nodeData.tsCreation = tsNow;
+            nodeData.tsLastSave = tsNow;
+            pCtStorageControl->add_delayed_node_xml(nodeData.nodeId, nodeCopy.pNodeDoc);
+            Gtk::TreeIter new_iter;
+            if (not newIters.empty()) {
+                new_iter = ct_treestore.append_node(&nodeData, &newIters.at(nodeCopy.parentIdx)/*as parent*/);
+            }
+            else if (curr_iter) {
+                new_iter = ct_treestore.insert_node(&nodeData, curr_iter/*after*/);
+            }
+            else {
+                new_iter = ct_treestore.append_node(&nodeData);
+            }
+            ct_treestore.to_ct_tree_iter(new_iter).pending_new_db_node();
+            newIters.push_back(new_iter);
         }
-    };
-    duplicate_subnodes(other_ct_tree_iter, new_top_iter);
+    }
+    Gtk::TreeIter new_top_iter = newIters.front();
+    _pCtMainWin->update_window_save_needed();
 
-    _pCtMainWin->get_tree_store().nodes_sequences_fix(new_top_iter->parent(), true);
+    ct_treestore.nodes_sequences_fix(new_top_iter->parent(), true);
     pWinToCopyFrom->get_tree_view().set_cursor_safe(other_ct_tree_iter); // this line fixes glich with text_buffer with widgets caused by the next line
     _pCtMainWin->get_tree_view().set_cursor_safe(new_top_iter);
     _pCtMainWin->get_text_view().grab_focus();
@@ -364,24 +396,22 @@ void CtActions::node_move_after(Gtk::TreeIter iter_to_move,
     _pCtMainWin->update_window_save_needed();
 }
 
-bool CtActions::_need_node_swap(Gtk::TreeIter& leftIter, Gtk::TreeIter& rightIter, bool ascending)
+bool CtActions::_tree_levels_sort(const std::vector<Gtk::TreeIter>& levelsParents, const bool ascending)
 {
-    Glib::ustring left_node_name = _pCtMainWin->get_tree_store().to_ct_tree_iter(leftIter).get_node_name().lowercase();
-    Glib::ustring right_node_name = _pCtMainWin->get_tree_store().to_ct_tree_iter(rightIter).get_node_name().lowercase();
-    //int cmp = left_node_name.compare(right_node_name);
-    int cmp = CtStrUtil::natural_compare(left_node_name, right_node_name);
-
-    return ascending ? cmp > 0 : cmp < 0;
+    CtTreeStore& ctTreeStore = _pCtMainWin->get_tree_store();
+    return CtMiscUtil::tree_levels_sort(ctTreeStore.get_store(), levelsParents, ctTreeStore.get_columns().colNodeName, ascending);
 }
 
-bool CtActions::_tree_sort_level_and_sublevels(const Gtk::TreeNodeChildren& children, bool ascending)
+bool CtActions::_tree_sort_level_and_sublevels(const bool ascending)
 {
-    auto need_swap = [this,&ascending](Gtk::TreeIter& l, Gtk::TreeIter& r) { return _need_node_swap(l, r, ascending); };
-    bool swap_excecuted = CtMiscUtil::node_siblings_sort(_pCtMainWin->get_tree_store().get_store(), children, need_swap);
-    for (auto& child: children)
-        if (_tree_sort_level_and_sublevels(child.children(), ascending))
-            swap_excecuted = true;
-    return swap_excecuted;
+    std::vector<Gtk::TreeIter> levelsParents{Gtk::TreeIter{}}; // the top level
+    _pCtMainWin->get_tree_store().get_store()->foreach_iter([&levelsParents](const Gtk::TreeIter& iter){
+        if (not iter->children().empty()) {
+            levelsParents.push_back(iter);
+        }
+        return false; /* continue */
+    });
+    return _tree_levels_sort(levelsParents, ascending);
 }
 
 void CtActions::node_edit()
@@ -854,7 +884,7 @@ void CtActions::tree_sort_ascending()
     _in_action = true;
     auto on_scope_exit = scope_guard([this](void*) { _in_action = false; });
 
-    if (_tree_sort_level_and_sublevels(_pCtMainWin->get_tree_store().get_store()->children(), true)) {
+    if (_tree_sort_level_and_sublevels(true)) {
         _pCtMainWin->get_tree_store().nodes_sequences_fix(Gtk::TreeIter(), true);
         _pCtMainWin->update_window_save_needed();
     }
@@ -866,7 +896,7 @@ void CtActions::tree_sort_descending()
     _in_action = true;
     auto on_scope_exit = scope_guard([this](void*) { _in_action = false; });
 
-    if (_tree_sort_level_and_sublevels(_pCtMainWin->get_tree_store().get_store()->children(), false)) {
+    if (_tree_sort_level_and_sublevels(false)) {
         _pCtMainWin->get_tree_store().nodes_sequences_fix(Gtk::TreeIter(), true);
         _pCtMainWin->update_window_save_needed();
     }
@@ -880,9 +910,7 @@ void CtActions::node_siblings_sort_ascending()
 
     if (not _is_there_selected_node_or_error()) return;
     Gtk::TreeIter father_iter = _pCtMainWin->curr_tree_iter()->parent();
-    const Gtk::TreeNodeChildren& children = father_iter ? father_iter->children() : _pCtMainWin->get_tree_store().get_store()->children();
-    auto need_swap = [this](Gtk::TreeIter& l, Gtk::TreeIter& r) { return _need_node_swap(l, r, true); };
-    if (CtMiscUtil::node_siblings_sort(_pCtMainWin->get_tree_store().get_store(), children, need_swap)) {
+    if (_tree_levels_sort({father_iter}, true)) {
         _pCtMainWin->get_tree_store().nodes_sequences_fix(father_iter, true);
         _pCtMainWin->update_window_save_needed();
     }
@@ -896,9 +924,7 @@ void CtActions::node_siblings_sort_descending()
 
     if (not _is_there_selected_node_or_error()) return;
     Gtk::TreeIter father_iter = _pCtMainWin->curr_tree_iter()->parent();
-    const Gtk::TreeNodeChildren& children = father_iter ? father_iter->children() : _pCtMainWin->get_tree_store().get_store()->children();
-    auto need_swap = [this](Gtk::TreeIter& l, Gtk::TreeIter& r) { return _need_node_swap(l, r, false); };
-    if (CtMiscUtil::node_siblings_sort(_pCtMainWin->get_tree_store().get_store(), children, need_swap)) {
+    if (_tree_levels_sort({father_iter}, false)) {
         _pCtMainWin->get_tree_store().nodes_sequences_fix(father_iter, true);
         _pCtMainWin->update_window_save_needed();
     }
@@ -25,6 +25,8 @@
 #include "ct_app.h"
 #include "ct_pref_dlg.h"
 #include "ct_storage_control.h"
+#include "ct_headless.h"
+#include "ct_trace.h"
 #include "config.h"
 #include "ct_logging.h"
 #include <iostream>
@@ -61,6 +63,20 @@ static void kill_callback_handler(int signum)
     _pCtApp->close_all_windows(true/*fromKillCallback*/);
 }
 
+// the config alone is enough for the exports with no CtMainWin
+void CtApp::_on_startup_config()
+{
+    if (_uCtCfg) return;
+
+    const fs::path config_dir = fs::get_cherrytree_configdir();
+    if (not fs::exists(config_dir)) {
+        if (g_mkdir_with_parents(config_dir.c_str(), 0755) < 0) {
+            spdlog::warn("Could not create config dir {}", config_dir.c_str());
+        }
+    }
+    _uCtCfg.reset(new CtConfig{});
+}
+
 // small optimization: second instance doesn't need all UI initialization, so we call it on the real startup
 void CtApp::_on_startup()
 {
@@ -72,15 +88,9 @@ void CtApp::_on_startup()
     (void)fs::alter_PATH_env_var();
 #endif // _WIN32
 
-    const fs::path config_dir = fs::get_cherrytree_configdir();
-    if (not fs::exists(config_dir)) {
-        if (g_mkdir_with_parents(config_dir.c_str(), 0755) < 0) {
-            spdlog::warn("Could not create config dir {}", config_dir.c_str());
-        }
-    }
-    _uCtCfg.reset(new CtConfig{});
-    //std::cout << _uCtCfg->specialChars.size() << "\t" << _uCtCfg->specialChars << std::endl;
+    _on_startup_config();
 
+    const fs::path config_dir = fs::get_cherrytree_configdir();
     const fs::path user_dir_icons = config_dir / "icons";
     _rIcontheme = Gtk::IconTheme::get_default();
     _rIcontheme->append_search_path(user_dir_icons.string());
@@ -182,23 +192,33 @@ void CtApp::on_activate()
 
 void CtApp::on_open(const Gio::Application::type_vec_files& files, const Glib::ustring& /*hint*/)
 {
-    _on_startup();
-
     // do some export stuff from console and close app after
     if ( not _export_to_txt_dir.empty() or
          not _export_to_html_dir.empty() or
-         not _export_to_pdf_dir.empty() )
+         not _export_to_pdf_dir.empty() or
+         not _convert_to.empty() or
+         _print_summary_info )
     {
         _no_gui = true;
         spdlog::debug("export arguments are detected");
         for (const Glib::RefPtr<Gio::File>& r_file : files) {
             spdlog::debug("file to export: {}", r_file->get_path());
-            CtMainWin* pWin = _create_window(true/*no_gui*/);
             const std::string canonicalPath = fs::canonical(r_file->get_path()).string();
+            if (_headless_export(canonicalPath)) {
+                continue;
+            }
+            _on_startup();
+            CtMainWin* pWin = _create_window(true/*no_gui*/);
             if (pWin->file_open(canonicalPath, ""/*node*/, ""/*anchor*/, _password)) {
                 try {
+                    if (_print_summary_info) {
+                        CtSummaryInfo summaryInfo{};
+                        if (pWin->get_tree_store().populate_summary_info(summaryInfo)) {
+                            _print_summary(canonicalPath, summaryInfo);
+                        }
+                    }
                     if (not _export_to_txt_dir.empty()) {
-                        pWin->get_ct_actions()->export_to_txt_auto(_export_to_txt_dir, _export_overwrite, _export_single_file);
+                        pWin->get_ct_actions()->export_to_txt_auto(_export_to_txt_dir, _export_overwrite, _export_single_file, _export_jobs);
                     }
                     if (not _export_to_html_dir.empty()) {
                         pWin->get_ct_actions()->export_to_html_auto(_export_to_html_dir, _export_overwrite, _export_single_file);
@@ -206,6 +226,9 @@ void CtApp::on_open(const Gio::Application::type_vec_files& files, const Glib::u
                     if (not _export_to_pdf_dir.empty()) {
                         pWin->get_ct_actions()->export_to_pdf_auto(_export_to_pdf_dir, _export_overwrite);
                     }
+                    if (not _convert_to.empty()) {
+                        (void)pWin->get_ct_actions()->export_to_ct_auto(_convert_to, _export_overwrite, _password);
+                    }
                 }
                 catch (std::exception& e) {
                     spdlog::error("caught exception: {}", e.what());
@@ -219,6 +242,8 @@ void CtApp::on_open(const Gio::Application::type_vec_files& files, const Glib::u
         return;
     }
 
+    _on_startup();
+
     // ordinary app start with filepath argument
     for (const Glib::RefPtr<Gio::File>& r_file : files) {
         CtMainWin* pAppWindow = _get_window_by_path(r_file->get_path());
@@ -247,6 +272,59 @@ void CtApp::on_open(const Gio::Application::type_vec_files& files, const Glib::u
     _new_window = false; // reset for future calls
 }
 
+bool CtApp::_headless_export(const std::string& filepath)
+{
+    // the document is exported with no CtMainWin when there is no need for the widgets,
+    // the html and pdf exports and the conversion go through the window
+    if ( not _export_to_html_dir.empty() or
+         not _export_to_pdf_dir.empty() or
+         not _convert_to.empty() or
+         not CtHeadlessDoc::is_supported(filepath) )
+    {
+        return false;
+    }
+    Glib::ustring error;
+    std::unique_ptr<CtHeadlessDoc> pHeadlessDoc = CtHeadlessDoc::load(filepath, error);
+    if (not pHeadlessDoc) {
+        spdlog::warn("headless load of {} failed ({}), falling back to the window", filepath, error.raw());
+        return false;
+    }
+    _on_startup_config();
+    try {
+        if (not _export_to_txt_dir.empty()) {
+            CtExportOptions exportOptions;
+            exportOptions.single_file = _export_single_file;
+            exportOptions.jobs = _export_jobs;
+            pHeadlessDoc->export_to_txt_auto(_export_to_txt_dir, _export_overwrite, exportOptions, _uCtCfg->hRule);
+        }
+        if (_print_summary_info) {
+            _print_summary(filepath, pHeadlessDoc->get_summary_info());
+        }
+    }
+    catch (std::exception& e) {
+        spdlog::error("caught exception: {}", e.what());
+    }
+    return true;
+}
+
+/*static*/void CtApp::_print_summary(const std::string& filepath, const CtSummaryInfo& summaryInfo)
+{
+    std::cout << filepath << std::endl
+              << "  " << _("Number of Rich Text Nodes") << ": " << summaryInfo.nodes_rich_text_num << std::endl
+              << "  " << _("Number of Plain Text Nodes") << ": " << summaryInfo.nodes_plain_text_num << std::endl
+              << "  " << _("Number of Code Nodes") << ": " << summaryInfo.nodes_code_num << std::endl
+              << "  " << _("Number of Images") << ": " << summaryInfo.images_num << std::endl
+              << "  " << _("Number of LatexBoxes") << ": " << summaryInfo.latexes_num << std::endl
+              << "  " << _("Number of Embedded Files") << ": " << summaryInfo.embfile_num << std::endl
+              << "  " << _("Number of Tables") << ": " << summaryInfo.heavytables_num << " + " << summaryInfo.lighttables_num << std::endl
+              << "  " << _("Number of CodeBoxes") << ": " << summaryInfo.codeboxes_num << std::endl
+              << "  " << _("Number of Anchors") << ": " << summaryInfo.anchors_num << std::endl
+              << "  " << _("Number of Shared Nodes / Groups") << ": " << summaryInfo.nodes_shared_tot << " / " << summaryInfo.nodes_shared_groups << std::endl
+              << "  " << _("Word Count") << ": " << summaryInfo.words_num << std::endl
+              << "  " << _("Character Count") << ": " << summaryInfo.chars_num << std::endl
+              << "  " << _("Line Count") << ": " << summaryInfo.lines_num << std::endl;
+}
+
 void CtApp::on_window_removed(Gtk::Window* window)
 {
     // override this function, so hidden windows won't be deleted from the window list
@@ -259,6 +337,16 @@ void CtApp::on_window_removed(Gtk::Window* window)
     }
 }
 
+void CtApp::on_shutdown()
+{
+    if (not _trace_filepath.empty()) {
+        if (CtTrace::write_chrome_json(_trace_filepath)) {
+            spdlog::info("trace written to {}", _trace_filepath);
+        }
+    }
+    Gtk::Application::on_shutdown();
+}
+
 CtMainWin* CtApp::_create_window(const bool no_gui)
 {
     CtMainWin* pCtMainWin = new CtMainWin{no_gui,
@@ -429,8 +517,12 @@ void CtApp::_add_main_option_entries()
     add_main_option_entry(Gio::Application::OPTION_TYPE_FILENAME, "export_to_html_dir", 'x', _("Export to HTML at specified directory path"));
     add_main_option_entry(Gio::Application::OPTION_TYPE_FILENAME, "export_to_txt_dir",  't', _("Export to Text at specified directory path"));
     add_main_option_entry(Gio::Application::OPTION_TYPE_FILENAME, "export_to_pdf_dir",  'p', _("Export to PDF at specified directory path"));
+    add_main_option_entry(Gio::Application::OPTION_TYPE_FILENAME, "convert_to",         'c', _("Save as a document at specified path, with the type from the extension (a directory for multiple files)"));
     add_main_option_entry(Gio::Application::OPTION_TYPE_BOOL,     "export_overwrite",   'w', _("Overwrite if export path already exists"));
     add_main_option_entry(Gio::Application::OPTION_TYPE_BOOL,     "export_single_file", 's', _("Export to a single file (for HTML or TXT)"));
+    add_main_option_entry(Gio::Application::OPTION_TYPE_INT,      "jobs",               'j', _("Number of parallel jobs for the export (for TXT), default one per core"));
+    add_main_option_entry(Gio::Application::OPTION_TYPE_BOOL,     "summary_info",       'i', _("Print the tree summary information"));
+    add_main_option_entry(Gio::Application::OPTION_TYPE_FILENAME, "trace",              'T', _("Record a performance trace, written on exit to the specified path (Chrome trace format)"));
     add_main_option_entry(Gio::Application::OPTION_TYPE_STRING,   "password",           'P', _("Password to open document"));
     add_main_option_entry(Gio::Application::OPTION_TYPE_BOOL,     "new_window",         'N', _("Create a new window"));
     add_main_option_entry(Gio::Application::OPTION_TYPE_BOOL,     "secondary_session",  'S', _("Run in secondary session, independent from main session"));
@@ -463,8 +555,15 @@ int CtApp::_on_handle_local_options(const Glib::RefPtr<Glib::VariantDict>& rOpti
     rOptions->lookup_value("export_to_html_dir", _export_to_html_dir);
     rOptions->lookup_value("export_to_txt_dir", _export_to_txt_dir);
     rOptions->lookup_value("export_to_pdf_dir", _export_to_pdf_dir);
+    rOptions->lookup_value("convert_to", _convert_to);
     rOptions->lookup_value("export_overwrite", _export_overwrite);
     rOptions->lookup_value("export_single_file", _export_single_file);
+    rOptions->lookup_value("jobs", _export_jobs);
+    rOptions->lookup_value("summary_info", _print_summary_info);
+    rOptions->lookup_value("trace", _trace_filepath);
+    if (not _trace_filepath.empty()) {
+        CtTrace::set_enabled(true);
+    }
     rOptions->lookup_value("password", _password);
     rOptions->lookup_value("new_window", new_window);
 
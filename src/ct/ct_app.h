@@ -59,9 +59,13 @@ protected:
     std::string   _export_to_html_dir;
     std::string   _export_to_txt_dir;
     std::string   _export_to_pdf_dir;
+    std::string   _convert_to;
+    std::string   _trace_filepath;
     Glib::ustring _password;
     bool          _export_overwrite{false};
     bool          _export_single_file{false};
+    int           _export_jobs{0};
+    bool          _print_summary_info{false};
     bool          _new_window{false};
     bool          _initDone{false};
     bool          _no_gui{false};
@@ -71,8 +75,10 @@ protected:
     void        on_activate() override;
     void        on_open(const Gio::Application::type_vec_files& files, const Glib::ustring& hint) override;
     void        on_window_removed(Gtk::Window* window) override;
+    void        on_shutdown() override;
 
     void        _on_startup();
+    void        _on_startup_config();
     void        _add_main_option_entries();
     void        _print_gresource_icons();
 
@@ -81,6 +87,9 @@ protected:
     CtMainWin*  _get_window_by_path(const std::string& filepath);
     bool        _quit_or_hide_window(CtMainWin* pCtMainWin, const bool fromDelete, const bool fromKillCallback);
     int         _on_handle_local_options(const Glib::RefPtr<Glib::VariantDict>& rOptions);
+    // load the document with no CtMainWin for the exports that do not need one, false to use the window
+    bool        _headless_export(const std::string& filepath);
+    static void _print_summary(const std::string& filepath, const CtSummaryInfo& summaryInfo);
 
 private:
     Gtk::Window* _pWinToCopyFrom{nullptr};
@@ -65,6 +65,13 @@ CtClipboard::CtClipboard(CtMainWin* pCtMainWin)
     clipb._paste_clipboard(Glib::wrap(pTextView), ctPairCodeboxMainWin.first);
 }
 
+CtClipboardSelection::~CtClipboardSelection()
+{
+    for (CtAnchoredWidget* pWidget : widgets) {
+        delete pWidget;
+    }
+}
+
 // Cut to Clipboard
 void CtClipboard::_cut_clipboard(Gtk::TextView* pTextView, CtCodebox* pCodebox)
 {
@@ -259,12 +266,19 @@ Glib::ustring CtClipboard::rich_text_get_from_text_buffer_selection(CtTreeIter n
     int iter_sel_end_offset = iter_sel_end.get_offset();
     if (exclude_iter_sel_end)
         iter_sel_end_offset -= 1;
-    std::list<CtAnchoredWidget*> widget_vector = node_iter.get_anchored_widgets(iter_sel_start_offset, iter_sel_end_offset);
+    return rich_text_get_from_text_buffer_selection(node_iter.get_anchored_widgets(iter_sel_start_offset, iter_sel_end_offset),
+                                                    text_buffer, iter_sel_start, iter_sel_end, change_case);
+}
 
+// Get rich text from the text buffer selection given the widgets within the selection
+Glib::ustring CtClipboard::rich_text_get_from_text_buffer_selection(const std::list<CtAnchoredWidget*>& widgets, Glib::RefPtr<Gtk::TextBuffer> text_buffer,
+                                                                    Gtk::TextIter iter_sel_start, Gtk::TextIter iter_sel_end,
+                                                                    gchar change_case /*="n"*/)
+{
     xmlpp::Document doc;
     auto root = doc.create_root_node("root");
-    int start_offset = iter_sel_start_offset;
-    for (CtAnchoredWidget* widget: widget_vector)
+    int start_offset = iter_sel_start.get_offset();
+    for (CtAnchoredWidget* widget: widgets)
     {
         int end_offset = widget->getOffset();
         _rich_text_process_slot(root, start_offset, end_offset, text_buffer, widget, change_case);
@@ -389,12 +403,12 @@ void CtClipboard::_selection_to_clipboard(Glib::RefPtr<Gtk::TextBuffer> text_buf
         }
     }
 
+    // the formats are generated from the snapshot only when requested, see _selection_generate_target()
     CtClipboardData* clip_data = new CtClipboardData{};
-    clip_data->html_text = CtExport2Html{_pCtMainWin}.selection_export_to_html(text_buffer, iter_sel_start, iter_sel_end, !pCodebox ? node_syntax_high : CtConst::PLAIN_TEXT_ID);
     if (not pCodebox and CtConst::RICH_TEXT_ID == node_syntax_high) {
+        clip_data->pSelection = _selection_snapshot(text_buffer, iter_sel_start, iter_sel_end,
+            ct_tree_iter.get_anchored_widgets(iter_sel_start.get_offset(), iter_sel_end.get_offset()), node_syntax_high);
         std::vector<std::string> targets_vector;
-        clip_data->plain_text = CtExport2Txt{_pCtMainWin}.selection_export_to_txt(ct_tree_iter, text_buffer, iter_sel_start.get_offset(), iter_sel_end.get_offset(), true);
-        clip_data->rich_text = rich_text_get_from_text_buffer_selection(ct_tree_iter, text_buffer, iter_sel_start, iter_sel_end);
         if (not CtClipboard::_static_force_plain_text) {
             targets_vector = {CtConst::TARGET_CTD_PLAIN_TEXT, CtConst::TARGET_CTD_RICH_TEXT, CtConst::TARGETS_HTML[0], CtConst::TARGETS_HTML[1]};
             if (pixbuf_target) {
@@ -408,7 +422,8 @@ void CtClipboard::_selection_to_clipboard(Glib::RefPtr<Gtk::TextBuffer> text_buf
         _set_clipboard_data(targets_vector, clip_data);
     }
     else {
-        clip_data->plain_text = text_buffer->get_text(iter_sel_start, iter_sel_end);
+        clip_data->pSelection = _selection_snapshot(text_buffer, iter_sel_start, iter_sel_end,
+            std::list<CtAnchoredWidget*>{}, not pCodebox ? node_syntax_high : CtConst::PLAIN_TEXT_ID);
         std::vector<std::string> targets_vector;
         if (not CtClipboard::_static_force_plain_text) {
             targets_vector = {CtConst::TARGET_CTD_PLAIN_TEXT, CtConst::TARGETS_HTML[0], CtConst::TARGETS_HTML[1]};
@@ -420,6 +435,94 @@ void CtClipboard::_selection_to_clipboard(Glib::RefPtr<Gtk::TextBuffer> text_buf
     }
 }
 
+std::unique_ptr<CtClipboardSelection> CtClipboard::_selection_snapshot(Glib::RefPtr<Gtk::TextBuffer> text_buffer,
+                                                                       Gtk::TextIter iter_sel_start,
+                                                                       Gtk::TextIter iter_sel_end,
+                                                                       const std::list<CtAnchoredWidget*>& widgets,
+                                                                       const std::string& syntax_highlighting)
+{
+    auto pSelection = std::make_unique<CtClipboardSelection>();
+    pSelection->syntaxHighlighting = syntax_highlighting;
+    pSelection->rTextBuffer = _pCtMainWin->get_new_text_buffer();
+    Glib::RefPtr<Gsv::Buffer> rSnapBuffer = pSelection->rTextBuffer;
+    rSnapBuffer->begin_not_undoable_action();
+    if (CtConst::RICH_TEXT_ID != syntax_highlighting) {
+        // the syntax highlighting is applied on the snapshot only if the html is requested
+        rSnapBuffer->set_text(text_buffer->get_text(iter_sel_start, iter_sel_end));
+    }
+    else {
+        // insert() of a range skips the child anchors, so copy the slots in between and re-create the anchors
+        const int sel_start_offset = iter_sel_start.get_offset();
+        Gtk::TextIter iter_slot_start = iter_sel_start;
+        for (CtAnchoredWidget* pWidget : widgets) {
+            Gtk::TextIter iter_anchor = text_buffer->get_iter_at_offset(pWidget->getOffset());
+            rSnapBuffer->insert(rSnapBuffer->end(), iter_slot_start, iter_anchor);
+            const int snap_anchor_offset = rSnapBuffer->end().get_offset();
+            rSnapBuffer->create_child_anchor(rSnapBuffer->end());
+            for (const Glib::RefPtr<Gtk::TextTag>& rTag : iter_anchor.get_tags()) {
+                rSnapBuffer->apply_tag(rTag, rSnapBuffer->get_iter_at_offset(snap_anchor_offset), rSnapBuffer->end());
+            }
+            // no deep copy of the images and embedded files content
+            std::shared_ptr<CtAnchoredWidgetState> pState = pWidget->get_state_shared();
+            if (0 != sel_start_offset) {
+                if (std::shared_ptr<CtAnchoredWidgetState> pStateMoved = pState->copy()) {
+                    pState = pStateMoved; // the shared state is immutable
+                }
+                pState->charOffset -= sel_start_offset;
+            }
+            pSelection->widgetsStates.push_back(pState);
+            iter_slot_start = iter_anchor;
+            iter_slot_start.forward_char();
+        }
+        rSnapBuffer->insert(rSnapBuffer->end(), iter_slot_start, iter_sel_end);
+    }
+    rSnapBuffer->end_not_undoable_action();
+    return pSelection;
+}
+
+void CtClipboard::_selection_generate_target(CtClipboardData* clip_data, const Glib::ustring& target)
+{
+    CtClipboardSelection* pSelection = clip_data->pSelection.get();
+    if (not pSelection) {
+        return;
+    }
+    const bool is_rich_text = CtConst::RICH_TEXT_ID == pSelection->syntaxHighlighting;
+    Glib::RefPtr<Gsv::Buffer> rSnapBuffer = pSelection->rTextBuffer;
+    auto f_get_widgets = [&]()->const std::list<CtAnchoredWidget*>&{
+        if (pSelection->widgets.empty()) {
+            for (const std::shared_ptr<CtAnchoredWidgetState>& pState : pSelection->widgetsStates) {
+                pSelection->widgets.push_back(pState->to_widget(_pCtMainWin));
+            }
+        }
+        return pSelection->widgets;
+    };
+    if (CtConst::TARGET_CTD_PLAIN_TEXT == target) {
+        if (not pSelection->plainDone) {
+            if (is_rich_text) {
+                clip_data->plain_text = CtExport2Txt{_pCtMainWin}.selection_export_to_txt(f_get_widgets(), rSnapBuffer,
+                    0, rSnapBuffer->end().get_offset(), true/*check_link_target*/);
+            }
+            else {
+                clip_data->plain_text = rSnapBuffer->get_text();
+            }
+            pSelection->plainDone = true;
+        }
+    }
+    else if (CtConst::TARGET_CTD_RICH_TEXT == target) {
+        if (not pSelection->richDone and is_rich_text) {
+            clip_data->rich_text = rich_text_get_from_text_buffer_selection(f_get_widgets(), rSnapBuffer, rSnapBuffer->begin(), rSnapBuffer->end());
+            pSelection->richDone = true;
+        }
+    }
+    else if (vec::exists(CtConst::TARGETS_HTML, target)) {
+        if (not pSelection->htmlDone) {
+            clip_data->html_text = CtExport2Html{_pCtMainWin}.selection_export_to_html(rSnapBuffer, rSnapBuffer->begin(), rSnapBuffer->end(),
+                pSelection->syntaxHighlighting, is_rich_text ? f_get_widgets() : std::list<CtAnchoredWidget*>{});
+            pSelection->htmlDone = true;
+        }
+    }
+}
+
 void CtClipboard::_set_clipboard_data(const std::vector<std::string>& targets_list, CtClipboardData* clip_data)
 {
     std::vector<Gtk::TargetEntry> target_entries;
@@ -440,6 +543,7 @@ void CtClipboard::_on_clip_data_get(Gtk::SelectionData& selection_data, CtClipbo
 {
     CtClipboard::_static_from_column_edit = clip_data->from_column_edit;
     const Glib::ustring target = selection_data.get_target();
+    _selection_generate_target(clip_data, target);
     if (CtConst::TARGET_CTD_PLAIN_TEXT == target) {
         selection_data.set(target, 8, (const guint8*)clip_data->plain_text.c_str(), (int)clip_data->plain_text.bytes());
     }
@@ -28,6 +28,23 @@
 #include "ct_codebox.h"
 #include "ct_table.h"
 #include <libxml++/libxml++.h>
+#include <memory>
+
+class CtAnchoredWidgetState;
+
+// Immutable copy of a text selection (text, tags and widgets states with offsets relative to the
+// selection start), the clipboard formats are generated from it only when requested
+struct CtClipboardSelection
+{
+    ~CtClipboardSelection();
+    Glib::RefPtr<Gsv::Buffer> rTextBuffer;
+    std::list<std::shared_ptr<CtAnchoredWidgetState>> widgetsStates;
+    std::list<CtAnchoredWidget*> widgets; // instantiated from widgetsStates on first need
+    std::string syntaxHighlighting;
+    bool htmlDone{false};
+    bool plainDone{false};
+    bool richDone{false};
+};
 
 struct CtClipboardData
 {
@@ -38,6 +55,7 @@ struct CtClipboardData
     Glib::ustring rich_text;
     Glib::RefPtr<Gdk::Pixbuf> pix_buf;
     bool from_column_edit{false};
+    std::unique_ptr<CtClipboardSelection> pSelection; // if set, the texts above are generated lazily
 };
 
 class CtClipboard
@@ -64,6 +82,9 @@ public:
     Glib::ustring rich_text_get_from_text_buffer_selection(CtTreeIter node_iter, Glib::RefPtr<Gtk::TextBuffer> text_buffer,
                                                            Gtk::TextIter iter_sel_start, Gtk::TextIter iter_sel_end,
                                                            gchar change_case = 'n', bool exclude_iter_sel_end = false);
+    Glib::ustring rich_text_get_from_text_buffer_selection(const std::list<CtAnchoredWidget*>& widgets, Glib::RefPtr<Gtk::TextBuffer> text_buffer,
+                                                           Gtk::TextIter iter_sel_start, Gtk::TextIter iter_sel_end,
+                                                           gchar change_case = 'n');
     void from_xml_string_to_buffer(Glib::RefPtr<Gtk::TextBuffer> text_buffer,
                                    const Glib::ustring& xml_string,
                                    bool* const pPasteHadWidgets = nullptr);
@@ -76,6 +97,12 @@ private:
 private:
     void _selection_to_clipboard(Glib::RefPtr<Gtk::TextBuffer> text_buffer, Gtk::TextView* sourceview, Gtk::TextIter iter_sel_start, Gtk::TextIter iter_sel_end, int num_chars, CtCodebox* pCodebox);
     void _set_clipboard_data(const std::vector<std::string>& targets_list, CtClipboardData* clip_data);
+    std::unique_ptr<CtClipboardSelection> _selection_snapshot(Glib::RefPtr<Gtk::TextBuffer> text_buffer,
+                                                              Gtk::TextIter iter_sel_start,
+                                                              Gtk::TextIter iter_sel_end,
+                                                              const std::list<CtAnchoredWidget*>& widgets,
+                                                              const std::string& syntax_highlighting);
+    void _selection_generate_target(CtClipboardData* clip_data, const Glib::ustring& target);
 
 private:
     void _on_clip_data_get(Gtk::SelectionData& selection_data, CtClipboardData* clip_data);
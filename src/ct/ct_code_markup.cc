@@ -0,0 +1,190 @@
+/*
+ * ct_code_markup.cc
+ *
+ * Copyright 2009-2024
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_code_markup.h"
+#include "ct_main_win.h"
+#include "ct_misc_utils.h"
+#include "ct_logging.h"
+
+/*static*/CtCodeMarkup::CtCacheList CtCodeMarkup::_cacheList;
+/*static*/std::unordered_map<std::string, CtCodeMarkup::CtCacheList::iterator> CtCodeMarkup::_cacheMap;
+/*static*/size_t CtCodeMarkup::_cacheBytes{0u};
+
+/*static*/Glib::ustring CtCodeMarkup::get_markup(CtMainWin* pCtMainWin,
+                                                 const Glib::RefPtr<Gsv::Buffer>& rCodeBuffer,
+                                                 const int start_offset,
+                                                 const int end_offset,
+                                                 const std::string& syntax_highlighting,
+                                                 const Target target)
+{
+    const Gtk::TextIter start_iter = start_offset >= 0 ? rCodeBuffer->get_iter_at_offset(start_offset) : rCodeBuffer->begin();
+    const Gtk::TextIter end_iter = end_offset >= 0 ? rCodeBuffer->get_iter_at_offset(end_offset) : rCodeBuffer->end();
+    const bool is_plain_text = CtConst::PLAIN_TEXT_ID == syntax_highlighting;
+    const bool need_highlight = Target::Html == target or not is_plain_text;
+    if (need_highlight) {
+        pCtMainWin->apply_syntax_highlighting(rCodeBuffer, syntax_highlighting, false/*forceReApply*/);
+    }
+    const int tabs_to_spaces = Target::Pango == target and not is_plain_text ? pCtMainWin->get_ct_config()->tabsWidth : 0;
+    const Glib::ustring code_text = rCodeBuffer->get_text(start_iter, end_iter);
+
+    Glib::RefPtr<Gsv::StyleScheme> rStyleScheme = rCodeBuffer->get_style_scheme();
+    const std::string cacheKey = fmt::format("{}|{}|{}|{}|{}|{}",
+                                             static_cast<int>(target),
+                                             syntax_highlighting,
+                                             rStyleScheme ? rStyleScheme->get_id().raw() : std::string{},
+                                             tabs_to_spaces,
+                                             code_text.bytes(),
+                                             std::hash<std::string>{}(code_text.raw()));
+    if (const Glib::ustring* pCachedMarkup = _cache_get(cacheKey)) {
+        return *pCachedMarkup;
+    }
+    if (need_highlight) {
+        rCodeBuffer->ensure_highlight(start_iter, end_iter);
+    }
+    const Glib::ustring markup = _serialize(code_text, start_iter, end_iter, target, tabs_to_spaces);
+    _cache_put(cacheKey, markup);
+    return markup;
+}
+
+/*static*/Glib::ustring CtCodeMarkup::_serialize(const Glib::ustring& code_text,
+                                                 Gtk::TextIter curr_iter,
+                                                 const Gtk::TextIter& end_iter,
+                                                 const Target target,
+                                                 const int tabs_to_spaces)
+{
+    // the span opening is built once per style tag, the tags are shared by the whole buffer
+    std::unordered_map<GtkTextTag*, std::pair<std::string/*color*/, std::string/*span*/>> tagSpans;
+    const std::string indentation(static_cast<size_t>(std::max(0, tabs_to_spaces)), CtConst::CHAR_SPACE[0]);
+
+    std::string markup;
+    markup.reserve(code_text.bytes() + code_text.bytes()/2u);
+    std::string former_color{CtConst::COLOR_48_BLACK};
+    bool span_opened{false};
+    bool is_indentation{true};
+    const char* pRun = code_text.c_str();
+    while (curr_iter.compare(end_iter) < 0) {
+        Gtk::TextIter run_end_iter = curr_iter;
+        // the tags are the same until the next toggle
+        if (not run_end_iter.forward_to_tag_toggle(Glib::RefPtr<Gtk::TextTag>{}) or run_end_iter.compare(end_iter) > 0) {
+            run_end_iter = end_iter;
+        }
+        std::vector<Glib::RefPtr<Gtk::TextTag>> curr_tags = curr_iter.get_tags();
+        if (not curr_tags.empty()) {
+            auto itTagSpan = tagSpans.find(curr_tags[0]->gobj());
+            if (tagSpans.end() == itTagSpan) {
+                const std::string color = curr_tags[0]->property_foreground_gdk().get_value().to_string();
+                const std::string font_weight = std::to_string(curr_tags[0]->property_weight().get_value());
+                std::string span;
+                if (Target::Html == target) {
+                    span = "<span style=\"color:" + CtRgbUtil::get_rgb24str_from_str_any(CtRgbUtil::rgb_to_no_white(color)) + ";font-weight:" + font_weight + "\">";
+                }
+                else {
+                    span = "<span foreground=\"" + color + "\" font_weight=\"" + font_weight + "\">";
+                }
+                itTagSpan = tagSpans.emplace(curr_tags[0]->gobj(), std::make_pair(color, span)).first;
+            }
+            const std::string& curr_color = itTagSpan->second.first;
+            if (former_color != curr_color) {
+                former_color = curr_color;
+                if (curr_color == CtConst::COLOR_48_BLACK) {
+                    // end of tag
+                    markup += "</span>";
+                    span_opened = false;
+                }
+                else {
+                    if (span_opened) markup += "</span>";
+                    // start of tag
+                    markup += itTagSpan->second.second;
+                    span_opened = true;
+                }
+            }
+        }
+        else if (span_opened) {
+            span_opened = false;
+            former_color = CtConst::COLOR_48_BLACK;
+            markup += "</span>";
+        }
+
+        // escape the whole run
+        const char* pRunEnd = g_utf8_offset_to_pointer(pRun, run_end_iter.get_offset() - curr_iter.get_offset());
+        for (; pRun < pRunEnd; ++pRun) {
+            const char ch = *pRun;
+            if (tabs_to_spaces > 0 and is_indentation) {
+                if ('\t' == ch) {
+                    markup += indentation;
+                    continue;
+                }
+                is_indentation = false;
+            }
+            switch (ch) {
+                case '&':  markup += "&amp;";  break;
+                case '\"': markup += "&quot;"; break;
+                case '\'': markup += "&#39;";  break;
+                case '<':  markup += "&lt;";   break;
+                case '>':  markup += "&gt;";   break;
+                case '\n': {
+                    if (Target::Html == target) markup += "<br />";
+                    else markup += ch;
+                    is_indentation = true;
+                } break;
+                default:   markup += ch;       break;
+            }
+        }
+        curr_iter = run_end_iter;
+    }
+    if (span_opened) markup += "</span>";
+    return Glib::ustring{markup};
+}
+
+/*static*/void CtCodeMarkup::cache_clear()
+{
+    _cacheList.clear();
+    _cacheMap.clear();
+    _cacheBytes = 0u;
+}
+
+/*static*/const Glib::ustring* CtCodeMarkup::_cache_get(const std::string& cacheKey)
+{
+    auto itMap = _cacheMap.find(cacheKey);
+    if (_cacheMap.end() == itMap) {
+        return nullptr;
+    }
+    // move to the front, most recently used
+    _cacheList.splice(_cacheList.begin(), _cacheList, itMap->second);
+    return &itMap->second->second;
+}
+
+/*static*/void CtCodeMarkup::_cache_put(const std::string& cacheKey, const Glib::ustring& markup)
+{
+    if (markup.bytes() > CacheMaxBytes/4u) {
+        return; // would push out everything else
+    }
+    _cacheList.emplace_front(cacheKey, markup);
+    _cacheMap[cacheKey] = _cacheList.begin();
+    _cacheBytes += markup.bytes();
+    while (_cacheBytes > CacheMaxBytes and not _cacheList.empty()) {
+        _cacheBytes -= _cacheList.back().second.bytes();
+        _cacheMap.erase(_cacheList.back().first);
+        _cacheList.pop_back();
+    }
+}
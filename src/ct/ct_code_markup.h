@@ -0,0 +1,70 @@
+/*
+ * ct_code_markup.h
+ *
+ * Copyright 2009-2024
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#pragma once
+
+#include <gtksourceviewmm/buffer.h>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+class CtMainWin;
+
+// Html or pango markup of a syntax highlighted code buffer, built jumping from one tag toggle to the next
+// rather than char by char; the result is cached by syntax, style scheme and content so that exporting
+// or copying again the same code does not need to serialize it again
+class CtCodeMarkup
+{
+public:
+    enum class Target { Html, Pango };
+
+    // code between start_offset and end_offset (-1 for the buffer start/end);
+    // html has the newlines as <br />, pango has the indentation tabs as spaces unless plain text
+    static Glib::ustring get_markup(CtMainWin* pCtMainWin,
+                                    const Glib::RefPtr<Gsv::Buffer>& rCodeBuffer,
+                                    const int start_offset,
+                                    const int end_offset,
+                                    const std::string& syntax_highlighting,
+                                    const Target target);
+
+    static size_t get_cache_num_entries() { return _cacheList.size(); }
+    static size_t get_cache_bytes() { return _cacheBytes; }
+    static void   cache_clear();
+
+private:
+    static Glib::ustring _serialize(const Glib::ustring& code_text,
+                                    Gtk::TextIter curr_iter,
+                                    const Gtk::TextIter& end_iter,
+                                    const Target target,
+                                    const int tabs_to_spaces);
+
+    static const Glib::ustring* _cache_get(const std::string& cacheKey);
+    static void                 _cache_put(const std::string& cacheKey, const Glib::ustring& markup);
+
+    static constexpr size_t CacheMaxBytes{16u*1024u*1024u};
+
+    using CtCacheList = std::list<std::pair<std::string, Glib::ustring>>;
+    static CtCacheList                                              _cacheList; // most recently used first
+    static std::unordered_map<std::string, CtCacheList::iterator> _cacheMap;
+    static size_t                                                   _cacheBytes;
+};
@@ -166,6 +166,9 @@ CtCodebox::CtCodebox(CtMainWin* pCtMainWin,
     set_show_line_numbers(showLineNumbers);
 
     // signals
+    _rTextBuffer->signal_changed().connect([this](){
+        _content_changed();
+    });
     _ctTextview.signal_populate_popup().connect([this](Gtk::Menu* menu){
         if (not _pCtMainWin->user_active()) return;
         //for (auto iter : menu->get_children()) menu->remove(*iter);
@@ -298,6 +301,39 @@ std::shared_ptr<CtAnchoredWidgetState> CtCodebox::get_state()
     return std::shared_ptr<CtAnchoredWidgetState>(new CtAnchoredWidgetState_Codebox(this));
 }
 
+bool CtCodebox::_state_shared_minor_fields_equal(const CtAnchoredWidgetState& state) const
+{
+    const auto& codeboxState = static_cast<const CtAnchoredWidgetState_Codebox&>(state);
+    return codeboxState.syntax == _syntaxHighlighting and
+           codeboxState.width == get_frame_width() and
+           codeboxState.height == _frameHeight and
+           codeboxState.widthInPixels == _widthInPixels and
+           codeboxState.brackets == _highlightBrackets and
+           codeboxState.showNum == _showLineNumbers;
+}
+
+void CtCodebox::_state_shared_minor_fields_set(CtAnchoredWidgetState& state) const
+{
+    auto& codeboxState = static_cast<CtAnchoredWidgetState_Codebox&>(state);
+    codeboxState.syntax = _syntaxHighlighting;
+    codeboxState.width = get_frame_width();
+    codeboxState.height = _frameHeight;
+    codeboxState.widthInPixels = _widthInPixels;
+    codeboxState.brackets = _highlightBrackets;
+    codeboxState.showNum = _showLineNumbers;
+}
+
+size_t CtCodebox::get_content_signature()
+{
+    // the fields written by to_sqlite
+    size_t signature = std::hash<std::string>{}(get_text_content().raw());
+    _signature_combine(signature, std::hash<std::string>{}(_syntaxHighlighting));
+    _signature_combine(signature, static_cast<size_t>(get_frame_width()));
+    _signature_combine(signature, static_cast<size_t>(_frameHeight));
+    _signature_combine(signature, (_widthInPixels ? 0x1u : 0x0u) | (_highlightBrackets ? 0x2u : 0x0u) | (_showLineNumbers ? 0x4u : 0x0u));
+    return signature;
+}
+
 void CtCodebox::set_show_line_numbers(const bool showLineNumbers)
 {
     _showLineNumbers = showLineNumbers;
@@ -81,6 +81,7 @@ public:
     void set_modified_false() override { set_text_buffer_modified_false(); }
     CtAnchWidgType get_type() const override { return CtAnchWidgType::CodeBox; }
     std::shared_ptr<CtAnchoredWidgetState> get_state() override;
+    size_t get_content_signature() override;
 
     void set_width_height(int newWidth, int newHeight);
     void set_width_in_pixels(const bool widthInPixels) { _widthInPixels = widthInPixels; }
@@ -103,6 +104,11 @@ public:
 private:
     bool _on_key_press_event(GdkEventKey* event);
 
+    // the content generation follows the text buffer, the other fields are compared at each state
+    bool _has_content_generation() const override { return true; }
+    bool _state_shared_minor_fields_equal(const CtAnchoredWidgetState& state) const override;
+    void _state_shared_minor_fields_set(CtAnchoredWidgetState& state) const override;
+
 private:
     int _frameWidth;
     int _frameHeight;
@@ -299,6 +299,8 @@ void CtConfig::_populate_keyfile_from_data()
     _uKeyFile->set_boolean(_currentGroup, "pt_highl_curr_line", ptHighlCurrLine);
     _uKeyFile->set_boolean(_currentGroup, "rt_highl_match_bra", rtHighlMatchBra);
     _uKeyFile->set_boolean(_currentGroup, "pt_highl_match_bra", ptHighlMatchBra);
+    _uKeyFile->set_integer(_currentGroup, "pt_large_doc_threshold", ptLargeDocThreshold);
+    _uKeyFile->set_integer(_currentGroup, "pt_large_doc_no_highl_threshold", ptLargeDocNoHighlThreshold);
     _uKeyFile->set_integer(_currentGroup, "space_around_lines", spaceAroundLines);
     _uKeyFile->set_integer(_currentGroup, "relative_wrapped_space", relativeWrappedSpace);
     _uKeyFile->set_string(_currentGroup, "h_rule", hRule);
@@ -405,7 +407,11 @@ void CtConfig::_populate_keyfile_from_data()
     _uKeyFile->set_boolean(_currentGroup, "autosave_on_quit", autosaveOnQuit);
     _uKeyFile->set_boolean(_currentGroup, "enable_custom_backup_dir", customBackupDirOn);
     _uKeyFile->set_string(_currentGroup, "custom_backup_dir", customBackupDir);
+    _uKeyFile->set_integer(_currentGroup, "save_verify", static_cast<int>(saveVerify));
     _uKeyFile->set_integer(_currentGroup, "limit_undoable_steps", limitUndoableSteps);
+    _uKeyFile->set_integer(_currentGroup, "undo_ram_states_per_node", undoRamStatesPerNode);
+    _uKeyFile->set_integer(_currentGroup, "undo_ram_budget_mb", undoRamBudgetMB);
+    _uKeyFile->set_integer(_currentGroup, "nodes_buffers_budget_mb", nodesBuffersBudgetMB);
 
     // [keyboard]
     _currentGroup = "keyboard";
@@ -606,6 +612,8 @@ void CtConfig::_populate_data_from_keyfile()
     _populate_bool_from_keyfile("pt_highl_curr_line", &ptHighlCurrLine);
     _populate_bool_from_keyfile("rt_highl_match_bra", &rtHighlMatchBra);
     _populate_bool_from_keyfile("pt_highl_match_bra", &ptHighlMatchBra);
+    _populate_int_from_keyfile("pt_large_doc_threshold", &ptLargeDocThreshold);
+    _populate_int_from_keyfile("pt_large_doc_no_highl_threshold", &ptLargeDocNoHighlThreshold);
     _populate_int_from_keyfile("space_around_lines", &spaceAroundLines);
     _populate_int_from_keyfile("relative_wrapped_space", &relativeWrappedSpace);
     _populate_string_from_keyfile("h_rule", &hRule);
@@ -740,7 +748,19 @@ void CtConfig::_populate_data_from_keyfile()
     _populate_bool_from_keyfile("autosave_on_quit", &autosaveOnQuit);
     _populate_bool_from_keyfile("enable_custom_backup_dir", &customBackupDirOn);
     _populate_string_from_keyfile("custom_backup_dir", &customBackupDir);
+    int save_verify;
+    if (_populate_int_from_keyfile("save_verify", &save_verify)) {
+        if (save_verify >= static_cast<int>(CtSaveVerify::FULL) and save_verify <= static_cast<int>(CtSaveVerify::STRUCTURAL)) {
+            saveVerify = static_cast<CtSaveVerify>(save_verify);
+        }
+        else {
+            spdlog::warn("!! save_verify {} out of range", save_verify);
+        }
+    }
     _populate_int_from_keyfile("limit_undoable_steps", &limitUndoableSteps);
+    _populate_int_from_keyfile("undo_ram_states_per_node", &undoRamStatesPerNode);
+    _populate_int_from_keyfile("undo_ram_budget_mb", &undoRamBudgetMB);
+    _populate_int_from_keyfile("nodes_buffers_budget_mb", &nodesBuffersBudgetMB);
 
     // [keyboard]
     _currentGroup = "keyboard";
@@ -144,6 +144,8 @@ public:
     bool                                        ptHighlCurrLine{true};
     bool                                        rtHighlMatchBra{false};
     bool                                        ptHighlMatchBra{true};
+    int                                         ptLargeDocThreshold{2000};
+    int                                         ptLargeDocNoHighlThreshold{20000};
     int                                         spaceAroundLines{0};
     int                                         relativeWrappedSpace{50};
     Glib::ustring                               hRule{"~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~"};
@@ -251,7 +253,11 @@ public:
     bool                                        autosaveOnQuit{false};
     bool                                        customBackupDirOn{false};
     std::string                                 customBackupDir{""};
+    CtSaveVerify                                saveVerify{CtSaveVerify::FULL};
     int                                         limitUndoableSteps{10};
+    int                                         undoRamStatesPerNode{3}; // 0 for all in memory
+    int                                         undoRamBudgetMB{32}; // 0 for no limit
+    int                                         nodesBuffersBudgetMB{512}; // 0 for no limit
 
     // [keyboard]
     std::map<std::string, std::string>          customKbShortcuts;
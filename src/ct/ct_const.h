@@ -61,6 +61,7 @@ const inline static gchar* RICH_TEXT_ID             {"custom-colors"};
 const inline static gchar* TABLE_CELL_TEXT_ID       {"table-cell-text"};
 const inline static gchar* PLAIN_TEXT_ID            {"plain-text"};
 const inline static gchar* STYLE_APPLIED_ID         {"<style-applied>"};
+const inline static gchar* LARGE_DOC_APPLIED_ID     {"<large-doc-applied>"};
 const inline static gchar* SYN_HIGHL_SHELL          {"sh"};
 #if defined(__APPLE__)
 const inline static gchar* VTE_SHELL_DEFAULT        {"/bin/zsh"};
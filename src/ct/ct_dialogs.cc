@@ -24,6 +24,7 @@
 #include "ct_dialogs.h"
 #include "ct_treestore.h"
 #include "ct_main_win.h"
+#include "ct_trace.h"
 
 void CtDialogs::bookmarks_handle_dialog(CtMainWin* pCtMainWin)
 {
@@ -649,9 +650,66 @@ void CtDialogs::summary_info_dialog(CtMainWin* pCtMainWin, const CtSummaryInfo&
     grid.attach(label_shared_key, 0, 9, 1, 1);
     Gtk::Label label_shared_val{fmt::format("{} / {}", summaryInfo.nodes_shared_tot, summaryInfo.nodes_shared_groups)};
     grid.attach(label_shared_val, 1, 9, 1, 1);
+    Gtk::Label label_words_key;
+    label_words_key.set_markup(Glib::ustring{"<b>"} + _("Word Count") + "</b>");
+    grid.attach(label_words_key, 0, 10, 1, 1);
+    Gtk::Label label_words_val{std::to_string(summaryInfo.words_num)};
+    grid.attach(label_words_val, 1, 10, 1, 1);
+    Gtk::Label label_chars_key;
+    label_chars_key.set_markup(Glib::ustring{"<b>"} + _("Character Count") + "</b>");
+    grid.attach(label_chars_key, 0, 11, 1, 1);
+    Gtk::Label label_chars_val{std::to_string(summaryInfo.chars_num)};
+    grid.attach(label_chars_val, 1, 11, 1, 1);
+    Gtk::Label label_lines_key;
+    label_lines_key.set_markup(Glib::ustring{"<b>"} + _("Line Count") + "</b>");
+    grid.attach(label_lines_key, 0, 12, 1, 1);
+    Gtk::Label label_lines_val{std::to_string(summaryInfo.lines_num)};
+    grid.attach(label_lines_val, 1, 12, 1, 1);
     Gtk::Box* pContentArea = dialog.get_content_area();
     pContentArea->pack_start(grid);
     pContentArea->show_all();
     dialog.run();
     dialog.hide();
 }
+
+bool CtDialogs::trace_dialog(CtMainWin* pCtMainWin)
+{
+    Gtk::Dialog dialog = Gtk::Dialog{_("Performance Trace"),
+                                     *pCtMainWin,
+                                     Gtk::DialogFlags::DIALOG_MODAL | Gtk::DialogFlags::DIALOG_DESTROY_WITH_PARENT};
+    Gtk::Button* pButtonExport = dialog.add_button(_("_Export..."), Gtk::RESPONSE_APPLY);
+    dialog.add_button(Gtk::Stock::CLOSE, Gtk::RESPONSE_CLOSE);
+    dialog.set_default_size(700, 350);
+    dialog.set_position(Gtk::WindowPosition::WIN_POS_CENTER_ON_PARENT);
+
+    Gtk::CheckButton checkbutton_enabled{_("Record the Timings of Load, Save, Search and Export")};
+    checkbutton_enabled.set_active(CtTrace::is_enabled());
+    Gtk::TextView textview;
+    textview.set_editable(false);
+    textview.set_monospace(true);
+    auto f_update_summaries = [&](){
+        std::string summaries;
+        for (const std::string& summary : CtTrace::get_summaries()) {
+            summaries += summary + "\n";
+        }
+        textview.get_buffer()->set_text(summaries.empty() ? _("Nothing Recorded Yet") : summaries);
+        pButtonExport->set_sensitive(not summaries.empty());
+    };
+    f_update_summaries();
+    checkbutton_enabled.signal_toggled().connect([&](){
+        CtTrace::set_enabled(checkbutton_enabled.get_active());
+        f_update_summaries();
+    });
+    Gtk::ScrolledWindow scrolledwindow;
+    scrolledwindow.set_policy(Gtk::POLICY_AUTOMATIC, Gtk::POLICY_AUTOMATIC);
+    scrolledwindow.add(textview);
+
+    Gtk::Box* pContentArea = dialog.get_content_area();
+    pContentArea->set_spacing(6);
+    pContentArea->pack_start(checkbutton_enabled, false, false);
+    pContentArea->pack_start(scrolledwindow);
+    pContentArea->show_all();
+    const int response = dialog.run();
+    dialog.hide();
+    return Gtk::RESPONSE_APPLY == response;
+}
@@ -306,6 +306,9 @@ std::string dialog_palette(CtMainWin* pCtMainWin);
 
 void summary_info_dialog(CtMainWin* pCtMainWin, const CtSummaryInfo& summaryInfo);
 
+// true if the user asked to export the trace
+bool trace_dialog(CtMainWin* pCtMainWin);
+
 enum class TableHandleResp { Cancel, Ok, OkFromFile };
 TableHandleResp table_handle_dialog(CtMainWin* pCtMainWin,
                                     const Glib::ustring& title,
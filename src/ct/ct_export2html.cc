@@ -22,11 +22,13 @@
  */
 
 #include "ct_export2html.h"
+#include "ct_code_markup.h"
 #include "ct_misc_utils.h"
 #include "ct_main_win.h"
 #include "ct_dialogs.h"
 #include "ct_storage_control.h"
 #include "ct_logging.h"
+#include "ct_trace.h"
 #include "ct_filesystem.h"
 #include "ct_list.h"
 
@@ -81,6 +83,7 @@ bool CtExport2Html::prepare_html_folder(fs::path dir_place, fs::path new_folder,
 // Export a Node To HTML
 void CtExport2Html::node_export_to_html(CtTreeIter tree_iter, const CtExportOptions& options, const Glib::ustring& index, int sel_start, int sel_end)
 {
+    CtTraceSpan traceSpan{"node_export_to_html"};
     Glib::RefPtr<Gsv::Buffer> rTextBuffer = tree_iter.get_node_text_buffer();
     if (not rTextBuffer) {
         throw std::runtime_error(str::format(_("Failed to retrieve the content of the node '%s'"), tree_iter.get_node_name()));
@@ -160,6 +163,7 @@ void CtExport2Html::node_export_to_html(CtTreeIter tree_iter, const CtExportOpti
 // Export All Nodes To HTML
 void CtExport2Html::nodes_all_export_to_multiple_html(bool all_tree, const CtExportOptions& options)
 {
+    CtTraceOperation traceOperation{"export_html"};
     fs::path home_svg = fs::get_cherrytree_datadir() / fs::path("icons") / "ct_home.svg";
     fs::copy_file(home_svg, _images_dir / "home.svg");
 
@@ -216,6 +220,7 @@ void CtExport2Html::nodes_all_export_to_multiple_html(bool all_tree, const CtExp
 // Export All Nodes To Single HTML
 void CtExport2Html::nodes_all_export_to_single_html(bool all_tree, const CtExportOptions&)
 {
+    CtTraceOperation traceOperation{"export_html"};
     fs::path index_html_filepath = _export_dir / "index.html";
     Glib::RefPtr<Gio::File> rFile = Gio::File::create_for_path(index_html_filepath.string());
     Glib::RefPtr<Gio::FileOutputStream> rFileStream = rFile->append_to();
@@ -326,6 +331,20 @@ Glib::ustring CtExport2Html::selection_export_to_html(Glib::RefPtr<Gtk::TextBuff
                                                       Gtk::TextIter start_iter,
                                                       Gtk::TextIter end_iter,
                                                       const Glib::ustring& syntax_highlighting)
+{
+    std::list<CtAnchoredWidget*> widgets;
+    if (syntax_highlighting == CtConst::RICH_TEXT_ID) {
+        widgets = _pCtMainWin->curr_tree_iter().get_anchored_widgets(start_iter.get_offset(), end_iter.get_offset());
+    }
+    return selection_export_to_html(text_buffer, start_iter, end_iter, syntax_highlighting, widgets);
+}
+
+// Returns the HTML given the text buffer, selection and the widgets within the selection
+Glib::ustring CtExport2Html::selection_export_to_html(Glib::RefPtr<Gtk::TextBuffer> text_buffer,
+                                                      Gtk::TextIter start_iter,
+                                                      Gtk::TextIter end_iter,
+                                                      const Glib::ustring& syntax_highlighting,
+                                                      const std::list<CtAnchoredWidget*>& widgets)
 {
     Glib::ustring html_text = str::format(HTML_HEADER, "");
     if (syntax_highlighting == CtConst::RICH_TEXT_ID) {
@@ -333,7 +352,6 @@ Glib::ustring CtExport2Html::selection_export_to_html(Glib::RefPtr<Gtk::TextBuff
         int images_count{0};
         fs::path tempFolder = _pCtMainWin->get_ct_tmp()->getHiddenDirPath("IMAGE_TEMP_FOLDER");
         int start_offset = start_iter.get_offset();
-        std::list<CtAnchoredWidget*> widgets = _pCtMainWin->curr_tree_iter().get_anchored_widgets(start_iter.get_offset(), end_iter.get_offset());
         for (CtAnchoredWidget* widget : widgets) {
             int end_offset = widget->getOffset();
             node_html_text += html_process_slot(_pCtConfig, _pCtMainWin, start_offset, end_offset, text_buffer);
@@ -392,7 +410,7 @@ Glib::ustring CtExport2Html::_get_embfile_html(CtImageEmbFile* embfile, CtTreeIt
     Glib::ustring embfile_html = "<table style=\"" + embfile_align_text + "\"><tr><td><a href=\"" +
             embfile_rel_path.string_unix() + "\">Linked file: " + embfile->get_file_name().string() + " </a></td></tr></table>";
 
-    g_file_set_contents((embed_dir / embfile_name).c_str(), embfile->get_raw_blob().c_str(), (gssize)embfile->get_raw_blob().size(), nullptr);
+    (void)embfile->get_blob()->write_to_file((embed_dir / embfile_name).string());
 
     return embfile_html;
 }
@@ -466,58 +484,9 @@ Glib::ustring CtExport2Html::_get_table_html(CtTableCommon* table)
 // Get rich text from syntax highlighted code node
 Glib::ustring CtExport2Html::_html_get_from_code_buffer(const Glib::RefPtr<Gsv::Buffer>& code_buffer, int sel_start, int sel_end, const std::string& syntax_highlighting, const bool from_selection/*=false*/)
 {
-    Gtk::TextIter curr_iter = sel_start >= 0 ? code_buffer->get_iter_at_offset(sel_start) : code_buffer->begin();
-    Gtk::TextIter end_iter = sel_end >= 0 ? code_buffer->get_iter_at_offset(sel_end) : code_buffer->end();
-
-    _pCtMainWin->apply_syntax_highlighting(code_buffer, syntax_highlighting, false/*forceReApply*/);
-    code_buffer->ensure_highlight(curr_iter, end_iter);
-
-    Glib::ustring html_text;
-    Glib::ustring former_tag_str = CtConst::COLOR_48_BLACK;
-    bool span_opened = false;
-    for (;;) {
-        auto curr_tags = curr_iter.get_tags();
-        if (curr_tags.size() > 0) {
-            Glib::ustring curr_tag_str = curr_tags[0]->property_foreground_gdk().get_value().to_string();
-            int font_weight = curr_tags[0]->property_weight().get_value();
-            if (curr_tag_str == CtConst::COLOR_48_BLACK) {
-                if (former_tag_str != curr_tag_str) {
-                    former_tag_str = curr_tag_str;
-                    // end of tag
-                    html_text += "</span>";
-                    span_opened = false;
-                }
-            }
-            else {
-                if (former_tag_str != curr_tag_str) {
-                    former_tag_str = curr_tag_str;
-                    if (span_opened) html_text += "</span>";
-                    // start of tag
-                    Glib::ustring color = CtRgbUtil::rgb_to_no_white(curr_tag_str);
-                    color = CtRgbUtil::get_rgb24str_from_str_any(color);
-                    html_text += "<span style=\"color:" + color + ";font-weight:" + std::to_string(font_weight) + "\">";
-                    span_opened = true;
-                }
-            }
-        }
-        else if (span_opened) {
-            span_opened = false;
-            former_tag_str = CtConst::COLOR_48_BLACK;
-            html_text += "</span>";
-        }
-        Glib::ustring sym = str::xml_escape(Glib::ustring(1, curr_iter.get_char()));
-        html_text += sym;
-        if (!curr_iter.forward_char() || (sel_end >= 0 && curr_iter.get_offset() >= sel_end)) {
-            if (span_opened) html_text += "</span>";
-            break;
-        }
-    }
-
-    html_text = str::replace(html_text, CtConst::CHAR_NEWLINE, "<br />");
-    if (from_selection) html_text = "<pre style=\"display:inline;\">" + html_text + "</pre>";
-    else html_text = "<pre>" + html_text + "</pre>";
-    //spdlog::debug("{}", html_text);
-    return html_text;
+    const Glib::ustring html_text = CtCodeMarkup::get_markup(_pCtMainWin, code_buffer, sel_start, sel_end, syntax_highlighting, CtCodeMarkup::Target::Html);
+    if (from_selection) return "<pre style=\"display:inline;\">" + html_text + "</pre>";
+    return "<pre>" + html_text + "</pre>";
 }
 
 // Given a treestore iter returns the HTML rich text
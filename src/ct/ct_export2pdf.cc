@@ -22,8 +22,13 @@
  */
 
 #include "ct_export2pdf.h"
+#include "ct_code_markup.h"
 #include "ct_dialogs.h"
+#include "ct_trace.h"
 #include <utility>
+#include <pango/pangocairo.h>
+#include <atomic>
+#include <thread>
 
 namespace {
 
@@ -89,77 +94,7 @@ Glib::ustring CtExport2Pango::pango_get_from_code_buffer(Glib::RefPtr<Gsv::Buffe
                                                          int sel_end,
                                                          const std::string& syntax_highlighting)
 {
-    Gtk::TextIter curr_iter = sel_start < 0 ? code_buffer->begin() : code_buffer->get_iter_at_offset(sel_start);
-    Gtk::TextIter end_iter = sel_start < 0 ? code_buffer->end() : code_buffer->get_iter_at_offset(sel_end);
-    Glib::ustring indentation;
-    bool indentation_force_spaces{false};
-    if (syntax_highlighting != CtConst::PLAIN_TEXT_ID) {
-        _pCtMainWin->apply_syntax_highlighting(code_buffer, syntax_highlighting, false/*forceReApply*/);
-        code_buffer->ensure_highlight(curr_iter, end_iter);
-        indentation = str::repeat(CtConst::CHAR_SPACE, _pCtConfig->tabsWidth);
-        indentation_force_spaces = true;
-    }
-    Glib::ustring pango_text;
-    Glib::ustring former_tag_str = CtConst::COLOR_48_BLACK;
-    bool span_opened{false};
-    bool is_indentation{true};
-    while (true) {
-        auto curr_tags = curr_iter.get_tags();
-        if (not curr_tags.empty()) {
-            Glib::ustring curr_tag_str = curr_tags[0]->property_foreground_gdk().get_value().to_string();
-            int font_weight = curr_tags[0]->property_weight();
-            if (curr_tag_str == CtConst::COLOR_48_BLACK) {
-                if (former_tag_str != curr_tag_str) {
-                    former_tag_str = curr_tag_str;
-                    // end of tag
-                    pango_text += "</span>";
-                    span_opened = false;
-                }
-            }
-            else {
-                if (former_tag_str != curr_tag_str) {
-                    former_tag_str = curr_tag_str;
-                    if (span_opened) pango_text += "</span>";
-                    // start of tag
-                    Glib::ustring color = CtRgbUtil::get_rgb24str_from_str_any(CtRgbUtil::rgb_to_no_white(curr_tag_str));
-                    pango_text += "<span foreground=\"" + curr_tag_str + "\" font_weight=\"" + std::to_string(font_weight) + "\">";
-                    span_opened = true;
-                }
-            }
-        }
-        else if (span_opened) {
-            span_opened = false;
-            former_tag_str = CtConst::COLOR_48_BLACK;
-            pango_text += "</span>";
-        }
-        const auto curr_char = curr_iter.get_char();
-        if (indentation_force_spaces) {
-            if (is_indentation) {
-                if ('\t' == curr_char) {
-                    pango_text += indentation;
-                }
-                else {
-                    is_indentation = false;
-                }
-            }
-            if (not is_indentation) {
-                pango_text += str::xml_escape(Glib::ustring{1, curr_char});
-                if ('\n' == curr_char) {
-                    is_indentation = true;
-                }
-            }
-        }
-        else {
-            pango_text += str::xml_escape(Glib::ustring{1, curr_char});
-        }
-        if (not curr_iter.forward_char() or (sel_end >= 0 && curr_iter.get_offset() > sel_end)) {
-            if (span_opened) pango_text += "</span>";
-            break;
-        }
-    }
-    //if (pango_text.empty() || pango_text[pango_text.size()-1] != g_utf8_get_char(CtConst::CHAR_NEWLINE))
-    //    pango_text += CtConst::CHAR_NEWLINE;
-    return pango_text;
+    return CtCodeMarkup::get_markup(_pCtMainWin, code_buffer, sel_start, sel_end, syntax_highlighting, CtCodeMarkup::Target::Pango);
 }
 
 // Process a Single Pango Slot
@@ -365,6 +300,7 @@ std::shared_ptr<CtPangoText> CtExport2Pango::_pango_link_url(const Glib::ustring
 
 void CtExport2Pdf::node_export_print(const fs::path& pdf_filepath, CtTreeIter tree_iter, const CtExportOptions& options, int sel_start, int sel_end)
 {
+    CtTraceOperation traceOperation{"export_pdf"};
     Glib::RefPtr<Gsv::Buffer> rTextBuffer = tree_iter.get_node_text_buffer();
     if (not rTextBuffer) {
         throw std::runtime_error(str::format(_("Failed to retrieve the content of the node '%s'"), tree_iter.get_node_name()));
@@ -387,6 +323,7 @@ void CtExport2Pdf::node_export_print(const fs::path& pdf_filepath, CtTreeIter tr
 
 void CtExport2Pdf::node_and_subnodes_export_print(const fs::path& pdf_filepath, CtTreeIter tree_iter, const CtExportOptions& options)
 {
+    CtTraceOperation traceOperation{"export_pdf"};
     std::vector<CtPangoObjectPtr> tree_pango_slots;
     _nodes_all_export_print_iter(tree_iter, options, tree_pango_slots);
 
@@ -395,6 +332,7 @@ void CtExport2Pdf::node_and_subnodes_export_print(const fs::path& pdf_filepath,
 
 void CtExport2Pdf::tree_export_print(const fs::path& pdf_filepath, CtTreeIter tree_iter, const CtExportOptions& options)
 {
+    CtTraceOperation traceOperation{"export_pdf"};
     std::vector<CtPangoObjectPtr> tree_pango_slots;
     while (tree_iter) {
         _nodes_all_export_print_iter(tree_iter, options, tree_pango_slots);
@@ -493,6 +431,7 @@ void CtPrint::run_page_setup_dialog(Gtk::Window* pWin)
 // Start the Print Operations for Text
 void CtPrint::print_text(const fs::path& pdf_filepath, const std::vector<CtPangoObjectPtr>& slots)
 {
+    CtTraceSpan traceSpan{"print_text"};
     CtPrintData print_data;
     print_data.slots = slots;
 
@@ -506,6 +445,10 @@ void CtPrint::print_text(const fs::path& pdf_filepath, const std::vector<CtPango
     print_data.operation->signal_begin_print().connect(sigc::bind(f_begin_print_text, &print_data));
     print_data.operation->signal_draw_page().connect(sigc::bind(f_draw_page_text, &print_data));
     print_data.operation->set_export_filename(pdf_filepath.string());
+    // the slots point to the widgets of the printed nodes while the progress dialog runs the main loop
+    CtNodesBuffersLru& nodesBuffersLru = _pCtMainWin->get_nodes_buffers_lru();
+    nodesBuffersLru.hold();
+    auto on_scope_exit = scope_guard([&](void*) { nodesBuffersLru.unhold(); });
     try {
         auto res = print_data.operation->run(!pdf_filepath.empty() ? Gtk::PRINT_OPERATION_ACTION_EXPORT : Gtk::PRINT_OPERATION_ACTION_PRINT_DIALOG);
         if (res == Gtk::PRINT_OPERATION_RESULT_ERROR)
@@ -523,6 +466,7 @@ void CtPrint::print_text(const fs::path& pdf_filepath, const std::vector<CtPango
 // Here we Compute the Lines Positions, the Number of Pages Needed and the Page Breaks
 void CtPrint::_on_begin_print_text(const Glib::RefPtr<Gtk::PrintContext>& context, CtPrintData* print_data)
 {
+    CtTraceSpan traceSpan{"paginate"};
     auto get_font_with_fallback_ = [](Pango::FontDescription font, const std::string& fallbackFont) {
 #ifdef _WIN32
         // explicit fallback is needed on Win32, linux works OK without it
@@ -553,6 +497,8 @@ void CtPrint::_on_begin_print_text(const Glib::RefPtr<Gtk::PrintContext>& contex
         return _get_width_height_from_layout_line(layout_newline->get_line(0)).height;
     }();
 
+    _prebuild_layouts(print_data);
+
     bool any_image_resized{false};
     for (auto slot : print_data->slots) {
         if (dynamic_cast<CtPangoNewPage*>(slot.get())) {
@@ -575,12 +521,117 @@ void CtPrint::_on_begin_print_text(const Glib::RefPtr<Gtk::PrintContext>& contex
     }
 
     print_data->operation->set_n_pages(print_data->pages.size());
+    _lastPagesLinesY.assign(print_data->pages.size(), std::vector<int>{});
+    for (int i = 0; i < print_data->pages.size(); ++i) {
+        for (const CtPrintPages::CtPageLine& line : print_data->pages.get_page(i).lines) {
+            _lastPagesLinesY[i].push_back(line.y);
+        }
+    }
     if (any_image_resized) {
         print_data->warning = Glib::ustring(_("Warning: One or More Images Were Reduced to Enter the Page!")) + " ("
                                        + std::to_string(static_cast<int>(_page_width))+ "x" + std::to_string(static_cast<int>(_page_height)) + ")";
     }
 }
 
+void CtPrint::_prebuild_layouts(CtPrintData* print_data)
+{
+    // the markup is taken here as the buffers must be accessed by the main thread only,
+    // then the layouts are built by the worker threads
+    std::vector<CtPrintLayoutJob> jobs;
+    for (const CtPangoObjectPtr& slot : print_data->slots) {
+        if (auto pango_text = dynamic_cast<const CtPangoText*>(slot.get())) {
+            CtPrintLayoutJob job;
+            job.markup = pango_text->text;
+            job.pFont = &_get_slot_font(pango_text->synt_highl);
+            job.width = static_cast<int>(_page_width - pango_text->indent) * Pango::SCALE;
+            job.pLayoutDest = &print_data->textLayouts[pango_text];
+            jobs.push_back(std::move(job));
+        }
+        else if (auto pango_widget = dynamic_cast<const CtPangoWidget*>(slot.get())) {
+            if (auto codebox = dynamic_cast<const CtCodebox*>(pango_widget->widget)) {
+                if (print_data->codeboxLayouts.count(codebox)) {
+                    continue;
+                }
+                std::pair<int, Glib::RefPtr<Pango::Layout>>& width_n_layout = print_data->codeboxLayouts[codebox];
+                // the width when the codebox starts a new line
+                const int available_width = static_cast<int>(_page_width - pango_widget->indent);
+                width_n_layout.first = static_cast<int>(std::min(_codebox_get_frame_width(codebox), static_cast<double>(available_width)));
+                CtPrintLayoutJob job;
+                job.markup = _codebox_get_markup(print_data, codebox);
+                job.pFont = codebox->get_syntax_highlighting() != CtConst::PLAIN_TEXT_ID ? &_code_font : &_plain_font;
+                job.width = width_n_layout.first * Pango::SCALE;
+                job.pLayoutDest = &width_n_layout.second;
+                jobs.push_back(std::move(job));
+            }
+            else if (auto table = dynamic_cast<const CtTableCommon*>(pango_widget->widget)) {
+                if (not print_data->tableLayouts.count(table)) {
+                    _table_add_layout_jobs(table, print_data->tableLayouts[table], jobs);
+                }
+            }
+        }
+    }
+    _run_layout_jobs(jobs, print_data->context);
+}
+
+void CtPrint::_run_layout_jobs(std::vector<CtPrintLayoutJob>& jobs, const Glib::RefPtr<Gtk::PrintContext>& context)
+{
+    if (jobs.empty()) {
+        return;
+    }
+    const size_t threads_max = _layoutThreadsMax > 0 ? _layoutThreadsMax : std::thread::hardware_concurrency();
+    const size_t num_threads = std::max<size_t>(1u, std::min<size_t>(threads_max, jobs.size()/LayoutJobsPerThreadMin));
+    // the main thread uses the pango context of the print context, every other thread its own font map
+    // (a font map is not thread safe) with the resolution and font options of the print context
+    std::vector<Glib::RefPtr<Pango::Context>> pango_contexts;
+    Glib::RefPtr<Pango::Context> print_pango_context = context->create_pango_context();
+    pango_cairo_update_context(context->get_cairo_context()->cobj(), print_pango_context->gobj());
+    pango_contexts.push_back(print_pango_context);
+    for (size_t i = 1; i < num_threads; ++i) {
+        PangoFontMap* pFontMap = pango_cairo_font_map_new();
+        pango_cairo_font_map_set_resolution(PANGO_CAIRO_FONT_MAP(pFontMap), pango_cairo_context_get_resolution(print_pango_context->gobj()));
+        Glib::RefPtr<Pango::Context> pango_context = Glib::wrap(pango_font_map_create_context(pFontMap));
+        g_object_unref(pFontMap); // kept by the context (and then by the layouts)
+        pango_cairo_context_set_resolution(pango_context->gobj(), pango_cairo_context_get_resolution(print_pango_context->gobj()));
+        pango_cairo_context_set_font_options(pango_context->gobj(), pango_cairo_context_get_font_options(print_pango_context->gobj()));
+        pango_context_set_matrix(pango_context->gobj(), pango_context_get_matrix(print_pango_context->gobj()));
+        pango_context_set_language(pango_context->gobj(), pango_context_get_language(print_pango_context->gobj()));
+        pango_context_set_base_dir(pango_context->gobj(), pango_context_get_base_dir(print_pango_context->gobj()));
+        pango_contexts.push_back(pango_context);
+    }
+    std::atomic<size_t> next_job{0u};
+    // plain pango calls, the C++ wrappers are created back in the main thread
+    auto f_build_layouts = [&jobs, &next_job](PangoContext* pPangoContext) {
+        for (size_t i = next_job++; i < jobs.size(); i = next_job++) {
+            CtPrintLayoutJob& job = jobs[i];
+            job.pLayout = pango_layout_new(pPangoContext);
+            pango_layout_set_font_description(job.pLayout, job.pFont->gobj());
+            pango_layout_set_width(job.pLayout, job.width);
+            pango_layout_set_wrap(job.pLayout, PANGO_WRAP_WORD_CHAR);
+            pango_layout_set_markup(job.pLayout, job.markup.c_str(), -1);
+            (void)pango_layout_get_line_count(job.pLayout); // the lines are computed lazily, we want it here
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < num_threads; ++i) {
+        threads.emplace_back(f_build_layouts, pango_contexts[i]->gobj());
+    }
+    f_build_layouts(pango_contexts[0]->gobj());
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (CtPrintLayoutJob& job : jobs) {
+        *job.pLayoutDest = Glib::wrap(job.pLayout);
+    }
+    spdlog::debug("{} layouts by {} threads", jobs.size(), num_threads);
+}
+
+const Pango::FontDescription& CtPrint::_get_slot_font(const Glib::ustring& synt_highl)
+{
+    if (synt_highl == CtConst::RICH_TEXT_ID) return _rich_font;
+    if (synt_highl == CtConst::PLAIN_TEXT_ID) return _plain_font;
+    return _code_font;
+}
+
 bool CtPrint::_cairo_tag_can_apply(const Glib::ustring& tag_name, const Glib::ustring& tag_attr, const CtPrintData* print_data)
 {
     if (CAIRO_TAG_DEST == tag_name or not str::startswith(tag_attr, "dest=")) {
@@ -678,11 +729,6 @@ void CtPrint::_process_pango_text(CtPrintData* print_data, CtPangoText* text_slo
 {
     auto context = print_data->context;
     CtPrintPages& pages = print_data->pages;
-    Pango::FontDescription* font = [&]() {
-        if (text_slot->synt_highl == CtConst::RICH_TEXT_ID) return &_rich_font;
-        if (text_slot->synt_highl == CtConst::PLAIN_TEXT_ID) return &_plain_font;
-        return &_code_font;
-    }();
 
     Glib::ustring tag_name, tag_attr;
     if (auto pango_link = dynamic_cast<CtPangoLink*>(text_slot)) {
@@ -716,18 +762,27 @@ void CtPrint::_process_pango_text(CtPrintData* print_data, CtPangoText* text_slo
         }
     }
 
-    Glib::RefPtr<Pango::Layout> layout = context->create_pango_layout();
-    layout->set_font_description(*font);
     const int max_layout_line_width = _page_width - text_slot->indent;
-    layout->set_width(max_layout_line_width * Pango::SCALE);
-    layout->set_wrap(Pango::WRAP_WORD_CHAR);
     // the next line fixes the link issue, allowing to start paragraphs from where a link ends
     // don't apply paragraph indent because set_indent will work only for the first line
     // also avoid `\n` because new lines also got indent
+    int first_line_indent{0};
     if (PANGO_DIRECTION_RTL != text_slot->pango_dir and CtConst::CHAR_NEWLINE != text_slot->text and -1 != pages.last_line().cur_x) {
-        layout->set_indent(int(pages.last_line().cur_x * Pango::SCALE));
+        first_line_indent = int(pages.last_line().cur_x * Pango::SCALE);
+    }
+    Glib::RefPtr<Pango::Layout> layout;
+    auto itPrebuilt = print_data->textLayouts.find(text_slot);
+    if (0 == first_line_indent and print_data->textLayouts.end() != itPrebuilt) {
+        layout = itPrebuilt->second;
+    }
+    else {
+        layout = context->create_pango_layout();
+        layout->set_font_description(_get_slot_font(text_slot->synt_highl));
+        layout->set_width(max_layout_line_width * Pango::SCALE);
+        layout->set_wrap(Pango::WRAP_WORD_CHAR);
+        layout->set_indent(first_line_indent);
+        layout->set_markup(text_slot->text);
     }
-    layout->set_markup(text_slot->text);
 
     int layout_count = layout->get_line_count();
     for (int i = 0; i < layout_count; ++i) {
@@ -909,8 +964,8 @@ void CtPrint::_process_pango_codebox(CtPrintData* print_data, const CtCodebox* c
     auto context = print_data->context;
     CtPrintPages& pages = print_data->pages;
 
-    Glib::ustring original_content = CtExport2Pango{_pCtMainWin}.pango_get_from_code_buffer(
-        codebox->get_buffer(), -1, -1, codebox->get_syntax_highlighting());
+    Glib::ustring original_content = _codebox_get_markup(print_data, codebox);
+    bool is_whole_content{true};
 
     for (int i = 0; i < 1000/*just a big number without meaning*/; ++i) {
         // first loop we try and fit the codebox in line with existing text
@@ -949,7 +1004,7 @@ void CtPrint::_process_pango_codebox(CtPrintData* print_data, const CtCodebox* c
             }
         }
 
-        double codebox_width = (codebox->get_width_in_pixels() ? codebox->get_frame_width() : _text_window_width * codebox->get_frame_width()/100.0)*_page_dpi_scale;
+        double codebox_width = _codebox_get_frame_width(codebox);
         if (0 == i and codebox_width > available_width and available_width < (_page_width - pango_widget->indent)) {
             pages.new_line();
             continue; // restart loop from a new line
@@ -959,7 +1014,16 @@ void CtPrint::_process_pango_codebox(CtPrintData* print_data, const CtCodebox* c
         }
 
         // use content if it's ok
-        auto codebox_layout = _codebox_get_layout(codebox, original_content, context, codebox_width);
+        Glib::RefPtr<Pango::Layout> codebox_layout;
+        auto itPrebuilt = print_data->codeboxLayouts.find(codebox);
+        if (is_whole_content and print_data->codeboxLayouts.end() != itPrebuilt and
+            itPrebuilt->second.first == static_cast<int>(codebox_width) and itPrebuilt->second.second)
+        {
+            codebox_layout = itPrebuilt->second.second;
+        }
+        else {
+            codebox_layout = _codebox_get_layout(codebox, original_content, context, codebox_width);
+        }
         double codebox_height = _get_height_from_layout(codebox_layout);
         if (pages.last_line().test_element_height(codebox_height + (BOX_OFFSET * _page_dpi_scale), _page_height)) {
 
@@ -1001,6 +1065,7 @@ void CtPrint::_process_pango_codebox(CtPrintData* print_data, const CtCodebox* c
 
             // go to to check the second part
             original_content = second_split;
+            is_whole_content = false;
         }
     }
 }
@@ -1018,6 +1083,21 @@ Glib::RefPtr<Pango::Layout> CtPrint::_codebox_get_layout(const CtCodebox* codebo
     return layout;
 }
 
+const Glib::ustring& CtPrint::_codebox_get_markup(CtPrintData* print_data, const CtCodebox* codebox)
+{
+    auto itMarkup = print_data->codeboxMarkups.find(codebox);
+    if (print_data->codeboxMarkups.end() == itMarkup) {
+        itMarkup = print_data->codeboxMarkups.emplace(codebox, CtExport2Pango{_pCtMainWin}.pango_get_from_code_buffer(
+            codebox->get_buffer(), -1, -1, codebox->get_syntax_highlighting())).first;
+    }
+    return itMarkup->second;
+}
+
+double CtPrint::_codebox_get_frame_width(const CtCodebox* codebox)
+{
+    return (codebox->get_width_in_pixels() ? codebox->get_frame_width() : _text_window_width * codebox->get_frame_width()/100.0)*_page_dpi_scale;
+}
+
 // Split Long CodeBoxes
 void CtPrint::_codebox_split_content(const CtCodebox* codebox,
                                      Glib::ustring original_content,
@@ -1071,8 +1151,8 @@ void CtPrint::_process_pango_table(CtPrintData *print_data,
                                    const CtTableCommon* table,
                                    const CtPangoWidget* pango_widget)
 {
-    auto context = print_data->context;
     CtPrintPages& pages = print_data->pages;
+    const CtPageTable::TableLayouts& table_all_layouts = _table_get_all_layouts(print_data, table);
 
     int first_row = 1;
 
@@ -1126,7 +1206,7 @@ void CtPrint::_process_pango_table(CtPrintData *print_data,
 
         // use table is length is ok
         std::vector<double> rows_h, cols_w;
-        auto table_layouts = _table_get_layouts(table, first_row, -1, context);
+        auto table_layouts = _table_get_layouts(table_all_layouts, first_row, -1);
         _table_get_grid(table_layouts, table->get_col_widths(), rows_h, cols_w);
         double table_height = _table_get_width_height(rows_h);
         if (pages.last_line().test_element_height(table_height + (BOX_OFFSET * _page_dpi_scale), _page_height)) {
@@ -1147,12 +1227,12 @@ void CtPrint::_process_pango_table(CtPrintData *print_data,
         }
 
         // if table is too long, split it
-        int split_row = _table_split_content(table, first_row, _page_height - pages.last_line().y - (BOX_OFFSET * _page_dpi_scale), context);
+        int split_row = _table_split_content(table, table_all_layouts, first_row, _page_height - pages.last_line().y - (BOX_OFFSET * _page_dpi_scale));
         if (split_row == -1) {
             pages.new_page(); // need a new page
         }
         else {
-            auto split_layouts = _table_get_layouts(table, first_row, split_row, context);
+            auto split_layouts = _table_get_layouts(table_all_layouts, first_row, split_row);
             _table_get_grid(split_layouts, table->get_col_widths(), rows_h, cols_w);
             double table_height = _table_get_width_height(rows_h);
 
@@ -1173,32 +1253,49 @@ void CtPrint::_process_pango_table(CtPrintData *print_data,
     }
 }
 
-CtPageTable::TableLayouts CtPrint::_table_get_layouts(const CtTableCommon* table,
-                                                      const int first_row,
-                                                      const int last_row,
-                                                      const Glib::RefPtr<Gtk::PrintContext>& context)
+void CtPrint::_table_add_layout_jobs(const CtTableCommon* table,
+                                     CtPageTable::TableLayouts& table_all_layouts,
+                                     std::vector<CtPrintLayoutJob>& jobs)
 {
     std::vector<std::vector<Glib::ustring>> rows;
     table->write_strings_matrix(rows);
-    CtPageTable::TableLayouts table_layouts;
+    table_all_layouts.resize(rows.size());
     for (size_t r = 0u; r < rows.size(); ++r) {
-        if (first_row != -1 && r > 0 && (int)r < first_row) continue; // skip row out of range except header
-        if (last_row != -1 && (int)r > last_row) break;
-
-        std::vector<Glib::RefPtr<Pango::Layout>> layouts;
+        table_all_layouts[r].resize(rows.at(r).size());
         for (size_t c = 0u; c < rows.at(r).size(); ++c) {
-            Glib::ustring text = str::xml_escape(rows.at(r).at(c));
-            if (r == 0) text = "<b>" + text + "</b>";
-            Glib::RefPtr<Pango::Layout> cell_layout = context->create_pango_layout();
-            cell_layout->set_font_description(_rich_font);
-            cell_layout->set_width(int((table->get_col_width(c) * _page_dpi_scale) * Pango::SCALE));
-            cell_layout->set_wrap(Pango::WRAP_WORD_CHAR);
-            cell_layout->set_markup(text);
-            layouts.push_back(cell_layout);
-        }
-        table_layouts.push_back(std::move(layouts));
+            CtPrintLayoutJob job;
+            job.markup = str::xml_escape(rows.at(r).at(c));
+            if (r == 0) job.markup = "<b>" + job.markup + "</b>";
+            job.pFont = &_rich_font;
+            job.width = int((table->get_col_width(c) * _page_dpi_scale) * Pango::SCALE);
+            job.pLayoutDest = &table_all_layouts[r][c];
+            jobs.push_back(std::move(job));
+        }
+    }
+}
+
+const CtPageTable::TableLayouts& CtPrint::_table_get_all_layouts(CtPrintData* print_data, const CtTableCommon* table)
+{
+    auto itLayouts = print_data->tableLayouts.find(table);
+    if (print_data->tableLayouts.end() == itLayouts) {
+        itLayouts = print_data->tableLayouts.emplace(table, CtPageTable::TableLayouts{}).first;
+        std::vector<CtPrintLayoutJob> jobs;
+        _table_add_layout_jobs(table, itLayouts->second, jobs);
+        _run_layout_jobs(jobs, print_data->context);
     }
+    return itLayouts->second;
+}
 
+CtPageTable::TableLayouts CtPrint::_table_get_layouts(const CtPageTable::TableLayouts& table_all_layouts,
+                                                      const int first_row,
+                                                      const int last_row)
+{
+    CtPageTable::TableLayouts table_layouts;
+    for (size_t r = 0u; r < table_all_layouts.size(); ++r) {
+        if (first_row != -1 && r > 0 && (int)r < first_row) continue; // skip row out of range except header
+        if (last_row != -1 && (int)r > last_row) break;
+        table_layouts.push_back(table_all_layouts[r]);
+    }
     return table_layouts;
 }
 
@@ -1233,14 +1330,14 @@ double CtPrint::_table_get_width_height(std::vector<double>& data)
 }
 
 int CtPrint::_table_split_content(const CtTableCommon* table,
+                                  const CtPageTable::TableLayouts& table_all_layouts,
                                   const int start_row,
-                                  const int check_height,
-                                  const Glib::RefPtr<Gtk::PrintContext>& context)
+                                  const int check_height)
 {
     int last_row = start_row;
     for (; last_row < (int)table->get_num_rows(); ++last_row) {
         std::vector<double> rows_h, cols_w;
-        auto table_layouts = _table_get_layouts(table, start_row, last_row, context);
+        auto table_layouts = _table_get_layouts(table_all_layouts, start_row, last_row);
         _table_get_grid(table_layouts, table->get_col_widths(), rows_h, cols_w);
         double table_height = _table_get_width_height(rows_h);
         if (table_height > check_height) {
@@ -270,11 +270,27 @@ private:
     std::vector<CtPrintPage> _pages{CtPrintPage{}};
 };
 
+// Pango layout to be built by a worker thread
+struct CtPrintLayoutJob
+{
+    Glib::ustring                 markup;
+    const Pango::FontDescription* pFont{nullptr};
+    int                           width{0}; // pango units
+    Glib::RefPtr<Pango::Layout>*  pLayoutDest{nullptr};
+    PangoLayout*                  pLayout{nullptr};
+};
+
 // Print Operation Data
 struct CtPrintData
 {
     std::vector<CtPangoObjectPtr>      slots;
 
+    // layouts built in parallel ahead of the sequential pagination
+    std::unordered_map<const CtPangoText*, Glib::RefPtr<Pango::Layout>>                 textLayouts; // no first line indent
+    std::unordered_map<const CtCodebox*, Glib::ustring>                                codeboxMarkups;
+    std::unordered_map<const CtCodebox*, std::pair<int, Glib::RefPtr<Pango::Layout>>>  codeboxLayouts; // at the frame width
+    std::unordered_map<const CtTableCommon*, CtPageTable::TableLayouts>                tableLayouts; // all the rows
+
     Glib::RefPtr<Gtk::PrintOperation>  operation;
     Glib::RefPtr<Gtk::PrintContext>    context;
 
@@ -297,12 +313,22 @@ public:
     void run_page_setup_dialog(Gtk::Window* pMainWin);
     void print_text(const fs::path& pdf_filepath, const std::vector<CtPangoObjectPtr>& slots);
 
+    // 0 for as many threads building the layouts as the hardware allows, 1 for the main thread only
+    void set_layout_threads_max(const size_t threadsMax) { _layoutThreadsMax = threadsMax; }
+    // the bottom y of the lines of every page of the last print, to compare paginations
+    const std::vector<std::vector<int>>& get_last_pages_lines_y() const { return _lastPagesLinesY; }
+
 private:
     void _on_begin_print_text(const Glib::RefPtr<Gtk::PrintContext>& context, CtPrintData* print_data);
     void _on_draw_page_text(const Glib::RefPtr<Gtk::PrintContext>& context, int page_nr, CtPrintData* print_data);
     bool _cairo_tag_can_apply(const Glib::ustring& tag_name, const Glib::ustring& tag_attr, const CtPrintData* print_data);
 
 private:
+    static constexpr size_t LayoutJobsPerThreadMin{8};
+    void _prebuild_layouts(CtPrintData* print_data);
+    void _run_layout_jobs(std::vector<CtPrintLayoutJob>& jobs, const Glib::RefPtr<Gtk::PrintContext>& context);
+    const Pango::FontDescription& _get_slot_font(const Glib::ustring& synt_highl);
+
     void _process_pango_text(CtPrintData* print_data, CtPangoText* text_slot);
     void _process_pango_image(CtPrintData* print_data, const CtImage* image, const CtPangoWidget* pango_widget, bool& any_image_resized);
     void _process_pango_codebox(CtPrintData* print_data, const CtCodebox* codebox, const CtPangoWidget* pango_widget);
@@ -312,6 +338,8 @@ private:
                                                     Glib::ustring content,
                                                     Glib::RefPtr<Gtk::PrintContext> context,
                                                     const int codebox_width);
+    const Glib::ustring&        _codebox_get_markup(CtPrintData* print_data, const CtCodebox* codebox);
+    double                      _codebox_get_frame_width(const CtCodebox* codebox);
     void                        _codebox_split_content(const CtCodebox* codebox,
                                                        Glib::ustring original_content,
                                                        const int check_height,
@@ -320,19 +348,22 @@ private:
                                                        Glib::ustring& second_split,
                                                        const int codebox_width);
 
-    CtPageTable::TableLayouts   _table_get_layouts(const CtTableCommon* table,
+    void                        _table_add_layout_jobs(const CtTableCommon* table,
+                                                       CtPageTable::TableLayouts& table_all_layouts,
+                                                       std::vector<CtPrintLayoutJob>& jobs);
+    const CtPageTable::TableLayouts& _table_get_all_layouts(CtPrintData* print_data, const CtTableCommon* table);
+    CtPageTable::TableLayouts   _table_get_layouts(const CtPageTable::TableLayouts& table_all_layouts,
                                                    const int first_row,
-                                                   const int last_row,
-                                                   const Glib::RefPtr<Gtk::PrintContext>& context);
+                                                   const int last_row);
     void                        _table_get_grid(const CtPageTable::TableLayouts& table_layouts,
                                                 const CtTableColWidths& col_widths,
                                                 std::vector<double>& rows_h,
                                                 std::vector<double>& cols_w);
     double                      _table_get_width_height(std::vector<double>& data);
     int                         _table_split_content(const CtTableCommon* table,
+                                                     const CtPageTable::TableLayouts& table_all_layouts,
                                                      const int start_row,
-                                                     const int check_height,
-                                                     const Glib::RefPtr<Gtk::PrintContext>& context);
+                                                     const int check_height);
 
     void _draw_codebox_box(Cairo::RefPtr<Cairo::Context> cairo_context, double x0, double y0, double codebox_width, double codebox_height);
     void _draw_codebox_code(Cairo::RefPtr<Cairo::Context> cairo_context, Glib::RefPtr<Pango::Layout> codebox_layout, double x0, double y0);
@@ -363,4 +394,6 @@ private:
     double                           _page_dpi_scale;
     double                           _page_width;
     double                           _page_height;
+    size_t                           _layoutThreadsMax{0};
+    std::vector<std::vector<int>>    _lastPagesLinesY;
 };
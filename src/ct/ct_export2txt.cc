@@ -23,6 +23,9 @@
 
 #include "ct_export2txt.h"
 #include "ct_main_win.h"
+#include "ct_image.h"
+#include "ct_trace.h"
+#include <giomm/file.h>
 
 CtExport2Txt::CtExport2Txt(CtMainWin* pCtMainWin)
  : _pCtMainWin(pCtMainWin)
@@ -31,41 +34,261 @@ CtExport2Txt::CtExport2Txt(CtMainWin* pCtMainWin)
 
 // Export the Selected Node To Txt
 Glib::ustring CtExport2Txt::node_export_to_txt(CtTreeIter tree_iter, fs::path filepath, CtExportOptions export_options, int sel_start, int sel_end)
+{
+    Glib::ustring plain_text;
+    for (const Glib::ustring& piece : _node_get_txt_pieces(tree_iter, export_options, sel_start, sel_end)) {
+        plain_text += piece;
+    }
+    if (not filepath.empty()) {
+        CtMiscUtil::text_file_set_contents_add_cr_on_win(filepath.string(), plain_text);
+    }
+    return plain_text;
+}
+
+std::vector<Glib::ustring> CtExport2Txt::_node_get_txt_pieces(CtTreeIter tree_iter, const CtExportOptions& export_options, int sel_start, int sel_end)
 {
     Glib::RefPtr<Gsv::Buffer> rTextBuffer = tree_iter.get_node_text_buffer();
     if (not rTextBuffer) {
         throw std::runtime_error(str::format(_("Failed to retrieve the content of the node '%s'"), tree_iter.get_node_name()));
     }
-    Glib::ustring plain_text;
+    std::vector<Glib::ustring> pieces;
+    if (export_options.include_node_name) {
+        pieces.push_back(str::repeat("#", 1+_pCtMainWin->get_tree_store().get_store()->iter_depth(tree_iter)) +
+                         CtConst::CHAR_SPACE + tree_iter.get_node_name() + CtConst::CHAR_NEWLINE);
+    }
+    pieces.push_back(selection_export_to_txt(tree_iter, rTextBuffer, sel_start, sel_end, false));
+    pieces.push_back(str::repeat(CtConst::CHAR_NEWLINE, 2));
+    return pieces;
+}
+
+CtTxtNodeData CtExport2Txt::_node_get_txt_data(CtTreeIter tree_iter, const CtExportOptions& export_options)
+{
+    Glib::RefPtr<Gsv::Buffer> rTextBuffer = tree_iter.get_node_text_buffer();
+    if (not rTextBuffer) {
+        throw std::runtime_error(str::format(_("Failed to retrieve the content of the node '%s'"), tree_iter.get_node_name()));
+    }
+    CtTxtNodeData nodeData;
     if (export_options.include_node_name) {
-        for (int i = 0; i < 1+_pCtMainWin->get_tree_store().get_store()->iter_depth(tree_iter); ++i) {
-            plain_text += "#";
+        nodeData.header = str::repeat("#", 1+_pCtMainWin->get_tree_store().get_store()->iter_depth(tree_iter)) +
+                          CtConst::CHAR_SPACE + tree_iter.get_node_name() + CtConst::CHAR_NEWLINE;
+    }
+    nodeData.text = rTextBuffer->get_text(); // the anchor chars are not included
+    for (CtAnchoredWidget* pWidget : tree_iter.get_anchored_widgets_fast()) {
+        CtTxtNodeData::CtTxtWidget txtWidget;
+        txtWidget.type = pWidget->get_type();
+        txtWidget.charOffset = rTextBuffer->get_iter_at_child_anchor(pWidget->getTextChildAnchor()).get_offset();
+        if (auto pTable = dynamic_cast<CtTableCommon*>(pWidget)) pTable->write_strings_matrix(txtWidget.rows);
+        else if (auto pCodebox = dynamic_cast<CtCodebox*>(pWidget)) txtWidget.text = pCodebox->get_text_content();
+        else if (auto pLatex = dynamic_cast<CtImageLatex*>(pWidget)) txtWidget.text = pLatex->get_latex_text();
+        nodeData.widgets.push_back(std::move(txtWidget));
+    }
+    std::sort(nodeData.widgets.begin(), nodeData.widgets.end(), [](const CtTxtNodeData::CtTxtWidget& a, const CtTxtNodeData::CtTxtWidget& b){
+        return a.charOffset < b.charOffset;
+    });
+    return nodeData;
+}
+
+/*static*/std::vector<Glib::ustring> CtExport2Txt::node_data_to_txt_pieces(const CtTxtNodeData& nodeData, const Glib::ustring& hRule)
+{
+    // same output as selection_export_to_txt, the widgets offsets count one anchor char per previous widget
+    std::vector<Glib::ustring> pieces;
+    if (not nodeData.header.empty()) {
+        pieces.push_back(nodeData.header);
+    }
+    Glib::ustring plain_text;
+    const int text_len = static_cast<int>(nodeData.text.size());
+    int start_offset{0};
+    int num_anchors{0};
+    for (const CtTxtNodeData::CtTxtWidget& widget : nodeData.widgets) {
+        const int end_offset = std::min(std::max(widget.charOffset - num_anchors, start_offset), text_len);
+        ++num_anchors;
+        plain_text += nodeData.text.substr(start_offset, end_offset - start_offset);
+        start_offset = end_offset;
+        switch (widget.type) {
+            case CtAnchWidgType::TableHeavy: [[fallthrough]];
+            case CtAnchWidgType::TableLight: plain_text += table_plain(widget.rows); break;
+            case CtAnchWidgType::CodeBox: plain_text += codebox_plain(widget.text, hRule); break;
+            case CtAnchWidgType::ImageLatex: plain_text += latex_plain(widget.text, hRule); break;
+            default: break;
         }
-        plain_text += CtConst::CHAR_SPACE + tree_iter.get_node_name() + CtConst::CHAR_NEWLINE;
     }
-    plain_text += selection_export_to_txt(tree_iter, rTextBuffer, sel_start, sel_end, false);
-    plain_text += str::repeat(CtConst::CHAR_NEWLINE, 2);
-    if (not filepath.empty()) {
-        CtMiscUtil::text_file_set_contents_add_cr_on_win(filepath.string(), plain_text);
+    plain_text += nodeData.text.substr(start_offset);
+    pieces.push_back(std::move(plain_text));
+    pieces.push_back(str::repeat(CtConst::CHAR_NEWLINE, 2));
+    return pieces;
+}
+
+CtExport2TxtWriter::CtExport2TxtWriter(const fs::path& single_txt_filepath, const int jobs, const Glib::ustring& hRule)
+ : _hRule{hRule}
+{
+    if (not single_txt_filepath.empty()) {
+        try {
+            _rOutStream = Gio::BufferedOutputStream::create(Gio::File::create_for_path(single_txt_filepath.string())->replace());
+            _rOutStream->set_buffer_size(OutStreamBufferSize);
+        }
+        catch (Glib::Error& e) {
+            throw std::runtime_error(e.what());
+        }
+    }
+    const size_t num_jobs = jobs > 0 ? static_cast<size_t>(jobs) : std::max(1u, std::thread::hardware_concurrency());
+    for (size_t i = 0; i < num_jobs; ++i) {
+        _workers.emplace_back(&CtExport2TxtWriter::_worker, this);
+    }
+}
+
+CtExport2TxtWriter::~CtExport2TxtWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock{_jobsMutex};
+        _noMoreJobs = true;
+    }
+    _cvJobs.notify_all();
+    for (std::thread& worker : _workers) {
+        worker.join();
+    }
+}
+
+/*static*/std::string CtExport2TxtWriter::join_txt_pieces(const std::vector<Glib::ustring>& pieces)
+{
+    size_t tot_bytes{0u};
+    for (const Glib::ustring& piece : pieces) {
+        tot_bytes += piece.bytes();
+    }
+    std::string joined;
+    joined.reserve(tot_bytes);
+    for (const Glib::ustring& piece : pieces) {
+        joined += piece.raw();
+    }
+#if defined(_WIN32)
+    joined = str::replace(joined, "\n", "\r\n");
+#endif // _WIN32
+    return joined;
+}
+
+void CtExport2TxtWriter::_worker()
+{
+    for (;;) {
+        CtTxtNodeJob job;
+        {
+            std::unique_lock<std::mutex> lock{_jobsMutex};
+            _cvJobs.wait(lock, [&](){ return not _jobsToDo.empty() or _noMoreJobs; });
+            if (_jobsToDo.empty()) {
+                return;
+            }
+            job = std::move(_jobsToDo.front());
+            _jobsToDo.pop_front();
+        }
+        CtTraceSpan traceSpan{"txt_join"};
+        std::string joined = join_txt_pieces(CtExport2Txt::node_data_to_txt_pieces(job.nodeData, _hRule));
+        job.nodeData = CtTxtNodeData{};
+        if (not job.filepath.empty()) {
+            if (not g_file_set_contents(job.filepath.c_str(), joined.c_str(), static_cast<gssize>(joined.size()), nullptr)) {
+                spdlog::error("!! writing {}", job.filepath.string());
+            }
+            else {
+                CtTrace::counter_add(CtTraceCounter::BytesWritten, static_cast<gint64>(joined.size()));
+            }
+            std::lock_guard<std::mutex> lock{_jobsMutex};
+            _inFlightBytes -= job.bytes;
+        }
+        else {
+            std::lock_guard<std::mutex> lock{_jobsMutex};
+            _joinedToWrite.emplace(job.seq, std::make_pair(std::move(joined), job.bytes));
+        }
+        _cvDone.notify_all();
+    }
+}
+
+void CtExport2TxtWriter::_write_in_order(std::unique_lock<std::mutex>& lock)
+{
+    for (auto it = _joinedToWrite.find(_nextSeqToWrite); _joinedToWrite.end() != it; it = _joinedToWrite.find(_nextSeqToWrite)) {
+        std::pair<std::string, size_t> joined_n_bytes = std::move(it->second);
+        _joinedToWrite.erase(it);
+        ++_nextSeqToWrite;
+        lock.unlock();
+        if (_rOutStream) {
+            gsize bytes_written{0u};
+            try {
+                _rOutStream->write_all(joined_n_bytes.first.data(), joined_n_bytes.first.size(), bytes_written);
+            }
+            catch (Glib::Error& e) {
+                throw std::runtime_error(e.what());
+            }
+            CtTrace::counter_add(CtTraceCounter::BytesWritten, static_cast<gint64>(bytes_written));
+        }
+        lock.lock();
+        _inFlightBytes -= joined_n_bytes.second;
+    }
+}
+
+void CtExport2TxtWriter::push(CtTxtNodeData&& nodeData, const fs::path& filepath)
+{
+    CtTxtNodeJob job;
+    job.nodeData = std::move(nodeData);
+    job.filepath = filepath;
+    job.bytes = job.nodeData.header.bytes() + job.nodeData.text.bytes();
+    for (const CtTxtNodeData::CtTxtWidget& widget : job.nodeData.widgets) {
+        job.bytes += widget.text.bytes();
+        for (const auto& row : widget.rows) {
+            for (const Glib::ustring& cell : row) {
+                job.bytes += cell.bytes();
+            }
+        }
+    }
+    job.seq = job.filepath.empty() ? _nextSeq++ : 0u;
+    {
+        std::unique_lock<std::mutex> lock{_jobsMutex};
+        for (;;) {
+            _write_in_order(lock);
+            if (_inFlightBytes < MaxInFlightBytes) break;
+            _cvDone.wait(lock);
+        }
+        _inFlightBytes += job.bytes;
+        _jobsToDo.push_back(std::move(job));
+    }
+    _cvJobs.notify_one();
+}
+
+void CtExport2TxtWriter::finish()
+{
+    {
+        std::unique_lock<std::mutex> lock{_jobsMutex};
+        for (;;) {
+            _write_in_order(lock);
+            if (_nextSeqToWrite == _nextSeq) break;
+            _cvDone.wait(lock);
+        }
+    }
+    if (_rOutStream) {
+        try {
+            _rOutStream->close();
+        }
+        catch (Glib::Error& e) {
+            throw std::runtime_error(e.what());
+        }
+        _rOutStream.reset();
     }
-    return plain_text;
 }
 
 // Export All Nodes To Txt
 void CtExport2Txt::nodes_all_export_to_txt(bool all_tree, fs::path export_dir, fs::path single_txt_filepath, CtExportOptions export_options)
 {
+    CtTraceOperation traceOperation{"export_txt"};
+    // the main thread takes the nodes text and widgets data in tree order, the writer formats and joins it
+    // and writes the node files or the single file
+    CtExport2TxtWriter txtWriter{export_dir.empty() ? single_txt_filepath : fs::path{}, export_options.jobs, _pCtMainWin->get_ct_config()->hRule};
+
     // function to iterate nodes
-    Glib::ustring tree_plain_text;
     std::function<void(CtTreeIter)> f_traverseFunc;
-    f_traverseFunc = [this, &f_traverseFunc, &export_options, &tree_plain_text, &export_dir](CtTreeIter tree_iter) {
-        if (export_dir.empty()) {
-            tree_plain_text += node_export_to_txt(tree_iter, "", export_options, -1, -1);
-        }
-        else {
-            fs::path filepath = export_dir / CtMiscUtil::get_node_hierarchical_name(tree_iter, "--"/*separator*/,
-                                                true/*for_filename*/, true/*root_to_leaf*/, true/*trail_node_id*/, ".txt"/*trailer*/);
-            node_export_to_txt(tree_iter, filepath, export_options, -1, -1);
+    f_traverseFunc = [&](CtTreeIter tree_iter) {
+        fs::path filepath;
+        if (not export_dir.empty()) {
+            filepath = export_dir / CtMiscUtil::get_node_hierarchical_name(tree_iter, "--"/*separator*/,
+                                        true/*for_filename*/, true/*root_to_leaf*/, true/*trail_node_id*/, ".txt"/*trailer*/);
         }
+        txtWriter.push(_node_get_txt_data(tree_iter, export_options), filepath);
+        // the node data is a copy, the node buffer may be unloaded
+        (void)_pCtMainWin->get_nodes_buffers_lru().evict_over_budget();
         for (auto& child: tree_iter->children())
             f_traverseFunc(_pCtMainWin->get_tree_store().to_ct_tree_iter(child));
     };
@@ -75,18 +298,19 @@ void CtExport2Txt::nodes_all_export_to_txt(bool all_tree, fs::path export_dir, f
         f_traverseFunc(tree_iter);
         if (!all_tree) break;
     }
-
-    if (not single_txt_filepath.empty()) {
-        CtMiscUtil::text_file_set_contents_add_cr_on_win(single_txt_filepath.string(), tree_plain_text);
-    }
+    txtWriter.finish();
 }
 
 // Export the Buffer To Txt
 Glib::ustring CtExport2Txt::selection_export_to_txt(CtTreeIter tree_iter, Glib::RefPtr<Gtk::TextBuffer> text_buffer, int sel_start, int sel_end, bool check_link_target)
 {
-    Glib::ustring plain_text;
-    std::list<CtAnchoredWidget*> widgets = tree_iter.get_anchored_widgets(sel_start, sel_end);
+    return selection_export_to_txt(tree_iter.get_anchored_widgets(sel_start, sel_end), text_buffer, sel_start, sel_end, check_link_target);
+}
 
+// Export the Buffer To Txt given the widgets within the selection
+Glib::ustring CtExport2Txt::selection_export_to_txt(const std::list<CtAnchoredWidget*>& widgets, Glib::RefPtr<Gtk::TextBuffer> text_buffer, int sel_start, int sel_end, bool check_link_target)
+{
+    Glib::ustring plain_text;
     int start_offset = sel_start >= 0 ? sel_start : 0;
     for (CtAnchoredWidget* widget : widgets) {
         int end_offset = widget->getOffset();
@@ -105,6 +329,21 @@ Glib::ustring CtExport2Txt::get_table_plain(CtTableCommon* table_orig)
 {
     std::vector<std::vector<Glib::ustring>> rows;
     table_orig->write_strings_matrix(rows);
+    return table_plain(rows);
+}
+
+Glib::ustring CtExport2Txt::get_codebox_plain(CtCodebox* codebox)
+{
+    return codebox_plain(codebox->get_text_content(), _pCtMainWin->get_ct_config()->hRule);
+}
+
+Glib::ustring CtExport2Txt::get_latex_plain(CtImageLatex* latex)
+{
+    return latex_plain(latex->get_latex_text(), _pCtMainWin->get_ct_config()->hRule);
+}
+
+/*static*/Glib::ustring CtExport2Txt::table_plain(const std::vector<std::vector<Glib::ustring>>& rows)
+{
     Glib::ustring table_plain = CtConst::CHAR_NEWLINE;
     for (const auto& row : rows) {
         table_plain += CtConst::CHAR_PIPE;
@@ -116,18 +355,18 @@ Glib::ustring CtExport2Txt::get_table_plain(CtTableCommon* table_orig)
     return table_plain;
 }
 
-Glib::ustring CtExport2Txt::get_codebox_plain(CtCodebox* codebox)
+/*static*/Glib::ustring CtExport2Txt::codebox_plain(const Glib::ustring& content, const Glib::ustring& hRule)
 {
-    Glib::ustring codebox_plain = CtConst::CHAR_NEWLINE + _pCtMainWin->get_ct_config()->hRule + CtConst::CHAR_NEWLINE;
-    codebox_plain += codebox->get_text_content();
-    codebox_plain += CtConst::CHAR_NEWLINE + _pCtMainWin->get_ct_config()->hRule + CtConst::CHAR_NEWLINE;
+    Glib::ustring codebox_plain = CtConst::CHAR_NEWLINE + hRule + CtConst::CHAR_NEWLINE;
+    codebox_plain += content;
+    codebox_plain += CtConst::CHAR_NEWLINE + hRule + CtConst::CHAR_NEWLINE;
     return codebox_plain;
 }
 
-Glib::ustring CtExport2Txt::get_latex_plain(CtImageLatex* latex)
+/*static*/Glib::ustring CtExport2Txt::latex_plain(const Glib::ustring& latexText, const Glib::ustring& hRule)
 {
-    Glib::ustring latex_plain = CtConst::CHAR_NEWLINE + _pCtMainWin->get_ct_config()->hRule + CtConst::CHAR_NEWLINE;
-    Glib::ustring latex_text = latex->get_latex_text();
+    Glib::ustring latex_plain = CtConst::CHAR_NEWLINE + hRule + CtConst::CHAR_NEWLINE;
+    Glib::ustring latex_text = latexText;
     const Glib::ustring::size_type begin_doc = latex_text.find("\\begin{document}");
     if (std::string::npos != begin_doc) {
         const Glib::ustring::size_type end_doc = latex_text.rfind("\\end{document}");
@@ -137,7 +376,7 @@ Glib::ustring CtExport2Txt::get_latex_plain(CtImageLatex* latex)
         }
     }
     latex_plain += latex_text;
-    latex_plain += CtConst::CHAR_NEWLINE + _pCtMainWin->get_ct_config()->hRule + CtConst::CHAR_NEWLINE;
+    latex_plain += CtConst::CHAR_NEWLINE + hRule + CtConst::CHAR_NEWLINE;
     return latex_plain;
 }
 
@@ -24,12 +24,77 @@
 #pragma once
 
 #include <gtkmm/textiter.h>
+#include <giomm/bufferedoutputstream.h>
+#include <condition_variable>
+#include <map>
+#include <thread>
 #include "ct_treestore.h"
 #include "ct_table.h"
 #include "ct_dialogs.h"
 
 class CtImageLatex;
 
+// The content of a node as the txt export needs it, taken once by the main thread (or from the storage)
+// so that the formatting can be done by any thread
+struct CtTxtNodeData
+{
+    struct CtTxtWidget
+    {
+        CtAnchWidgType                          type{CtAnchWidgType::None};
+        int                                     charOffset{0}; // in the text buffer, one anchor char per widget
+        std::vector<std::vector<Glib::ustring>> rows;          // table
+        Glib::ustring                           text;          // codebox content, latex text
+    };
+    Glib::ustring            header; // the node name line, empty if not exported
+    Glib::ustring            text;   // without the anchor chars
+    std::vector<CtTxtWidget> widgets; // in offset order
+};
+
+// Formats and joins the exported nodes and writes them on worker threads, to a file per node
+// or appended in order to a single file; no more than MaxInFlightBytes are held at any time
+class CtExport2TxtWriter
+{
+public:
+    CtExport2TxtWriter(const fs::path& single_txt_filepath, const int jobs, const Glib::ustring& hRule);
+    ~CtExport2TxtWriter();
+
+    // the node data is formatted by the worker thread, an empty filepath for the single file
+    void push(CtTxtNodeData&& nodeData, const fs::path& filepath);
+    // write the remaining pieces of the single file and close it
+    void finish();
+
+    static std::string join_txt_pieces(const std::vector<Glib::ustring>& pieces);
+
+private:
+    static constexpr size_t MaxInFlightBytes{64u*1024u*1024u};
+    static constexpr gsize  OutStreamBufferSize{1024u*1024u};
+
+    struct CtTxtNodeJob
+    {
+        size_t        seq{0u};
+        CtTxtNodeData nodeData;
+        fs::path      filepath;
+        size_t        bytes{0u};
+    };
+
+    void _worker();
+    // to be called with the lock held, released while writing
+    void _write_in_order(std::unique_lock<std::mutex>& lock);
+
+    std::mutex                                                _jobsMutex;
+    std::condition_variable                                   _cvJobs;
+    std::condition_variable                                   _cvDone;
+    std::deque<CtTxtNodeJob>                                  _jobsToDo;
+    std::map<size_t, std::pair<std::string, size_t/*bytes*/>> _joinedToWrite;
+    size_t                                                    _inFlightBytes{0u};
+    bool                                                      _noMoreJobs{false};
+    size_t                                                    _nextSeq{0u};
+    size_t                                                    _nextSeqToWrite{0u};
+    Glib::RefPtr<Gio::BufferedOutputStream>                   _rOutStream;
+    const Glib::ustring                                       _hRule;
+    std::vector<std::thread>                                  _workers;
+};
+
 class CtExport2Txt
 {
 public:
@@ -39,12 +104,24 @@ public:
     Glib::ustring node_export_to_txt(CtTreeIter tree_iter, fs::path filepath, CtExportOptions export_options, int sel_start, int sel_end);
     void          nodes_all_export_to_txt(bool all_tree, fs::path export_dir, fs::path single_txt_filepath, CtExportOptions export_options);
     Glib::ustring selection_export_to_txt(CtTreeIter tree_iter, Glib::RefPtr<Gtk::TextBuffer> text_buffer, int sel_start, int sel_end, bool check_link_target);
+    Glib::ustring selection_export_to_txt(const std::list<CtAnchoredWidget*>& widgets, Glib::RefPtr<Gtk::TextBuffer> text_buffer, int sel_start, int sel_end, bool check_link_target);
 
     Glib::ustring get_table_plain(CtTableCommon* table_orig);
     Glib::ustring get_codebox_plain(CtCodebox* codebox);
     Glib::ustring get_latex_plain(CtImageLatex* latex);
 
+    // no gtk, to be called by any thread
+    static Glib::ustring              table_plain(const std::vector<std::vector<Glib::ustring>>& rows);
+    static Glib::ustring              codebox_plain(const Glib::ustring& content, const Glib::ustring& hRule);
+    static Glib::ustring              latex_plain(const Glib::ustring& latexText, const Glib::ustring& hRule);
+    static std::vector<Glib::ustring> node_data_to_txt_pieces(const CtTxtNodeData& nodeData, const Glib::ustring& hRule);
+
 private:
+    CtTxtNodeData _node_get_txt_data(CtTreeIter tree_iter, const CtExportOptions& export_options);
+
+    // the node content is taken by the main thread as a list of pieces, then joined (and written) by a worker thread
+    std::vector<Glib::ustring> _node_get_txt_pieces(CtTreeIter tree_iter, const CtExportOptions& export_options, int sel_start, int sel_end);
+
     Glib::ustring _plain_process_slot(int start_offset, int end_offset, Glib::RefPtr<Gtk::TextBuffer> curr_buffer, bool check_link_target);
     Glib::ustring _tag_link_in_given_iter(Gtk::TextIter iter);
 
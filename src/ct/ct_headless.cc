@@ -0,0 +1,460 @@
+/*
+ * ct_headless.cc
+ *
+ * Copyright 2009-2024
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_headless.h"
+#include "ct_storage_xml.h"
+#include "ct_storage_sqlite.h"
+#include "ct_export2txt.h"
+#include "ct_text_stats.h"
+#include "ct_image.h"
+#include "ct_misc_utils.h"
+#include "ct_logging.h"
+#include "ct_trace.h"
+#include <glibmm/i18n.h>
+#include <algorithm>
+#include <unordered_set>
+
+/*static*/bool CtHeadlessDoc::is_supported(const fs::path& file_path)
+{
+    const CtDocType docType = fs::get_doc_type_from_file_ext(file_path);
+    return (CtDocType::XML == docType or CtDocType::SQLite == docType) and
+           CtDocEncrypt::False == fs::get_doc_encrypt_from_file_ext(file_path);
+}
+
+/*static*/std::unique_ptr<CtHeadlessDoc> CtHeadlessDoc::load(const fs::path& file_path, Glib::ustring& error)
+{
+    CtTraceOperation traceOperation{"load"};
+    if (not is_supported(file_path)) {
+        error = str::format(_("%s is not supported"), file_path.string());
+        return nullptr;
+    }
+    std::unique_ptr<CtHeadlessDoc> pHeadlessDoc{new CtHeadlessDoc{file_path}};
+    try {
+        if (CtDocType::XML == fs::get_doc_type_from_file_ext(file_path)) {
+            pHeadlessDoc->_load_xml();
+        }
+        else {
+            pHeadlessDoc->_load_sqlite();
+        }
+    }
+    catch (std::exception& e) {
+        error = e.what();
+        return nullptr;
+    }
+    pHeadlessDoc->_map_nodes_by_id();
+    return pHeadlessDoc;
+}
+
+CtHeadlessDoc::CtHeadlessDoc(const fs::path& file_path)
+ : _file_path{file_path}
+{
+}
+
+void CtHeadlessDoc::_load_xml()
+{
+    std::unique_ptr<xmlpp::DomParser> parser = CtStorageXml::get_parser(_file_path);
+    std::function<void(const xmlpp::Element*, std::vector<Node>&)> f_nodes_from_xml;
+    f_nodes_from_xml = [&](const xmlpp::Element* xml_element, std::vector<Node>& siblings) {
+        siblings.emplace_back();
+        Node& node = siblings.back();
+        _node_from_xml(xml_element, node);
+        for (const xmlpp::Node* xml_node : xml_element->get_children("node")) {
+            f_nodes_from_xml(static_cast<const xmlpp::Element*>(xml_node), node.children);
+        }
+    };
+    for (const xmlpp::Node* xml_node : parser->get_document()->get_root_node()->get_children("node")) {
+        f_nodes_from_xml(static_cast<const xmlpp::Element*>(xml_node), _topNodes);
+    }
+}
+
+/*static*/void CtHeadlessDoc::_node_from_xml(const xmlpp::Element* xml_element, Node& node)
+{
+    node.nodeId = CtStrUtil::gint64_from_gstring(xml_element->get_attribute_value("unique_id").c_str());
+    node.sharedNodesMasterId = CtStrUtil::gint64_from_gstring(xml_element->get_attribute_value("master_id").c_str());
+    if (node.sharedNodesMasterId > 0) {
+        return; // the data is in the master node
+    }
+    node.name = xml_element->get_attribute_value("name");
+    node.syntax = xml_element->get_attribute_value("prog_lang");
+    for (const xmlpp::Node* xml_slot : xml_element->get_children()) {
+        const xmlpp::Element* slot_element = dynamic_cast<const xmlpp::Element*>(xml_slot);
+        if (not slot_element) {
+            continue;
+        }
+        if ("rich_text" == slot_element->get_name()) {
+            if (const xmlpp::TextNode* text_node = slot_element->get_child_text()) {
+                node.text += text_node->get_content();
+            }
+        }
+        else {
+            _widget_from_xml(slot_element, node);
+        }
+    }
+    std::stable_sort(node.widgets.begin(), node.widgets.end(), [](const Widget& w1, const Widget& w2){
+        return w1.charOffset < w2.charOffset;
+    });
+}
+
+/*static*/void CtHeadlessDoc::_widget_from_xml(const xmlpp::Element* xml_element, Node& node)
+{
+    const Glib::ustring element_name = xml_element->get_name();
+    if (element_name != "codebox" and element_name != "table" and element_name != "encoded_png") {
+        return;
+    }
+    Widget widget;
+    widget.charOffset = std::stoi(xml_element->get_attribute_value("char_offset"));
+    const xmlpp::TextNode* pTextNode = xml_element->get_child_text();
+    if ("codebox" == element_name) {
+        widget.type = CtAnchWidgType::CodeBox;
+        widget.text = pTextNode ? pTextNode->get_content() : "";
+    }
+    else if ("table" == element_name) {
+        widget.type = CtStrUtil::is_str_true(xml_element->get_attribute_value("is_light")) ?
+            CtAnchWidgType::TableLight : CtAnchWidgType::TableHeavy;
+        _table_rows_from_xml(xml_element, widget);
+    }
+    else if (not xml_element->get_attribute_value("anchor").empty()) {
+        widget.type = CtAnchWidgType::ImageAnchor;
+    }
+    else {
+        const std::string file_name = xml_element->get_attribute_value("filename");
+        if (file_name == CtImageLatex::LatexSpecialFilename) {
+            widget.type = CtAnchWidgType::ImageLatex;
+            widget.text = pTextNode ? pTextNode->get_content() : "";
+        }
+        else {
+            widget.type = file_name.empty() ? CtAnchWidgType::ImagePng : CtAnchWidgType::ImageEmbFile;
+        }
+    }
+    node.widgets.push_back(std::move(widget));
+}
+
+/*static*/void CtHeadlessDoc::_table_rows_from_xml(const xmlpp::Element* xml_element, Widget& widget)
+{
+    for (const xmlpp::Node* pNodeRow : xml_element->get_children("row")) {
+        widget.rows.emplace_back();
+        for (const xmlpp::Node* pNodeCell : pNodeRow->get_children("cell")) {
+            const xmlpp::TextNode* pTextNode = static_cast<const xmlpp::Element*>(pNodeCell)->get_child_text();
+            widget.rows.back().push_back(pTextNode ? pTextNode->get_content() : "");
+        }
+    }
+    // the header row is stored last
+    if (not widget.rows.empty()) {
+        std::rotate(widget.rows.rbegin(), widget.rows.rbegin() + 1, widget.rows.rend());
+    }
+}
+
+void CtHeadlessDoc::_load_sqlite()
+{
+    sqlite3* pDb{nullptr};
+    if (sqlite3_open_v2(_file_path.c_str(), &pDb, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        const std::string error = sqlite3_errmsg(pDb);
+        sqlite3_close(pDb); // even after error, pDb is initialized
+        throw std::runtime_error(std::string("sqlite3_open: ") + error);
+    }
+    auto on_scope_exit = scope_guard([&](void*) { sqlite3_close(pDb); });
+
+    auto f_get_children = [pDb](const gint64 father_id)->std::vector<std::pair<gint64,gint64>>{
+        auto uStmt = std::make_unique<Sqlite3StmtAuto>(pDb, "SELECT node_id, master_id FROM children WHERE father_id=? ORDER BY sequence ASC");
+        if (uStmt->is_bad()) {
+            // an older version of the SQLite db didn't have master_id
+            uStmt.reset(new Sqlite3StmtAuto{pDb, "SELECT node_id FROM children WHERE father_id=? ORDER BY sequence ASC"});
+            if (uStmt->is_bad()) {
+                throw std::runtime_error(CtStorageSqlite::ERR_SQLITE_PREPV2 + sqlite3_errmsg(pDb));
+            }
+        }
+        std::vector<std::pair<gint64,gint64>> node_children;
+        sqlite3_bind_int64(*uStmt, 1, father_id);
+        while (sqlite3_step(*uStmt) == SQLITE_ROW) {
+            node_children.push_back(std::make_pair(sqlite3_column_int64(*uStmt, 0), sqlite3_column_int64(*uStmt, 1)));
+        }
+        return node_children;
+    };
+    std::function<void(const std::pair<gint64,gint64>&, std::vector<Node>&)> f_nodes_from_db;
+    f_nodes_from_db = [&](const std::pair<gint64,gint64>& id_pair, std::vector<Node>& siblings) {
+        siblings.emplace_back();
+        Node& node = siblings.back();
+        _node_from_sqlite(pDb, id_pair.first, id_pair.second, node);
+        for (const std::pair<gint64,gint64>& child_id_pair : f_get_children(id_pair.first)) {
+            f_nodes_from_db(child_id_pair, node.children);
+        }
+    };
+    for (const std::pair<gint64,gint64>& top_id_pair : f_get_children(0)) {
+        f_nodes_from_db(top_id_pair, _topNodes);
+    }
+}
+
+/*static*/void CtHeadlessDoc::_node_from_sqlite(sqlite3* pDb, const gint64 node_id, const gint64 master_id, Node& node)
+{
+    node.nodeId = node_id;
+    node.sharedNodesMasterId = master_id;
+    if (master_id > 0) {
+        return; // the data is in the master node
+    }
+    Sqlite3StmtAuto stmt{pDb, "SELECT name, syntax, txt, has_codebox, has_table, has_image FROM node WHERE node_id=?"};
+    if (stmt.is_bad()) {
+        throw std::runtime_error(CtStorageSqlite::ERR_SQLITE_PREPV2 + sqlite3_errmsg(pDb));
+    }
+    sqlite3_bind_int64(stmt, 1, node_id);
+    if (sqlite3_step(stmt) != SQLITE_ROW) {
+        throw std::runtime_error(std::string("CtHeadlessDoc: missing node properties for id ") + std::to_string(node_id));
+    }
+    node.name = CtStorageSqlite::safe_sqlite3_column_text(stmt, 0);
+    node.syntax = CtStorageSqlite::safe_sqlite3_column_text(stmt, 1);
+    const char* textContent = CtStorageSqlite::safe_sqlite3_column_text(stmt, 2);
+    if (CtConst::RICH_TEXT_ID != node.syntax) {
+        node.text = textContent;
+        return;
+    }
+    xmlpp::DomParser parser;
+    if (not CtXmlHelper::safe_parse_memory(parser, textContent) or not parser.get_document()->get_root_node()) {
+        throw std::runtime_error(str::format("xml read: %s", textContent));
+    }
+    for (const xmlpp::Node* xml_slot : parser.get_document()->get_root_node()->get_children("rich_text")) {
+        if (const xmlpp::TextNode* text_node = static_cast<const xmlpp::Element*>(xml_slot)->get_child_text()) {
+            node.text += text_node->get_content();
+        }
+    }
+    if (sqlite3_column_int64(stmt, 3) or sqlite3_column_int64(stmt, 4) or sqlite3_column_int64(stmt, 5)) {
+        _widgets_from_sqlite(pDb, node_id, node);
+    }
+}
+
+/*static*/void CtHeadlessDoc::_widgets_from_sqlite(sqlite3* pDb, const gint64 node_id, Node& node)
+{
+    {
+        Sqlite3StmtAuto stmt{pDb, "SELECT offset, txt FROM codebox WHERE node_id=?"};
+        if (stmt.is_bad()) {
+            throw std::runtime_error(CtStorageSqlite::ERR_SQLITE_PREPV2 + sqlite3_errmsg(pDb));
+        }
+        sqlite3_bind_int64(stmt, 1, node_id);
+        while (SQLITE_ROW == sqlite3_step(stmt)) {
+            Widget widget;
+            widget.type = CtAnchWidgType::CodeBox;
+            widget.charOffset = static_cast<int>(sqlite3_column_int64(stmt, 0));
+            widget.text = CtStorageSqlite::safe_sqlite3_column_text(stmt, 1);
+            node.widgets.push_back(std::move(widget));
+        }
+    }
+    {
+        Sqlite3StmtAuto stmt{pDb, "SELECT offset, txt FROM grid WHERE node_id=?"};
+        if (stmt.is_bad()) {
+            throw std::runtime_error(CtStorageSqlite::ERR_SQLITE_PREPV2 + sqlite3_errmsg(pDb));
+        }
+        sqlite3_bind_int64(stmt, 1, node_id);
+        while (SQLITE_ROW == sqlite3_step(stmt)) {
+            const char* textContent = CtStorageSqlite::safe_sqlite3_column_text(stmt, 1);
+            xmlpp::DomParser parser;
+            if (not CtXmlHelper::safe_parse_memory(parser, textContent) or not parser.get_document()->get_root_node()) {
+                throw std::runtime_error(str::format("table xml read: %s", textContent));
+            }
+            const xmlpp::Element* p_table_node = parser.get_document()->get_root_node();
+            Widget widget;
+            widget.type = CtStrUtil::is_str_true(p_table_node->get_attribute_value("is_light")) ?
+                CtAnchWidgType::TableLight : CtAnchWidgType::TableHeavy;
+            widget.charOffset = static_cast<int>(sqlite3_column_int64(stmt, 0));
+            _table_rows_from_xml(p_table_node, widget);
+            node.widgets.push_back(std::move(widget));
+        }
+    }
+    {
+        Sqlite3StmtAuto stmt{pDb, "SELECT offset, anchor, png, filename FROM image WHERE node_id=?"};
+        if (stmt.is_bad()) {
+            throw std::runtime_error(CtStorageSqlite::ERR_SQLITE_PREPV2 + sqlite3_errmsg(pDb));
+        }
+        sqlite3_bind_int64(stmt, 1, node_id);
+        while (SQLITE_ROW == sqlite3_step(stmt)) {
+            Widget widget;
+            widget.charOffset = static_cast<int>(sqlite3_column_int64(stmt, 0));
+            const std::string fileName = CtStorageSqlite::safe_sqlite3_column_text(stmt, 3);
+            if (not std::string{CtStorageSqlite::safe_sqlite3_column_text(stmt, 1)}.empty()) {
+                widget.type = CtAnchWidgType::ImageAnchor;
+            }
+            else if (fileName == CtImageLatex::LatexSpecialFilename) {
+                widget.type = CtAnchWidgType::ImageLatex;
+                const void* pBlob = sqlite3_column_blob(stmt, 2);
+                const int blobSize = sqlite3_column_bytes(stmt, 2);
+                widget.text = std::string(reinterpret_cast<const char*>(pBlob), static_cast<size_t>(blobSize));
+            }
+            else {
+                widget.type = fileName.empty() ? CtAnchWidgType::ImagePng : CtAnchWidgType::ImageEmbFile;
+            }
+            node.widgets.push_back(std::move(widget));
+        }
+    }
+    std::stable_sort(node.widgets.begin(), node.widgets.end(), [](const Widget& w1, const Widget& w2){
+        return w1.charOffset < w2.charOffset;
+    });
+}
+
+void CtHeadlessDoc::_map_nodes_by_id()
+{
+    // the nodes are not moved anymore once the whole tree is loaded
+    std::function<void(const std::vector<Node>&)> f_map_nodes;
+    f_map_nodes = [&](const std::vector<Node>& nodes) {
+        for (const Node& node : nodes) {
+            _nodesById[node.nodeId] = &node;
+            f_map_nodes(node.children);
+        }
+    };
+    f_map_nodes(_topNodes);
+}
+
+const CtHeadlessDoc::Node& CtHeadlessDoc::_get_data_node(const Node& node) const
+{
+    if (node.sharedNodesMasterId > 0) {
+        const auto it = _nodesById.find(node.sharedNodesMasterId);
+        if (_nodesById.end() != it) {
+            return *it->second;
+        }
+        spdlog::error("!! unexp missing master id {}", node.sharedNodesMasterId);
+    }
+    return node;
+}
+
+CtTxtNodeData CtHeadlessDoc::_node_get_txt_data(const Node& node, const int depth, const CtExportOptions& export_options) const
+{
+    // as CtExport2Txt takes it from the buffer, the widgets offsets count one anchor char per previous widget
+    const Node& dataNode = _get_data_node(node);
+    CtTxtNodeData nodeData;
+    if (export_options.include_node_name) {
+        nodeData.header = str::repeat("#", depth) + CtConst::CHAR_SPACE + dataNode.name + CtConst::CHAR_NEWLINE;
+    }
+    nodeData.text = dataNode.text;
+    nodeData.widgets.reserve(dataNode.widgets.size());
+    for (const Widget& widget : dataNode.widgets) {
+        CtTxtNodeData::CtTxtWidget txtWidget;
+        txtWidget.type = widget.type;
+        txtWidget.charOffset = widget.charOffset;
+        txtWidget.rows = widget.rows;
+        txtWidget.text = widget.text;
+        nodeData.widgets.push_back(std::move(txtWidget));
+    }
+    return nodeData;
+}
+
+std::string CtHeadlessDoc::_node_get_txt_filename(const std::vector<const Node*>& nodesPath) const
+{
+    // same as CtMiscUtil::get_node_hierarchical_name(tree_iter, "--", true, true, true, ".txt")
+    std::string hierarchical_name;
+    for (size_t i = 0; i < nodesPath.size(); ++i) {
+        if (i > 0) {
+            hierarchical_name += "--";
+        }
+        hierarchical_name += str::trim(_get_data_node(*nodesPath[i]).name).raw();
+    }
+    hierarchical_name += fmt::format("_{:d}", nodesPath.back()->nodeId);
+    hierarchical_name += ".txt";
+    hierarchical_name = CtMiscUtil::clean_from_chars_not_for_filename(hierarchical_name);
+    if (hierarchical_name.size() > (size_t)CtConst::MAX_FILE_NAME_LEN) {
+        hierarchical_name = hierarchical_name.substr(hierarchical_name.size() - (size_t)CtConst::MAX_FILE_NAME_LEN);
+    }
+    return hierarchical_name;
+}
+
+void CtHeadlessDoc::export_to_txt_auto(const fs::path& dir, bool overwrite, const CtExportOptions& export_options, const Glib::ustring& hRule) const
+{
+    CtTraceOperation traceOperation{"export_txt"};
+    spdlog::debug("headless txt export to: {}", dir);
+    fs::path single_txt_filepath;
+    fs::path export_dir;
+    if (export_options.single_file) {
+        single_txt_filepath = dir / (_file_path.filename().string() + ".txt");
+        if (fs::is_regular_file(single_txt_filepath)) fs::remove(single_txt_filepath);
+    }
+    else {
+        fs::path new_folder = CtMiscUtil::clean_from_chars_not_for_filename(_file_path.filename().string()) + "_TXT";
+        new_folder = fs::prepare_export_folder(dir, new_folder, overwrite);
+        export_dir = dir / new_folder;
+        g_mkdir_with_parents(export_dir.c_str(), 0777);
+    }
+    CtExport2TxtWriter txtWriter{single_txt_filepath, export_options.jobs, hRule};
+    std::vector<const Node*> nodesPath;
+    std::function<void(const Node&)> f_traverseFunc;
+    f_traverseFunc = [&](const Node& node) {
+        nodesPath.push_back(&node);
+        const fs::path filepath = export_dir.empty() ? fs::path{} : export_dir / _node_get_txt_filename(nodesPath);
+        txtWriter.push(_node_get_txt_data(node, static_cast<int>(nodesPath.size()), export_options), filepath);
+        for (const Node& child : node.children) {
+            f_traverseFunc(child);
+        }
+        nodesPath.pop_back();
+    };
+    for (const Node& node : _topNodes) {
+        f_traverseFunc(node);
+    }
+    txtWriter.finish();
+}
+
+CtSummaryInfo CtHeadlessDoc::get_summary_info() const
+{
+    CtSummaryInfo summaryInfo{};
+    std::unordered_set<gint64> sharedMasterIds;
+    std::function<void(const Node&)> f_traverseFunc;
+    f_traverseFunc = [&](const Node& node) {
+        const Node& dataNode = _get_data_node(node);
+        if (dataNode.syntax == CtConst::RICH_TEXT_ID) {
+            ++summaryInfo.nodes_rich_text_num;
+        }
+        else if (dataNode.syntax == CtConst::PLAIN_TEXT_ID) {
+            ++summaryInfo.nodes_plain_text_num;
+        }
+        else {
+            ++summaryInfo.nodes_code_num;
+        }
+        if (node.sharedNodesMasterId > 0) {
+            // shared non master
+            ++summaryInfo.nodes_shared_tot;
+            if (sharedMasterIds.insert(node.sharedNodesMasterId).second) {
+                ++summaryInfo.nodes_shared_groups;
+                ++summaryInfo.nodes_shared_tot; // add the new master to the count
+            }
+        }
+        else {
+            // non shared or shared master (data holder), counted as CtTextStats with one anchor char per widget
+            const CtTextTotals textTotals = CtTextStats::count_text(node.text);
+            summaryInfo.words_num += textTotals.words;
+            summaryInfo.chars_num += textTotals.chars + node.widgets.size();
+            summaryInfo.lines_num += textTotals.lines;
+            for (const Widget& widget : node.widgets) {
+                switch (widget.type) {
+                    case CtAnchWidgType::CodeBox: ++summaryInfo.codeboxes_num; break;
+                    case CtAnchWidgType::ImageAnchor: ++summaryInfo.anchors_num; break;
+                    case CtAnchWidgType::ImageLatex: ++summaryInfo.latexes_num; break;
+                    case CtAnchWidgType::ImageEmbFile: ++summaryInfo.embfile_num; break;
+                    case CtAnchWidgType::ImagePng: ++summaryInfo.images_num; break;
+                    case CtAnchWidgType::TableHeavy: ++summaryInfo.heavytables_num; break;
+                    case CtAnchWidgType::TableLight: ++summaryInfo.lighttables_num; break;
+                    default: break;
+                }
+            }
+        }
+        for (const Node& child : node.children) {
+            f_traverseFunc(child);
+        }
+    };
+    for (const Node& node : _topNodes) {
+        f_traverseFunc(node);
+    }
+    return summaryInfo;
+}
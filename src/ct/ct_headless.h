@@ -0,0 +1,93 @@
+/*
+ * ct_headless.h
+ *
+ * Copyright 2009-2024
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#pragma once
+
+#include "ct_types.h"
+#include "ct_filesystem.h"
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace xmlpp { class Element; }
+struct sqlite3;
+struct CtTxtNodeData;
+
+// A document loaded straight from the storage into plain structures, with no tree store,
+// text buffers or widgets and so no CtMainWin: used by the command line exports and summary
+class CtHeadlessDoc
+{
+public:
+    struct Widget
+    {
+        CtAnchWidgType                          type{CtAnchWidgType::None};
+        int                                     charOffset{0}; // in the text buffer, counting the anchors
+        Glib::ustring                           text;          // codebox or latex content
+        std::vector<std::vector<Glib::ustring>> rows;          // table, header row first
+    };
+    struct Node
+    {
+        gint64              nodeId{0};
+        gint64              sharedNodesMasterId{0};
+        Glib::ustring       name;
+        std::string         syntax;
+        Glib::ustring       text;    // without the widgets anchors
+        std::vector<Widget> widgets; // sorted by offset
+        std::vector<Node>   children;
+    };
+
+    // only the unencrypted single file documents (ctd, ctb) can be loaded
+    static bool is_supported(const fs::path& file_path);
+    static std::unique_ptr<CtHeadlessDoc> load(const fs::path& file_path, Glib::ustring& error);
+
+    const fs::path&          get_file_path() const { return _file_path; }
+    const std::vector<Node>& get_top_nodes() const { return _topNodes; }
+
+    void          export_to_txt_auto(const fs::path& dir, bool overwrite, const CtExportOptions& export_options, const Glib::ustring& hRule) const;
+    CtSummaryInfo get_summary_info() const;
+
+private:
+    CtHeadlessDoc(const fs::path& file_path);
+
+    void _load_xml();
+    void _load_sqlite();
+    void _map_nodes_by_id();
+
+    static void _node_from_xml(const xmlpp::Element* xml_element, Node& node);
+    static void _widget_from_xml(const xmlpp::Element* xml_element, Node& node);
+    static void _table_rows_from_xml(const xmlpp::Element* xml_element, Widget& widget);
+    static void _node_from_sqlite(sqlite3* pDb, const gint64 node_id, const gint64 master_id, Node& node);
+    static void _widgets_from_sqlite(sqlite3* pDb, const gint64 node_id, Node& node);
+
+    // the shared non master nodes take the name and content from the master
+    const Node& _get_data_node(const Node& node) const;
+
+    // formatted by CtExport2Txt::node_data_to_txt_pieces as the nodes of a window
+    CtTxtNodeData _node_get_txt_data(const Node& node, const int depth, const CtExportOptions& export_options) const;
+    std::string   _node_get_txt_filename(const std::vector<const Node*>& nodesPath) const;
+
+private:
+    fs::path                                  _file_path;
+    std::vector<Node>                         _topNodes;
+    std::unordered_map<gint64, const Node*>   _nodesById;
+};
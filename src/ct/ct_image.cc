@@ -28,6 +28,8 @@
 #include "ct_logging.h"
 #include "ct_storage_control.h"
 #include "ct_storage_multifile.h"
+#include <glib/gstdio.h>
+#include <atomic>
 
 CtImage::CtImage(CtMainWin* pCtMainWin,
                  const std::string& rawBlob,
@@ -482,6 +484,412 @@ bool CtImageLatex::_on_button_press_event(GdkEventButton* event)
     return true; // do not propagate the event
 }
 
+/*static*/const size_t CtEmbFileBlob::SpillThreshold{1024u*1024u};
+
+/*static*/std::shared_ptr<const CtEmbFileBlob> CtEmbFileBlob::create(const std::string& rawBlob, const std::string& sha256sum)
+{
+    std::shared_ptr<CtEmbFileBlob> pBlob{new CtEmbFileBlob{}};
+    pBlob->_size = rawBlob.size();
+    pBlob->_sha256sum = not sha256sum.empty() ?
+        sha256sum : Glib::Checksum::compute_checksum(Glib::Checksum::ChecksumType::CHECKSUM_SHA256, rawBlob);
+    if (pBlob->_size > SpillThreshold) {
+        pBlob->_spillFilepath = _new_spill_filepath();
+        if (not pBlob->_spillFilepath.empty() and
+            not g_file_set_contents(pBlob->_spillFilepath.c_str(), rawBlob.c_str(), (gssize)rawBlob.size(), nullptr))
+        {
+            spdlog::error("!! {} {}", __FUNCTION__, pBlob->_spillFilepath);
+            pBlob->_spillFilepath.clear();
+        }
+    }
+    if (pBlob->_spillFilepath.empty()) {
+        pBlob->_rawBlob = rawBlob;
+    }
+    return pBlob;
+}
+
+/*static*/std::shared_ptr<const CtEmbFileBlob> CtEmbFileBlob::create_from_file(const std::string& filepath, const std::string& sha256sum)
+{
+    try {
+        return _create_from_file(filepath, sha256sum);
+    }
+    catch (Glib::Error& error) {
+        spdlog::error("!! {} {}", __FUNCTION__, error.what());
+    }
+    return nullptr;
+}
+
+/*static*/std::shared_ptr<const CtEmbFileBlob> CtEmbFileBlob::_create_from_file(const std::string& filepath, const std::string& sha256sum)
+{
+    const size_t fileSize = static_cast<size_t>(fs::file_size(filepath));
+    if (fileSize <= SpillThreshold) {
+        return create(Glib::file_get_contents(filepath), sha256sum);
+    }
+    std::shared_ptr<CtEmbFileBlob> pBlob{new CtEmbFileBlob{}};
+    pBlob->_size = fileSize;
+    pBlob->_spillFilepath = _new_spill_filepath();
+    // a copy rather than a hard link, the source may be later modified in place or rotated into the backups
+    if (pBlob->_spillFilepath.empty() or not fs::copy_file(filepath, pBlob->_spillFilepath)) {
+        return create(Glib::file_get_contents(filepath), sha256sum);
+    }
+    if (not sha256sum.empty()) {
+        pBlob->_sha256sum = sha256sum;
+    }
+    else {
+        Glib::Checksum checksum{Glib::Checksum::ChecksumType::CHECKSUM_SHA256};
+        (void)_read_file_chunks(pBlob->_spillFilepath, [&checksum](const char* pData, const size_t dataSize){
+            checksum.update(reinterpret_cast<const guchar*>(pData), static_cast<gsize>(dataSize));
+            return true;
+        });
+        pBlob->_sha256sum = checksum.get_string();
+    }
+    return pBlob;
+}
+
+CtEmbFileBlob::~CtEmbFileBlob()
+{
+    if (_pSqliteRows) {
+        _pSqliteRows->remove_blob(this);
+    }
+    if (not _spillFilepath.empty() and 0 != g_remove(_spillFilepath.c_str())) {
+        spdlog::debug("{} g_remove {}", __FUNCTION__, _spillFilepath);
+    }
+}
+
+const std::string& CtEmbFileBlob::get_sha256sum() const
+{
+    // not known yet for a content loaded from a sqlite row, also if detached meanwhile
+    if (_sha256sum.empty()) {
+        Glib::Checksum checksum{Glib::Checksum::ChecksumType::CHECKSUM_SHA256};
+        if (read_chunks([&checksum](const char* pData, const size_t dataSize){
+                checksum.update(reinterpret_cast<const guchar*>(pData), static_cast<gsize>(dataSize));
+                return true;
+            }))
+        {
+            _sha256sum = checksum.get_string();
+        }
+    }
+    return _sha256sum;
+}
+
+bool CtEmbFileBlob::has_same_content(const CtEmbFileBlob& other) const
+{
+    if (this == &other) {
+        return true;
+    }
+    if (_size != other._size) {
+        return false;
+    }
+    if (_inSqliteRow and other._inSqliteRow and _pSqliteRows == other._pSqliteRows and
+        _pSqliteRows->is_same_row(this, &other))
+    {
+        return true;
+    }
+    return get_sha256sum() == other.get_sha256sum();
+}
+
+std::string CtEmbFileBlob::get_raw_blob() const
+{
+    if (_inSqliteRow) {
+        std::string rawBlob;
+        rawBlob.reserve(_size);
+        if (not _pSqliteRows->read_chunks(this, [&rawBlob](const char* pData, const size_t dataSize){
+                rawBlob.append(pData, dataSize);
+                return true;
+            }))
+        {
+            return std::string{};
+        }
+        return rawBlob;
+    }
+    if (_spillFilepath.empty()) {
+        return _rawBlob;
+    }
+    try {
+        return Glib::file_get_contents(_spillFilepath);
+    }
+    catch (Glib::Error& error) {
+        spdlog::error("!! {} {}", __FUNCTION__, error.what());
+    }
+    return std::string{};
+}
+
+bool CtEmbFileBlob::write_to_file(const std::string& filepath) const
+{
+    if (_inSqliteRow) {
+        return _write_file_chunks(filepath, [this](const std::function<bool(const char* pData, const size_t dataSize)>& f_chunk){
+            return _pSqliteRows->read_chunks(this, f_chunk);
+        });
+    }
+    if (_spillFilepath.empty()) {
+        return g_file_set_contents(filepath.c_str(), _rawBlob.c_str(), (gssize)_rawBlob.size(), nullptr);
+    }
+    return fs::copy_file(_spillFilepath, filepath);
+}
+
+bool CtEmbFileBlob::read_chunks(const std::function<bool(const char* pData, const size_t dataSize)>& f_chunk) const
+{
+    if (_inSqliteRow) {
+        return _pSqliteRows->read_chunks(this, f_chunk);
+    }
+    if (_spillFilepath.empty()) {
+        return f_chunk(_rawBlob.c_str(), _rawBlob.size());
+    }
+    return _read_file_chunks(_spillFilepath, f_chunk);
+}
+
+/*static*/bool CtEmbFileBlob::_write_file_chunks(const std::string& filepath,
+                                                 const std::function<bool(const std::function<bool(const char* pData, const size_t dataSize)>& f_chunk)>& f_read_chunks)
+{
+    try {
+        Glib::RefPtr<Gio::FileOutputStream> rOutputStream = Gio::File::create_for_path(filepath)->replace();
+        const bool retVal = f_read_chunks([&rOutputStream](const char* pData, const size_t dataSize){
+            gsize bytesWritten{0};
+            return rOutputStream->write_all(pData, dataSize, bytesWritten);
+        });
+        rOutputStream->close();
+        return retVal;
+    }
+    catch (Glib::Error& error) {
+        spdlog::error("!! {} {}", __FUNCTION__, error.what());
+    }
+    return false;
+}
+
+/*static*/bool CtEmbFileBlob::_read_file_chunks(const std::string& filepath,
+                                                const std::function<bool(const char* pData, const size_t dataSize)>& f_chunk)
+{
+    try {
+        Glib::RefPtr<Gio::FileInputStream> rInputStream = Gio::File::create_for_path(filepath)->read();
+        std::vector<char> chunk(256u*1024u);
+        while (true) {
+            const gssize bytesRead = rInputStream->read(chunk.data(), chunk.size());
+            if (bytesRead <= 0) {
+                break;
+            }
+            if (not f_chunk(chunk.data(), static_cast<size_t>(bytesRead))) {
+                return false;
+            }
+        }
+        return true;
+    }
+    catch (Glib::Error& error) {
+        spdlog::error("!! {} {}", __FUNCTION__, error.what());
+    }
+    return false;
+}
+
+/*static*/std::string CtEmbFileBlob::_new_spill_filepath()
+{
+    // one directory for the whole process, removed at exit
+    struct CtSpillDir
+    {
+        CtSpillDir() {
+            gchar* pDirPath = g_dir_make_tmp("cherrytree-embfiles-XXXXXX", nullptr);
+            if (pDirPath) {
+                dirPath = pDirPath;
+                g_free(pDirPath);
+            }
+            else {
+                spdlog::error("!! g_dir_make_tmp");
+            }
+        }
+        ~CtSpillDir() {
+            if (not dirPath.empty()) {
+                (void)fs::remove_all(dirPath);
+            }
+        }
+        std::string dirPath;
+    };
+    static CtSpillDir spillDir;
+    static std::atomic<size_t> nextFileId{1};
+    if (spillDir.dirPath.empty()) {
+        return std::string{};
+    }
+    return Glib::build_filename(spillDir.dirPath, std::to_string(nextFileId++));
+}
+
+CtEmbFileSqliteRows::~CtEmbFileSqliteRows()
+{
+    if (_ownDb and _pDb) {
+        sqlite3_close(_pDb);
+    }
+}
+
+void CtEmbFileSqliteRows::set_db(sqlite3* pDb, const bool ownDb/*= false*/)
+{
+    std::lock_guard<std::mutex> lock{_mutex};
+    _pDb = pDb;
+    _ownDb = ownDb;
+}
+
+bool CtEmbFileSqliteRows::has_blobs()
+{
+    std::lock_guard<std::mutex> lock{_mutex};
+    return not _rows.empty();
+}
+
+std::shared_ptr<const CtEmbFileBlob> CtEmbFileSqliteRows::create_blob(const gint64 nodeId, const sqlite3_int64 rowId, const size_t size)
+{
+    std::shared_ptr<CtEmbFileBlob> pBlob{new CtEmbFileBlob{}};
+    pBlob->_size = size;
+    pBlob->_inSqliteRow = true;
+    pBlob->_pSqliteRows = shared_from_this();
+    std::lock_guard<std::mutex> lock{_mutex};
+    _rows[pBlob.get()] = CtRow{nodeId, rowId};
+    return pBlob;
+}
+
+bool CtEmbFileSqliteRows::is_same_row(const CtEmbFileBlob* pBlob, const CtEmbFileBlob* pOtherBlob)
+{
+    std::unique_lock<std::mutex> lock = _lock_no_vacuum();
+    auto itRow = _rows.find(pBlob);
+    auto itOtherRow = _rows.find(pOtherBlob);
+    return _rows.end() != itRow and _rows.end() != itOtherRow and
+           0 != itRow->second.rowId and itRow->second.rowId == itOtherRow->second.rowId;
+}
+
+bool CtEmbFileSqliteRows::read_chunks(const CtEmbFileBlob* pBlob, const std::function<bool(const char* pData, const size_t dataSize)>& f_chunk)
+{
+    std::unique_lock<std::mutex> lock = _lock_no_vacuum();
+    auto itRow = _rows.find(pBlob);
+    if (_rows.end() == itRow or 0 == itRow->second.rowId) {
+        spdlog::error("!! {} row lost", __FUNCTION__);
+        return false;
+    }
+    return _read_row_chunks(itRow->second.rowId, f_chunk);
+}
+
+void CtEmbFileSqliteRows::remove_blob(const CtEmbFileBlob* pBlob)
+{
+    std::lock_guard<std::mutex> lock{_mutex};
+    _rows.erase(pBlob);
+}
+
+void CtEmbFileSqliteRows::detach_row(const sqlite3_int64 rowId)
+{
+    std::unique_lock<std::mutex> lock = _lock_no_vacuum();
+    _detach_if([rowId](const CtRow& row){ return rowId == row.rowId; });
+}
+
+void CtEmbFileSqliteRows::detach_node(const gint64 nodeId)
+{
+    std::unique_lock<std::mutex> lock = _lock_no_vacuum();
+    _detach_if([nodeId](const CtRow& row){ return nodeId == row.nodeId; });
+}
+
+bool CtEmbFileSqliteRows::remap_rowids(const std::function<bool()>& f_vacuum)
+{
+    bool remap{false};
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        remap = _vacuuming = _pDb and not _rows.empty();
+        if (remap) {
+            Sqlite3StmtAuto stmt{_pDb, "SELECT offset FROM image WHERE rowid=?"};
+            for (auto& currPair : _rows) {
+                sqlite3_reset(stmt);
+                sqlite3_bind_int64(stmt, 1, currPair.second.rowId);
+                currPair.second.charOffset = SQLITE_ROW == sqlite3_step(stmt) ? sqlite3_column_int(stmt, 0) : -1;
+            }
+        }
+    }
+    if (not remap) {
+        return f_vacuum();
+    }
+    // the reads wait meanwhile, the blobs can still go
+    const bool vacuumed = f_vacuum();
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        if (vacuumed) {
+            Sqlite3StmtAuto stmt{_pDb, "SELECT rowid FROM image WHERE node_id=? AND offset=?"};
+            for (auto& currPair : _rows) {
+                sqlite3_reset(stmt);
+                sqlite3_bind_int64(stmt, 1, currPair.second.nodeId);
+                sqlite3_bind_int64(stmt, 2, currPair.second.charOffset);
+                currPair.second.rowId = SQLITE_ROW == sqlite3_step(stmt) ? sqlite3_column_int64(stmt, 0) : 0;
+                if (0 == currPair.second.rowId) {
+                    spdlog::error("!! {} node {} offset {}", __FUNCTION__, currPair.second.nodeId, currPair.second.charOffset);
+                }
+            }
+        }
+        _vacuuming = false;
+    }
+    _cvNoVacuum.notify_all();
+    return vacuumed;
+}
+
+std::unique_lock<std::mutex> CtEmbFileSqliteRows::_lock_no_vacuum()
+{
+    std::unique_lock<std::mutex> lock{_mutex};
+    _cvNoVacuum.wait(lock, [this](){ return not _vacuuming; });
+    return lock;
+}
+
+bool CtEmbFileSqliteRows::_read_row_chunks(const sqlite3_int64 rowId, const std::function<bool(const char* pData, const size_t dataSize)>& f_chunk)
+{
+    if (not _pDb) {
+        spdlog::error("!! {} db closed", __FUNCTION__);
+        return false;
+    }
+    sqlite3_blob* pSqliteBlob{nullptr};
+    if (sqlite3_blob_open(_pDb, "main", "image", "png", rowId, 0/*read-only*/, &pSqliteBlob) != SQLITE_OK) {
+        spdlog::error("!! sqlite3_blob_open: {}", sqlite3_errmsg(_pDb));
+        return false;
+    }
+    const int blobSize = sqlite3_blob_bytes(pSqliteBlob);
+    std::vector<char> chunk(256u*1024u);
+    bool retVal{true};
+    for (int offset = 0; retVal and offset < blobSize;) {
+        const int chunkSize = std::min(blobSize - offset, static_cast<int>(chunk.size()));
+        if (sqlite3_blob_read(pSqliteBlob, chunk.data(), chunkSize, offset) != SQLITE_OK) {
+            spdlog::error("!! sqlite3_blob_read: {}", sqlite3_errmsg(_pDb));
+            retVal = false;
+            break;
+        }
+        retVal = f_chunk(chunk.data(), static_cast<size_t>(chunkSize));
+        offset += chunkSize;
+    }
+    sqlite3_blob_close(pSqliteBlob);
+    return retVal;
+}
+
+void CtEmbFileSqliteRows::_detach_if(const std::function<bool(const CtRow&)>& f_match)
+{
+    for (auto itRow = _rows.begin(); itRow != _rows.end();) {
+        if (not f_match(itRow->second)) {
+            ++itRow;
+            continue;
+        }
+        const CtEmbFileBlob* pBlob = itRow->first;
+        const sqlite3_int64 rowId = itRow->second.rowId;
+        bool detached{false};
+        if (pBlob->_size > CtEmbFileBlob::SpillThreshold) {
+            std::string spillFilepath = CtEmbFileBlob::_new_spill_filepath();
+            if (not spillFilepath.empty() and
+                CtEmbFileBlob::_write_file_chunks(spillFilepath, [this, rowId](const std::function<bool(const char* pData, const size_t dataSize)>& f_chunk){
+                    return _read_row_chunks(rowId, f_chunk);
+                }))
+            {
+                pBlob->_spillFilepath = spillFilepath;
+                detached = true;
+            }
+        }
+        if (not detached) {
+            std::string rawBlob;
+            rawBlob.reserve(pBlob->_size);
+            detached = _read_row_chunks(rowId, [&rawBlob](const char* pData, const size_t dataSize){
+                rawBlob.append(pData, dataSize);
+                return true;
+            });
+            pBlob->_rawBlob = std::move(rawBlob);
+        }
+        if (not detached) {
+            spdlog::error("!! {} row {}", __FUNCTION__, rowId);
+        }
+        pBlob->_inSqliteRow = false;
+        itRow = _rows.erase(itRow);
+    }
+}
+
 /*static*/size_t CtImageEmbFile::get_next_unique_id()
 {
     static size_t next_unique_id{1};
@@ -490,14 +898,14 @@ bool CtImageLatex::_on_button_press_event(GdkEventButton* event)
 
 CtImageEmbFile::CtImageEmbFile(CtMainWin* pCtMainWin,
                                const fs::path& fileName,
-                               const std::string& rawBlob,
+                               std::shared_ptr<const CtEmbFileBlob> pBlob,
                                const time_t timeSeconds,
                                const int charOffset,
                                const std::string& justification,
                                const size_t uniqueId)
  : CtImage{pCtMainWin, _get_file_icon(pCtMainWin, fileName), charOffset, justification}
  , _fileName{fileName}
- , _rawBlob{rawBlob}
+ , _pBlob{pBlob}
  , _timeSeconds{timeSeconds}
  , _uniqueId{uniqueId}
 {
@@ -517,12 +925,16 @@ void CtImageEmbFile::to_xml(xmlpp::Element* p_node_parent,
     p_image_node->set_attribute("filename", _fileName.string());
     p_image_node->set_attribute("time", std::to_string(_timeSeconds));
     if (multifile_dir.empty()) {
-        const std::string encodedBlob = Glib::Base64::encode(_rawBlob);
+        const std::string encodedBlob = Glib::Base64::encode(_pBlob->get_raw_blob());
         p_image_node->add_child_text(encodedBlob);
     }
     else {
-        const std::string sha256sum = CtStorageMultiFile::save_blob(_rawBlob, multifile_dir, _fileName.extension());
-        p_image_node->set_attribute("sha256sum", sha256sum);
+        // an unchanged blob is already in the node directory and is neither hashed nor read
+        std::shared_ptr<const CtEmbFileBlob> pBlob = _pBlob;
+        CtStorageMultiFile::save_blob_sha256sum(pBlob->get_sha256sum(), multifile_dir, _fileName.extension(), [pBlob](const std::string& filepath){
+            return pBlob->write_to_file(filepath);
+        });
+        p_image_node->set_attribute("sha256sum", pBlob->get_sha256sum());
     }
 }
 
@@ -540,7 +952,14 @@ bool CtImageEmbFile::to_sqlite(sqlite3* pDb, const gint64 node_id, const int off
         sqlite3_bind_int64(p_stmt, 2, _charOffset+offset_adjustment);
         sqlite3_bind_text(p_stmt, 3, _justification.c_str(), _justification.size(), SQLITE_STATIC);
         sqlite3_bind_text(p_stmt, 4, "", -1, SQLITE_STATIC); // anchor
-        sqlite3_bind_blob(p_stmt, 5, _rawBlob.c_str(), _rawBlob.size(), SQLITE_STATIC);
+        if (_pBlob->is_spilled() or _pBlob->is_in_sqlite_row()) {
+            // the spilled content or the one in another row is streamed into the row below rather than read in memory
+            sqlite3_bind_zeroblob64(p_stmt, 5, _pBlob->size());
+        }
+        else {
+            const std::string rawBlob = _pBlob->get_raw_blob();
+            sqlite3_bind_blob(p_stmt, 5, rawBlob.c_str(), rawBlob.size(), SQLITE_TRANSIENT);
+        }
         sqlite3_bind_text(p_stmt, 6, file_name.c_str(), file_name.size(), SQLITE_STATIC);
         sqlite3_bind_text(p_stmt, 7, "", -1, SQLITE_STATIC); // link
         sqlite3_bind_int64(p_stmt, 8, _timeSeconds);
@@ -549,10 +968,33 @@ bool CtImageEmbFile::to_sqlite(sqlite3* pDb, const gint64 node_id, const int off
             retVal = false;
         }
         sqlite3_finalize(p_stmt);
+        if (retVal and (_pBlob->is_spilled() or _pBlob->is_in_sqlite_row())) {
+            retVal = _blob_stream_to_sqlite(pDb, sqlite3_last_insert_rowid(pDb));
+        }
     }
     return retVal;
 }
 
+bool CtImageEmbFile::_blob_stream_to_sqlite(sqlite3* pDb, const sqlite3_int64 rowId)
+{
+    sqlite3_blob* pSqliteBlob{nullptr};
+    if (sqlite3_blob_open(pDb, "main", "image", "png", rowId, 1/*read-write*/, &pSqliteBlob) != SQLITE_OK) {
+        spdlog::error("!! sqlite3_blob_open: {}", sqlite3_errmsg(pDb));
+        return false;
+    }
+    int offset{0};
+    const bool retVal = _pBlob->read_chunks([&](const char* pData, const size_t dataSize){
+        if (sqlite3_blob_write(pSqliteBlob, pData, static_cast<int>(dataSize), offset) != SQLITE_OK) {
+            spdlog::error("!! sqlite3_blob_write: {}", sqlite3_errmsg(pDb));
+            return false;
+        }
+        offset += static_cast<int>(dataSize);
+        return true;
+    });
+    sqlite3_blob_close(pSqliteBlob);
+    return retVal;
+}
+
 std::shared_ptr<CtAnchoredWidgetState> CtImageEmbFile::get_state()
 {
     return std::shared_ptr<CtAnchoredWidgetState>(new CtAnchoredWidgetState_EmbFile{this});
@@ -573,7 +1015,7 @@ void CtImageEmbFile::update_label_widget()
 void CtImageEmbFile::update_tooltip()
 {
     char humanReadableSize[16];
-    const size_t embfileBytes{_rawBlob.size()};
+    const size_t embfileBytes{_pBlob->size()};
     const double embfileKbytes{static_cast<double>(embfileBytes)/1024};
     const double embfileMbytes{embfileKbytes/1024};
     if (embfileMbytes > 1) {
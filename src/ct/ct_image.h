@@ -27,6 +27,11 @@
 #include "ct_const.h"
 #include "ct_codebox.h"
 #include "ct_widgets.h"
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 class CtImage : public CtAnchoredWidget
 {
@@ -55,6 +60,8 @@ public:
     Glib::RefPtr<Gdk::Pixbuf> get_pixbuf() const { return _rPixbuf; }
 
 protected:
+    bool _has_content_generation() const override { return true; }
+
     Gtk::Image _image;
     Glib::RefPtr<Gdk::Pixbuf> _rPixbuf;
 };
@@ -82,7 +89,7 @@ public:
     const std::string get_raw_blob();
     void update_label_widget();
     const Glib::ustring& get_link() { return _link; }
-    void set_link(const Glib::ustring& link) { _link = link; }
+    void set_link(const Glib::ustring& link) { _link = link; _content_changed(); }
 
 private:
     bool _on_button_press_event(GdkEventButton* event);
@@ -160,12 +167,105 @@ protected:
     const size_t  _uniqueId;
 };
 
+class CtEmbFileSqliteRows;
+
+// Immutable content of an embedded file, shared by the widget and its undo states.
+// Contents larger than SpillThreshold are kept in a temporary file instead of in memory,
+// contents loaded from a sqlite document stay in their row; both are read back only
+// to open/save/export them; the sha256sum is computed once so that change detection
+// and the multifile dedup never need the bytes more than once
+class CtEmbFileBlob
+{
+    friend class CtEmbFileSqliteRows;
+public:
+    static const size_t SpillThreshold;
+
+    static std::shared_ptr<const CtEmbFileBlob> create(const std::string& rawBlob, const std::string& sha256sum = "");
+    // the file is not read in memory if larger than SpillThreshold but copied; a known sha256sum
+    // (multifile blob) is not computed again; nullptr if the file cannot be read
+    static std::shared_ptr<const CtEmbFileBlob> create_from_file(const std::string& filepath, const std::string& sha256sum = "");
+
+    CtEmbFileBlob(const CtEmbFileBlob&) = delete;
+    CtEmbFileBlob& operator=(const CtEmbFileBlob&) = delete;
+    ~CtEmbFileBlob();
+
+    size_t             size() const { return _size; }
+    // read in chunks the first time for a content loaded from a sqlite row
+    const std::string& get_sha256sum() const;
+    bool               is_spilled() const { return not _spillFilepath.empty(); }
+    const std::string& get_spill_filepath() const { return _spillFilepath; }
+    bool               is_in_sqlite_row() const { return _inSqliteRow; }
+    bool               has_same_content(const CtEmbFileBlob& other) const;
+    std::string        get_raw_blob() const;
+    bool               write_to_file(const std::string& filepath) const;
+    // the content in consecutive chunks, without the whole of it in memory if spilled or in a sqlite row
+    bool               read_chunks(const std::function<bool(const char* pData, const size_t dataSize)>& f_chunk) const;
+
+private:
+    CtEmbFileBlob() {}
+    static std::shared_ptr<const CtEmbFileBlob> _create_from_file(const std::string& filepath, const std::string& sha256sum);
+    static std::string _new_spill_filepath();
+    static bool _read_file_chunks(const std::string& filepath, const std::function<bool(const char* pData, const size_t dataSize)>& f_chunk);
+    static bool _write_file_chunks(const std::string& filepath,
+                                   const std::function<bool(const std::function<bool(const char* pData, const size_t dataSize)>& f_chunk)>& f_read_chunks);
+
+    size_t                               _size{0};
+    mutable std::string                  _sha256sum;
+    mutable std::string                  _rawBlob; // raw data, not a string; empty if spilled or in a sqlite row
+    mutable std::string                  _spillFilepath;
+    mutable bool                         _inSqliteRow{false}; // until detached
+    std::shared_ptr<CtEmbFileSqliteRows> _pSqliteRows;
+};
+
+// The rows of a sqlite document holding the content of live embedded file blobs, shared by the
+// storage and the blobs. The storage detaches the blobs before deleting their rows, has the rowids
+// remapped around a VACUUM and leaves the connection to the blobs if still in use when it goes
+class CtEmbFileSqliteRows : public std::enable_shared_from_this<CtEmbFileSqliteRows>
+{
+public:
+    ~CtEmbFileSqliteRows();
+
+    // nullptr while the storage connection is closed; an owned connection is closed with this
+    void set_db(sqlite3* pDb, const bool ownDb = false);
+    bool has_blobs();
+
+    std::shared_ptr<const CtEmbFileBlob> create_blob(const gint64 nodeId, const sqlite3_int64 rowId, const size_t size);
+    bool is_same_row(const CtEmbFileBlob* pBlob, const CtEmbFileBlob* pOtherBlob);
+    bool read_chunks(const CtEmbFileBlob* pBlob, const std::function<bool(const char* pData, const size_t dataSize)>& f_chunk);
+    void remove_blob(const CtEmbFileBlob* pBlob);
+
+    // the content still in use goes in memory or in a spill file before the rows are deleted
+    void detach_row(const sqlite3_int64 rowId);
+    void detach_node(const gint64 nodeId);
+
+    // f_vacuum may renumber the rowids, the rows are then found again by node_id and offset
+    bool remap_rowids(const std::function<bool()>& f_vacuum);
+
+private:
+    struct CtRow
+    {
+        gint64        nodeId{0};
+        sqlite3_int64 rowId{0};  // 0 if lost
+        int           charOffset{-1}; // only around a VACUUM
+    };
+    std::unique_lock<std::mutex> _lock_no_vacuum();
+    bool _read_row_chunks(const sqlite3_int64 rowId, const std::function<bool(const char* pData, const size_t dataSize)>& f_chunk);
+    void _detach_if(const std::function<bool(const CtRow&)>& f_match);
+
+    std::mutex              _mutex; // the VACUUM runs in a worker thread
+    std::condition_variable _cvNoVacuum;
+    bool                    _vacuuming{false};
+    sqlite3*                _pDb{nullptr};
+    bool                    _ownDb{false};
+    std::unordered_map<const CtEmbFileBlob*, CtRow> _rows;
+};
+
 class CtImageEmbFile : public CtImage
 {
 public:
     CtImageEmbFile(CtMainWin* pCtMainWin,
                    const fs::path& fileName,
-                   const std::string& rawBlob,
+                   std::shared_ptr<const CtEmbFileBlob> pBlob,
                    const time_t timeSeconds,
                    const int charOffset,
                    const std::string& justification,
@@ -178,11 +278,11 @@ public:
     std::shared_ptr<CtAnchoredWidgetState> get_state() override;
 
     const fs::path&      get_file_name() const { return _fileName; }
-    void                 set_file_name(const fs::path& path) { _fileName = path; }
-    const std::string&   get_raw_blob() { return _rawBlob; }
-    void                 set_raw_blob(const std::string& buffer) { _rawBlob = buffer; }
+    void                 set_file_name(const fs::path& path) { _fileName = path; _content_changed(); }
+    const std::shared_ptr<const CtEmbFileBlob>& get_blob() const { return _pBlob; }
+    void                 set_blob(std::shared_ptr<const CtEmbFileBlob> pBlob) { _pBlob = pBlob; _content_changed(); }
     time_t               get_time() { return _timeSeconds; }
-    void                 set_time(const time_t time) { _timeSeconds = time; }
+    void                 set_time(const time_t time) { _timeSeconds = time; _content_changed(); }
     size_t               get_unique_id() { return _uniqueId; }
 
     static size_t        get_next_unique_id();
@@ -195,10 +295,11 @@ private:
 
 private:
     bool _on_button_press_event(GdkEventButton* event);
+    bool _blob_stream_to_sqlite(sqlite3* pDb, const sqlite3_int64 rowId);
 
 protected:
     fs::path      _fileName;
-    std::string   _rawBlob;      // raw data, not a string
+    std::shared_ptr<const CtEmbFileBlob> _pBlob;
     time_t        _timeSeconds;
     const size_t  _uniqueId;
 };
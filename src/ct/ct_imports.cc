@@ -28,6 +28,8 @@
 #include "ct_export2html.h"
 #include "ct_logging.h"
 #include <libxml2/libxml/SAX.h>
+#include <atomic>
+#include <thread>
 
 namespace {
 
@@ -37,6 +39,58 @@ xmlpp::Element* create_root_plaintext_text_el(xmlpp::Document& doc, const Glib::
     return el;
 }
 
+// two cases:
+// 1. children with the same names, one with content and other as dir, join them
+// 2. dir contains  note with the same name, join them (from keepnote)
+void join_dir_subnodes(std::unique_ptr<CtImportedNode>& dir_node)
+{
+    std::function<void(std::unique_ptr<CtImportedNode>&)> join_subdir_subnote;
+    join_subdir_subnote = [&](std::unique_ptr<CtImportedNode>& node) {
+        for (auto iter1 = node->children.begin(); iter1 != node->children.end(); ++iter1)
+        {
+            if ((*iter1)->has_content() && (*iter1)->children.empty()) // node with content
+            {
+                for (auto iter2 = node->children.begin(); iter2 != node->children.end(); ++iter2)
+                {
+                    if (!(*iter2)->has_content()) // dir node
+                    {
+                        if (iter1->get() == iter2->get()) continue; // same node?
+                        if ((*iter1)->node_name == (*iter2)->node_name)
+                        {
+                            std::swap((*iter1)->children, (*iter2)->children);
+                            node->children.erase(iter2);
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        for (auto& child: node->children)
+            join_subdir_subnote(child);
+    };
+
+    std::function<void(std::unique_ptr<CtImportedNode>&)> join_parent_dir_subnote;
+    join_parent_dir_subnote = [&](std::unique_ptr<CtImportedNode>& node) {
+        if (!node->has_content())
+        {
+            for (auto iter = node->children.begin(); iter != node->children.end(); ++iter)
+            {
+                if ((*iter)->has_content() && (*iter)->children.empty() && node->node_name == (*iter)->node_name)
+                {
+                    node->copy_content((*iter));
+                    node->children.erase(iter);
+                    break;
+                }
+            }
+        }
+        for (auto& child: node->children)
+            join_parent_dir_subnote(child);
+    };
+
+    join_subdir_subnote(dir_node);
+    join_parent_dir_subnote(dir_node);
+}
+
 } // namespace (anonymous)
 
 namespace CtXML {
@@ -166,75 +220,125 @@ std::vector<std::pair<size_t, size_t>> CtImports::get_web_links_offsets_from_pla
     return web_links;
 }
 
-std::unique_ptr<CtImportedNode> CtImports::traverse_dir(const fs::path& dir, CtImporterInterface* importer)
+std::unique_ptr<CtImportedNode> CtImports::traverse_dir(const fs::path& dir, CtImporterInterface* importer, CtStatusBar* pStatusBar)
 {
-    auto dir_node = std::make_unique<CtImportedNode>(dir, dir.filename().string());
-    for (const auto& dir_item: fs::get_dir_entries(dir))
-    {
-        if (fs::is_directory(dir_item))
-        {
-            if (auto node = traverse_dir(dir_item, importer))
-                dir_node->children.emplace_back(std::move(node));
-        }
-        else if (auto node = importer->import_file(dir_item))
-            dir_node->children.emplace_back(std::move(node));
-    }
-
-    // skip empty dirs
-    if (dir_node->children.empty())
-        return nullptr;
-
-    // not the best place but
-    // two cases:
-    // 1. children with the same names, one with content and other as dir, join them
-    // 2. dir contains  note with the same name, join them (from keepnote)
-
-    std::function<void(std::unique_ptr<CtImportedNode>&)> join_subdir_subnote;
-    join_subdir_subnote = [&](std::unique_ptr<CtImportedNode>& node) {
-        for (auto iter1 = node->children.begin(); iter1 != node->children.end(); ++iter1)
+    // 1. scan the directory tree, the file nodes are left empty to be imported later
+    std::unordered_set<CtImportedNode*> dir_nodes;
+    std::vector<std::pair<fs::path, std::unique_ptr<CtImportedNode>*>> files_to_import;
+    std::function<void(std::unique_ptr<CtImportedNode>&)> f_scan_dir;
+    f_scan_dir = [&](std::unique_ptr<CtImportedNode>& dir_node) {
+        dir_nodes.insert(dir_node.get());
+        for (const auto& dir_item: fs::get_dir_entries(dir_node->path))
         {
-            if ((*iter1)->has_content() && (*iter1)->children.empty()) // node with content
+            if (fs::is_directory(dir_item))
             {
-                for (auto iter2 = node->children.begin(); iter2 != node->children.end(); ++iter2)
-                {
-                    if (!(*iter2)->has_content()) // dir node
-                    {
-                        if (iter1->get() == iter2->get()) continue; // same node?
-                        if ((*iter1)->node_name == (*iter2)->node_name)
-                        {
-                            std::swap((*iter1)->children, (*iter2)->children);
-                            node->children.erase(iter2);
-                            break;
-                        }
-                    }
-                }
+                dir_node->children.emplace_back(std::make_unique<CtImportedNode>(dir_item, dir_item.filename().string()));
+                f_scan_dir(dir_node->children.back());
+            }
+            else
+            {
+                dir_node->children.emplace_back(nullptr);
+                files_to_import.emplace_back(dir_item, &dir_node->children.back());
             }
         }
-        for (auto& child: node->children)
-            join_subdir_subnote(child);
     };
+    auto dir_node = std::make_unique<CtImportedNode>(dir, dir.filename().string());
+    f_scan_dir(dir_node);
 
-    std::function<void(std::unique_ptr<CtImportedNode>&)> join_parent_dir_subnote;
-    join_parent_dir_subnote = [&](std::unique_ptr<CtImportedNode>& node) {
-        if (!node->has_content())
-        {
-            for (auto iter = node->children.begin(); iter != node->children.end(); ++iter)
-            {
-                if ((*iter)->has_content() && (*iter)->children.empty() && node->node_name == (*iter)->node_name)
-                {
-                    node->copy_content((*iter));
-                    node->children.erase(iter);
-                    break;
-                }
-            }
+    // 2. import the files on worker threads, each with its own importer
+    std::atomic<size_t> next_file{0};
+    std::atomic<size_t> done_files{0};
+    std::atomic<bool> stop{false};
+    auto f_import_file = [&](CtImporterInterface* worker_importer, const size_t i) {
+        try {
+            *files_to_import[i].second = worker_importer->import_file(files_to_import[i].first);
         }
-        for (auto& child: node->children)
-            join_parent_dir_subnote(child);
+        catch (std::exception& ex) {
+            spdlog::error("{} {}: {}", __FUNCTION__, files_to_import[i].first, ex.what());
+        }
+        ++done_files;
     };
+    auto f_import_files = [&](CtImporterInterface* worker_importer) {
+        for (size_t i = next_file++; i < files_to_import.size() and not stop; i = next_file++) {
+            f_import_file(worker_importer, i);
+        }
+    };
+    std::vector<std::unique_ptr<CtImporterInterface>> worker_importers;
+    size_t concur_num = std::thread::hardware_concurrency();
+    if (concur_num == 0) concur_num = 4;
+    concur_num = std::min(concur_num, files_to_import.size());
+    for (size_t i = 0; i < concur_num; ++i) {
+        std::unique_ptr<CtImporterInterface> worker_importer = importer->clone();
+        if (not worker_importer) {
+            break; // the importer is not able to run in parallel
+        }
+        worker_importers.push_back(std::move(worker_importer));
+    }
+    if (pStatusBar) {
+        pStatusBar->progressBar.set_fraction(0);
+        pStatusBar->progressBar.set_text("0/" + std::to_string(files_to_import.size()));
+        pStatusBar->progressBar.show();
+        pStatusBar->stopButton.show();
+        pStatusBar->set_progress_stop(false);
+        while (gtk_events_pending()) gtk_main_iteration();
+    }
+    auto f_update_progress = [&]() {
+        if (not pStatusBar) return;
+        const size_t done = done_files;
+        pStatusBar->progressBar.set_fraction(files_to_import.empty() ? 1.0 : (double)done/files_to_import.size());
+        pStatusBar->progressBar.set_text(std::to_string(done) + "/" + std::to_string(files_to_import.size()));
+        while (gtk_events_pending()) gtk_main_iteration();
+        if (pStatusBar->is_progress_stop()) stop = true;
+    };
+    if (worker_importers.empty()) {
+        // one file at a time with the progress in between
+        for (size_t i = 0; i < files_to_import.size() and not stop; ++i) {
+            f_import_file(importer, i);
+            f_update_progress();
+        }
+    }
+    else {
+        std::list<std::thread> td_tasks;
+        for (auto& worker_importer : worker_importers) {
+            td_tasks.emplace_back(f_import_files, worker_importer.get());
+        }
+        while (done_files < files_to_import.size() and not stop) {
+            f_update_progress();
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        for (auto& task: td_tasks)
+            task.join();
+    }
+    if (pStatusBar) {
+        pStatusBar->progressBar.hide();
+        pStatusBar->stopButton.hide();
+        pStatusBar->set_progress_stop(false);
+    }
+    if (stop) {
+        spdlog::debug("{} stopped", __FUNCTION__);
+        return nullptr;
+    }
 
-    join_subdir_subnote(dir_node);
-    join_parent_dir_subnote(dir_node);
+    // 3. drop the files that were not imported and the empty dirs, bottom up
+    std::function<bool(std::unique_ptr<CtImportedNode>&)> f_finalise_dir;
+    f_finalise_dir = [&](std::unique_ptr<CtImportedNode>& node) {
+        for (auto iter = node->children.begin(); iter != node->children.end(); )
+        {
+            if (not *iter or (dir_nodes.count(iter->get()) and not f_finalise_dir(*iter)))
+                iter = node->children.erase(iter);
+            else
+                ++iter;
+        }
 
+        // skip empty dirs
+        if (node->children.empty())
+            return false;
+
+        join_dir_subnodes(node);
+        return true;
+    };
+    if (not f_finalise_dir(dir_node))
+        return nullptr;
     return dir_node;
 }
 
@@ -415,7 +519,7 @@ xmlpp::Element* CtTomboyImport::_rich_text_serialize(const Glib::ustring& text_d
     return dom_iter;
 }
 
-CtZimImport::CtZimImport(CtConfig* config) : _zim_parser{std::make_unique<CtZimParser>(config)} {}
+CtZimImport::CtZimImport(CtConfig* config) : _config{config}, _zim_parser{std::make_unique<CtZimParser>(config)} {}
 
 std::unique_ptr<CtImportedNode> CtZimImport::import_file(const fs::path& file)
 {
@@ -457,7 +561,7 @@ std::unique_ptr<CtImportedNode> CtPlainTextImport::import_file(const fs::path& f
     return nullptr;
 }
 
-CtMDImport::CtMDImport(CtConfig* config) : _parser{std::make_unique<CtMDParser>(config)}
+CtMDImport::CtMDImport(CtConfig* config) : _config{config}, _parser{std::make_unique<CtMDParser>(config)}
 {
 }
 
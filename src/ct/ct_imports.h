@@ -68,7 +68,11 @@ struct CtImportedNode
 class CtImporterInterface
 {
 public:
+    virtual ~CtImporterInterface() = default;
+
     virtual std::unique_ptr<CtImportedNode> import_file(const fs::path& file) = 0;
+    // importer with the same settings for a worker thread, nullptr if the files are to be imported one at a time
+    virtual std::unique_ptr<CtImporterInterface> clone() { return nullptr; }
     virtual std::string                     file_pattern_name() { return ""; }
     virtual std::vector<Glib::ustring>      file_patterns() { return {}; }
     virtual std::vector<Glib::ustring>      file_mime_types() { return {}; }
@@ -86,15 +90,17 @@ public:
 #endif
 };
 
+struct CtStatusBar;
+
 namespace CtImports {
 
 std::vector<std::pair<size_t, size_t>> get_web_links_offsets_from_plain_text(const Glib::ustring& plain_text);
-std::unique_ptr<CtImportedNode> traverse_dir(const fs::path& dir, CtImporterInterface* importer);
+// the directory tree is scanned first and then the files are imported on worker threads,
+// with the status bar the progress is shown and the stop button cancels the import (nullptr returned)
+std::unique_ptr<CtImportedNode> traverse_dir(const fs::path& dir, CtImporterInterface* importer, CtStatusBar* pStatusBar = nullptr);
 
 } // namespace CtImports
 
-struct CtStatusBar;
-
 namespace CtXML {
 
 xmlpp::Element* codebox_to_xml(xmlpp::Element* parent, const Glib::ustring& justification, int char_offset, int frame_width, int frame_height, int width_in_pixels, const Glib::ustring& syntax_highlighting, bool highlight_brackets, bool show_line_numbers);
@@ -121,6 +127,7 @@ public:
 
     // virtuals of CtImporterInterface
     std::unique_ptr<CtImportedNode> import_file(const fs::path& file) override;
+    std::unique_ptr<CtImporterInterface> clone() override { return std::make_unique<CtHtmlImport>(_config); }
 
 private:
     CtConfig* _config;
@@ -161,10 +168,12 @@ public:
 
     // virtuals of CtImporterInterface
     std::unique_ptr<CtImportedNode> import_file(const fs::path& file) override;
+    std::unique_ptr<CtImporterInterface> clone() override { return std::make_unique<CtZimImport>(_config); }
 
     ~CtZimImport();
 
 private:
+    CtConfig*                    _config;
     std::unique_ptr<CtZimParser> _zim_parser;
 };
 
@@ -175,6 +184,7 @@ public:
 
     // virtuals of CtImporterInterface
     std::unique_ptr<CtImportedNode> import_file(const fs::path& file) override;
+    std::unique_ptr<CtImporterInterface> clone() override { return std::make_unique<CtPlainTextImport>(nullptr); }
     std::string                     file_pattern_name() override { return _("Plain Text Document"); }
 #ifdef _WIN32
     std::vector<Glib::ustring>      file_patterns() override { return {"*.txt"}; }
@@ -192,10 +202,12 @@ public:
 
     // virtuals of CtImporterInterface
     std::unique_ptr<CtImportedNode> import_file(const fs::path& file) override;
+    std::unique_ptr<CtImporterInterface> clone() override { return std::make_unique<CtMDImport>(_config); }
     std::vector<Glib::ustring>        file_patterns() override { return {"*.md"}; };
     std::string                       file_pattern_name() override { return _("Markdown Document"); }
 
 private:
+    CtConfig*                   _config;
     std::unique_ptr<CtMDParser> _parser;
 };
 
@@ -25,6 +25,8 @@
 #include "ct_actions.h"
 #include "ct_storage_control.h"
 #include "ct_clipboard.h"
+#include "ct_text_stats.h"
+#include "ct_trace.h"
 
 CtMainWin::CtMainWin(bool                            no_gui,
                      CtConfig*                       pCtConfig,
@@ -47,6 +49,7 @@ CtMainWin::CtMainWin(bool                            no_gui,
  , _pCtStatusIcon{pCtStatusIcon}
  , _ctTextview{this}
  , _ctStateMachine{this}
+ , _nodesBuffersLru{this}
 {
     get_style_context()->add_class("ct-app-win");
     set_icon(_pGtkIconTheme->load_icon(CtConst::APP_NAME, 48));
@@ -309,6 +312,7 @@ void CtMainWin::config_apply()
     _ctWinHeader.lockIcon.hide();
     _ctWinHeader.bookmarkIcon.hide();
     _ctWinHeader.ghostIcon.hide();
+    _ctWinHeader.largeDocIcon.hide();
 
     menu_rebuild_toolbars(false);
     show_hide_statusbar(_pCtConfig->statusbarVisible);
@@ -443,11 +447,15 @@ Gtk::EventBox& CtMainWin::_init_window_header()
     _ctWinHeader.bookmarkIcon.hide();
     _ctWinHeader.ghostIcon.set_from_icon_name("ct_ghost", Gtk::ICON_SIZE_MENU);
     _ctWinHeader.ghostIcon.hide();
+    _ctWinHeader.largeDocIcon.set_from_icon_name("ct_warning", Gtk::ICON_SIZE_MENU);
+    _ctWinHeader.largeDocIcon.set_tooltip_text(_("Large Document: syntax highlighting, spell check and line wrapping are limited"));
+    _ctWinHeader.largeDocIcon.hide();
     _ctWinHeader.headerBox.pack_start(_ctWinHeader.buttonBox, false, false);
     _ctWinHeader.headerBox.pack_start(_ctWinHeader.nameLabel, true, true);
     _ctWinHeader.headerBox.pack_start(_ctWinHeader.lockIcon, false, false);
     _ctWinHeader.headerBox.pack_start(_ctWinHeader.bookmarkIcon, false, false);
     _ctWinHeader.headerBox.pack_start(_ctWinHeader.ghostIcon, false, false);
+    _ctWinHeader.headerBox.pack_start(_ctWinHeader.largeDocIcon, false, false);
     _ctWinHeader.eventBox.add(_ctWinHeader.headerBox);
     _ctWinHeader.eventBox.get_style_context()->add_class("ct-header-panel");
     return _ctWinHeader.eventBox;
@@ -534,6 +542,11 @@ void CtMainWin::window_header_update_bookmark_icon(const bool show)
     _ctWinHeader.bookmarkIcon.set_visible(show);
 }
 
+void CtMainWin::window_header_update_large_doc_icon(const bool show)
+{
+    _ctWinHeader.largeDocIcon.set_visible(show);
+}
+
 void CtMainWin::menu_top_optional_bookmarks_enforce()
 {
     auto pBookmarksMenu = dynamic_cast<Gtk::Widget*>(_pBookmarksSubmenus[2]);
@@ -690,6 +703,7 @@ void CtMainWin::reset()
     user_active() = false;
 
     _ctStateMachine.reset();
+    _nodesBuffersLru.reset();
 
     _uCtStorage.reset(CtStorageControl::create_dummy_storage(this));
 
@@ -703,6 +717,7 @@ void CtMainWin::reset()
     window_header_update_lock_icon(false);
     window_header_update_ghost_icon(false);
     window_header_update_bookmark_icon(false);
+    window_header_update_large_doc_icon(false);
     menu_set_bookmark_menu_items();
     _uCtMenu->find_action("ct_vacuum")->signal_set_visible.emit(false);
     menu_top_optional_bookmarks_enforce();
@@ -742,7 +757,11 @@ void CtMainWin::update_selected_node_statusbar_info()
             statusbar_text += separator_text + _("Spell Check") + _(": ") + _pCtConfig->spellCheckLang;
         }
         if (_pCtConfig->wordCountOn) {
-            statusbar_text += separator_text + _("Word Count") + _(": ") + std::to_string(CtTextIterUtil::get_words_count(_ctTextview.get_buffer()));
+            if (CtTextStats* pTextStats = CtTextStats::get_for_buffer(_ctTextview.get_buffer())) {
+                statusbar_text += separator_text + _("Word Count") + _(": ") + std::to_string(pTextStats->get_words());
+                statusbar_text += separator_text + _("Character Count") + _(": ") + std::to_string(pTextStats->get_chars());
+                statusbar_text += separator_text + _("Line Count") + _(": ") + std::to_string(pTextStats->get_lines());
+            }
         }
         if (treeIter.get_node_creating_time() > 0) {
             const Glib::ustring timestamp_creation = str::time_format(_pCtConfig->timestampFormat, treeIter.get_node_creating_time());
@@ -753,6 +772,13 @@ void CtMainWin::update_selected_node_statusbar_info()
             statusbar_text += separator_text + _("Date Modified") + _(": ") + timestamp_lastsave;
         }
     }
+    if (CtTrace::is_enabled()) {
+        // the latest of load, save, search, export
+        const std::string traceSummary = CtTrace::get_last_summary();
+        if (not traceSummary.empty()) {
+            statusbar_text += "  -  " + traceSummary;
+        }
+    }
     _ctStatusBar.update_status(statusbar_text);
 }
 
@@ -38,6 +38,7 @@
 #include "ct_image.h"
 #include "ct_export2pdf.h"
 #include "ct_state_machine.h"
+#include "ct_nodes_buffers_lru.h"
 
 struct CtStatusBar
 {
@@ -66,6 +67,7 @@ struct CtWinHeader
     Gtk::Image       lockIcon;
     Gtk::Image       bookmarkIcon;
     Gtk::Image       ghostIcon;
+    Gtk::Image       largeDocIcon;
     Gtk::EventBox    eventBox;
     std::unordered_map<Gtk::Button*, gint64> button_to_node_id;
 };
@@ -141,6 +143,7 @@ public:
     CtTmp*                            get_ct_tmp()      { return _pCtTmp; }
     Gtk::IconTheme*                   get_icon_theme()  { return _pGtkIconTheme; }
     CtStateMachine&                   get_state_machine() { return _ctStateMachine; }
+    CtNodesBuffersLru&                get_nodes_buffers_lru() { return _nodesBuffersLru; }
     Glib::RefPtr<Gtk::TextTagTable>&  get_text_tag_table() { return _rGtkTextTagTable; }
     Glib::RefPtr<Gtk::CssProvider>&   get_css_provider()   { return _rGtkCssProvider; }
     Gsv::LanguageManager*             get_language_manager() { return _pGsvLanguageManager; }
@@ -179,6 +182,7 @@ public:
     void window_header_update_lock_icon(const bool show);
     void window_header_update_ghost_icon(const bool show);
     void window_header_update_bookmark_icon(const bool show);
+    void window_header_update_large_doc_icon(const bool show);
 
     void menu_update_bookmark_menu_item(bool is_bookmarked);
     void menu_set_bookmark_menu_items();
@@ -302,6 +306,7 @@ private:
     std::unique_ptr<CtTreeView>  _uCtTreeview;
     CtTextView                   _ctTextview;
     CtStateMachine               _ctStateMachine;
+    CtNodesBuffersLru            _nodesBuffersLru;
     std::unique_ptr<CtPairCodeboxMainWin> _uCtPairCodeboxMainWin;
 
     Glib::RefPtr<Gtk::CssProvider> _css_provider_theme;
@@ -472,8 +472,11 @@ void CtMainWin::load_buffer_from_state(std::shared_ptr<CtNodeState> state, CtTre
     }
     tree_iter.remove_all_embedded_widgets();
     std::list<CtAnchoredWidget*> widgets;
-    for (xmlpp::Node* text_node : state->buffer_xml.get_root_node()->get_children()) {
-        CtStorageXmlHelper{this}.get_text_buffer_one_slot_from_xml(gsv_buffer, text_node, widgets, nullptr, -1, "");
+    xmlpp::DomParser parser;
+    if (CtXmlHelper::safe_parse_memory(parser, state->buffer_xml_string)) {
+        for (xmlpp::Node* text_node : parser.get_document()->get_root_node()->get_children()) {
+            CtStorageXmlHelper{this}.get_text_buffer_one_slot_from_xml(gsv_buffer, text_node, widgets, nullptr, -1, "");
+        }
     }
 
     // xml storage doesn't have widgets, so load them separately
@@ -63,6 +63,7 @@ void CtMainWin::_on_treeview_cursor_changed()
         return;
     }
     _uCtTreestore->text_view_apply_textbuffer(treeIter, &_ctTextview);
+    _nodesBuffersLru.touch(nodeIdDataHolder, rTextBuffer, treeIter.get_anchored_widgets_fast().size());
 
     if (user_active()) {
         auto mapScrIter = _nodesVScrollPos.find(nodeIdDataHolder);
@@ -24,6 +24,7 @@
 #include "ct_main_win.h"
 #include "ct_actions.h"
 #include "ct_storage_control.h"
+#include "ct_trace.h"
 
 void CtMainWin::window_title_update(std::optional<bool> saveNeeded)
 {
@@ -146,6 +147,9 @@ bool CtMainWin::file_open(const fs::path& filepath,
                           const Glib::ustring password/*= ""*/,
                           const bool is_reload/*= false*/)
 {
+    if (_uCtStorage->is_saving()) {
+        return false;
+    }
     if (not fs::exists(filepath)) {
         g_autofree gchar* title = g_strdup_printf(_("The Path %s does Not Exist"), str::xml_escape(filepath.string()).c_str());
         CtDialogs::error_dialog(Glib::ustring{title}, *this);
@@ -255,6 +259,9 @@ bool CtMainWin::file_open(const fs::path& filepath,
 
 bool CtMainWin::file_save_ask_user()
 {
+    if (_uCtStorage->is_saving()) {
+        return false; // not to close while the storage is in use
+    }
     if (_uCtActions->get_were_embfiles_opened()) {
         const Glib::ustring message = Glib::ustring{"<b>"} +
             _("Temporary Files were Created and Opened with External Applications.") +
@@ -299,10 +306,22 @@ bool CtMainWin::file_save(const bool need_vacuum)
     if (not get_tree_store().get_iter_first()) {
         return false;
     }
+    if (_uCtStorage->is_saving()) {
+        return false; // e.g. autosave while the vacuum of the previous save is in progress
+    }
     Glib::ustring error;
     if (_uCtStorage->save(need_vacuum, error)) {
         update_window_save_not_needed();
+        const CtStorageSyncPending* pSyncPending = _uCtStorage->get_storage_sync_pending();
+        if (not pSyncPending->nodes_to_write_dict.empty() or not pSyncPending->nodes_to_rm_set.empty() or pSyncPending->bookmarks_to_write) {
+            // edited while vacuuming, after the save was written
+            window_title_update(true/*save_needed*/);
+            _fileSaveNeeded = true;
+        }
         _ctStateMachine.update_state();
+        if (CtTrace::is_enabled()) {
+            update_selected_node_statusbar_info();
+        }
         return true;
     }
     CtDialogs::error_dialog(str::xml_escape(error), *this);
@@ -314,6 +333,9 @@ void CtMainWin::file_save_as(const std::string& new_filepath,
                              const Glib::ustring& password)
 {
     resetAutoSaveCounter();
+    if (_uCtStorage->is_saving()) {
+        return;
+    }
     Glib::ustring error;
     std::unique_ptr<CtStorageControl> new_storage{
         CtStorageControl::save_as(this,
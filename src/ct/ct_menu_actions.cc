@@ -493,6 +493,8 @@ void CtMenu::init_actions(CtActions* pActions)
         _("About CherryTree"), sigc::mem_fun(*pActions, &CtActions::dialog_about)});
     _actions.push_back(CtMenuAction{help_cat, "open_cfg_folder", "ct_directory", _("_Open Preferences Directory"), None,
         _("Open the Directory with Preferences Files"), sigc::mem_fun(*pActions, &CtActions::folder_cfg_open)});
+    _actions.push_back(CtMenuAction{help_cat, "ct_trace", "ct_info", _("Performance _Trace..."), None,
+        _("Record and Export the Timings of Load, Save, Search and Export"), sigc::mem_fun(*pActions, &CtActions::trace_dialog)});
 
     // add actions in the Windows for the toolbar
     // by default actions will have prefix 'win.'
@@ -379,6 +379,7 @@ const char* CtMenu::_get_ui_str_menu()
     <menuitem action='ct_github'/>
     <menuitem action='ct_issues'/>
     <menuitem action='ct_help'/>
+    <menuitem action='ct_trace'/>
     <separator/>
     <menuitem action='ct_about'/>
   </menu>
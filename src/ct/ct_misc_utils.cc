@@ -31,6 +31,8 @@
 #include "ct_list.h"
 #include <ctime>
 #include <regex>
+#include <algorithm>
+#include <numeric>
 #include <glib/gstdio.h> // to get stats
 #include <curl/curl.h>
 #include <fribidi.h>
@@ -315,6 +317,56 @@ void CtMiscUtil::parallel_for(size_t first, size_t last, std::function<void(size
         task.join();
 }
 
+bool CtMiscUtil::tree_levels_sort(Glib::RefPtr<Gtk::TreeStore> store,
+                                  const std::vector<Gtk::TreeIter>& levelsParents,
+                                  const Gtk::TreeModelColumn<Glib::ustring>& nameColumn,
+                                  const bool ascending)
+{
+    struct CtSortLevel
+    {
+        Gtk::TreeIter              parentIter;
+        std::vector<Glib::ustring> names;
+        std::vector<int>           newOrder; // newOrder[newPosition] = oldPosition
+    };
+    // the store is only read and written here in the main thread
+    std::vector<CtSortLevel> levels;
+    for (const Gtk::TreeIter& parentIter : levelsParents) {
+        const Gtk::TreeNodeChildren children = parentIter ? parentIter->children() : store->children();
+        if (children.size() < 2) {
+            continue;
+        }
+        levels.push_back(CtSortLevel{parentIter, {}, {}});
+        levels.back().names.reserve(children.size());
+        for (const Gtk::TreeRow& row : children) {
+            levels.back().names.push_back(row.get_value(nameColumn));
+        }
+    }
+    CtMiscUtil::parallel_for(0, levels.size(), [&levels, ascending](size_t index) {
+        CtSortLevel& level = levels[index];
+        std::vector<CtStrUtil::NaturalSortKey> keys;
+        keys.reserve(level.names.size());
+        for (const Glib::ustring& name : level.names) {
+            keys.push_back(CtStrUtil::natural_sort_key(name));
+        }
+        level.newOrder.resize(keys.size());
+        std::iota(level.newOrder.begin(), level.newOrder.end(), 0);
+        // stable, the siblings with the same name keep their order
+        std::stable_sort(level.newOrder.begin(), level.newOrder.end(), [&keys, ascending](const int l, const int r) {
+            const int cmp = CtStrUtil::natural_sort_key_compare(keys[l], keys[r]);
+            return ascending ? cmp < 0 : cmp > 0;
+        });
+    });
+    bool reordered{false};
+    for (const CtSortLevel& level : levels) {
+        if (std::is_sorted(level.newOrder.begin(), level.newOrder.end())) {
+            continue; // already in order
+        }
+        store->reorder(level.parentIter ? level.parentIter->children() : store->children(), level.newOrder);
+        reordered = true;
+    }
+    return reordered;
+}
+
 Glib::ustring CtTextIterUtil::get_selected_text(Glib::RefPtr<Gtk::TextBuffer> pTextBuffer)
 {
     Gtk::TextIter iter_sel_start, iter_sel_end;
@@ -512,26 +564,6 @@ PangoDirection CtTextIterUtil::get_pango_direction(const Gtk::TextIter& textIter
     return PANGO_DIRECTION_NEUTRAL;
 }
 
-int CtTextIterUtil::get_words_count(const Glib::RefPtr<Gtk::TextBuffer>& text_buffer)
-{
-    int words = 0;
-    Glib::ustring text = text_buffer->get_text(true);
-    if (!text.empty())
-    {
-        int text_size = text.size();
-        PangoLogAttr* attrs = g_new0(PangoLogAttr, text_size + 1);
-        pango_get_log_attrs(text.c_str(), -1, 0,
-                            pango_language_from_string ("C"),
-                            attrs,
-                            text_size + 1);
-        for (int i = 0; i < text_size; ++i)
-            if (attrs[i].is_word_start)
-                ++words;
-        g_free (attrs);
-    }
-    return words;
-}
-
 // Returns the Line Content Given the Text Iter
 Glib::ustring CtTextIterUtil::get_line_content(Glib::RefPtr<Gtk::TextBuffer> text_buffer, const int match_end_offset)
 {
@@ -717,6 +749,27 @@ gchar** CtStrUtil::vector_to_array(const std::vector<std::string>& inVec)
     return array;
 }
 
+// the values of the digits of any script, without the leading zeros
+static std::string natural_number_digits(const Glib::ustring& number)
+{
+    std::string digits;
+    for (const gunichar ch : number) {
+        digits += static_cast<char>('0' + g_unichar_digit_value(ch));
+    }
+    const size_t firstNotZero = digits.find_first_not_of('0');
+    return std::string::npos == firstNotZero ? std::string{} : digits.substr(firstNotZero);
+}
+
+// the number with fewer digits is smaller
+static int natural_number_compare(const std::string& l_digits, const std::string& r_digits)
+{
+    if (l_digits.size() != r_digits.size()) {
+        return l_digits.size() < r_digits.size() ? -1 : +1;
+    }
+    const int diff = l_digits.compare(r_digits);
+    return diff < 0 ? -1 : (diff > 0 ? +1 : 0);
+}
+
 int CtStrUtil::natural_compare(const Glib::ustring& left, const Glib::ustring& right)
 {
     enum mode_t { STRING, NUMBER } mode = STRING;
@@ -752,11 +805,8 @@ int CtStrUtil::natural_compare(const Glib::ustring& left, const Glib::ustring& r
             Glib::ustring r_number;
             for (; r != right.end() && g_unichar_digit_value(*r) != -1; ++r)
                 r_number += *r;
-            // converting number to integer can give INT overflow, so comparing them as strings
-            int max_str_len = std::max(l_number.size(), r_number.size());
-            l_number = str::repeat("0", max_str_len - l_number.size()) + l_number; // padding with '0' for easer comparing
-            r_number = str::repeat("0", max_str_len - r_number.size()) + r_number; // padding with '0' for easer comparing
-            const int diff = l_number.compare(r_number);
+            // converting number to integer can give INT overflow, so comparing them as strings of digits values
+            const int diff = natural_number_compare(natural_number_digits(l_number), natural_number_digits(r_number));
             if (diff != 0)
                 return diff;
             // continue the next substring
@@ -768,6 +818,66 @@ int CtStrUtil::natural_compare(const Glib::ustring& left, const Glib::ustring& r
     return 0;
 }
 
+CtStrUtil::NaturalSortKey CtStrUtil::natural_sort_key(const Glib::ustring& text)
+{
+    NaturalSortKey sortKey;
+    Glib::ustring run;
+    bool runIsNumber{false};
+    auto f_run_to_segment = [&sortKey, &run, &runIsNumber]() {
+        if (run.empty()) {
+            return;
+        }
+        if (runIsNumber) {
+            sortKey.segments.push_back(NaturalSortKey::Segment{true, natural_number_digits(run)});
+        }
+        else {
+            // natural_compare collates character by character: the collation key of each character,
+            // terminated by a '\0' that is lower than any byte of a key, so that a shorter key comes first
+            std::string key;
+            for (const gunichar ch : run) {
+                gchar utf8[6];
+                const gint numBytes = g_unichar_to_utf8(ch, utf8);
+                gchar* pCollateKey = g_utf8_collate_key(utf8, numBytes);
+                key += pCollateKey;
+                key += '\0';
+                g_free(pCollateKey);
+            }
+            sortKey.segments.push_back(NaturalSortKey::Segment{false, std::move(key)});
+        }
+        run.clear();
+    };
+    for (const gunichar ch : text.casefold()) {
+        const bool isDigit = -1 != g_unichar_digit_value(ch);
+        if (isDigit != runIsNumber) {
+            f_run_to_segment();
+            runIsNumber = isDigit;
+        }
+        run += ch;
+    }
+    f_run_to_segment();
+    return sortKey;
+}
+
+int CtStrUtil::natural_sort_key_compare(const NaturalSortKey& left, const NaturalSortKey& right)
+{
+    const size_t numSegments = std::min(left.segments.size(), right.segments.size());
+    for (size_t i = 0; i < numSegments; ++i) {
+        const NaturalSortKey::Segment& l = left.segments[i];
+        const NaturalSortKey::Segment& r = right.segments[i];
+        if (l.isNumber != r.isNumber) {
+            return l.isNumber ? -1 : +1; // the digits first
+        }
+        const int diff = l.isNumber ? natural_number_compare(l.key, r.key) : l.key.compare(r.key);
+        if (diff != 0) {
+            return diff < 0 ? -1 : +1;
+        }
+    }
+    if (left.segments.size() != right.segments.size()) {
+        return left.segments.size() < right.segments.size() ? -1 : +1;
+    }
+    return 0;
+}
+
 Glib::ustring CtStrUtil::highlight_words(const Glib::ustring& text, std::vector<Glib::ustring> words, const Glib::ustring& markup_tag /* = "b" */)
 {
     if (words.empty())
@@ -1081,78 +1191,102 @@ Glib::ustring str::sanitize_bad_symbols(const Glib::ustring& xml_content)
     return re_pattern->replace(xml_content, 0/*start_position*/, "", static_cast<Glib::RegexMatchFlags>(0u));
 }
 
-struct DiacrToAscii {
-    DiacrToAscii(const char* replacement_, const char* pattern_)
-     : replacement{replacement_}
-     , pattern{pattern_}
-    {}
-    Glib::ustring replacement;
-    Glib::ustring pattern;
-    Glib::RefPtr<Glib::Regex> pRegExp;
-};
-static std::list<DiacrToAscii> list_DiacrToAscii{
-    {"a", "[àáâãäåāăąạ]"},
-    {"A", "[ÀÁÂÃÄÅĀĂĄẠ]"},
-    {"b", "[ḅ]"},
-    {"B", "[Ḅ]"},
-    {"c", "[çćĉċč]"},
-    {"C", "[ÇĆĈĊČ]"},
-    {"d", "[ďđḍ]"},
-    {"D", "[ĎĐḌ]"},
-    {"e", "[èéêëēĕėęěẹ]"},
-    {"E", "[ÈÉÊËĒĔĖĘĚẸ]"},
-    {"g", "[ĝğġģ]"},
-    {"G", "[ĜĞĠĢ]"},
-    {"h", "[ĥħḥ]"},
-    {"H", "[ĤĦḤ]"},
-    {"i", "[ìíîïĩīĭįıị]"},
-    {"I", "[ÌÍÎÏĨĪĬĮİỊ]"},
-    {"j", "[ĵ]"},
-    {"J", "[Ĵ]"},
-    {"k", "[ķḳ]"},
-    {"K", "[ĶḲ]"},
-    {"l", "[ĺļľŀłḷ]"},
-    {"L", "[ĹĻĽĿŁḶ]"},
-    {"m", "[ṃ]"},
-    {"M", "[Ṃ]"},
-    {"n", "[ñńņňŉṇ]"},
-    {"N", "[ÑŃŅŇṆ]"},
-    {"o", "[òóôõöøōŏőọ]"},
-    {"O", "[ÒÓÔÕÖØŌŎŐỌ]"},
-    {"r", "[ŕŗřṛ]"},
-    {"R", "[ŔŖŘṚ]"},
-    {"s", "[śŝşšṣ]"},
-    {"S", "[ŚŜŞŠṢ]"},
-    {"t", "[ţťŧṭ]"},
-    {"T", "[ŢŤŦṬ]"},
-    {"u", "[ùúûüũūŭůűųụ]"},
-    {"U", "[ÙÚÛÜŨŪŬŮŰŲỤ]"},
-    {"w", "[ŵẉ]"},
-    {"W", "[ŴẈ]"},
-    {"y", "[ýŷÿỵ]"},
-    {"Y", "[ÝŶŸỴ]"},
-    {"z", "[źżžẓ]"},
-    {"Z", "[ŹŻŽẒ]"},
-};
-static bool list_DiacrToAscii_initialised{false};
-
-// https://docs.oracle.com/cd/E29584_01/webhelp/mdex_basicDev/src/rbdv_chars_mapping.html
-Glib::ustring str::diacritical_to_ascii(const Glib::ustring& in_text)
-{
-    const Glib::RegexMatchFlags re_flags{static_cast<Glib::RegexMatchFlags>(0u)};
-    Glib::ustring tmp_str{in_text};
-    if (not list_DiacrToAscii_initialised) {
-        list_DiacrToAscii_initialised = true;
-        for (DiacrToAscii& curr_DiacrToAscii : list_DiacrToAscii) {
-            curr_DiacrToAscii.pRegExp = Glib::Regex::create(curr_DiacrToAscii.pattern);
+// codepoints up to the end of the Latin Extended Additional block
+static const gunichar DiacrFoldTableSize{0x1F00};
+
+static bool _is_combining_diacritical_mark(const gunichar ch)
+{
+    return (ch >= 0x0300 and ch <= 0x036F) or // Combining Diacritical Marks
+           (ch >= 0x1AB0 and ch <= 0x1AFF) or // Combining Diacritical Marks Extended
+           (ch >= 0x1DC0 and ch <= 0x1DFF) or // Combining Diacritical Marks Supplement
+           (ch >= 0x20D0 and ch <= 0x20FF) or // Combining Diacritical Marks for Symbols
+           (ch >= 0xFE20 and ch <= 0xFE2F);   // Combining Half Marks
+}
+
+static std::vector<gunichar> _get_diacr_fold_table()
+{
+    std::vector<gunichar> foldTable(DiacrFoldTableSize);
+    gunichar decomposition[G_UNICHAR_MAX_DECOMPOSITION_LENGTH];
+    for (gunichar ch = 0; ch < DiacrFoldTableSize; ++ch) {
+        foldTable[ch] = ch;
+        if (ch < 0x80) {
+            continue;
+        }
+        // canonical decomposition, e.g. 'é' -> 'e' + U+0301
+        const gsize decompLen = g_unichar_fully_decompose(ch, FALSE/*compat*/, decomposition, G_UNICHAR_MAX_DECOMPOSITION_LENGTH);
+        if (decompLen < 2u or decomposition[0] >= 0x80 or not g_unichar_isalpha(decomposition[0])) {
+            continue;
+        }
+        bool onlyMarks{true};
+        for (gsize i = 1; i < decompLen; ++i) {
+            if (not _is_combining_diacritical_mark(decomposition[i])) {
+                onlyMarks = false;
+                break;
+            }
+        }
+        if (onlyMarks) {
+            foldTable[ch] = decomposition[0];
         }
     }
-    for (DiacrToAscii& curr_DiacrToAscii : list_DiacrToAscii) {
-        if (curr_DiacrToAscii.pRegExp->match(tmp_str, re_flags)) {
-            tmp_str = curr_DiacrToAscii.pRegExp->replace(tmp_str, 0/*start_position*/, curr_DiacrToAscii.replacement, re_flags);
+    // letters with a stroke or otherwise without a canonical decomposition
+    // https://docs.oracle.com/cd/E29584_01/webhelp/mdex_basicDev/src/rbdv_chars_mapping.html
+    for (const auto& currPair : std::vector<std::pair<gunichar, gunichar>>{
+            {0x00D8/*Ø*/, 'O'}, {0x00F8/*ø*/, 'o'},
+            {0x0110/*Đ*/, 'D'}, {0x0111/*đ*/, 'd'},
+            {0x0126/*Ħ*/, 'H'}, {0x0127/*ħ*/, 'h'},
+            {0x0131/*ı*/, 'i'},
+            {0x013F/*Ŀ*/, 'L'}, {0x0140/*ŀ*/, 'l'},
+            {0x0141/*Ł*/, 'L'}, {0x0142/*ł*/, 'l'},
+            {0x0149/*ŉ*/, 'n'},
+            {0x0166/*Ŧ*/, 'T'}, {0x0167/*ŧ*/, 't'}})
+    {
+        foldTable[currPair.first] = currPair.second;
+    }
+    return foldTable;
+}
+
+Glib::ustring str::diacritical_to_ascii(const Glib::ustring& in_text, std::vector<int>* pOrigOffsets)
+{
+    static const std::vector<gunichar> foldTable = _get_diacr_fold_table();
+
+    const std::string& in_raw = in_text.raw();
+    std::string out_raw;
+    out_raw.reserve(in_raw.size());
+    if (pOrigOffsets) {
+        pOrigOffsets->clear();
+        pOrigOffsets->reserve(in_raw.size() + 1u);
+    }
+    int origOffset{0};
+    const char* pIn = in_raw.c_str();
+    const char* const pInEnd = pIn + in_raw.size();
+    while (pIn < pInEnd) {
+        if (static_cast<unsigned char>(*pIn) < 0x80) {
+            // ascii fast path
+            out_raw += *pIn++;
+            if (pOrigOffsets) pOrigOffsets->push_back(origOffset);
+            ++origOffset;
+            continue;
+        }
+        gunichar ch = g_utf8_get_char(pIn);
+        pIn = g_utf8_next_char(pIn);
+        if (not _is_combining_diacritical_mark(ch)) {
+            if (ch < DiacrFoldTableSize) {
+                ch = foldTable[ch];
+            }
+            gchar utf8Buf[6];
+            out_raw.append(utf8Buf, g_unichar_to_utf8(ch, utf8Buf));
+            if (pOrigOffsets) pOrigOffsets->push_back(origOffset);
         }
+        ++origOffset;
     }
-    return tmp_str;
+    if (pOrigOffsets) pOrigOffsets->push_back(origOffset);
+    return Glib::ustring{out_raw};
+}
+
+int str::diacritical_folded_offset(const std::vector<int>& origOffsets, const int origOffset)
+{
+    // origOffsets is sorted, the dropped marks are attached to the char before them
+    return static_cast<int>(std::lower_bound(origOffsets.begin(), origOffsets.end(), origOffset) - origOffsets.begin());
 }
 
 Glib::ustring str::re_escape(const Glib::ustring& text)
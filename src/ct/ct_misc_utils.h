@@ -111,6 +111,14 @@ URI_TYPE get_uri_type(const std::string& uri);
 
 void parallel_for(size_t first, size_t last, std::function<void(size_t)> f);
 
+// sorts the children of each of the levels (an empty parent iter for the top level) by the natural order of the
+// names in nameColumn: the sort keys are computed once per name and the levels sorted in parallel, then each level
+// is reordered in the store in one go; returns true if any level changed order
+bool tree_levels_sort(Glib::RefPtr<Gtk::TreeStore> store,
+                      const std::vector<Gtk::TreeIter>& levelsParents,
+                      const Gtk::TreeModelColumn<Glib::ustring>& nameColumn,
+                      const bool ascending);
+
 bool text_file_set_contents_add_cr_on_win(const std::string& filepath, const std::string& text_content);
 
 } // namespace CtMiscUtil
@@ -175,8 +183,6 @@ const gchar* get_text_iter_alignment(const Gtk::TextIter& textIter, CtMainWin* p
 
 PangoDirection get_pango_direction(const Gtk::TextIter& textIter);
 
-int get_words_count(const Glib::RefPtr<Gtk::TextBuffer>& text_buffer);
-
 const inline static size_t LINE_CONTENT_LIMIT{100u};
 Glib::ustring get_line_content(Glib::RefPtr<Gtk::TextBuffer> text_buffer, const int match_end_offset);
 Glib::ustring get_line_content(const Glib::ustring& text_multiline, const int match_end_offset);
@@ -246,6 +252,21 @@ bool contains_words(const String& text, const std::vector<String>& words, bool r
 // https://stackoverflow.com/questions/642213/how-to-implement-a-natural-sort-algorithm-in-c
 int natural_compare(const Glib::ustring& left, const Glib::ustring& right);
 
+// the order of natural_compare on the case-folded text, computed once per string for sorting: the runs of
+// digits are kept as their values without the leading zeros, the runs of other characters as the sequence
+// of the collation keys of their characters
+struct NaturalSortKey
+{
+    struct Segment
+    {
+        bool        isNumber;
+        std::string key;
+    };
+    std::vector<Segment> segments;
+};
+NaturalSortKey natural_sort_key(const Glib::ustring& text);
+int natural_sort_key_compare(const NaturalSortKey& left, const NaturalSortKey& right);
+
 // Returns a version of text in which all occurrences of words
 // are highlighted using Pango markup
 Glib::ustring highlight_words(const Glib::ustring& text, std::vector<Glib::ustring> words, const Glib::ustring& markup_tag = "b");
@@ -326,7 +347,13 @@ Glib::ustring xml_escape(const Glib::ustring& text);
 
 Glib::ustring sanitize_bad_symbols(const Glib::ustring& xml_content);
 
-Glib::ustring diacritical_to_ascii(const Glib::ustring& in_text);
+// single pass: the latin letters with diacritical marks are folded to their ascii base letter and the
+// combining diacritical marks are dropped; with pOrigOffsets, for every char of the returned text
+// (plus one past the end) the char offset in in_text, to map the matches back to the original text
+Glib::ustring diacritical_to_ascii(const Glib::ustring& in_text, std::vector<int>* pOrigOffsets = nullptr);
+
+// char offset in the text returned by diacritical_to_ascii of the char at origOffset in the original text
+int diacritical_folded_offset(const std::vector<int>& origOffsets, const int origOffset);
 
 Glib::ustring re_escape(const Glib::ustring& text);
 
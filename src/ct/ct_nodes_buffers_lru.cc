@@ -0,0 +1,156 @@
+/*
+ * ct_nodes_buffers_lru.cc
+ *
+ * Copyright 2009-2024
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_nodes_buffers_lru.h"
+#include "ct_main_win.h"
+#include "ct_logging.h"
+#include "ct_trace.h"
+#include <glibmm/main.h>
+
+CtNodesBuffersLru::CtNodesBuffersLru(CtMainWin* pCtMainWin)
+ : _pCtMainWin{pCtMainWin}
+{
+}
+
+CtNodesBuffersLru::~CtNodesBuffersLru()
+{
+    _evictTimeoutConnection.disconnect();
+}
+
+/*static*/size_t CtNodesBuffersLru::estimate_bytes(const Glib::RefPtr<Gsv::Buffer>& rTextBuffer, const size_t numWidgets)
+{
+    const size_t numChars = rTextBuffer ? static_cast<size_t>(rTextBuffer->get_char_count()) : 0u;
+    return numChars*BytesPerChar + numWidgets*BytesPerWidget;
+}
+
+void CtNodesBuffersLru::touch(const gint64 nodeId, const Glib::RefPtr<Gsv::Buffer>& rTextBuffer, const size_t numWidgets)
+{
+    const size_t bytes = estimate_bytes(rTextBuffer, numWidgets);
+    const auto it = _nodesEntries.find(nodeId);
+    if (_nodesEntries.end() != it) {
+        _lruNodeIds.splice(_lruNodeIds.begin(), _lruNodeIds, it->second.itLru);
+        _totBytes -= it->second.bytes;
+        it->second.bytes = bytes;
+    }
+    else {
+        _lruNodeIds.push_front(nodeId);
+        _nodesEntries[nodeId] = CtEntry{_lruNodeIds.begin(), bytes};
+    }
+    _totBytes += bytes;
+    const size_t budgetBytes = _get_budget_bytes();
+    if (budgetBytes > 0 and _totBytes > budgetBytes) {
+        _schedule_evict();
+    }
+}
+
+void CtNodesBuffersLru::reset()
+{
+    _evictTimeoutConnection.disconnect();
+    _lruNodeIds.clear();
+    _nodesEntries.clear();
+    _totBytes = 0;
+    _noEvictBelowBytes = 0;
+}
+
+size_t CtNodesBuffersLru::evict_over_budget()
+{
+    const size_t budgetBytes = _get_budget_bytes();
+    if (0 == budgetBytes or _totBytes <= budgetBytes or _totBytes < _noEvictBelowBytes or _holds > 0) {
+        return 0;
+    }
+    CtTraceSpan traceSpan{"evict_buffers"};
+    CtTreeStore& ctTreeStore = _pCtMainWin->get_tree_store();
+    // one pass on the tree store for the rows of all the loaded nodes
+    std::unordered_map<gint64, Gtk::TreeIter> nodesIters;
+    ctTreeStore.get_store()->foreach_iter([&](const Gtk::TreeIter& iter){
+        const gint64 nodeId = iter->get_value(ctTreeStore.get_columns().colNodeUniqueId);
+        if (_nodesEntries.count(nodeId) != 0) {
+            nodesIters[nodeId] = iter;
+        }
+        return false; /* continue */
+    });
+    CtTreeIter currTreeIter = _pCtMainWin->curr_tree_iter();
+    const gint64 currNodeId = currTreeIter ? currTreeIter.get_node_id_data_holder() : -1;
+    const size_t targetBytes = budgetBytes/100u*EvictToPercentOfBudget;
+    size_t numUnloaded{0};
+    auto itLru = _lruNodeIds.end();
+    while (_totBytes > targetBytes and _lruNodeIds.begin() != itLru) {
+        --itLru;
+        const gint64 nodeId = *itLru;
+        if (nodeId == currNodeId) {
+            continue;
+        }
+        const auto itIter = nodesIters.find(nodeId);
+        if (nodesIters.end() == itIter) {
+            itLru = _forget(itLru); // the node was removed
+            continue;
+        }
+        CtTreeIter ctTreeIter = ctTreeStore.to_ct_tree_iter(itIter->second);
+        if (not ctTreeIter.get_node_buffer_already_loaded()) {
+            itLru = _forget(itLru);
+            continue;
+        }
+        if (ctTreeIter.get_node_text_buffer()->get_modified()) {
+            continue;
+        }
+        if (ctTreeIter.unload_node_text_buffer()) {
+            itLru = _forget(itLru);
+            ++numUnloaded;
+        }
+    }
+    // when what is left cannot be unloaded, do not try again on every next load
+    _noEvictBelowBytes = _totBytes > targetBytes ? _totBytes + budgetBytes/4u : 0u;
+    spdlog::debug("{} unloaded {}, left {} estimated {} MB", __FUNCTION__, numUnloaded, _nodesEntries.size(), _totBytes/(1024u*1024u));
+    return numUnloaded;
+}
+
+size_t CtNodesBuffersLru::_get_budget_bytes() const
+{
+    const int budgetMB = _pCtMainWin->get_ct_config()->nodesBuffersBudgetMB;
+    return budgetMB > 0 ? static_cast<size_t>(budgetMB)*1024u*1024u : 0u;
+}
+
+std::list<gint64>::iterator CtNodesBuffersLru::_forget(std::list<gint64>::iterator itLru)
+{
+    const auto it = _nodesEntries.find(*itLru);
+    if (_nodesEntries.end() != it) {
+        _totBytes -= it->second.bytes;
+        _nodesEntries.erase(it);
+    }
+    return _lruNodeIds.erase(itLru);
+}
+
+void CtNodesBuffersLru::_schedule_evict()
+{
+    if (_evictTimeoutConnection.connected()) {
+        return;
+    }
+    _evictTimeoutConnection = Glib::signal_timeout().connect([this](){
+        if (not _pCtMainWin->user_active() or _holds > 0) {
+            return true; /* retry later, not in the middle of a programmatic change */
+        }
+        _noEvictBelowBytes = 0; // e.g. after a save, more buffers may have nothing left to save
+        (void)evict_over_budget();
+        return false; /* false for disconnect */
+    }, EvictDelayMs);
+}
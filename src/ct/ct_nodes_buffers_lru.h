@@ -0,0 +1,79 @@
+/*
+ * ct_nodes_buffers_lru.h
+ *
+ * Copyright 2009-2024
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#pragma once
+
+#include <gtksourceviewmm/buffer.h>
+#include <list>
+#include <unordered_map>
+
+class CtMainWin;
+
+// The loaded nodes text buffers in least recently used order, with an estimate of their memory:
+// over the configured budget, the buffers with nothing to save that are not on display are unloaded
+// and read again from the storage the next time they are needed (the undo states are kept as xml)
+class CtNodesBuffersLru
+{
+public:
+    CtNodesBuffersLru(CtMainWin* pCtMainWin);
+    ~CtNodesBuffersLru();
+
+    // the text buffer of the node (data holder) was loaded or is in use
+    void touch(const gint64 nodeId, const Glib::RefPtr<Gsv::Buffer>& rTextBuffer, const size_t numWidgets);
+    void reset();
+    // unloads the least recently used buffers down to below the budget, returns the number unloaded
+    size_t evict_over_budget();
+
+    // no unloading while the widgets of other nodes are referenced across a nested main loop (e.g. printing)
+    void hold()   { ++_holds; }
+    void unhold() { --_holds; }
+
+    size_t get_estimated_bytes() const { return _totBytes; }
+    size_t get_num_loaded() const { return _nodesEntries.size(); }
+
+    static size_t estimate_bytes(const Glib::RefPtr<Gsv::Buffer>& rTextBuffer, const size_t numWidgets);
+
+private:
+    size_t _get_budget_bytes() const;
+    std::list<gint64>::iterator _forget(std::list<gint64>::iterator itLru);
+    void _schedule_evict();
+
+    static constexpr size_t BytesPerChar{10};          // text segments, lines, tags toggles
+    static constexpr size_t BytesPerWidget{64*1024};   // gtk widgets, codebox/table own buffers
+    static constexpr size_t EvictToPercentOfBudget{75}; // not to evict again on every next load
+    static constexpr guint  EvictDelayMs{1000};
+
+    struct CtEntry
+    {
+        std::list<gint64>::iterator itLru;
+        size_t                      bytes{0};
+    };
+
+    CtMainWin* const                   _pCtMainWin;
+    std::list<gint64>                  _lruNodeIds; // most recently used first
+    std::unordered_map<gint64, CtEntry> _nodesEntries;
+    size_t                             _totBytes{0};
+    size_t                             _noEvictBelowBytes{0};
+    int                                _holds{0};
+    sigc::connection                   _evictTimeoutConnection;
+};
@@ -342,6 +342,12 @@ private:
         int slot_style_id;
         std::map<std::string, std::string> styles;
     };
+    struct pending_image
+    {
+        xmlpp::Element* p_image_node;
+        std::string     img_path;
+        std::string     rawBlob; // png, empty if the image could not be loaded
+    };
 
     static const std::set<std::string> HTML_A_TAGS;
 
@@ -374,6 +380,8 @@ private:
 
     std::string _convert_html_color(const std::string& html_color);
     void        _insert_image(std::string img_path, std::string trailing_chars);
+    void        _load_pending_images();
+    static std::string _load_image_png(const std::string& img_path, const std::string& local_dir);
     void        _insert_table();
     void        _insert_codebox();
     void        _rich_text_serialize(std::string text);
@@ -406,6 +414,7 @@ private:
     std::string            _slot_text;
     int                    _slot_style_id;
     std::list<slot_styles> _slot_styles_cache;
+    std::vector<pending_image> _pending_images;
 };
 
 #ifdef MD_AUTO_REPLACEMENT
@@ -28,6 +28,7 @@
 #include "ct_storage_xml.h"
 
 #include <cassert>
+#include <mutex>
 
 namespace {
 std::vector<std::string> split_rednotebook_html_nodes(const std::string& input)
@@ -179,6 +180,7 @@ void CtHtml2Xml::feed(const std::string& html)
 
 
     _rich_text_save_pending();
+    _load_pending_images();
 }
 
 void CtHtml2Xml::handle_starttag(std::string_view tag, const char** atts)
@@ -570,87 +572,121 @@ std::string CtHtml2Xml::_convert_html_color(const std::string& html_color)
 }
 
 // Insert Image in Buffer
+// the image is only referenced here, it is loaded with the others at the end of the parsing
 void CtHtml2Xml::_insert_image(std::string img_path, std::string trailing_chars)
 {
     _rich_text_save_pending();
 
-    // todo: remove this copy-paste (image.cc)
-    auto insert_image = [&](Glib::RefPtr<Gdk::Pixbuf> pixbuf) {
-        g_autofree gchar* pBuffer{NULL};
-        gsize buffer_size;
-        pixbuf->save_to_buffer(pBuffer, buffer_size, "png");
-        const std::string rawBlob = std::string(pBuffer, buffer_size);
-        const std::string encodedBlob = Glib::Base64::encode(rawBlob);
-
-        xmlpp::Element* p_image_node = _slot_root->add_child("encoded_png");
-        p_image_node->set_attribute("char_offset", std::to_string(_char_offset));
-        p_image_node->set_attribute(CtConst::TAG_JUSTIFICATION, CtConst::TAG_PROP_VAL_LEFT);
-        p_image_node->set_attribute("link", CtConst::LINK_TYPE_WEBS + CtConst::CHAR_SPACE + img_path);
-        p_image_node->add_child_text(encodedBlob);
-    };
+    xmlpp::Element* p_image_node = _slot_root->add_child("encoded_png");
+    p_image_node->set_attribute("char_offset", std::to_string(_char_offset));
+    p_image_node->set_attribute(CtConst::TAG_JUSTIFICATION, CtConst::TAG_PROP_VAL_LEFT);
+    p_image_node->set_attribute("link", CtConst::LINK_TYPE_WEBS + CtConst::CHAR_SPACE + img_path);
+    _pending_images.push_back(pending_image{p_image_node, img_path, ""});
+
+    _char_offset += 1;
+    if (!trailing_chars.empty())
+        _rich_text_serialize(trailing_chars);
+}
+
+// Load the images referenced while parsing, in parallel, and put them in the document
+void CtHtml2Xml::_load_pending_images()
+{
+    if (_pending_images.empty()) return;
 
     if (_status_bar) {
-        _status_bar->update_status(std::string(_("Downloading")) + " " + img_path + " ...");
-       while (gtk_events_pending()) gtk_main_iteration();
+        _status_bar->update_status(std::string(_("Downloading")) + " " + std::to_string(_pending_images.size()) + " ...");
+        while (gtk_events_pending()) gtk_main_iteration();
     }
 
-    bool image_good = false;
+    CtMiscUtil::parallel_for(0, _pending_images.size(), [&](size_t index) {
+        _pending_images[index].rawBlob = _load_image_png(_pending_images[index].img_path, _local_dir);
+    });
 
+    // the images that failed leave no character in the buffer so the following offsets move back
+    std::unordered_set<xmlpp::Element*> failed_images;
+    for (pending_image& image : _pending_images) {
+        if (image.rawBlob.empty()) {
+            spdlog::error("Failed to download {}", image.img_path);
+            failed_images.insert(image.p_image_node);
+        }
+        else {
+            image.p_image_node->add_child_text(Glib::Base64::encode(image.rawBlob));
+        }
+    }
+    _pending_images.clear();
+    if (not failed_images.empty()) {
+        int offset_shift{0};
+        for (xmlpp::Node* p_child : _slot_root->get_children()) {
+            auto p_element = dynamic_cast<xmlpp::Element*>(p_child);
+            if (not p_element or not p_element->get_attribute("char_offset")) continue;
+            if (failed_images.count(p_element)) {
+                _slot_root->remove_child(p_element);
+                ++offset_shift;
+            }
+            else if (offset_shift > 0) {
+                const int char_offset = std::stoi(p_element->get_attribute_value("char_offset"));
+                p_element->set_attribute("char_offset", std::to_string(char_offset - offset_shift));
+            }
+        }
+        _char_offset -= offset_shift;
+    }
+
+    if (_status_bar)
+        _status_bar->update_status("");
+}
+
+// Image as png, from a data uri, a local file or a download (run from the worker threads)
+/*static*/std::string CtHtml2Xml::_load_image_png(const std::string& img_path, const std::string& local_dir)
+{
+    auto f_to_png = [](const std::string& image_raw)->std::string{
+        Glib::RefPtr<Gdk::PixbufLoader> pixbuf_loader = Gdk::PixbufLoader::create();
+        pixbuf_loader->write((const guint8*)image_raw.c_str(), image_raw.size());
+        pixbuf_loader->close();
+        auto pixbuf = pixbuf_loader->get_pixbuf();
+        if (not pixbuf) {
+            return "";
+        }
+        if (pixbuf_loader->get_format().get_name() == "png") {
+            // already png, keep the original encoded bytes
+            return image_raw;
+        }
+        g_autofree gchar* pBuffer{NULL};
+        gsize buffer_size;
+        pixbuf->save_to_buffer(pBuffer, buffer_size, "png");
+        return std::string(pBuffer, buffer_size);
+    };
 
     // 1. trying base64 encoding
-    try
-    {
-        if (str::startswith(img_path, "data:image") && img_path.find(',') != std::string::npos)
-        {
+    try {
+        if (str::startswith(img_path, "data:image") && img_path.find(',') != std::string::npos) {
             const std::string image_base64 = img_path.substr(img_path.find(',') + 1);
-            const std::string image_raw = Glib::Base64::decode(image_base64);
-            Glib::RefPtr<Gdk::PixbufLoader> pixbuf_loader = Gdk::PixbufLoader::create();
-            pixbuf_loader->write((const guint8*)image_raw.c_str(), image_raw.size());
-            pixbuf_loader->close();
-            auto pixbuf = pixbuf_loader->get_pixbuf();
-            insert_image(pixbuf);
-            image_good = true;
+            return f_to_png(Glib::Base64::decode(image_base64));
         }
     } catch (...) { }
 
-    // 2. trying to download
+    // 2. trying to load from disk
     try {
-        std::string file_buffer = fs::download_file(img_path);
-        if (!file_buffer.empty()) {
-            Glib::RefPtr<Gdk::PixbufLoader> pixbuf_loader = Gdk::PixbufLoader::create();
-            pixbuf_loader->write((const guint8*)file_buffer.c_str(), file_buffer.size());
-            pixbuf_loader->close();
-            auto pixbuf = pixbuf_loader->get_pixbuf();
-            insert_image(pixbuf);
-            image_good = true;
+        std::string local_image = Glib::build_filename(local_dir, img_path);
+        if (Glib::file_test(local_image, Glib::FILE_TEST_IS_REGULAR)) {
+            return f_to_png(Glib::file_get_contents(local_image));
         }
-    }  catch (...) { }
+    } catch (...) { }
 
-    // 3. trying to load from disk
+    // 3. trying to download
     try {
-        if (!image_good) {
-            std::string local_image = Glib::build_filename(_local_dir, img_path);
-            if (Glib::file_test(local_image, Glib::FILE_TEST_IS_REGULAR)) {
-                Glib::RefPtr<Gdk::Pixbuf> pixbuf = Gdk::Pixbuf::create_from_file(local_image);
-                if (pixbuf) {
-                    insert_image(pixbuf);
-                    image_good = true;
-                }
-            }
+        // curl global init/cleanup in fs::download_file are not thread safe
+        static std::mutex downloadMutex;
+        std::string file_buffer;
+        {
+            std::lock_guard<std::mutex> lock{downloadMutex};
+            file_buffer = fs::download_file(img_path);
         }
-    }
-    catch (...) {}
-
-    if (image_good) {
-        _char_offset += 1;
-        if (!trailing_chars.empty())
-            _rich_text_serialize(trailing_chars);
-    } else {
-        spdlog::error("Failed to download {}", img_path);
-    }
+        if (!file_buffer.empty()) {
+            return f_to_png(file_buffer);
+        }
+    } catch (...) { }
 
-    if (_status_bar)
-        _status_bar->update_status("");
+    return "";
 }
 
 void CtHtml2Xml::_insert_table()
@@ -47,16 +47,29 @@ Gtk::Widget* CtPrefDlg::build_tab_misc()
     auto file_chooser_button_backup_dir = Gtk::manage(new Gtk::FileChooserButton{_("Custom Backup Directory"),
                                                                                  Gtk::FileChooserAction::FILE_CHOOSER_ACTION_SELECT_FOLDER});
     auto hbox_custom_backup_dir = Gtk::manage(new Gtk::Box{Gtk::ORIENTATION_HORIZONTAL, 4/*spacing*/});
+    auto hbox_save_verify = Gtk::manage(new Gtk::Box{Gtk::ORIENTATION_HORIZONTAL, 4/*spacing*/});
+    auto label_save_verify = Gtk::manage(new Gtk::Label{_("Verify After Saving")});
+    auto radiobutton_save_verify_full = Gtk::manage(new Gtk::RadioButton{_("Full")});
+    auto radiobutton_save_verify_sampled = Gtk::manage(new Gtk::RadioButton{_("Sampled")});
+    radiobutton_save_verify_sampled->join_group(*radiobutton_save_verify_full);
+    auto radiobutton_save_verify_structural = Gtk::manage(new Gtk::RadioButton{_("Structure Only")});
+    radiobutton_save_verify_structural->join_group(*radiobutton_save_verify_full);
+    hbox_save_verify->set_tooltip_text(_("Check of the saved document before it is encrypted or rotated into the backups: the structure is always validated, the content of all nodes or of a sample of nodes is compared with what was written"));
 
     hbox_num_backups->pack_start(*label_num_backups, false, false);
     hbox_num_backups->pack_start(*spinbutton_num_backups, false, false);
     hbox_custom_backup_dir->pack_start(*checkbutton_custom_backup_dir, false, false);
     hbox_custom_backup_dir->pack_start(*file_chooser_button_backup_dir);
+    hbox_save_verify->pack_start(*label_save_verify, false, false);
+    hbox_save_verify->pack_start(*radiobutton_save_verify_full, false, false);
+    hbox_save_verify->pack_start(*radiobutton_save_verify_sampled, false, false);
+    hbox_save_verify->pack_start(*radiobutton_save_verify_structural, false, false);
     vbox_saving->pack_start(*hbox_autosave, false, false);
     vbox_saving->pack_start(*checkbutton_autosave_on_quit, false, false);
     vbox_saving->pack_start(*checkbutton_backup_before_saving, false, false);
     vbox_saving->pack_start(*hbox_num_backups, false, false);
     vbox_saving->pack_start(*hbox_custom_backup_dir, false, false);
+    vbox_saving->pack_start(*hbox_save_verify, false, false);
 
     checkbutton_autosave->set_active(_pConfig->autosaveOn);
     spinbutton_autosave->set_value(_pConfig->autosaveMinutes);
@@ -67,6 +80,9 @@ Gtk::Widget* CtPrefDlg::build_tab_misc()
     checkbutton_custom_backup_dir->set_active(_pConfig->customBackupDirOn);
     file_chooser_button_backup_dir->set_filename(_pConfig->customBackupDir);
     file_chooser_button_backup_dir->set_sensitive(_pConfig->backupCopy and _pConfig->customBackupDirOn);
+    radiobutton_save_verify_full->set_active(_pConfig->saveVerify == CtSaveVerify::FULL);
+    radiobutton_save_verify_sampled->set_active(_pConfig->saveVerify == CtSaveVerify::SAMPLED);
+    radiobutton_save_verify_structural->set_active(_pConfig->saveVerify == CtSaveVerify::STRUCTURAL);
 
     Gtk::Frame* frame_saving = new_managed_frame_with_align(_("Saving"), vbox_saving);
 
@@ -88,11 +104,20 @@ Gtk::Widget* CtPrefDlg::build_tab_misc()
         file_chooser_button_debug_log_dir->set_sensitive(false);
     }
 
+    auto hbox_buffers_budget = Gtk::manage(new Gtk::Box{Gtk::ORIENTATION_HORIZONTAL, 4/*spacing*/});
+    auto label_buffers_budget = Gtk::manage(new Gtk::Label{_("Memory for the Loaded Nodes Content (MB, 0 for No Limit)")});
+    Glib::RefPtr<Gtk::Adjustment> adjustment_buffers_budget = Gtk::Adjustment::create(_pConfig->nodesBuffersBudgetMB, 0, 100000, 1);
+    auto spinbutton_buffers_budget = Gtk::manage(new Gtk::SpinButton{adjustment_buffers_budget});
+    hbox_buffers_budget->set_tooltip_text(_("Over this estimate, the content of the least recently used nodes that have nothing to save is unloaded, to be read again from the document when needed"));
+
     hbox_debug_log->pack_start(*checkbutton_debug_log, false, false);
     hbox_debug_log->pack_start(*file_chooser_button_debug_log_dir);
     vbox_misc_misc->pack_start(*checkbutton_newer_version, false, false);
     vbox_misc_misc->pack_start(*checkbutton_reload_doc_last, false, false);
     vbox_misc_misc->pack_start(*checkbutton_mod_time_sentinel, false, false);
+    hbox_buffers_budget->pack_start(*label_buffers_budget, false, false);
+    hbox_buffers_budget->pack_start(*spinbutton_buffers_budget, false, false);
+    vbox_misc_misc->pack_start(*hbox_buffers_budget, false, false);
     vbox_misc_misc->pack_start(*hbox_debug_log, false, false);
 
     checkbutton_newer_version->set_active(_pConfig->checkVersion);
@@ -167,6 +192,18 @@ Gtk::Widget* CtPrefDlg::build_tab_misc()
     file_chooser_button_backup_dir->signal_file_set().connect([this, file_chooser_button_backup_dir](){
         _pConfig->customBackupDir = file_chooser_button_backup_dir->get_filename();
     });
+    radiobutton_save_verify_full->signal_toggled().connect([this, radiobutton_save_verify_full](){
+        if (!radiobutton_save_verify_full->get_active()) return;
+        _pConfig->saveVerify = CtSaveVerify::FULL;
+    });
+    radiobutton_save_verify_sampled->signal_toggled().connect([this, radiobutton_save_verify_sampled](){
+        if (!radiobutton_save_verify_sampled->get_active()) return;
+        _pConfig->saveVerify = CtSaveVerify::SAMPLED;
+    });
+    radiobutton_save_verify_structural->signal_toggled().connect([this, radiobutton_save_verify_structural](){
+        if (!radiobutton_save_verify_structural->get_active()) return;
+        _pConfig->saveVerify = CtSaveVerify::STRUCTURAL;
+    });
     checkbutton_debug_log->signal_toggled().connect([this, checkbutton_debug_log, file_chooser_button_debug_log_dir](){
         if (checkbutton_debug_log->get_active()) {
             Glib::file_set_contents(fs::get_cherrytree_logcfg_filepath().string(), "");
@@ -182,6 +219,10 @@ Gtk::Widget* CtPrefDlg::build_tab_misc()
                                 file_chooser_button_debug_log_dir->get_filename());
         need_restart(RESTART_REASON::DEBUG_LOG);
     });
+    spinbutton_buffers_budget->signal_value_changed().connect([this, spinbutton_buffers_budget](){
+        _pConfig->nodesBuffersBudgetMB = spinbutton_buffers_budget->get_value_as_int();
+        apply_for_each_window([](CtMainWin* win) { win->get_nodes_buffers_lru().evict_over_budget(); });
+    });
     checkbutton_reload_doc_last->signal_toggled().connect([this, checkbutton_reload_doc_last](){
         _pConfig->reloadDocLast = checkbutton_reload_doc_last->get_active();
     });
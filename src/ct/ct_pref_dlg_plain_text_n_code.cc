@@ -35,9 +35,27 @@ Gtk::Widget* CtPrefDlg::build_tab_plain_text_n_code()
     auto checkbutton_pt_highl_match_bra = Gtk::manage(new Gtk::CheckButton{_("Highlight Matching Brackets")});
     checkbutton_pt_highl_match_bra->set_active(_pConfig->ptHighlMatchBra);
 
+    auto hbox_large_doc = Gtk::manage(new Gtk::Box{Gtk::ORIENTATION_HORIZONTAL, 4/*spacing*/});
+    auto label_large_doc = Gtk::manage(new Gtk::Label{_("Large Document Threshold (Thousands of Characters)")});
+    Glib::RefPtr<Gtk::Adjustment> adj_large_doc = Gtk::Adjustment::create(_pConfig->ptLargeDocThreshold, 0, 1000000, 100);
+    auto spinbutton_large_doc = Gtk::manage(new Gtk::SpinButton{adj_large_doc});
+    spinbutton_large_doc->set_value(_pConfig->ptLargeDocThreshold);
+    spinbutton_large_doc->set_tooltip_text(_("Above this size line wrapping, spell check and current line highlighting are off and the syntax highlighting is deferred (0 to disable)"));
+    hbox_large_doc->pack_start(*label_large_doc, false, false);
+    hbox_large_doc->pack_start(*spinbutton_large_doc, false, false);
+    auto hbox_large_doc_no_highl = Gtk::manage(new Gtk::Box{Gtk::ORIENTATION_HORIZONTAL, 4/*spacing*/});
+    auto label_large_doc_no_highl = Gtk::manage(new Gtk::Label{_("No Syntax Highlighting Threshold (Thousands of Characters)")});
+    Glib::RefPtr<Gtk::Adjustment> adj_large_doc_no_highl = Gtk::Adjustment::create(_pConfig->ptLargeDocNoHighlThreshold, 0, 1000000, 100);
+    auto spinbutton_large_doc_no_highl = Gtk::manage(new Gtk::SpinButton{adj_large_doc_no_highl});
+    spinbutton_large_doc_no_highl->set_value(_pConfig->ptLargeDocNoHighlThreshold);
+    hbox_large_doc_no_highl->pack_start(*label_large_doc_no_highl, false, false);
+    hbox_large_doc_no_highl->pack_start(*spinbutton_large_doc_no_highl, false, false);
+
     vbox_syntax->pack_start(*checkbutton_pt_show_white_spaces, false, false);
     vbox_syntax->pack_start(*checkbutton_pt_highl_curr_line, false, false);
     vbox_syntax->pack_start(*checkbutton_pt_highl_match_bra, false, false);
+    vbox_syntax->pack_start(*hbox_large_doc, false, false);
+    vbox_syntax->pack_start(*hbox_large_doc_no_highl, false, false);
 
     Gtk::Frame* frame_syntax = new_managed_frame_with_align(_("Text Editor"), vbox_syntax);
 
@@ -140,6 +158,12 @@ Gtk::Widget* CtPrefDlg::build_tab_plain_text_n_code()
         _pConfig->ptHighlMatchBra = checkbutton_pt_highl_match_bra->get_active();
         apply_for_each_window([](CtMainWin* win) { win->reapply_syntax_highlighting('p'/*PlainTextNCode*/); });
     });
+    spinbutton_large_doc->signal_value_changed().connect([this, spinbutton_large_doc](){
+        _pConfig->ptLargeDocThreshold = spinbutton_large_doc->get_value_as_int();
+    });
+    spinbutton_large_doc_no_highl->signal_value_changed().connect([this, spinbutton_large_doc_no_highl](){
+        _pConfig->ptLargeDocNoHighlThreshold = spinbutton_large_doc_no_highl->get_value_as_int();
+    });
     checkbutton_code_exec_confirm->signal_toggled().connect([this, checkbutton_code_exec_confirm](){
         _pConfig->codeExecConfirm = checkbutton_code_exec_confirm->get_active();
     });
@@ -86,6 +86,18 @@ Gtk::Widget* CtPrefDlg::build_tab_rich_text()
     auto spinbutton_limit_undoable_steps = Gtk::manage(new Gtk::SpinButton{adj_limit_undoable_steps});
     hbox_misc_text->pack_start(*label_limit_undoable_steps, false, false);
     hbox_misc_text->pack_start(*spinbutton_limit_undoable_steps, false, false);
+    auto hbox_undo_ram = Gtk::manage(new Gtk::Box{Gtk::ORIENTATION_HORIZONTAL, 4/*spacing*/});
+    auto label_undo_ram_states = Gtk::manage(new Gtk::Label{_("Undoable Steps in Memory Per Node (0 for All)")});
+    Glib::RefPtr<Gtk::Adjustment> adj_undo_ram_states = Gtk::Adjustment::create(_pConfig->undoRamStatesPerNode, 0, 10000, 1);
+    auto spinbutton_undo_ram_states = Gtk::manage(new Gtk::SpinButton{adj_undo_ram_states});
+    auto label_undo_ram_budget = Gtk::manage(new Gtk::Label{_("Total (MB, 0 for No Limit)")});
+    Glib::RefPtr<Gtk::Adjustment> adj_undo_ram_budget = Gtk::Adjustment::create(_pConfig->undoRamBudgetMB, 0, 100000, 1);
+    auto spinbutton_undo_ram_budget = Gtk::manage(new Gtk::SpinButton{adj_undo_ram_budget});
+    hbox_undo_ram->set_tooltip_text(_("The older undoable steps are compressed to a temporary file and read back when undone"));
+    hbox_undo_ram->pack_start(*label_undo_ram_states, false, false);
+    hbox_undo_ram->pack_start(*spinbutton_undo_ram_states, false, false);
+    hbox_undo_ram->pack_start(*label_undo_ram_budget, false, false);
+    hbox_undo_ram->pack_start(*spinbutton_undo_ram_budget, false, false);
     auto checkbutton_camelcase_autolink = Gtk::manage(new Gtk::CheckButton{_("Auto Link CamelCase Text to Node With Same Name")});
     checkbutton_camelcase_autolink->set_active(_pConfig->camelCaseAutoLink);
     auto checkbutton_triple_click_sel_paragraph = Gtk::manage(new Gtk::CheckButton{_("At Triple Click Select the Whole Paragraph")});
@@ -106,6 +118,7 @@ Gtk::Widget* CtPrefDlg::build_tab_rich_text()
     vbox_misc_text->pack_start(*hbox_embfile_max_size, false, false);
     vbox_misc_text->pack_start(*checkbutton_embfile_show_filename, false, false);
     vbox_misc_text->pack_start(*hbox_misc_text, false, false);
+    vbox_misc_text->pack_start(*hbox_undo_ram, false, false);
     vbox_misc_text->pack_start(*checkbutton_camelcase_autolink, false, false);
     vbox_misc_text->pack_start(*checkbutton_triple_click_sel_paragraph, false, false);
 #ifdef MD_AUTO_REPLACEMENT
@@ -180,6 +193,12 @@ Gtk::Widget* CtPrefDlg::build_tab_rich_text()
     spinbutton_limit_undoable_steps->signal_value_changed().connect([this, spinbutton_limit_undoable_steps](){
         _pConfig->limitUndoableSteps = spinbutton_limit_undoable_steps->get_value_as_int();
     });
+    spinbutton_undo_ram_states->signal_value_changed().connect([this, spinbutton_undo_ram_states](){
+        _pConfig->undoRamStatesPerNode = spinbutton_undo_ram_states->get_value_as_int();
+    });
+    spinbutton_undo_ram_budget->signal_value_changed().connect([this, spinbutton_undo_ram_budget](){
+        _pConfig->undoRamBudgetMB = spinbutton_undo_ram_budget->get_value_as_int();
+    });
     checkbutton_camelcase_autolink->signal_toggled().connect([this, checkbutton_camelcase_autolink]{
         _pConfig->camelCaseAutoLink = checkbutton_camelcase_autolink->get_active();
     });
@@ -193,7 +193,11 @@ Gtk::Widget* CtPrefDlg::build_tab_text_n_code()
     });
     checkbutton_line_wrap->signal_toggled().connect([this, checkbutton_line_wrap](){
         _pConfig->lineWrapping = checkbutton_line_wrap->get_active();
-        apply_for_each_window([](CtMainWin* win) { win->get_text_view().set_wrap_mode(win->get_ct_config()->lineWrapping ? Gtk::WrapMode::WRAP_WORD_CHAR : Gtk::WrapMode::WRAP_NONE); });
+        apply_for_each_window([](CtMainWin* win) {
+            if (not win->get_text_view().get_large_doc_mode()) {
+                win->get_text_view().set_wrap_mode(win->get_ct_config()->lineWrapping ? Gtk::WrapMode::WRAP_WORD_CHAR : Gtk::WrapMode::WRAP_NONE);
+            }
+        });
     });
     checkbutton_auto_indent->signal_toggled().connect([this, checkbutton_auto_indent](){
         _pConfig->autoIndent = checkbutton_auto_indent->get_active();
@@ -24,6 +24,8 @@
 #include "ct_state_machine.h"
 #include "ct_main_win.h"
 #include "ct_storage_xml.h"
+#include "ct_trace.h"
+#include "ct_logging.h"
 
 // ImagePng
 CtAnchoredWidgetState_ImagePng::CtAnchoredWidgetState_ImagePng(CtImagePng* image)
@@ -40,8 +42,9 @@ bool CtAnchoredWidgetState_ImagePng::equal(std::shared_ptr<CtAnchoredWidgetState
            charOffset == other_state->charOffset and
            justification == other_state->justification and
            link == other_state->link and
-           pixbuf->get_byte_length() == other_state->pixbuf->get_byte_length() and
-           0 == memcmp(pixbuf->get_pixels(), other_state->pixbuf->get_pixels(), pixbuf->get_byte_length() * sizeof(guint8));
+           (pixbuf == other_state->pixbuf or
+            (pixbuf->get_byte_length() == other_state->pixbuf->get_byte_length() and
+             0 == memcmp(pixbuf->get_pixels(), other_state->pixbuf->get_pixels(), pixbuf->get_byte_length() * sizeof(guint8))));
 }
 
 CtAnchoredWidget* CtAnchoredWidgetState_ImagePng::to_widget(CtMainWin* pCtMainWin)
@@ -97,7 +100,7 @@ CtAnchoredWidget* CtAnchoredWidgetState_Latex::to_widget(CtMainWin* pCtMainWin)
 CtAnchoredWidgetState_EmbFile::CtAnchoredWidgetState_EmbFile(CtImageEmbFile* embFile)
  : CtAnchoredWidgetState{embFile->getOffset(), embFile->getJustification()}
  , fileName{embFile->get_file_name()}
- , rawBlob{embFile->get_raw_blob()}
+ , pBlob{embFile->get_blob()}
  , timeSeconds{embFile->get_time()}
  , uniqueId{embFile->get_unique_id()}
 {
@@ -110,20 +113,20 @@ bool CtAnchoredWidgetState_EmbFile::equal(std::shared_ptr<CtAnchoredWidgetState>
            charOffset == other_state->charOffset and
            justification == other_state->justification and
            fileName == other_state->fileName and
-           rawBlob == other_state->rawBlob and
+           pBlob->has_same_content(*other_state->pBlob) and
            timeSeconds == other_state->timeSeconds and
            uniqueId == other_state->uniqueId;
 }
 
 CtAnchoredWidget* CtAnchoredWidgetState_EmbFile::to_widget(CtMainWin* pCtMainWin)
 {
-    return new CtImageEmbFile{pCtMainWin, fileName, rawBlob, timeSeconds, charOffset, justification, uniqueId};
+    return new CtImageEmbFile{pCtMainWin, fileName, pBlob, timeSeconds, charOffset, justification, uniqueId};
 }
 
 // Codebox
 CtAnchoredWidgetState_Codebox::CtAnchoredWidgetState_Codebox(CtCodebox* codebox)
  : CtAnchoredWidgetState{codebox->getOffset(), codebox->getJustification()}
- , content{codebox->get_text_content()}
+ , pContent{std::make_shared<const Glib::ustring>(codebox->get_text_content())}
  , syntax{codebox->get_syntax_highlighting()}
  , width{codebox->get_frame_width()}
  , height{codebox->get_frame_height()}
@@ -145,13 +148,13 @@ bool CtAnchoredWidgetState_Codebox::equal(std::shared_ptr<CtAnchoredWidgetState>
            widthInPixels == other_state->widthInPixels and
            brackets == other_state->brackets and
            showNum == other_state->showNum and
-           content == other_state->content;
+           (pContent == other_state->pContent or *pContent == *other_state->pContent);
 }
 
 CtAnchoredWidget* CtAnchoredWidgetState_Codebox::to_widget(CtMainWin* pCtMainWin)
 {
     return new CtCodebox{pCtMainWin,
-                         content,
+                         *pContent,
                          syntax,
                          width,
                          height,
@@ -170,7 +173,9 @@ CtAnchoredWidgetState_TableCommon::CtAnchoredWidgetState_TableCommon(const CtTab
  , currRow{table->current_row()}
  , currCol{table->current_column()}
 {
-    table->write_strings_matrix(rows);
+    auto pNewRows = std::make_shared<std::vector<std::vector<Glib::ustring>>>();
+    table->write_strings_matrix(*pNewRows);
+    pRows = pNewRows;
 }
 
 bool CtAnchoredWidgetState_TableCommon::equal(std::shared_ptr<CtAnchoredWidgetState> state)
@@ -183,14 +188,14 @@ bool CtAnchoredWidgetState_TableCommon::equal(std::shared_ptr<CtAnchoredWidgetSt
            colWidths == other_state->colWidths and
            currRow == other_state->currRow and
            currCol == other_state->currCol and
-           rows == other_state->rows;
+           (pRows == other_state->pRows or *pRows == *other_state->pRows);
 }
 
 CtTableLight* CtAnchoredWidgetState_TableCommon::to_widget_light(CtMainWin* pCtMainWin) const
 {
     CtTableMatrix tableMatrix;
-    tableMatrix.reserve(rows.size());
-    for (const auto& row : rows) {
+    tableMatrix.reserve(pRows->size());
+    for (const auto& row : *pRows) {
         tableMatrix.push_back(CtTableRow{});
         tableMatrix.back().reserve(row.size());
         for (const auto& cell : row) {
@@ -210,8 +215,8 @@ CtTableLight* CtAnchoredWidgetState_TableCommon::to_widget_light(CtMainWin* pCtM
 CtTableHeavy* CtAnchoredWidgetState_TableCommon::to_widget_heavy(CtMainWin* pCtMainWin) const
 {
     CtTableMatrix tableMatrix;
-    tableMatrix.reserve(rows.size());
-    for (const auto& row : rows) {
+    tableMatrix.reserve(pRows->size());
+    for (const auto& row : *pRows) {
         tableMatrix.push_back(CtTableRow{});
         tableMatrix.back().reserve(row.size());
         for (const auto& cell : row) {
@@ -243,6 +248,9 @@ void CtStateMachine::reset()
     _visited_nodes_list.clear();
     _visited_nodes_idx = -1;
     _node_states.clear();
+    _uStatesArena.reset();
+    _ramBytes = 0;
+    _noSpillBelowBytes = 0;
 }
 
 // Requested the Previous Visited Node
@@ -282,13 +290,8 @@ void CtStateMachine::node_selected_changed(const gint64 node_id_data_holder)
     }
     if (not map::exists(_node_states, node_id_data_holder)) {
         CtTreeIter node = _pCtMainWin->curr_tree_iter();
-        auto state = std::shared_ptr<CtNodeState>(new CtNodeState{});
-        CtStorageXmlHelper{_pCtMainWin}.save_buffer_no_widgets_to_xml(state->buffer_xml.get_root_node(),
-                                                                      node.get_node_text_buffer(), 0, -1, 'n');
-        state->buffer_xml_string = state->buffer_xml.write_to_string();
-        for (auto widget : node.get_anchored_widgets()) {
-            state->widgetStates.push_back(widget->get_state());
-        }
+        auto state = _new_state(node);
+        _ramBytes += state->buffer_xml_string.bytes();
 
         CtNodeStates states;
         states.states.push_back(state);
@@ -296,6 +299,9 @@ void CtStateMachine::node_selected_changed(const gint64 node_id_data_holder)
         states.indicator = 0; // the current buffer state is saved
         _node_states.insert(std::make_pair(node_id_data_holder, states));
     }
+    _noSpillBelowBytes = 0; // the states of the node previously selected can now be spilled
+    _node_states[node_id_data_holder].lastUse = ++_useCounter;
+    _spill_over_budgets(node_id_data_holder);
 }
 
 // Insertion or Removal of text in the given node_id
@@ -335,7 +341,13 @@ std::shared_ptr<CtNodeState> CtStateMachine::requested_state_previous(const gint
     }
     if (_node_states[node_id_data_holder].index > 0) {
         _node_states[node_id_data_holder].index -= 1;
-        return _node_states[node_id_data_holder].get_state();
+        auto state = _page_in(_node_states[node_id_data_holder].get_state());
+        if (not state) {
+            _node_states[node_id_data_holder].index += 1; // still on the state of the buffer
+            return nullptr;
+        }
+        _spill_over_budgets(node_id_data_holder);
+        return state;
     }
     return nullptr;
 }
@@ -343,7 +355,7 @@ std::shared_ptr<CtNodeState> CtStateMachine::requested_state_previous(const gint
 // The current state is requested
 std::shared_ptr<CtNodeState> CtStateMachine::requested_state_current(const gint64 node_id_data_holder)
 {
-    return _node_states[node_id_data_holder].get_state();
+    return _page_in(_node_states[node_id_data_holder].get_state());
 }
 
 // A Subsequent State, if Existing, is Requested
@@ -351,7 +363,13 @@ std::shared_ptr<CtNodeState> CtStateMachine::requested_state_subsequent(const gi
 {
     if (_node_states[node_id_data_holder].index < (int)_node_states[node_id_data_holder].states.size()-1) {
         _node_states[node_id_data_holder].index += 1;
-        return _node_states[node_id_data_holder].get_state();
+        auto state = _page_in(_node_states[node_id_data_holder].get_state());
+        if (not state) {
+            _node_states[node_id_data_holder].index -= 1; // still on the state of the buffer
+            return nullptr;
+        }
+        _spill_over_budgets(node_id_data_holder);
+        return state;
     }
     return nullptr;
 }
@@ -359,7 +377,11 @@ std::shared_ptr<CtNodeState> CtStateMachine::requested_state_subsequent(const gi
 // Delete the states for the given node_id
 void CtStateMachine::delete_states(const gint64 node_id_data_holder)
 {
-    _node_states.erase(node_id_data_holder);
+    const auto iterStates = _node_states.find(node_id_data_holder);
+    if (iterStates != _node_states.end()) {
+        _erase_states(iterStates->second, 0, iterStates->second.states.size());
+        _node_states.erase(iterStates);
+    }
     if (vec::exists(_visited_nodes_list, node_id_data_holder)) {
         vec::remove(_visited_nodes_list, node_id_data_holder);
         _visited_nodes_idx = _visited_nodes_list.size()-1;
@@ -397,29 +419,25 @@ void CtStateMachine::update_state(CtTreeIter tree_iter)
     if (not tree_iter) return;
     if (not tree_iter.get_node_is_rich_text()) return;
 
+    CtTraceSpan traceSpan{"update_state"};
     const gint64 node_id_data_holder = tree_iter.get_node_id_data_holder();
     auto& node_states = _node_states[node_id_data_holder];
     if (not node_states.states.empty() and not curr_index_is_last_index(node_id_data_holder)) {
-        node_states.states.erase(node_states.states.begin() + node_states.index + 1, node_states.states.end());
+        _erase_states(node_states, node_states.index + 1, node_states.states.size());
     }
 
-    auto new_state = std::shared_ptr<CtNodeState>(new CtNodeState{});
-    CtStorageXmlHelper{_pCtMainWin}.save_buffer_no_widgets_to_xml(new_state->buffer_xml.get_root_node(),
-                                                                  tree_iter.get_node_text_buffer(), 0, -1, 'n');
-    new_state->buffer_xml_string = new_state->buffer_xml.write_to_string();
-    for (auto widget : tree_iter.get_anchored_widgets()) {
-        new_state->widgetStates.push_back(widget->get_state());
-    }
+    auto new_state = _new_state(tree_iter);
 
     if (node_states.states.size() > 0) {
         auto compare_widgets = [](const std::list<std::shared_ptr<CtAnchoredWidgetState>> lhs,
                                   const std::list<std::shared_ptr<CtAnchoredWidgetState>> rhs){
             return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](std::shared_ptr<CtAnchoredWidgetState> lhs, std::shared_ptr<CtAnchoredWidgetState> rhs) {
-                return lhs->equal(rhs);
+                return lhs == rhs or lhs->equal(rhs); // same pointer if the widget is unchanged
             });
         };
-        auto last_state = node_states.states.back();
-        if (new_state->buffer_xml_string == last_state->buffer_xml_string and
+        auto last_state = _page_in(node_states.states.back());
+        if (last_state and
+            new_state->buffer_xml_string == last_state->buffer_xml_string and
             compare_widgets(new_state->widgetStates, last_state->widgetStates))
         {
             return; // #print "update_state not needed"
@@ -430,11 +448,16 @@ void CtStateMachine::update_state(CtTreeIter tree_iter)
     new_state->v_adj_val = round(_pCtMainWin->getScrolledwindowText().get_vadjustment()->get_value());
 
     node_states.states.push_back(new_state);
-    while ((int)node_states.states.size() > _pCtMainWin->get_ct_config()->limitUndoableSteps) {
-        node_states.states.erase(node_states.states.begin());
+    _ramBytes += new_state->buffer_xml_string.bytes();
+    CtTrace::counter_add(CtTraceCounter::UndoStates, 1);
+    const int limitUndoableSteps = _pCtMainWin->get_ct_config()->limitUndoableSteps;
+    if ((int)node_states.states.size() > limitUndoableSteps) {
+        _erase_states(node_states, 0, node_states.states.size() - std::max(limitUndoableSteps, 1));
     }
     node_states.index = node_states.states.size() - 1;
     node_states.indicator = 0; // the current buffer state is saved
+    node_states.lastUse = ++_useCounter;
+    _spill_over_budgets(node_id_data_holder);
 }
 
 void CtStateMachine::update_curr_state_cursor_pos(const gint64 node_id_data_holder)
@@ -460,3 +483,117 @@ void CtStateMachine::update_curr_state_v_adj_val(const gint64 node_id_data_holde
         iterStates->second.get_state()->v_adj_val = v_adj_val;
     }
 }
+
+std::shared_ptr<CtNodeState> CtStateMachine::_new_state(CtTreeIter& tree_iter)
+{
+    auto state = std::make_shared<CtNodeState>();
+    xmlpp::Document buffer_xml;
+    CtStorageXmlHelper{_pCtMainWin}.save_buffer_no_widgets_to_xml(buffer_xml.create_root_node("buffer"),
+                                                                  tree_iter.get_node_text_buffer(), 0, -1, 'n');
+    state->buffer_xml_string = buffer_xml.write_to_string();
+    for (auto widget : tree_iter.get_anchored_widgets()) {
+        state->widgetStates.push_back(widget->get_state_shared());
+    }
+    return state;
+}
+
+// Read back the buffer of a state spilled to the arena, nullptr if it cannot be read
+std::shared_ptr<CtNodeState> CtStateMachine::_page_in(std::shared_ptr<CtNodeState> state)
+{
+    if (not state or state->spilledSlotId < 0) {
+        return state;
+    }
+    std::string buffer_xml_string;
+    if (not _uStatesArena or not _uStatesArena->get(state->spilledSlotId, buffer_xml_string)) {
+        spdlog::error("!! {} {}", __FUNCTION__, state->spilledSlotId);
+        return nullptr;
+    }
+    _uStatesArena->release(state->spilledSlotId);
+    state->spilledSlotId = -1;
+    state->buffer_xml_string = std::move(buffer_xml_string);
+    _ramBytes += state->buffer_xml_string.bytes();
+    return state;
+}
+
+// Move the buffer of a state to the arena, it stays in memory if the arena fails
+void CtStateMachine::_spill(CtNodeState& state)
+{
+    if (state.spilledSlotId >= 0 or state.buffer_xml_string.empty()) {
+        return;
+    }
+    if (not _uStatesArena) {
+        static int arenaCounter{0}; // one arena per window, in the same temporary directory
+        const fs::path dirPath = _pCtMainWin->get_ct_tmp()->getHiddenDirPath("undo_states");
+        _uStatesArena = std::make_unique<CtStatesArena>(dirPath / ("states_" + std::to_string(++arenaCounter)));
+    }
+    const gint64 slotId = _uStatesArena->put(state.buffer_xml_string.raw());
+    if (slotId < 0) {
+        return;
+    }
+    state.spilledSlotId = slotId;
+    _ramBytes -= state.buffer_xml_string.bytes();
+    Glib::ustring{}.swap(state.buffer_xml_string); // release the memory, clear() would keep the capacity
+}
+
+void CtStateMachine::_forget(const CtNodeState& state)
+{
+    if (state.spilledSlotId >= 0) {
+        if (_uStatesArena) {
+            _uStatesArena->release(state.spilledSlotId);
+        }
+    }
+    else {
+        _ramBytes -= state.buffer_xml_string.bytes();
+    }
+}
+
+void CtStateMachine::_erase_states(CtNodeStates& node_states, const size_t first, const size_t last)
+{
+    for (size_t i = first; i < last; ++i) {
+        _forget(*node_states.states[i]);
+    }
+    node_states.states.erase(node_states.states.begin() + first, node_states.states.begin() + last);
+}
+
+// Keep in memory the most recent states of the node and the current one; then, over the memory budget,
+// spill all the states of the nodes least recently used down to a margin below the budget
+void CtStateMachine::_spill_over_budgets(const gint64 node_id_data_holder)
+{
+    CtConfig* pCtConfig = _pCtMainWin->get_ct_config();
+    const auto iterStates = _node_states.find(node_id_data_holder);
+    if (pCtConfig->undoRamStatesPerNode > 0 and iterStates != _node_states.end()) {
+        CtNodeStates& node_states = iterStates->second;
+        const int firstInRam = (int)node_states.states.size() - pCtConfig->undoRamStatesPerNode;
+        for (int i = 0; i < firstInRam; ++i) {
+            if (i != node_states.index) {
+                _spill(*node_states.states[i]);
+            }
+        }
+    }
+    const size_t budgetBytes = pCtConfig->undoRamBudgetMB > 0 ? static_cast<size_t>(pCtConfig->undoRamBudgetMB)*1024u*1024u : 0u;
+    if (0 == budgetBytes or _ramBytes <= budgetBytes or _ramBytes < _noSpillBelowBytes) {
+        return;
+    }
+    const size_t targetBytes = budgetBytes/100u*SpillToPercentOfBudget;
+    CtTraceSpan traceSpan{"spill_undo_states"};
+    std::vector<std::pair<guint64, CtNodeStates*>> lruNodesStates;
+    for (auto& currPair : _node_states) {
+        if (currPair.first != node_id_data_holder) {
+            lruNodesStates.push_back(std::make_pair(currPair.second.lastUse, &currPair.second));
+        }
+    }
+    std::sort(lruNodesStates.begin(), lruNodesStates.end(), [](const auto& lhs, const auto& rhs){
+        return lhs.first < rhs.first;
+    });
+    for (auto& currPair : lruNodesStates) {
+        if (_ramBytes <= targetBytes) {
+            break;
+        }
+        for (auto& state : currPair.second->states) {
+            _spill(*state);
+        }
+    }
+    // when what is left cannot be spilled, do not sort all the nodes again on every next state
+    _noSpillBelowBytes = _ramBytes > targetBytes ? _ramBytes + budgetBytes/4u : 0u;
+    spdlog::debug("{} in memory {} KB, spilled {}", __FUNCTION__, _ramBytes/1024u, get_num_spilled());
+}
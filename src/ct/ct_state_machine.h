@@ -27,6 +27,7 @@
 #include "ct_image.h"
 #include "ct_codebox.h"
 #include "ct_table.h"
+#include "ct_states_arena.h"
 #include <vector>
 #include <map>
 #include <glibmm/regex.h>
@@ -45,6 +46,8 @@ public:
 
     virtual bool equal(std::shared_ptr<CtAnchoredWidgetState> state) = 0;
     virtual CtAnchoredWidget* to_widget(CtMainWin* pCtMainWin) = 0;
+    // copy sharing the content, for the widgets with a content generation
+    virtual std::shared_ptr<CtAnchoredWidgetState> copy() const { return nullptr; }
 
 public:
     int charOffset;
@@ -58,6 +61,9 @@ public:
 
     bool equal(std::shared_ptr<CtAnchoredWidgetState> state) override;
     CtAnchoredWidget* to_widget(CtMainWin* pCtMainWin) override;
+    std::shared_ptr<CtAnchoredWidgetState> copy() const override {
+        return std::make_shared<CtAnchoredWidgetState_ImagePng>(*this);
+    }
 
 public:
     Glib::ustring link;
@@ -71,6 +77,9 @@ public:
 
     bool equal(std::shared_ptr<CtAnchoredWidgetState> state) override;
     CtAnchoredWidget* to_widget(CtMainWin* pCtMainWin) override;
+    std::shared_ptr<CtAnchoredWidgetState> copy() const override {
+        return std::make_shared<CtAnchoredWidgetState_Anchor>(*this);
+    }
 
 public:
     Glib::ustring name;
@@ -83,6 +92,9 @@ public:
 
     bool equal(std::shared_ptr<CtAnchoredWidgetState> state) override;
     CtAnchoredWidget* to_widget(CtMainWin* pCtMainWin) override;
+    std::shared_ptr<CtAnchoredWidgetState> copy() const override {
+        return std::make_shared<CtAnchoredWidgetState_Latex>(*this);
+    }
 
 public:
     Glib::ustring text;
@@ -96,10 +108,13 @@ public:
 
     bool equal(std::shared_ptr<CtAnchoredWidgetState> state) override;
     CtAnchoredWidget* to_widget(CtMainWin* pCtMainWin) override;
+    std::shared_ptr<CtAnchoredWidgetState> copy() const override {
+        return std::make_shared<CtAnchoredWidgetState_EmbFile>(*this);
+    }
 
 public:
     fs::path      fileName;
-    std::string   rawBlob;      // raw data, not a string
+    std::shared_ptr<const CtEmbFileBlob> pBlob;
     time_t        timeSeconds;
     const size_t  uniqueId;
 };
@@ -111,9 +126,13 @@ public:
 
     bool equal(std::shared_ptr<CtAnchoredWidgetState> state) override;
     CtAnchoredWidget* to_widget(CtMainWin* pCtMainWin) override;
+    std::shared_ptr<CtAnchoredWidgetState> copy() const override {
+        return std::make_shared<CtAnchoredWidgetState_Codebox>(*this);
+    }
 
 public:
-    Glib::ustring content, syntax;
+    std::shared_ptr<const Glib::ustring> pContent;
+    Glib::ustring syntax;
     int width, height;
     bool widthInPixels, brackets, showNum;
 };
@@ -131,7 +150,7 @@ public:
 
     int colWidthDefault;
     CtTableColWidths colWidths;
-    std::vector<std::vector<Glib::ustring>> rows;
+    std::shared_ptr<const std::vector<std::vector<Glib::ustring>>> pRows;
     size_t currRow;
     size_t currCol;
 };
@@ -144,6 +163,9 @@ public:
     CtAnchoredWidget* to_widget(CtMainWin* pCtMainWin) override {
         return to_widget_light(pCtMainWin);
     }
+    std::shared_ptr<CtAnchoredWidgetState> copy() const override {
+        return std::make_shared<CtAnchoredWidgetState_TableLight>(*this);
+    }
 };
 class CtAnchoredWidgetState_TableHeavy : public CtAnchoredWidgetState_TableCommon
 {
@@ -154,15 +176,16 @@ public:
     CtAnchoredWidget* to_widget(CtMainWin* pCtMainWin) override {
         return to_widget_heavy(pCtMainWin);
     }
+    std::shared_ptr<CtAnchoredWidgetState> copy() const override {
+        return std::make_shared<CtAnchoredWidgetState_TableHeavy>(*this);
+    }
 };
 
 struct CtNodeState
 {
-    CtNodeState()  { buffer_xml.create_root_node("buffer"); }
-
     std::list<std::shared_ptr<CtAnchoredWidgetState>> widgetStates;
-    xmlpp::Document buffer_xml;
-    Glib::ustring   buffer_xml_string;
+    Glib::ustring   buffer_xml_string; // empty while spilled to the states arena
+    gint64          spilledSlotId{-1};
     int             cursor_pos{0};
     int             v_adj_val{0};
 };
@@ -172,6 +195,7 @@ struct CtNodeStates
     std::vector<std::shared_ptr<CtNodeState>> states;
     int index;
     int indicator;
+    guint64 lastUse{0};
 
     std::shared_ptr<CtNodeState> get_state() { return states[index]; }
 };
@@ -206,7 +230,17 @@ public:
         _visited_nodes_idx = _visited_nodes_list.size() - 1;
     }
 
+    size_t get_ram_bytes() const { return _ramBytes; }
+    size_t get_num_spilled() const { return _uStatesArena ? _uStatesArena->get_num_slots() : 0u; }
+
 private:
+    std::shared_ptr<CtNodeState> _new_state(CtTreeIter& tree_iter);
+    std::shared_ptr<CtNodeState> _page_in(std::shared_ptr<CtNodeState> state);
+    void _spill(CtNodeState& state);
+    void _forget(const CtNodeState& state);
+    void _erase_states(CtNodeStates& node_states, const size_t first, const size_t last);
+    void _spill_over_budgets(const gint64 node_id_data_holder);
+
     CtMainWin*                  _pCtMainWin;
     Glib::RefPtr<Glib::Regex>   _word_regex;
     bool                        _go_bk_fw_active;
@@ -216,4 +250,11 @@ private:
     int                         _visited_nodes_idx;
 
     std::map<gint64, CtNodeStates> _node_states;
+    // only the most recent states of each node are kept in memory, the others are compressed in the arena
+    std::unique_ptr<CtStatesArena> _uStatesArena;
+    size_t                      _ramBytes{0};
+    size_t                      _noSpillBelowBytes{0};
+    guint64                     _useCounter{0};
+
+    static constexpr size_t SpillToPercentOfBudget{75u};
 };
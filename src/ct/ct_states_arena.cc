@@ -0,0 +1,223 @@
+/*
+ * ct_states_arena.cc
+ *
+ * Copyright 2009-2024
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_states_arena.h"
+#include "ct_logging.h"
+#include "../7za/C/Alloc.h"
+#include "../7za/C/LzmaDec.h"
+#include "../7za/C/LzmaEnc.h"
+#include <glib/gstdio.h>
+
+CtStatesArena::CtStatesArena(const fs::path& filePath)
+ : _filePath{filePath}
+{
+}
+
+CtStatesArena::~CtStatesArena()
+{
+    clear();
+}
+
+/*static*/bool CtStatesArena::compress(const std::string& raw, std::string& compressed)
+{
+    CLzmaEncProps props;
+    LzmaEncProps_Init(&props);
+    props.level = 1;          // fast, the xml of the buffer compresses well anyway
+    props.dictSize = 1 << 20;
+    props.numThreads = 1;
+    SizeT destLen = raw.size() + raw.size()/3u + 128u;
+    compressed.resize(LZMA_PROPS_SIZE + destLen);
+    SizeT propsSize = LZMA_PROPS_SIZE;
+    const SRes res = LzmaEncode(reinterpret_cast<Byte*>(&compressed[LZMA_PROPS_SIZE]), &destLen,
+                                reinterpret_cast<const Byte*>(raw.data()), raw.size(),
+                                &props,
+                                reinterpret_cast<Byte*>(&compressed[0]), &propsSize,
+                                0/*writeEndMark*/, nullptr/*progress*/, &g_Alloc, &g_Alloc);
+    if (SZ_OK != res or LZMA_PROPS_SIZE != propsSize) {
+        spdlog::error("!! {} {}", __FUNCTION__, res);
+        return false;
+    }
+    compressed.resize(LZMA_PROPS_SIZE + destLen);
+    return true;
+}
+
+/*static*/bool CtStatesArena::decompress(const std::string& compressed, const size_t rawSize, std::string& raw)
+{
+    if (compressed.size() < LZMA_PROPS_SIZE) {
+        return false;
+    }
+    raw.resize(rawSize);
+    SizeT destLen = rawSize;
+    SizeT srcLen = compressed.size() - LZMA_PROPS_SIZE;
+    ELzmaStatus status;
+    const SRes res = LzmaDecode(reinterpret_cast<Byte*>(&raw[0]), &destLen,
+                                reinterpret_cast<const Byte*>(&compressed[LZMA_PROPS_SIZE]), &srcLen,
+                                reinterpret_cast<const Byte*>(&compressed[0]), LZMA_PROPS_SIZE,
+                                LZMA_FINISH_END, &status, &g_Alloc);
+    if (SZ_OK != res or destLen != rawSize) {
+        spdlog::error("!! {} {} {}/{}", __FUNCTION__, res, destLen, rawSize);
+        return false;
+    }
+    return true;
+}
+
+gint64 CtStatesArena::put(const std::string& data)
+{
+    std::string compressed;
+    if (not compress(data, compressed) or not _open() or not _seek(_pFile, _fileBytes)) {
+        return -1;
+    }
+    if (fwrite(compressed.data(), 1, compressed.size(), _pFile) != compressed.size()) {
+        spdlog::error("!! {} write {}", __FUNCTION__, _filePath.string());
+        return -1;
+    }
+    const gint64 slotId = _nextSlotId++;
+    _slots[slotId] = CtSlot{_fileBytes, compressed.size(), data.size()};
+    _fileBytes += static_cast<gint64>(compressed.size());
+    _liveBytes += static_cast<gint64>(compressed.size());
+    return slotId;
+}
+
+bool CtStatesArena::get(const gint64 slotId, std::string& data)
+{
+    const auto it = _slots.find(slotId);
+    if (_slots.end() == it or not _pFile) {
+        spdlog::error("!! {} {}", __FUNCTION__, slotId);
+        return false;
+    }
+    std::string compressed;
+    return _read_compressed(_pFile, it->second, compressed) and decompress(compressed, it->second.rawSize, data);
+}
+
+void CtStatesArena::release(const gint64 slotId)
+{
+    const auto it = _slots.find(slotId);
+    if (_slots.end() == it) {
+        return;
+    }
+    _liveBytes -= static_cast<gint64>(it->second.compressedSize);
+    _slots.erase(it);
+    if (_slots.empty()) {
+        clear();
+    }
+    else {
+        _compact_if_mostly_unused();
+    }
+}
+
+void CtStatesArena::clear()
+{
+    _close();
+    _slots.clear();
+    _fileBytes = 0;
+    _liveBytes = 0;
+}
+
+bool CtStatesArena::_open()
+{
+    if (not _pFile) {
+        _pFile = g_fopen(_filePath.c_str(), "w+b");
+        if (not _pFile) {
+            spdlog::error("!! {} {}", __FUNCTION__, _filePath.string());
+            return false;
+        }
+        _fileBytes = 0;
+    }
+    return true;
+}
+
+void CtStatesArena::_close()
+{
+    if (_pFile) {
+        fclose(_pFile);
+        _pFile = nullptr;
+        (void)g_remove(_filePath.c_str());
+    }
+}
+
+bool CtStatesArena::_read_compressed(FILE* pFile, const CtSlot& slot, std::string& compressed)
+{
+    compressed.resize(slot.compressedSize);
+    if (not _seek(pFile, slot.offset) or
+        fread(&compressed[0], 1, slot.compressedSize, pFile) != slot.compressedSize)
+    {
+        spdlog::error("!! {} {}", __FUNCTION__, _filePath.string());
+        return false;
+    }
+    return true;
+}
+
+void CtStatesArena::_compact_if_mostly_unused()
+{
+    if (_fileBytes < CompactMinFileBytes or _liveBytes*2 > _fileBytes) {
+        return;
+    }
+    // the live slots are copied to a new file that replaces the current one
+    const fs::path tmpFilePath = _filePath.string() + ".compact";
+    FILE* pTmpFile = g_fopen(tmpFilePath.c_str(), "w+b");
+    if (not pTmpFile) {
+        spdlog::error("!! {} {}", __FUNCTION__, tmpFilePath.string());
+        return;
+    }
+    std::unordered_map<gint64, CtSlot> newSlots;
+    gint64 newFileBytes{0};
+    std::string compressed;
+    for (const auto& currPair : _slots) {
+        if (not _read_compressed(_pFile, currPair.second, compressed) or
+            fwrite(compressed.data(), 1, compressed.size(), pTmpFile) != compressed.size())
+        {
+            fclose(pTmpFile);
+            (void)g_remove(tmpFilePath.c_str());
+            return;
+        }
+        newSlots[currPair.first] = CtSlot{newFileBytes, currPair.second.compressedSize, currPair.second.rawSize};
+        newFileBytes += static_cast<gint64>(compressed.size());
+    }
+    fclose(_pFile);
+    fclose(pTmpFile);
+    _pFile = nullptr;
+    if (not fs::move_file(tmpFilePath, _filePath)) {
+        spdlog::error("!! {} move {}", __FUNCTION__, tmpFilePath.string());
+        _slots.clear(); // the states not in memory are lost, rather than read from a wrong offset
+        clear();
+        return;
+    }
+    _pFile = g_fopen(_filePath.c_str(), "r+b");
+    _slots = std::move(newSlots);
+    _fileBytes = newFileBytes;
+    _liveBytes = newFileBytes;
+    if (not _pFile) {
+        spdlog::error("!! {} reopen {}", __FUNCTION__, _filePath.string());
+        _slots.clear();
+        clear();
+    }
+}
+
+/*static*/bool CtStatesArena::_seek(FILE* pFile, const gint64 offset)
+{
+#if defined(_WIN32)
+    return 0 == _fseeki64(pFile, offset, SEEK_SET);
+#else // !_WIN32
+    return 0 == fseeko(pFile, static_cast<off_t>(offset), SEEK_SET);
+#endif // !_WIN32
+}
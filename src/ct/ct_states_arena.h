@@ -0,0 +1,75 @@
+/*
+ * ct_states_arena.h
+ *
+ * Copyright 2009-2024
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#pragma once
+
+#include "ct_filesystem.h"
+#include <glib.h>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+
+// Undo states compressed with LZMA and spilled to a temporary file, each one read back when needed;
+// the space of the released states is reclaimed rewriting the file when it is mostly unused
+class CtStatesArena
+{
+public:
+    CtStatesArena(const fs::path& filePath);
+    ~CtStatesArena();
+
+    // returns the slot id, -1 if the data could not be spilled
+    gint64 put(const std::string& data);
+    bool   get(const gint64 slotId, std::string& data);
+    void   release(const gint64 slotId);
+    void   clear();
+
+    size_t get_num_slots() const { return _slots.size(); }
+    gint64 get_file_bytes() const { return _fileBytes; }
+
+    static bool compress(const std::string& raw, std::string& compressed);
+    static bool decompress(const std::string& compressed, const size_t rawSize, std::string& raw);
+
+private:
+    struct CtSlot
+    {
+        gint64 offset{0};
+        size_t compressedSize{0};
+        size_t rawSize{0};
+    };
+
+    bool _open();
+    void _close();
+    bool _read_compressed(FILE* pFile, const CtSlot& slot, std::string& compressed);
+    void _compact_if_mostly_unused();
+
+    static bool _seek(FILE* pFile, const gint64 offset);
+
+    static constexpr gint64 CompactMinFileBytes{16*1024*1024};
+
+    const fs::path                     _filePath;
+    FILE*                              _pFile{nullptr};
+    gint64                             _fileBytes{0};
+    gint64                             _liveBytes{0};
+    gint64                             _nextSlotId{0};
+    std::unordered_map<gint64, CtSlot> _slots;
+};
@@ -26,10 +26,14 @@
 #include "ct_storage_xml.h"
 #include "ct_storage_sqlite.h"
 #include "ct_storage_multifile.h"
+#include "ct_storage_verify.h"
 #include "ct_p7za_iface.h"
 #include "ct_main_win.h"
+#include "ct_actions.h"
 #include "ct_logging.h"
+#include "ct_trace.h"
 #include <glib/gstdio.h>
+#include <atomic>
 
 //#define DEBUG_BACKUP_ENCRYPT
 
@@ -59,6 +63,7 @@
                                                         Glib::ustring& error,
                                                         Glib::ustring password)
 {
+    CtTraceOperation traceOperation{"load"};
     fs::path extracted_file_path{file_path};
 
     try {
@@ -70,6 +75,7 @@
 
             // unpack file if need
             if (fs::get_doc_encrypt_from_file_ext(file_path) == CtDocEncrypt::True) {
+                CtTraceSpan traceSpan{"extract"};
                 extracted_file_path = _extract_file(pCtMainWin, file_path, password);
                 if (extracted_file_path.empty()) {
                     // user canceled operation
@@ -92,6 +98,7 @@
         doc->_password = password;
         doc->_extracted_file_path = extracted_file_path;
         doc->_storage.swap(pStorage);
+        doc->_compact_schedule();
         return doc;
     }
     catch (std::exception& e) {
@@ -104,15 +111,6 @@
     }
 }
 
-/*static*/bool CtStorageControl::document_integrity_check_pass(CtMainWin* pCtMainWin, const fs::path& file_path, Glib::ustring& error)
-{
-    std::unique_ptr<CtStorageEntity> storage = CtStorageControl::_get_entity_by_type(pCtMainWin, fs::get_doc_type_from_file_ext(file_path));
-    if (not storage) throw std::runtime_error("no storage");
-
-    storage->set_is_dry_run();
-    return storage->populate_treestore(file_path, error);
-}
-
 /*static*/CtStorageControl* CtStorageControl::save_as(CtMainWin* pCtMainWin,
                                                       const fs::path& file_path,
                                                       const CtDocType doc_type,
@@ -122,6 +120,7 @@
                                                       const int start_offset/*= 0*/,
                                                       const int end_offset/*= -1*/)
 {
+    CtTraceOperation traceOperation{"save_as"};
     auto on_scope_exit = scope_guard([&](void*) { pCtMainWin->get_status_bar().pop(); });
     pCtMainWin->get_status_bar().push(_("Writing to Disk..."));
     while (gtk_events_pending()) gtk_main_iteration();
@@ -199,11 +198,12 @@
         }
         // encrypt the file
         if (file_path != extracted_file_path) {
+            CtTraceSpan traceSpan{"encrypt"};
             storage->close_connect(); // temporary, because of sqlite keeping the file
             if (not _package_file(extracted_file_path, file_path, password)) {
                 throw std::runtime_error("couldn't encrypt the file");
             }
-            storage->reopen_connect();
+            storage->reopen_connect(false/*file_replaced*/);
         }
 
         // it's ready
@@ -213,6 +213,9 @@
         doc->_password = password;
         doc->_extracted_file_path = extracted_file_path;
         doc->_storage.swap(storage);
+        if (CtTrace::is_enabled() and CtDocType::MultiFile != doc_type) {
+            CtTrace::counter_add(CtTraceCounter::BytesWritten, static_cast<gint64>(fs::file_size(file_path)));
+        }
         return doc;
     }
     catch (std::exception& e) {
@@ -259,8 +262,16 @@ bool CtStorageControl::try_reopen(Glib::ustring& error)
 
 bool CtStorageControl::save(bool need_vacuum, Glib::ustring &error)
 {
+    if (_isSaving) {
+        spdlog::debug("{} already saving", __FUNCTION__);
+        return false;
+    }
+    CtTraceOperation traceOperation{"save"};
+    _compactTimeoutConnection.disconnect();
     _mod_time = 0;
+    _isSaving = true;
     auto on_scope_exit = scope_guard([&](void*) {
+        _isSaving = false;
         _pCtMainWin->get_status_bar().pop();
         _mod_time = fs::getmtime(_file_path);
     });
@@ -288,6 +299,7 @@ bool CtStorageControl::save(bool need_vacuum, Glib::ustring &error)
         _storage->test_connection();
 
         if (need_main_backup) {
+            CtTraceSpan traceSpan{"main_backup"};
             if (CtDocType::SQLite == doc_type and not need_encrypt) {
                 _storage->close_connect(); // temporary, because of sqlite keepig the file
                 if (not fs::copy_file(_file_path, main_backup)) {
@@ -296,7 +308,7 @@ bool CtStorageControl::save(bool need_vacuum, Glib::ustring &error)
 #if defined(DEBUG_BACKUP_ENCRYPT)
                 spdlog::debug("{} ++ {}", _file_path.string(), main_backup.string());
 #endif // DEBUG_BACKUP_ENCRYPT
-                _storage->reopen_connect();
+                _storage->reopen_connect(false/*file_replaced*/);
             }
             else {
                 if (not fs::move_file(_file_path, main_backup)) {
@@ -318,8 +330,9 @@ bool CtStorageControl::save(bool need_vacuum, Glib::ustring &error)
 #if defined(DEBUG_BACKUP_ENCRYPT)
         spdlog::debug("saved {}", _extracted_file_path.string());
 #endif // DEBUG_BACKUP_ENCRYPT
-        if (need_vacuum) {
-            _storage->vacuum();
+        if (CtTrace::is_enabled() and CtDocType::MultiFile != doc_type) {
+            // as for save_as the size of the written file, for sqlite the pages actually written are not known
+            CtTrace::counter_add(CtTraceCounter::BytesWritten, static_cast<gint64>(fs::file_size(_extracted_file_path)));
         }
         if (need_main_backup or need_encrypt) {
             std::shared_ptr<CtBackupEncryptData> pBackupEncryptData = std::make_shared<CtBackupEncryptData>();
@@ -327,7 +340,12 @@ bool CtStorageControl::save(bool need_vacuum, Glib::ustring &error)
             pBackupEncryptData->needEncrypt = need_encrypt;
             pBackupEncryptData->file_path = _file_path.string();
             pBackupEncryptData->main_backup = main_backup.string();
-            if (need_encrypt) {
+            if (not need_encrypt) {
+                // the main backup is verified, it holds the document as before this save
+                pBackupEncryptData->nodes_digests = _docDigests;
+            }
+            else {
+                pBackupEncryptData->nodes_digests = _storage->get_nodes_digests();
                 pBackupEncryptData->extracted_copy = _extracted_file_path.string() + (str_timestamp + _extracted_file_path.extension());
                 _storage->close_connect(); // temporary, because of sqlite keepig the file
                 if (not fs::copy_file(_extracted_file_path, pBackupEncryptData->extracted_copy)) {
@@ -336,24 +354,24 @@ bool CtStorageControl::save(bool need_vacuum, Glib::ustring &error)
 #if defined(DEBUG_BACKUP_ENCRYPT)
                 spdlog::debug("{} ++ {}", _extracted_file_path.string(), pBackupEncryptData->extracted_copy);
 #endif // DEBUG_BACKUP_ENCRYPT
-                _storage->reopen_connect();
+                _storage->reopen_connect(false/*file_replaced*/);
                 pBackupEncryptData->password = _password;
             }
             backupEncryptDEQueue.push_back(pBackupEncryptData);
         }
+        _update_doc_digests(doc_type);
         _syncPending.fix_db_tables = false;
         _syncPending.bookmarks_to_write = false;
         _syncPending.nodes_to_rm_set.clear();
         _syncPending.nodes_to_write_dict.clear();
-
-        return true;
+        _adopt_saved_nodes();
     }
     catch (std::exception& e) {
         // recover from backup
         try {
             _storage->close_connect();
-            if (need_main_backup and fs::is_regular_file(main_backup)) fs::move_file(main_backup, _file_path);
-            _storage->reopen_connect();
+            const bool restored = need_main_backup and fs::is_regular_file(main_backup) and fs::move_file(main_backup, _file_path);
+            _storage->reopen_connect(restored/*file_replaced*/);
         }
         catch (std::exception& e2) { spdlog::error(e2.what()); }
 
@@ -361,12 +379,51 @@ bool CtStorageControl::save(bool need_vacuum, Glib::ustring &error)
         error = e.what();
         return false;
     }
+
+    // the vacuum comes when the save is complete, the edits made meanwhile are pending for the next save
+    // and a vacuum failure leaves the saved document as it was
+    if (need_vacuum) {
+        CtTraceSpan traceSpan{"vacuum"};
+        try {
+            _vacuum_with_progress();
+        }
+        catch (std::exception& e) {
+            spdlog::error("!! vacuum {}", e.what());
+        }
+    }
+    _compact_schedule();
+    return true;
 }
 
 Glib::RefPtr<Gsv::Buffer> CtStorageControl::get_delayed_text_buffer(const gint64 node_id,
                                                                     const std::string& syntax,
                                                                     std::list<CtAnchoredWidget*>& widgets) const
 {
+    CtTraceSpan traceSpan{"load_node_buffer"};
+    _vacuum_interrupt_n_wait();
+    const auto itAdded = _addedNodesXml.find(node_id);
+    if (_addedNodesXml.end() != itAdded) {
+        auto xml_element = dynamic_cast<xmlpp::Element*>(itAdded->second->get_root_node()->get_first_child());
+        auto ret_buffer = CtStorageXmlHelper{_pCtMainWin}.create_buffer_and_widgets_from_xml(xml_element, syntax, widgets, nullptr, -1, "");
+        if (ret_buffer) {
+            _addedNodesXml.erase(itAdded);
+        }
+        return ret_buffer;
+    }
+    const auto itImported = _importedNodes.find(node_id);
+    if (_importedNodes.end() != itImported) {
+        auto node_doc = std::make_shared<xmlpp::Document>();
+        xmlpp::Element* xml_element = node_doc->create_root_node("root")->add_child("node");
+        if (not _get_imported_node_xml(node_id, syntax, xml_element)) {
+            return Glib::RefPtr<Gsv::Buffer>{};
+        }
+        auto ret_buffer = CtStorageXmlHelper{_pCtMainWin}.create_buffer_and_widgets_from_xml(xml_element, syntax, widgets, nullptr, -1, "");
+        if (ret_buffer) {
+            // the source document is released with its last imported node
+            _importedNodes.erase(node_id);
+        }
+        return ret_buffer;
+    }
     if (not _storage) {
         spdlog::error("!! storage is not initialized");
         return Glib::RefPtr<Gsv::Buffer>{};
@@ -374,6 +431,121 @@ Glib::RefPtr<Gsv::Buffer> CtStorageControl::get_delayed_text_buffer(const gint64
     return _storage->get_delayed_text_buffer(node_id, syntax, widgets);
 }
 
+bool CtStorageControl::get_stored_node_xml(const CtTreeIter& ct_tree_iter, xmlpp::Element* p_node_node) const
+{
+    _vacuum_interrupt_n_wait();
+    const gint64 node_id = ct_tree_iter.get_node_id_data_holder();
+    const auto itAdded = _addedNodesXml.find(node_id);
+    if (_addedNodesXml.end() != itAdded) {
+        // added in this session and never loaded, the xml is all there is
+        auto xml_element = dynamic_cast<xmlpp::Element*>(itAdded->second->get_root_node()->get_first_child());
+        for (xmlpp::Node* xml_slot : xml_element->get_children()) {
+            if (dynamic_cast<xmlpp::Element*>(xml_slot)) {
+                p_node_node->import_node(xml_slot);
+            }
+        }
+        return true;
+    }
+    const auto itImported = _importedNodes.find(node_id);
+    if (_importedNodes.end() != itImported and ct_tree_iter.get_node_buffer_already_loaded()) {
+        // the content to save is in the text buffer, the source is released by _adopt_saved_nodes
+        return false;
+    }
+    if (_importedNodes.end() != itImported) {
+        if (_get_imported_node_xml(node_id, ct_tree_iter.get_node_syntax_highlighting(), p_node_node)) {
+            return true;
+        }
+        for (xmlpp::Node* pChild : p_node_node->get_children()) {
+            p_node_node->remove_child(pChild);
+        }
+        return false;
+    }
+    if (not _storage) {
+        return false;
+    }
+    const auto it = _syncPending.nodes_to_write_dict.find(node_id);
+    if (_syncPending.nodes_to_write_dict.end() != it and it->second.buff) {
+        return false; // the content to save is in the text buffer
+    }
+    if (_storage->get_delayed_node_xml(node_id, ct_tree_iter.get_node_syntax_highlighting(), p_node_node)) {
+        return true;
+    }
+    for (xmlpp::Node* pChild : p_node_node->get_children()) {
+        p_node_node->remove_child(pChild);
+    }
+    return false;
+}
+
+void CtStorageControl::add_delayed_node_xml(const gint64 node_id, std::shared_ptr<xmlpp::Document> pNodeDoc)
+{
+    _addedNodesXml[node_id] = pNodeDoc;
+}
+
+bool CtStorageControl::release_node_buffer(const CtTreeIter& ct_tree_iter)
+{
+    if (not _storage) {
+        return false;
+    }
+    const gint64 node_id = ct_tree_iter.get_node_id();
+    if (_addedNodesXml.count(node_id) != 0 or _importedNodes.count(node_id) != 0) {
+        return false; // not in the storage
+    }
+    if (_pCtMainWin->get_ct_actions()->get_were_embfiles_opened_in_node(ct_tree_iter.get_node_id_data_holder())) {
+        return false; // the edits of the opened files go to the widgets of this text buffer
+    }
+    const auto it = _syncPending.nodes_to_write_dict.find(node_id);
+    if (_syncPending.nodes_to_write_dict.end() != it and (it->second.buff or not it->second.is_update_of_existing)) {
+        return false; // the content to save is in the text buffer
+    }
+    return _storage->release_text_buffer(ct_tree_iter);
+}
+
+void CtStorageControl::_adopt_saved_nodes()
+{
+    // the nodes added or imported and never loaded were written by the save, from now on they are loaded
+    // from the storage and the source documents are released with their last imported node
+    for (auto it = _importedNodes.begin(); it != _importedNodes.end();) {
+        if (_storage->adopt_saved_node(it->first)) it = _importedNodes.erase(it);
+        else ++it;
+    }
+    for (auto it = _addedNodesXml.begin(); it != _addedNodesXml.end();) {
+        if (_storage->adopt_saved_node(it->first)) it = _addedNodesXml.erase(it);
+        else ++it;
+    }
+}
+
+bool CtStorageControl::_get_imported_node_xml(const gint64 node_id, const std::string& syntax, xmlpp::Element* p_node_node) const
+{
+    const CtImportedNode& importedNode = _importedNodes.at(node_id);
+    if (not importedNode.pSource->get_delayed_node_xml(importedNode.sourceNodeId, syntax, p_node_node)) {
+        spdlog::error("!! {} node_id {} (source {})", __FUNCTION__, node_id, importedNode.sourceNodeId);
+        return false;
+    }
+    _imported_links_remap(p_node_node, *importedNode.pIdsRemap);
+    return true;
+}
+
+/*static*/void CtStorageControl::_imported_links_remap(xmlpp::Element* p_node_node, const std::multimap<gint64, gint64>& imported_ids_remap)
+{
+    for (xmlpp::Node* xml_slot : p_node_node->get_children("rich_text")) {
+        auto p_slot_element = static_cast<xmlpp::Element*>(xml_slot);
+        const Glib::ustring link = p_slot_element->get_attribute_value(CtConst::TAG_LINK);
+        if (not str::startswith(link, CtConst::LINK_TYPE_NODE + CtConst::CHAR_SPACE)) {
+            continue;
+        }
+        const CtLinkEntry link_entry = CtMiscUtil::get_link_entry(link);
+        const auto it = imported_ids_remap.find(link_entry.node_id);
+        if (imported_ids_remap.end() == it) {
+            continue; // link to a node outside of the imported document
+        }
+        Glib::ustring new_link = CtConst::LINK_TYPE_NODE + CtConst::CHAR_SPACE + std::to_string(it->second);
+        if (not link_entry.anch.empty()) {
+            new_link += CtConst::CHAR_SPACE + link_entry.anch;
+        }
+        p_slot_element->set_attribute(CtConst::TAG_LINK, new_link);
+    }
+}
+
 /*static*/fs::path CtStorageControl::_extract_file(CtMainWin* pCtMainWin, const fs::path& file_path, Glib::ustring& password)
 {
     fs::path temp_dir = pCtMainWin->get_ct_tmp()->getHiddenDirPath(file_path);
@@ -452,6 +624,7 @@ CtStorageControl::CtStorageControl(CtMainWin* pCtMainWin)
 
 CtStorageControl::~CtStorageControl()
 {
+    _compactTimeoutConnection.disconnect();
     if (_pThreadBackupEncrypt) {
         _backupEncryptKeepGoing = false;
         backupEncryptDEQueue.push_back(nullptr);
@@ -459,6 +632,126 @@ CtStorageControl::~CtStorageControl()
     }
 }
 
+void CtStorageControl::_vacuum_with_progress()
+{
+    CtStatusBar& ctStatusBar = _pCtMainWin->get_status_bar();
+    ctStatusBar.progressBar.set_text(_("Vacuum"));
+    ctStatusBar.progressBar.show();
+    ctStatusBar.stopButton.show();
+    ctStatusBar.set_progress_stop(false);
+    auto on_scope_exit = scope_guard([&](void*) {
+        _vacuumRunning = false;
+        ctStatusBar.progressBar.hide();
+        ctStatusBar.stopButton.hide();
+        ctStatusBar.set_progress_stop(false);
+    });
+
+    _vacuumStopRequested = false;
+    _vacuumDone = false;
+    _vacuumRunning = true;
+    std::exception_ptr pException;
+    std::thread vacuumThread([&](){
+        try {
+            if (not _storage->vacuum([this](){ return _vacuumStopRequested.load(); })) {
+                spdlog::debug("vacuum stopped");
+            }
+        }
+        catch (...) {
+            pException = std::current_exception();
+        }
+        _vacuumDone = true;
+    });
+    while (not _vacuumDone) {
+        ctStatusBar.progressBar.pulse();
+        while (gtk_events_pending()) gtk_main_iteration();
+        if (ctStatusBar.is_progress_stop()) _vacuumStopRequested = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    vacuumThread.join();
+    if (pException) {
+        std::rethrow_exception(pException);
+    }
+}
+
+void CtStorageControl::_vacuum_interrupt_n_wait() const
+{
+    if (not _vacuumRunning) {
+        return;
+    }
+    // the database is left as it was by the interrupted vacuum
+    _vacuumStopRequested = true;
+    while (not _vacuumDone) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+void CtStorageControl::_compact_schedule()
+{
+    _compactTimeoutConnection.disconnect();
+    const CtStorageFreeStats freeStats = _storage->get_free_stats();
+    if (freeStats.freeBytes < CompactMinFreeBytes or
+        freeStats.freeBytes*100 < freeStats.totBytes*CompactMinFreePercent)
+    {
+        return;
+    }
+    gchar* pFreeSize = g_format_size(static_cast<guint64>(freeStats.freeBytes));
+    const Glib::ustring freeSize{pFreeSize};
+    g_free(pFreeSize);
+    spdlog::debug("{} unused of {} bytes, incremental {}", freeStats.freeBytes, freeStats.totBytes, freeStats.incrementalVacuum);
+    if (not freeStats.incrementalVacuum) {
+        // a full vacuum is needed once to switch the document to the incremental reclaim
+        _pCtMainWin->get_status_bar().update_status(str::format(_("%s of Unused Space in the Document, Save and Vacuum to Reclaim It"), freeSize.raw()));
+        return;
+    }
+    _compactFreeBytesStart = freeStats.freeBytes;
+    _compactTimeoutConnection = Glib::signal_timeout().connect(sigc::mem_fun(*this, &CtStorageControl::_on_compact_timeout),
+                                                               CompactStepIntervalMs,
+                                                               Glib::PRIORITY_LOW);
+}
+
+bool CtStorageControl::_on_compact_timeout()
+{
+    bool keepGoing{false};
+    try {
+        keepGoing = _storage->compact_step(CompactStepPages);
+    }
+    catch (std::exception& e) {
+        spdlog::error("!! compact {}", e.what());
+    }
+    if (_file_path == _extracted_file_path) {
+        // the file was written by us, not to be taken as an external modification
+        _mod_time = fs::getmtime(_file_path);
+    }
+    if (not keepGoing) {
+        gchar* pReclaimedSize = g_format_size(static_cast<guint64>(_compactFreeBytesStart - _storage->get_free_stats().freeBytes));
+        const Glib::ustring reclaimedSize{pReclaimedSize};
+        g_free(pReclaimedSize);
+        _pCtMainWin->get_status_bar().update_status(str::format(_("Reclaimed %s of Unused Space in the Document"), reclaimedSize.raw()));
+    }
+    return keepGoing; /* false for disconnect */
+}
+
+void CtStorageControl::_update_doc_digests(const CtDocType doc_type)
+{
+    if (CtDocType::XML == doc_type) {
+        // the whole document is written at every save
+        _docDigests = _storage->get_nodes_digests();
+        return;
+    }
+    // the nodes written without a digest (e.g. turned shared non master) are not known any more
+    for (const auto& currPair : _syncPending.nodes_to_write_dict) {
+        if (currPair.second.buff) {
+            _docDigests.erase(currPair.first);
+        }
+    }
+    for (const auto& currPair : _storage->get_nodes_digests()) {
+        _docDigests[currPair.first] = currPair.second;
+    }
+    for (const gint64 node_id : _syncPending.nodes_to_rm_set) {
+        _docDigests.erase(node_id);
+    }
+}
+
 void CtStorageControl::_backupEncryptThread()
 {
     while (_backupEncryptKeepGoing) {
@@ -471,7 +764,7 @@ void CtStorageControl::_backupEncryptThread()
         // encrypt the file
         if (pBackupEncryptData->needEncrypt) {
             Glib::ustring error;
-            if (not CtStorageControl::document_integrity_check_pass(_pCtMainWin, pBackupEncryptData->extracted_copy, error)) {
+            if (not CtStorageVerify::verify(pBackupEncryptData->extracted_copy, pBackupEncryptData->nodes_digests, _pCtConfig->saveVerify, error)) {
                 spdlog::error("{} {}", __FUNCTION__, error.raw());
                 _pCtMainWin->errorsDEQueue.push_back(_("Failed integrity check of the saved document. Try File-->Save As"));
                 _pCtMainWin->dispatcherErrorMsg.emit();
@@ -505,7 +798,8 @@ void CtStorageControl::_backupEncryptThread()
 
         if (CtBackupType::SingleFile == pBackupEncryptData->backupType and not pBackupEncryptData->needEncrypt) {
             Glib::ustring error;
-            if (not CtStorageControl::document_integrity_check_pass(_pCtMainWin, pBackupEncryptData->main_backup, error)) {
+            // the main backup holds the previous version of the document, the digests are of the nodes saved before
+            if (not CtStorageVerify::verify(pBackupEncryptData->main_backup, pBackupEncryptData->nodes_digests, _pCtConfig->saveVerify, error)) {
                 spdlog::error("{} {}", __FUNCTION__, error.raw());
                 _pCtMainWin->errorsDEQueue.push_back(_("Failed integrity check of the saved document. Try File-->Save As"));
                 _pCtMainWin->dispatcherErrorMsg.emit();
@@ -701,6 +995,8 @@ void CtStorageControl::pending_rm_db_nodes(const std::vector<gint64>& node_ids)
             // no need to write changes to a node that got to be removed
             _syncPending.nodes_to_write_dict.erase(node_id);
         }
+        _addedNodesXml.erase(node_id);
+        _importedNodes.erase(node_id);
         _syncPending.nodes_to_rm_set.insert(node_id);
     }
 }
@@ -735,7 +1031,7 @@ void CtStorageControl::add_nodes_from_storage(const fs::path& file_path,
         }
     }
 
-    std::unique_ptr<CtStorageEntity> pStorage;
+    std::shared_ptr<CtStorageEntity> pStorage;
     if (is_folder) {
         pStorage = CtStorageControl::_get_entity_by_type(_pCtMainWin, CtDocType::MultiFile);
     }
@@ -745,9 +1041,37 @@ void CtStorageControl::add_nodes_from_storage(const fs::path& file_path,
 
     if (not pStorage) throw std::runtime_error("no storage");
 
-    pStorage->import_nodes(extracted_file_path, parent_iter);
+    std::multimap<gint64, gint64> imported_ids_remap;
+    pStorage->import_nodes(extracted_file_path, parent_iter, imported_ids_remap);
 
-    _pCtMainWin->get_tree_store().nodes_sequences_fix(parent_iter, false);
+    // the imported storage stays alive until the text buffers of all the imported nodes are created
+    // (the shared non master nodes have no content of their own)
+    std::unordered_map<gint64, gint64> source_ids;
+    for (const auto& idPair : imported_ids_remap) {
+        source_ids[idPair.second] = idPair.first;
+    }
+    auto pIdsRemap = std::make_shared<const std::multimap<gint64, gint64>>(std::move(imported_ids_remap));
+    CtTreeStore& ct_tree_store = _pCtMainWin->get_tree_store();
+    Gtk::TreeNodeChildren children = parent_iter ? parent_iter->children() : ct_tree_store.get_store()->children();
+    std::function<void(const Gtk::TreeNodeChildren&)> f_register_imported;
+    f_register_imported = [&](const Gtk::TreeNodeChildren& tree_children) {
+        for (const Gtk::TreeIter& tree_iter : tree_children) {
+            CtTreeIter ct_tree_iter = ct_tree_store.to_ct_tree_iter(tree_iter);
+            const auto it = source_ids.find(ct_tree_iter.get_node_id());
+            if (source_ids.end() == it) {
+                continue; // node that was already there
+            }
+            if (ct_tree_iter.get_node_shared_master_id() <= 0 and
+                not ct_tree_iter.get_node_buffer_already_loaded()/*duplicated id, the buffer is already there*/)
+            {
+                _importedNodes[it->first] = CtImportedNode{pStorage, it->second, pIdsRemap};
+            }
+            f_register_imported(tree_iter->children());
+        }
+    };
+    f_register_imported(children);
+
+    ct_tree_store.nodes_sequences_fix(parent_iter, false);
     _pCtMainWin->update_window_save_needed();
 }
 
@@ -760,6 +1084,9 @@ void CtStorageCache::generate_cache(CtMainWin* pCtMainWin, const CtStorageSyncPe
         std::string error;
         store.get_store()->foreach([&](const Gtk::TreePath&, const Gtk::TreeIter& iter)->bool{
             CtTreeIter ct_tree_iter = store.to_ct_tree_iter(iter);
+            if (not ct_tree_iter.get_node_buffer_already_loaded()) {
+                return false; /* the content is transcoded from the storage, no need to create the buffer */
+            }
             Glib::RefPtr<Gsv::Buffer> rTextBuffer = ct_tree_iter.get_node_text_buffer();
             if (not rTextBuffer) {
                 error = str::format(_("Failed to retrieve the content of the node '%s'"), ct_tree_iter.get_node_name());
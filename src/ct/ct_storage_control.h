@@ -26,9 +26,11 @@
 #include "ct_types.h"
 #include <glibmm/miscutils.h>
 #include <thread>
+#include <atomic>
 
 class CtMainWin;
 class CtTreeStore;
+class CtTreeIter;
 class CtStorageControl
 {
 public:
@@ -46,9 +48,6 @@ public:
                                      const CtExporting export_type,
                                      const int start_offset = 0,
                                      const int end_offset = -1);
-    static bool document_integrity_check_pass(CtMainWin* pCtMainWin,
-                                              const fs::path& file_path,
-                                              Glib::ustring& error);
 
     static std::list<std::pair<CtTreeIter, CtStorageNodeState>> get_sorted_by_level_nodes_to_write(
         CtTreeStore* pCtTreeStore,
@@ -63,6 +62,15 @@ public:
     Glib::RefPtr<Gsv::Buffer> get_delayed_text_buffer(const gint64 node_id,
                                                       const std::string& syntax,
                                                       std::list<CtAnchoredWidget*>& widgets) const;
+    // the slots of a node not modified since load, taken from the storage without creating the text buffer
+    bool get_stored_node_xml(const CtTreeIter& ct_tree_iter, xmlpp::Element* p_node_node) const;
+    // content of a node added in this session (e.g. a pasted subtree), kept as xml until the text buffer is needed
+    void add_delayed_node_xml(const gint64 node_id, std::shared_ptr<xmlpp::Document> pNodeDoc);
+    // the text buffer of a node with nothing to save can be unloaded and read again from the storage when needed
+    bool release_node_buffer(const CtTreeIter& ct_tree_iter);
+
+    // while saving (and vacuuming) the events are still processed, the document must not be saved/opened again
+    bool is_saving() const { return _isSaving; }
 
     const fs::path& get_file_path() { return _file_path; }
     time_t get_mod_time() { return _mod_time; }
@@ -90,6 +98,23 @@ private:
     static std::unique_ptr<CtStorageEntity> _get_entity_by_type(CtMainWin* pCtMainWin, CtDocType file_type);
     static fs::path _extract_file(CtMainWin* pCtMainWin, const fs::path& file_path, Glib::ustring& password);
     static bool     _package_file(const fs::path& file_from, const fs::path& file_to, const Glib::ustring& password);
+    static void     _imported_links_remap(xmlpp::Element* p_node_node, const std::multimap<gint64, gint64>& imported_ids_remap);
+
+    void _adopt_saved_nodes();
+    bool _get_imported_node_xml(const gint64 node_id, const std::string& syntax, xmlpp::Element* p_node_node) const;
+
+    // the storage vacuum runs in a worker thread while the status bar progress is kept alive (and can stop it)
+    void _vacuum_with_progress();
+    // a node to be read from the storage while vacuuming stops the vacuum and waits for it to be over
+    void _vacuum_interrupt_n_wait() const;
+    // the unused space is reclaimed in small steps at low priority, if the storage allows that
+    void _compact_schedule();
+    bool _on_compact_timeout();
+
+    static constexpr gint64 CompactMinFreeBytes{4*1024*1024};
+    static constexpr gint64 CompactMinFreePercent{10};
+    static constexpr int    CompactStepPages{256};
+    static constexpr guint  CompactStepIntervalMs{100};
 
     CtStorageControl(CtMainWin* pCtMainWin);
 
@@ -101,6 +126,25 @@ private:
     fs::path                         _extracted_file_path;
     std::unique_ptr<CtStorageEntity> _storage;
     CtStorageSyncPending             _syncPending;
+    mutable CtDelayedTextBufferMap   _addedNodesXml;
+    CtNodesDigests                   _docDigests; // of the nodes as on disk, known from the saves of this session
+    bool                             _isSaving{false};
+    bool                             _vacuumRunning{false};
+    mutable std::atomic<bool>        _vacuumStopRequested{false};
+    std::atomic<bool>                _vacuumDone{false};
+    sigc::connection                 _compactTimeoutConnection;
+    gint64                           _compactFreeBytesStart{0};
+
+    // node imported from another document, the content is read from the source storage when needed
+    struct CtImportedNode
+    {
+        std::shared_ptr<CtStorageEntity>                     pSource;
+        gint64                                               sourceNodeId;
+        std::shared_ptr<const std::multimap<gint64, gint64>> pIdsRemap;
+    };
+    mutable std::unordered_map<gint64, CtImportedNode> _importedNodes;
+
+    void _update_doc_digests(const CtDocType doc_type);
 
     std::unique_ptr<std::thread> _pThreadBackupEncrypt;
     void _backupEncryptThread();
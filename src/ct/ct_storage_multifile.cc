@@ -26,12 +26,39 @@
 #include "ct_storage_control.h"
 #include "ct_main_win.h"
 #include "ct_logging.h"
+#include "ct_trace.h"
 #include <glib/gstdio.h>
+#include <algorithm>
 
 /*static*/const std::string CtStorageMultiFile::SUBNODES_LST{"subnodes.lst"};
 /*static*/const std::string CtStorageMultiFile::BOOKMARKS_LST{"bookmarks.lst"};
 /*static*/const std::string CtStorageMultiFile::NODE_XML{"node.xml"};
 /*static*/const std::string CtStorageMultiFile::BEFORE_SAVE{".before"};
+/*static*/std::map<std::string, std::shared_ptr<CtStorageMultiFile::CtBlobIndex>> CtStorageMultiFile::_blobIndexes;
+/*static*/std::mutex CtStorageMultiFile::_blobIndexesMutex;
+
+CtStorageMultiFile::~CtStorageMultiFile()
+{
+    _set_dir_path(fs::path{});
+}
+
+void CtStorageMultiFile::_set_dir_path(const fs::path& dir_path)
+{
+    std::lock_guard<std::mutex> lock{_blobIndexesMutex};
+    if (_pBlobIndex) {
+        const auto it = _blobIndexes.find(_dir_path.string());
+        if (_blobIndexes.end() != it and it->second == _pBlobIndex) {
+            _blobIndexes.erase(it);
+        }
+        _pBlobIndex.reset();
+    }
+    _dir_path = dir_path;
+    if (not _dir_path.empty()) {
+        // a new document directory starts from an empty index
+        _pBlobIndex = std::make_shared<CtBlobIndex>();
+        _blobIndexes[_dir_path.string()] = _pBlobIndex;
+    }
+}
 
 bool CtStorageMultiFile::save_treestore(const fs::path& dir_path,
                                         const CtStorageSyncPending& syncPending,
@@ -41,6 +68,7 @@ bool CtStorageMultiFile::save_treestore(const fs::path& dir_path,
                                         const int start_offset/*= 0*/,
                                         const int end_offset/*= -1*/)
 {
+    CtTraceSpan traceSpan{"save_treestore"};
     try {
         CtTreeStore& ct_tree_store = _pCtMainWin->get_tree_store();
         if (_dir_path.empty()) {
@@ -49,7 +77,7 @@ bool CtStorageMultiFile::save_treestore(const fs::path& dir_path,
                 error = Glib::ustring{"failed to create "} + dir_path.string();
                 return false;
             }
-            _dir_path = dir_path;
+            _set_dir_path(dir_path);
 
             if ( CtExporting::NONESAVEAS == export_type or
                  CtExporting::ALL_TREE == export_type )
@@ -125,10 +153,28 @@ bool CtStorageMultiFile::save_treestore(const fs::path& dir_path,
             // update changed nodes
             const std::list<std::pair<CtTreeIter, CtStorageNodeState>> nodes_to_write = CtStorageControl::get_sorted_by_level_nodes_to_write(
                 &_pCtMainWin->get_tree_store(), syncPending.nodes_to_write_dict);
-            bool any_hier{false};
+            // the hierarchy changes touch the subnodes.lst of both the previous and the new parent
+            std::set<gint64> parents_to_update;
+            for (const auto& node_pair : nodes_to_write) {
+                if (node_pair.second.hier) {
+                    const CtTreeIter ct_tree_iter_parent = node_pair.first.parent();
+                    parents_to_update.insert(ct_tree_iter_parent ? ct_tree_iter_parent.get_node_id() : -1);
+                    const auto it = _nodes_dirs.find(node_pair.first.get_node_id());
+                    if (_nodes_dirs.end() != it) {
+                        parents_to_update.insert(it->second.parentId);
+                    }
+                }
+            }
+            for (const gint64 node_id : syncPending.nodes_to_rm_set) {
+                const auto it = _nodes_dirs.find(node_id);
+                if (_nodes_dirs.end() != it) {
+                    parents_to_update.insert(it->second.parentId);
+                }
+            }
+            // sorted root to leaves, the parent directory is in place before the children
             for (const auto& node_pair : nodes_to_write) {
                 _nodes_to_multifile(&node_pair.first,
-                                    _get_node_dirpath(node_pair.first),
+                                    node_pair.second.hier ? _get_node_dirpath_in_hier(node_pair.first) : _get_node_dirpath(node_pair.first),
                                     error,
                                     &storage_cache,
                                     node_pair.second,
@@ -136,23 +182,13 @@ bool CtStorageMultiFile::save_treestore(const fs::path& dir_path,
                                     pExpoMasterReassign,
                                     0,
                                     -1);
-                if (not any_hier and node_pair.second.hier) {
-                    any_hier = true;
-                }
             }
             if (not syncPending.nodes_to_rm_set.empty()) {
                 // remove nodes and their sub nodes
-                _already_queued_for_removal.clear();
-                for (const gint64 node_id : syncPending.nodes_to_rm_set) {
-                    _remove_disk_node_with_children(node_id);
-                }
-                if (not any_hier) {
-                    any_hier = true;
-                }
+                _remove_disk_nodes(syncPending.nodes_to_rm_set);
             }
-            if (any_hier) {
-                // full tree hierarchy verification needed
-                _verify_update_hierarchy(nullptr/*ct_tree_iter_parent*/, _dir_path);
+            if (not parents_to_update.empty()) {
+                _update_subnodes_lsts(parents_to_update);
             }
         }
         return true;
@@ -163,90 +199,101 @@ bool CtStorageMultiFile::save_treestore(const fs::path& dir_path,
     }
 }
 
-void CtStorageMultiFile::_verify_update_hierarchy(const CtTreeIter* ct_tree_iter_parent, const fs::path& dir_path)
+void CtStorageMultiFile::_update_subnodes_lsts(const std::set<gint64>& parent_ids)
 {
-    std::list<gint64> subnodes_list;
-
-    CtTreeIter ct_tree_iter = ct_tree_iter_parent ? ct_tree_iter_parent->first_child() : _pCtMainWin->get_tree_store().get_ct_iter_first();
-
-    while (ct_tree_iter) {
-        const gint64 node_id = ct_tree_iter.get_node_id();
-        subnodes_list.push_back(node_id);
-
-        _verify_update_hierarchy(&ct_tree_iter, dir_path / std::to_string(node_id));
-
-        ++ct_tree_iter;
-    }
-
-    const fs::path path_subnodes_lst = dir_path / SUBNODES_LST;
-    const std::string new_subnodes_lst = str::join_numbers(subnodes_list, ",");
-    const std::string old_subnodes_lst = fs::is_regular_file(path_subnodes_lst) ? Glib::file_get_contents(path_subnodes_lst.string()) : "";
-    if (new_subnodes_lst != old_subnodes_lst) {
-        if (new_subnodes_lst.empty()) {
-            fs::remove(path_subnodes_lst);
+    CtTreeStore& ct_tree_store = _pCtMainWin->get_tree_store();
+    for (const gint64 parent_id : parent_ids) {
+        fs::path dir_path{_dir_path};
+        CtTreeIter ct_tree_iter = ct_tree_store.get_ct_iter_first();
+        if (-1 != parent_id) {
+            const CtTreeIter ct_tree_iter_parent = ct_tree_store.get_node_from_node_id(parent_id);
+            const auto it = _nodes_dirs.find(parent_id);
+            if (not ct_tree_iter_parent or _nodes_dirs.end() == it) {
+                // removed parent
+                continue;
+            }
+            dir_path = it->second.dirpath;
+            ct_tree_iter = ct_tree_iter_parent.first_child();
         }
-        else {
-            Glib::file_set_contents(path_subnodes_lst.string(), new_subnodes_lst);
+        std::list<gint64> subnodes_list;
+        while (ct_tree_iter) {
+            const gint64 node_id = ct_tree_iter.get_node_id();
+            subnodes_list.push_back(node_id);
+            // no-op unless the directory name does not match the node id (e.g. duplicated id fixed on load)
+            _hier_move_node(node_id, parent_id, dir_path / std::to_string(node_id));
+            ++ct_tree_iter;
         }
-        spdlog::debug("'{}'->'{}'", old_subnodes_lst, new_subnodes_lst);
-    }
-}
 
-bool CtStorageMultiFile::_found_node_dirpath(const fs::path& node_id, const fs::path parent_path, fs::path& hierarchical_path) const
-{
-    const std::list<fs::path> dir_entries = fs::get_dir_entries(parent_path);
-    for (const fs::path& curr_path : dir_entries) {
-        if (fs::is_directory(curr_path)) {
-            if (curr_path.filename() == node_id) {
-                hierarchical_path = curr_path;
-                return true;
+        const fs::path path_subnodes_lst = dir_path / SUBNODES_LST;
+        const std::string new_subnodes_lst = str::join_numbers(subnodes_list, ",");
+        const std::string old_subnodes_lst = fs::is_regular_file(path_subnodes_lst) ? Glib::file_get_contents(path_subnodes_lst.string()) : "";
+        if (new_subnodes_lst != old_subnodes_lst) {
+            if (new_subnodes_lst.empty()) {
+                fs::remove(path_subnodes_lst);
             }
-            if (_found_node_dirpath(node_id, curr_path, hierarchical_path)) {
-                return true;
+            else {
+                Glib::file_set_contents(path_subnodes_lst.string(), new_subnodes_lst);
             }
+            spdlog::debug("'{}'->'{}'", old_subnodes_lst, new_subnodes_lst);
         }
     }
-    return false;
 }
 
 fs::path CtStorageMultiFile::_get_node_dirpath(const CtTreeIter& ct_tree_iter) const
 {
-    fs::path hierarchical_path{std::to_string(ct_tree_iter.get_node_id())};
-    CtTreeIter father_iter = ct_tree_iter.parent();
-    while (father_iter) {
-        hierarchical_path = fs::path{std::to_string(father_iter.get_node_id())} / hierarchical_path;
-        father_iter = father_iter.parent();
+    const auto it = _nodes_dirs.find(ct_tree_iter.get_node_id());
+    if (_nodes_dirs.end() != it) {
+        return it->second.dirpath;
     }
-    return _dir_path / hierarchical_path;
+    return _get_node_dirpath_in_hier(ct_tree_iter);
+}
+
+fs::path CtStorageMultiFile::_get_node_dirpath_in_hier(const CtTreeIter& ct_tree_iter) const
+{
+    // where the node directory belongs according to the tree hierarchy
+    const CtTreeIter father_iter = ct_tree_iter.parent();
+    const fs::path parent_dirpath = father_iter ? _get_node_dirpath(father_iter) : _dir_path;
+    return parent_dirpath / std::to_string(ct_tree_iter.get_node_id());
 }
 
-void CtStorageMultiFile::_remove_disk_node_with_children(const gint64 node_id)
+void CtStorageMultiFile::_remove_disk_nodes(const std::unordered_set<gint64>& node_ids)
 {
+    std::unordered_set<std::string> rm_dirpaths;
+    for (const gint64 node_id : node_ids) {
+        const auto it = _nodes_dirs.find(node_id);
+        if (_nodes_dirs.end() != it) {
+            rm_dirpaths.insert(it->second.dirpath.string());
+        }
+    }
+    if (rm_dirpaths.empty()) {
+        return;
+    }
+    // the removed nodes together with all the sub nodes still in their directories
+    std::vector<std::pair<gint64, std::string>> nodes_to_rm;
+    for (const auto& currPair : _nodes_dirs) {
+        const std::string curr_dirpath = currPair.second.dirpath.string();
+        bool to_rm = rm_dirpaths.count(curr_dirpath) != 0;
+        for (size_t pos = curr_dirpath.find(G_DIR_SEPARATOR, 1); not to_rm and std::string::npos != pos; pos = curr_dirpath.find(G_DIR_SEPARATOR, pos + 1)) {
+            to_rm = rm_dirpaths.count(curr_dirpath.substr(0, pos)) != 0;
+        }
+        if (to_rm) {
+            nodes_to_rm.push_back(std::make_pair(currPair.first, curr_dirpath));
+        }
+    }
     // the nodes must be passed to the BackupEncrypt thread from the leaves towards the root
     // so all can rotate in the backups
-    std::function<void(const fs::path& curr_node_dirpath)> f_iterative_queue_nodes_for_removal;
-    f_iterative_queue_nodes_for_removal = [&](const fs::path& curr_node_dirpath){
-        const gint64 curr_node_id = CtStrUtil::gint64_from_gstring(curr_node_dirpath.filename().c_str());
-        if (_already_queued_for_removal.find(curr_node_id) != _already_queued_for_removal.end()) {
-            // already processed
-            return;
-        }
-        // first process the subnodes
-        for (const fs::path& node_dirpath : CtStorageMultiFile::get_child_nodes_dirs(curr_node_dirpath)) {
-            f_iterative_queue_nodes_for_removal(node_dirpath);
-        }
-        // eventually process myself
+    std::sort(nodes_to_rm.begin(), nodes_to_rm.end(), [](const std::pair<gint64, std::string>& a, const std::pair<gint64, std::string>& b){
+        return a.second.size() > b.second.size();
+    });
+    for (const auto& currPair : nodes_to_rm) {
         std::shared_ptr<CtBackupEncryptData> pBackupEncryptData = std::make_shared<CtBackupEncryptData>();
         pBackupEncryptData->backupType = CtBackupType::MultiFile;
         pBackupEncryptData->needEncrypt = false;
         pBackupEncryptData->file_path = _dir_path.string();
-        pBackupEncryptData->main_backup = curr_node_dirpath.string();
+        pBackupEncryptData->main_backup = currPair.second;
         _pCtMainWin->get_ct_storage()->backupEncryptDEQueue.push_back(pBackupEncryptData);
-        _already_queued_for_removal.insert(curr_node_id);
-    };
-    fs::path node_dirpath;
-    if (_found_node_dirpath(std::to_string(node_id), _dir_path, node_dirpath) and not node_dirpath.empty()) {
-        f_iterative_queue_nodes_for_removal(node_dirpath);
+        _nodes_dirs.erase(currPair.first);
+        _blob_index_forget(*_pBlobIndex, currPair.second);
     }
 }
 
@@ -260,29 +307,31 @@ void CtStorageMultiFile::_write_bookmarks_to_disk(const std::list<gint64>& bookm
     }
 }
 
-void CtStorageMultiFile::_hier_try_move_node(const fs::path& dir_path_to)
+void CtStorageMultiFile::_hier_move_node(const gint64 node_id, const gint64 parent_id, const fs::path& dir_path_to)
 {
-    const fs::path dir_name = dir_path_to.filename();
-    fs::path dir_path_from;
-    std::function<void(const fs::path parent_path)> f_find_dir_from = [&](const fs::path parent_path){
-        for (const fs::path& p : fs::get_dir_entries(parent_path)) {
-            if (not dir_path_from.empty()) {
-                return;
-            }
-            if (fs::is_directory(p)) {
-                if (p.filename() == dir_name) {
-                    dir_path_from = p;
-                }
-                else {
-                    f_find_dir_from(p);
-                }
-            }
+    const auto it = _nodes_dirs.find(node_id);
+    if (_nodes_dirs.end() == it) {
+        return;
+    }
+    it->second.parentId = parent_id;
+    const fs::path dir_path_from = it->second.dirpath;
+    if (dir_path_from == dir_path_to) {
+        return;
+    }
+    spdlog::debug("{} -> {}", dir_path_from, dir_path_to);
+    _blob_index_forget(*_pBlobIndex, dir_path_from.string());
+    _blob_index_forget(*_pBlobIndex, dir_path_to.string());
+    if (not fs::move_file(dir_path_from, dir_path_to)) {
+        return;
+    }
+    it->second.dirpath = dir_path_to;
+    // the sub nodes directories moved along
+    const std::string prefix_from = dir_path_from.string() + G_DIR_SEPARATOR_S;
+    for (auto& currPair : _nodes_dirs) {
+        const std::string curr_dirpath = currPair.second.dirpath.string();
+        if (str::startswith(curr_dirpath, prefix_from)) {
+            currPair.second.dirpath = dir_path_to / curr_dirpath.substr(prefix_from.size());
         }
-    };
-    f_find_dir_from(_dir_path);
-    if (not dir_path_from.empty()) {
-        spdlog::debug("{} -> {}", dir_path_from, dir_path_to);
-        fs::move_file(dir_path_from, dir_path_to);
     }
 }
 
@@ -296,12 +345,14 @@ bool CtStorageMultiFile::_nodes_to_multifile(const CtTreeIter* ct_tree_iter,
                                              const int start_offset/*= 0*/,
                                              const int end_offset/*=-1*/)
 {
+    const gint64 node_id = ct_tree_iter->get_node_id();
+    const CtTreeIter ct_tree_iter_parent = ct_tree_iter->parent();
+    const gint64 parent_id = ct_tree_iter_parent ? ct_tree_iter_parent.get_node_id() : -1;
     if (CtExporting::NONESAVE == export_type and
         node_state.hier and
-        node_state.is_update_of_existing and
-        not fs::is_directory(dir_path))
+        node_state.is_update_of_existing)
     {
-        _hier_try_move_node(dir_path);
+        _hier_move_node(node_id, parent_id, dir_path);
     }
     if (not fs::is_directory(dir_path) and
         g_mkdir(dir_path.c_str(), 0755) < 0)
@@ -309,6 +360,7 @@ bool CtStorageMultiFile::_nodes_to_multifile(const CtTreeIter* ct_tree_iter,
         error = Glib::ustring{"!! mkdir "} + dir_path.string();
         return false;
     }
+    _nodes_dirs[node_id] = CtNodeDir{parent_id, dir_path};
     if (node_state.buff or node_state.prop) {
         fs::path dir_before_save;
         if (CtExporting::NONESAVE == export_type) {
@@ -331,6 +383,11 @@ bool CtStorageMultiFile::_nodes_to_multifile(const CtTreeIter* ct_tree_iter,
                     }
                 }
             }
+            {
+                // the node directory is now empty of blobs, no need to list it again
+                std::lock_guard<std::mutex> lock{_pBlobIndex->mutex};
+                _pBlobIndex->dirs[dir_path.string()].clear();
+            }
         }
         {
             xmlpp::Document xml_doc_node;
@@ -344,7 +401,8 @@ bool CtStorageMultiFile::_nodes_to_multifile(const CtTreeIter* ct_tree_iter,
                 export_type,
                 pExpoMasterReassign,
                 start_offset,
-                end_offset
+                end_offset,
+                CtExporting::NONESAVE != export_type/*from_storage, our own blobs were just moved away*/
             );
 
             // write file
@@ -398,45 +456,165 @@ bool CtStorageMultiFile::_nodes_to_multifile(const CtTreeIter* ct_tree_iter,
     return true;
 }
 
+/*static*/std::shared_ptr<CtStorageMultiFile::CtBlobIndex> CtStorageMultiFile::_get_blob_index(const std::string& dir_path)
+{
+    std::lock_guard<std::mutex> lock{_blobIndexesMutex};
+    // the document directory is the greatest one not after the node directory
+    auto it = _blobIndexes.upper_bound(dir_path);
+    while (_blobIndexes.begin() != it) {
+        --it;
+        if (it->first == dir_path or str::startswith(dir_path, it->first + G_DIR_SEPARATOR_S)) {
+            return it->second;
+        }
+    }
+    return nullptr;
+}
+
+/*static*/std::unordered_map<std::string, std::string>& CtStorageMultiFile::_blob_index_dir(CtBlobIndex& blobIndex, const std::string& dir_path)
+{
+    // to be called with blobIndex.mutex locked
+    auto itDir = blobIndex.dirs.find(dir_path);
+    if (blobIndex.dirs.end() == itDir) {
+        itDir = blobIndex.dirs.emplace(dir_path, std::unordered_map<std::string, std::string>{}).first;
+        try {
+            Glib::Dir gdir{dir_path};
+            for (const std::string& filename : gdir) {
+                // node.xml, subnodes.lst, .before and subnodes dirs are all shorter than a sha256sum
+                if (filename.size() >= 64u) {
+                    const std::string sha256sum = filename.substr(0, 64u);
+                    itDir->second[sha256sum] = filename;
+                    blobIndex.anyDir[sha256sum] = dir_path;
+                }
+            }
+        }
+        catch (Glib::Error& error) {
+            spdlog::debug("{} {}", __FUNCTION__, error.what());
+        }
+    }
+    return itDir->second;
+}
+
+/*static*/void CtStorageMultiFile::_blob_index_forget(CtBlobIndex& blobIndex, const std::string& dir_path)
+{
+    std::lock_guard<std::mutex> lock{blobIndex.mutex};
+    const std::string dir_path_prefix = dir_path + G_DIR_SEPARATOR_S;
+    for (auto itDir = blobIndex.dirs.begin(); itDir != blobIndex.dirs.end(); ) {
+        if (itDir->first == dir_path or str::startswith(itDir->first, dir_path_prefix)) {
+            itDir = blobIndex.dirs.erase(itDir);
+        }
+        else {
+            ++itDir;
+        }
+    }
+}
+
+/*static*/void CtStorageMultiFile::blob_index_forget(const std::string& dir_path)
+{
+    std::shared_ptr<CtBlobIndex> pBlobIndex = _get_blob_index(dir_path);
+    if (pBlobIndex) {
+        _blob_index_forget(*pBlobIndex, dir_path);
+    }
+}
+
 /*static*/std::string CtStorageMultiFile::save_blob(const std::string& rawBlob,
                                                     const std::string& dir_path,
                                                     const std::string& file_ext)
 {
     const std::string sha256sum = Glib::Checksum::compute_checksum(Glib::Checksum::ChecksumType::CHECKSUM_SHA256, rawBlob);
+    save_blob_sha256sum(sha256sum, dir_path, file_ext, [&rawBlob](const std::string& filepath){
+        Glib::file_set_contents(filepath, rawBlob);
+        return true;
+    });
+    return sha256sum;
+}
+
+/*static*/void CtStorageMultiFile::save_blob_sha256sum(const std::string& sha256sum,
+                                                       const std::string& dir_path,
+                                                       const std::string& file_ext,
+                                                       const std::function<bool(const std::string& filepath)>& f_write_blob)
+{
+    // a directory not of an open document (e.g. an export in progress) is listed for this call only
+    std::shared_ptr<CtBlobIndex> pBlobIndex = _get_blob_index(dir_path);
+    if (not pBlobIndex) {
+        pBlobIndex = std::make_shared<CtBlobIndex>();
+    }
     const std::string sha256sum_ext = sha256sum + file_ext;
+    std::lock_guard<std::mutex> lock{pBlobIndex->mutex};
+    std::unordered_map<std::string, std::string>& dirIndex = _blob_index_dir(*pBlobIndex, dir_path);
+    if (dirIndex.count(sha256sum) != 0) {
+        // already in this node directory
+        return;
+    }
     const std::string filepath = Glib::build_filename(dir_path, sha256sum_ext);
-    if (not Glib::file_test(filepath, Glib::FILE_TEST_IS_REGULAR)) {
-        const std::string filepath_before = Glib::build_filename(dir_path, BEFORE_SAVE, sha256sum_ext);
-        if (Glib::file_test(filepath_before, Glib::FILE_TEST_IS_REGULAR)) {
-            fs::move_file(filepath_before, filepath);
-        }
-        else {
-            Glib::file_set_contents(filepath, rawBlob);
+    const std::string filepath_before = Glib::build_filename(dir_path, BEFORE_SAVE, sha256sum_ext);
+    bool written{false};
+    if (Glib::file_test(filepath_before, Glib::FILE_TEST_IS_REGULAR)) {
+        written = fs::move_file(filepath_before, filepath);
+    }
+    if (not written) {
+        // the same blob already in another node directory is copied rather than serialized again;
+        // an own copy, never a link to the file of another node that could be modified or rotated
+        // into the backups independently
+        const auto itAny = pBlobIndex->anyDir.find(sha256sum);
+        if (pBlobIndex->anyDir.end() != itAny and itAny->second != dir_path) {
+            const auto itAnyDir = pBlobIndex->dirs.find(itAny->second);
+            if (pBlobIndex->dirs.end() != itAnyDir) {
+                const auto itAnyFile = itAnyDir->second.find(sha256sum);
+                if (itAnyDir->second.end() != itAnyFile) {
+                    written = fs::copy_file(Glib::build_filename(itAny->second, itAnyFile->second), filepath);
+                }
+            }
         }
     }
-    return sha256sum;
+    if (not written) {
+        written = f_write_blob(filepath);
+    }
+    if (not written) {
+        spdlog::error("!! {} {}", __FUNCTION__, filepath);
+        return;
+    }
+    dirIndex[sha256sum] = sha256sum_ext;
+    pBlobIndex->anyDir[sha256sum] = dir_path;
 }
 
 /*static*/bool CtStorageMultiFile::read_blob(const std::string& dir_path,
                                              const std::string& sha256sum,
                                              std::string& rawBlob)
 {
+    std::string filepath;
+    if (not get_blob_filepath(dir_path, sha256sum, filepath)) {
+        return false;
+    }
     try {
-        Glib::Dir gdir{dir_path};
-        std::list<std::string> dir_entries{gdir.begin(), gdir.end()};
-        for (const std::string& filename : dir_entries) {
-            if (str::startswith(filename, sha256sum)) {
-                rawBlob = Glib::file_get_contents(Glib::build_filename(dir_path, filename));
-                return true;
-            }
-        }
+        rawBlob = Glib::file_get_contents(filepath);
+        return true;
     }
     catch (Glib::Error& error) {
         spdlog::error("{} {}", __FUNCTION__, error.what());
+        // the index is stale, list the directory again on next access
+        blob_index_forget(dir_path);
     }
     return false;
 }
 
+/*static*/bool CtStorageMultiFile::get_blob_filepath(const std::string& dir_path,
+                                                     const std::string& sha256sum,
+                                                     std::string& filepath)
+{
+    std::shared_ptr<CtBlobIndex> pBlobIndex = _get_blob_index(dir_path);
+    if (not pBlobIndex) {
+        pBlobIndex = std::make_shared<CtBlobIndex>();
+    }
+    std::lock_guard<std::mutex> lock{pBlobIndex->mutex};
+    const std::unordered_map<std::string, std::string>& dirIndex = _blob_index_dir(*pBlobIndex, dir_path);
+    const auto it = dirIndex.find(sha256sum);
+    if (dirIndex.end() == it) {
+        return false;
+    }
+    filepath = Glib::build_filename(dir_path, it->second);
+    return true;
+}
+
 /*static*/std::list<fs::path> CtStorageMultiFile::get_child_nodes_dirs(const fs::path& dir_path)
 {
     std::list<fs::path> ret_list;
@@ -452,12 +630,13 @@ bool CtStorageMultiFile::_nodes_to_multifile(const CtTreeIter* ct_tree_iter,
 
 bool CtStorageMultiFile::populate_treestore(const fs::path& dir_path, Glib::ustring& error)
 {
+    CtTraceSpan traceSpan{"populate_treestore"};
     try {
         if (not fs::is_directory(dir_path)) {
             error = Glib::ustring{"missing "} + dir_path.string();
             return false;
         }
-        _dir_path = dir_path;
+        _set_dir_path(dir_path);
 
         CtTreeStore& ct_tree_store = _pCtMainWin->get_tree_store();
 
@@ -473,6 +652,8 @@ bool CtStorageMultiFile::populate_treestore(const fs::path& dir_path, Glib::ustr
         }
 
         // load node tree
+        _nodes_dirs.clear();
+        std::list<std::pair<CtTreeIter, fs::path>> nodes_dirs;
         std::list<CtTreeIter> nodes_with_duplicated_id;
         std::list<CtTreeIter> nodes_shared_non_master;
         std::function<void(const fs::path&, const gint64, Gtk::TreeIter)> f_nodes_from_multifile;
@@ -499,6 +680,9 @@ bool CtStorageMultiFile::populate_treestore(const fs::path& dir_path, Glib::ustr
             if (is_shared_non_master and not _isDryRun) {
                 nodes_shared_non_master.push_back(ct_tree_store.to_ct_tree_iter(new_iter));
             }
+            if (not _isDryRun) {
+                nodes_dirs.push_back(std::make_pair(ct_tree_store.to_ct_tree_iter(new_iter), nodedir));
+            }
             gint64 child_sequence{0};
             for (const fs::path& subnode_dirpath : CtStorageMultiFile::get_child_nodes_dirs(nodedir)) {
                 f_nodes_from_multifile(subnode_dirpath, ++child_sequence, new_iter);
@@ -513,6 +697,11 @@ bool CtStorageMultiFile::populate_treestore(const fs::path& dir_path, Glib::ustr
         for (CtTreeIter& ctTreeIter : nodes_with_duplicated_id) {
             ctTreeIter.set_node_id(ct_tree_store.node_id_get());
         }
+        // map the final node ids to their directories
+        for (const auto& currPair : nodes_dirs) {
+            const CtTreeIter ct_tree_iter_parent = currPair.first.parent();
+            _nodes_dirs[currPair.first.get_node_id()] = CtNodeDir{ct_tree_iter_parent ? ct_tree_iter_parent.get_node_id() : -1, currPair.second};
+        }
         // populate shared non master nodes now that the master nodes
         // are in the tree
         for (CtTreeIter& ctTreeIter : nodes_shared_non_master) {
@@ -528,29 +717,38 @@ bool CtStorageMultiFile::populate_treestore(const fs::path& dir_path, Glib::ustr
     }
 }
 
-void CtStorageMultiFile::import_nodes(const fs::path& dir_path, const Gtk::TreeIter& parent_iter)
+void CtStorageMultiFile::import_nodes(const fs::path& dir_path,
+                                      const Gtk::TreeIter& parent_iter,
+                                      std::multimap<gint64, gint64>& imported_ids_remap)
 {
     CtTreeStore& ct_tree_store = _pCtMainWin->get_tree_store();
+    gint64 next_node_id = ct_tree_store.node_id_get();
 
     std::list<CtTreeIter> nodes_shared_non_master;
-    std::map<gint64,gint64> imported_ids_remap;
     std::function<void(const fs::path&, const gint64 sequence, Gtk::TreeIter)> f_nodes_from_multifile;
     f_nodes_from_multifile = [&](const fs::path& nodedir, const gint64 sequence, Gtk::TreeIter parent_iter) {
         std::unique_ptr<xmlpp::DomParser> parser = CtStorageXml::get_parser(nodedir / NODE_XML);
         xmlpp::Node* xml_node = parser->get_document()->get_root_node()->get_first_child("node");
         auto xml_element = static_cast<xmlpp::Element*>(xml_node);
+        const gint64 readNodeId = CtStrUtil::gint64_from_gstring(xml_element->get_attribute_value("unique_id").c_str());
+        const bool isDuplicatedId = _delayed_text_buffers.count(readNodeId) != 0;
         bool is_shared_non_master{false};
         Gtk::TreeIter new_iter = CtStorageXmlHelper{_pCtMainWin}.node_from_xml(
             xml_element,
             sequence,
             parent_iter,
-            ct_tree_store.node_id_get(),
+            next_node_id++,
             nullptr/*pHasDuplicatedId*/,
             &is_shared_non_master,
             &imported_ids_remap,
             _delayed_text_buffers,
             _isDryRun,
             nodedir.string());
+        if (not isDuplicatedId) {
+            // not to keep the whole document in memory, node.xml is parsed again when needed
+            _delayed_text_buffers[readNodeId] = nullptr;
+            _nodes_dirs[readNodeId] = CtNodeDir{-1, nodedir};
+        }
         CtTreeIter new_ct_iter = ct_tree_store.to_ct_tree_iter(new_iter);
         new_ct_iter.pending_new_db_node();
         if (is_shared_non_master) {
@@ -592,11 +790,90 @@ Glib::RefPtr<Gsv::Buffer> CtStorageMultiFile::get_delayed_text_buffer(const gint
         return Glib::RefPtr<Gsv::Buffer>{};
     }
     std::shared_ptr<xmlpp::Document> node_buffer = _delayed_text_buffers[node_id];
-    auto xml_element = dynamic_cast<xmlpp::Element*>(node_buffer->get_root_node()->get_first_child());
-    const fs::path multifile_dir = _get_node_dirpath(_pCtMainWin->get_tree_store().get_node_from_node_id(node_id));
+    const auto itDir = _nodes_dirs.find(node_id);
+    const fs::path multifile_dir = _nodes_dirs.end() != itDir ?
+        itDir->second.dirpath : _get_node_dirpath(_pCtMainWin->get_tree_store().get_node_from_node_id(node_id));
+    std::unique_ptr<xmlpp::DomParser> parser;
+    xmlpp::Element* xml_element{nullptr};
+    if (node_buffer) {
+        xml_element = dynamic_cast<xmlpp::Element*>(node_buffer->get_root_node()->get_first_child());
+    }
+    else {
+        // imported or unloaded node, read again from the node directory
+        parser = CtStorageXml::get_parser(multifile_dir / NODE_XML);
+        xml_element = dynamic_cast<xmlpp::Element*>(parser->get_document()->get_root_node()->get_first_child("node"));
+    }
+    if (not xml_element) {
+        spdlog::error("!! {} node_id {} xml", __FUNCTION__, node_id);
+        return Glib::RefPtr<Gsv::Buffer>{};
+    }
     auto ret_buffer = CtStorageXmlHelper{_pCtMainWin}.create_buffer_and_widgets_from_xml(xml_element, syntax, widgets, nullptr, -1, multifile_dir.string());
     if (ret_buffer) {
         _delayed_text_buffers.erase(node_id);
     }
     return ret_buffer;
 }
+
+bool CtStorageMultiFile::get_delayed_node_xml(const gint64 node_id,
+                                              const std::string&/*syntax*/,
+                                              xmlpp::Element* p_node_node) const
+{
+    const auto it = _delayed_text_buffers.find(node_id);
+    const auto itDir = _nodes_dirs.find(node_id);
+    if (_delayed_text_buffers.end() == it or _nodes_dirs.end() == itDir) {
+        return false; // the text buffer was already created
+    }
+    const std::string multifile_dir = itDir->second.dirpath.string();
+    std::unique_ptr<xmlpp::DomParser> parser;
+    xmlpp::Element* xml_element{nullptr};
+    if (it->second) {
+        xml_element = dynamic_cast<xmlpp::Element*>(it->second->get_root_node()->get_first_child());
+    }
+    else {
+        // imported node, not parsed yet
+        parser = CtStorageXml::get_parser(itDir->second.dirpath / NODE_XML);
+        xml_element = dynamic_cast<xmlpp::Element*>(parser->get_document()->get_root_node()->get_first_child("node"));
+    }
+    if (not xml_element) {
+        return false;
+    }
+    for (xmlpp::Node* xml_slot : xml_element->get_children()) {
+        if (not dynamic_cast<xmlpp::Element*>(xml_slot) or xml_slot->get_name() == "node") {
+            continue;
+        }
+        auto p_slot_element = static_cast<xmlpp::Element*>(p_node_node->import_node(xml_slot));
+        const Glib::ustring sha256sum = p_slot_element->get_attribute_value("sha256sum");
+        if (not sha256sum.empty()) {
+            // the binaries are inline in the xml document
+            std::string rawBlob;
+            if (not read_blob(multifile_dir, sha256sum, rawBlob)) {
+                spdlog::warn("!! unexp not found {} in {}", sha256sum.raw(), multifile_dir);
+                return false;
+            }
+            p_slot_element->remove_attribute("sha256sum");
+            p_slot_element->add_child_text(Glib::Base64::encode(rawBlob));
+        }
+    }
+    return true;
+}
+
+bool CtStorageMultiFile::release_text_buffer(const CtTreeIter& ct_tree_iter)
+{
+    // the node directory is up to date with the text buffer, it will be parsed again when needed
+    const gint64 node_id = ct_tree_iter.get_node_id();
+    if (_nodes_dirs.count(node_id) == 0) {
+        return false;
+    }
+    _delayed_text_buffers[node_id] = nullptr;
+    return true;
+}
+
+bool CtStorageMultiFile::adopt_saved_node(const gint64 node_id)
+{
+    // the node directory was written by the save, it will be parsed when needed
+    if (_nodes_dirs.count(node_id) == 0) {
+        return false;
+    }
+    _delayed_text_buffers[node_id] = nullptr;
+    return true;
+}
@@ -29,6 +29,11 @@
 #include <gtksourceviewmm/buffer.h>
 #include <gtkmm/treeiter.h>
 #include <libxml++/libxml++.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 class CtMainWin;
 class CtAnchoredWidget;
@@ -46,21 +51,35 @@ public:
     static std::string save_blob(const std::string& rawBlob,
                                  const std::string& dir_path,
                                  const std::string& file_ext);
+    // as save_blob with the sha256sum already known, f_write_blob is only called
+    // if the blob is not already in the node directory
+    static void save_blob_sha256sum(const std::string& sha256sum,
+                                    const std::string& dir_path,
+                                    const std::string& file_ext,
+                                    const std::function<bool(const std::string& filepath)>& f_write_blob);
     static bool read_blob(const std::string& dir_path,
                           const std::string& sha256sum,
                           std::string& rawBlob);
+    static bool get_blob_filepath(const std::string& dir_path,
+                                  const std::string& sha256sum,
+                                  std::string& filepath);
+    // drop the indexed blobs of a node directory and of all its subdirectories
+    static void blob_index_forget(const std::string& dir_path);
 
     static std::list<fs::path> get_child_nodes_dirs(const fs::path& dir_path);
 
     CtStorageMultiFile(CtMainWin* pCtMainWin)
      : _pCtMainWin{pCtMainWin}
     {}
+    ~CtStorageMultiFile() override;
 
     void close_connect() override {}
-    void reopen_connect() override {}
+    void reopen_connect(const bool/*file_replaced*/) override {}
     void test_connection() override {}
     void try_reopen() override {}
-    void vacuum() override {}
+    bool vacuum(const std::function<bool()>& /*f_stop*/) override { return true; }
+    CtStorageFreeStats get_free_stats() override { return CtStorageFreeStats{}; }
+    bool compact_step(const int /*maxPages*/) override { return false; }
 
     bool populate_treestore(const fs::path& file_path, Glib::ustring& error) override;
     bool save_treestore(const fs::path& dir_path,
@@ -70,23 +89,56 @@ public:
                         const std::map<gint64, gint64>* pExpoMasterReassign = nullptr,
                         const int start_offset = 0,
                         const int end_offset = -1) override;
-    void import_nodes(const fs::path& file_path, const Gtk::TreeIter& parent_iter) override;
+    void import_nodes(const fs::path& file_path,
+                      const Gtk::TreeIter& parent_iter,
+                      std::multimap<gint64, gint64>& imported_ids_remap) override;
 
     Glib::RefPtr<Gsv::Buffer> get_delayed_text_buffer(const gint64 node_id,
                                                       const std::string& syntax,
                                                       std::list<CtAnchoredWidget*>& widgets) const override;
+    bool get_delayed_node_xml(const gint64 node_id,
+                              const std::string& syntax,
+                              xmlpp::Element* p_node_node) const override;
+    bool release_text_buffer(const CtTreeIter& ct_tree_iter) override;
+    bool adopt_saved_node(const gint64 node_id) override;
 
 private:
+    // the blobs are named after their sha256sum, each node directory is listed once
+    // on first access and from then on kept up to date by save_blob
+    struct CtBlobIndex
+    {
+        std::unordered_map<std::string, std::unordered_map<std::string, std::string>> dirs; // dir_path -> sha256sum -> filename
+        std::unordered_map<std::string, std::string> anyDir; // sha256sum -> a dir_path that had it, valid if still in dirs
+        std::mutex mutex;
+    };
+    // the blob index of each storage instance, by document directory, so that the static blob
+    // functions called with a node directory find the index of the document it belongs to
+    static std::map<std::string, std::shared_ptr<CtBlobIndex>> _blobIndexes;
+    static std::mutex _blobIndexesMutex;
+    static std::shared_ptr<CtBlobIndex> _get_blob_index(const std::string& dir_path);
+    static std::unordered_map<std::string, std::string>& _blob_index_dir(CtBlobIndex& blobIndex, const std::string& dir_path);
+    static void _blob_index_forget(CtBlobIndex& blobIndex, const std::string& dir_path);
+    void _set_dir_path(const fs::path& dir_path);
+
     CtMainWin* const _pCtMainWin;
     fs::path         _dir_path;
+    std::shared_ptr<CtBlobIndex> _pBlobIndex;
     mutable CtDelayedTextBufferMap _delayed_text_buffers;
-    std::unordered_set<gint64> _already_queued_for_removal;
+
+    struct CtNodeDir
+    {
+        gint64   parentId; // -1 for the top level nodes
+        fs::path dirpath;
+    };
+    // where each node currently is on disk, built on load and kept up to date on save
+    // so that moves and removals never need to crawl the document directory
+    std::unordered_map<gint64, CtNodeDir> _nodes_dirs;
 
     fs::path _get_node_dirpath(const CtTreeIter& ct_tree_iter) const;
-    bool _found_node_dirpath(const fs::path& node_id, const fs::path parent_path, fs::path& hierarchical_path) const;
-    void _remove_disk_node_with_children(const gint64 node_id);
-    void _verify_update_hierarchy(const CtTreeIter* ct_tree_iter_parent, const fs::path& dir_path);
-    void _hier_try_move_node(const fs::path& dir_path);
+    fs::path _get_node_dirpath_in_hier(const CtTreeIter& ct_tree_iter) const;
+    void _remove_disk_nodes(const std::unordered_set<gint64>& node_ids);
+    void _update_subnodes_lsts(const std::set<gint64>& parent_ids);
+    void _hier_move_node(const gint64 node_id, const gint64 parent_id, const fs::path& dir_path_to);
     void _write_bookmarks_to_disk(const std::list<gint64>& bookmarks_list);
     bool _nodes_to_multifile(const CtTreeIter* ct_tree_iter,
                              const fs::path& parent_dir_path,
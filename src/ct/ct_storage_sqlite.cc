@@ -24,10 +24,13 @@
 #include "ct_storage_sqlite.h"
 #include "ct_storage_xml.h"
 #include "ct_storage_control.h"
+#include "ct_storage_verify.h"
 #include "ct_main_win.h"
 #include "ct_logging.h"
+#include "ct_trace.h"
 #include <unistd.h>
 #include <optional>
+#include <unordered_map>
 
 const char CtStorageSqlite::TABLE_NODE_CREATE[]{"CREATE TABLE node ("
 "node_id INTEGER UNIQUE,"
@@ -111,20 +114,7 @@ const char CtStorageSqlite::TABLE_BOOKMARK_DELETE[]{"DELETE FROM bookmark"};
 const Glib::ustring CtStorageSqlite::ERR_SQLITE_PREPV2{"!! sqlite3_prepare_v2: "};
 const Glib::ustring CtStorageSqlite::ERR_SQLITE_STEP{"!! sqlite3_step: "};
 
-class Sqlite3StmtAuto
-{
-public:
-    Sqlite3StmtAuto(sqlite3* pDb, const char* sql) { _prepare(pDb, sql); }
-    ~Sqlite3StmtAuto() { sqlite3_finalize(_pStmt); }
-
-    operator sqlite3_stmt*() { return _pStmt; }
-    bool is_bad() { return not _pStmt; } // it could be operator bool(), but this way it's more explicit in conditions
-
-private:
-    bool _prepare(sqlite3* pDb, const char* sql) { return sqlite3_prepare_v2(pDb, sql, -1, &_pStmt, nullptr) == SQLITE_OK; }
-
-    sqlite3_stmt* _pStmt{nullptr};
-};
+/*static*/std::atomic<gint64> CtStorageSqlite::_dbUidLast{0};
 
 std::optional<std::vector<std::string>> get_quick_check_issues(sqlite3* db)
 {
@@ -168,6 +158,11 @@ bool CtStorageSqlite::_check_database_integrity()
 
 CtStorageSqlite::~CtStorageSqlite()
 {
+    if (_pDb and _pEmbFileRows and _pEmbFileRows->has_blobs()) {
+        // the embedded files still in use keep reading from their rows
+        _pEmbFileRows->set_db(_pDb, true/*ownDb*/);
+        _pDb = nullptr;
+    }
     _close_db();
 }
 
@@ -176,9 +171,10 @@ void CtStorageSqlite::close_connect()
     _close_db();
 }
 
-void CtStorageSqlite::reopen_connect()
+void CtStorageSqlite::reopen_connect(const bool file_replaced)
 {
-    _open_db(_file_path.c_str());
+    // the rowids of the widgets rows are still valid unless the file was replaced meanwhile
+    _open_db(_file_path, not file_replaced/*keepDbUid*/);
 }
 
 void CtStorageSqlite::test_connection()
@@ -232,6 +228,7 @@ void CtStorageSqlite::try_reopen()
 
 bool CtStorageSqlite::populate_treestore(const fs::path& file_path, Glib::ustring& error)
 {
+    CtTraceSpan traceSpan{"populate_treestore"};
     _close_db();
     try {
         // open db
@@ -288,12 +285,16 @@ bool CtStorageSqlite::save_treestore(const fs::path& file_path,
                                      const int start_offset/*= 0*/,
                                      const int end_offset/*= -1*/)
 {
+    CtTraceSpan traceSpan{"save_treestore"};
     try {
+        _nodesDigests.clear();
         // it's the first time (or an export), a new file will be created
         if (_pDb == nullptr) {
             _open_db(file_path);
             _file_path = file_path;
 
+            // the free pages are reclaimed in small steps in background rather than with a full VACUUM
+            _exec_no_callback("PRAGMA auto_vacuum = INCREMENTAL");
             _create_all_tables_in_db();
             if ( CtExporting::NONESAVEAS == export_type or
                  CtExporting::ALL_TREE == export_type )
@@ -384,6 +385,9 @@ bool CtStorageSqlite::save_treestore(const fs::path& file_path,
                 _remove_db_node_with_children(node_id);
             }
         }
+        if (CtExporting::NONESAVE == export_type) {
+            _digest_written_nodes();
+        }
         return true;
     }
     catch (std::exception& e) {
@@ -392,14 +396,64 @@ bool CtStorageSqlite::save_treestore(const fs::path& file_path,
     }
 }
 
-void CtStorageSqlite::vacuum()
+bool CtStorageSqlite::vacuum(const std::function<bool()>& f_stop)
 {
     spdlog::debug("VACUUM");
-    _exec_no_callback("VACUUM");
+    // applied by the VACUUM, from then on the free pages can be reclaimed in small steps by compact_step
+    _exec_no_callback("PRAGMA auto_vacuum = INCREMENTAL");
+    sqlite3_progress_handler(_pDb, 1000/*virtual machine instructions*/, [](void* pData)->int{
+        return (*static_cast<const std::function<bool()>*>(pData))() ? 1 : 0;
+    }, const_cast<std::function<bool()>*>(&f_stop));
+    auto on_scope_exit = scope_guard([&](void*) { sqlite3_progress_handler(_pDb, 0, nullptr, nullptr); });
+    char* p_err_msg{nullptr};
+    int retVal{SQLITE_OK};
+    // the rows of the embedded files in use are found again if renumbered
+    (void)_pEmbFileRows->remap_rowids([&](){
+        retVal = sqlite3_exec(_pDb, "VACUUM", nullptr, nullptr, &p_err_msg);
+        return SQLITE_OK == retVal;
+    });
+    if (SQLITE_INTERRUPT == retVal) {
+        // the database is left as it was
+        sqlite3_free(p_err_msg);
+        spdlog::debug("VACUUM interrupted");
+        return false;
+    }
+    if (SQLITE_OK != retVal) {
+        std::string msg = std::string("!! sqlite3 'VACUUM': ") + p_err_msg;
+        sqlite3_free(p_err_msg);
+        throw std::runtime_error(msg);
+    }
     _exec_no_callback("REINDEX");
+    // VACUUM may renumber the rowids
+    _dbUid = ++_dbUidLast;
+    return true;
+}
+
+CtStorageFreeStats CtStorageSqlite::get_free_stats()
+{
+    CtStorageFreeStats freeStats;
+    if (not _pDb) {
+        return freeStats;
+    }
+    const gint64 pageSize = _get_pragma_int64("page_size");
+    freeStats.totBytes = _get_pragma_int64("page_count") * pageSize;
+    freeStats.freeBytes = _get_pragma_int64("freelist_count") * pageSize;
+    freeStats.incrementalVacuum = 2/*INCREMENTAL*/ == _get_pragma_int64("auto_vacuum");
+    return freeStats;
 }
 
-void CtStorageSqlite::_open_db(const fs::path& path)
+bool CtStorageSqlite::compact_step(const int maxPages)
+{
+    if (not _pDb or 2/*INCREMENTAL*/ != _get_pragma_int64("auto_vacuum")) {
+        return false;
+    }
+    // the pages are moved within the file, the rowids stay
+    const std::string sqlCmd = fmt::format("PRAGMA incremental_vacuum({})", maxPages);
+    _exec_no_callback(sqlCmd.c_str());
+    return _get_pragma_int64("freelist_count") > 0;
+}
+
+void CtStorageSqlite::_open_db(const fs::path& path, const bool keepDbUid/*= false*/)
 {
     if (_pDb) return;
     if (sqlite3_open(path.c_str(), &_pDb) != SQLITE_OK) {
@@ -408,11 +462,19 @@ void CtStorageSqlite::_open_db(const fs::path& path)
         _pDb = nullptr;
         throw std::runtime_error(std::string("sqlite3_open: ") + error);
     }
+    if (not keepDbUid or 0 == _dbUid) {
+        _dbUid = ++_dbUidLast;
+    }
+    if (not _pEmbFileRows) {
+        _pEmbFileRows = std::make_shared<CtEmbFileSqliteRows>();
+    }
+    _pEmbFileRows->set_db(_pDb);
 }
 
 void CtStorageSqlite::_close_db()
 {
     if (not _pDb) return;
+    _pEmbFileRows->set_db(nullptr);
     sqlite3_close(_pDb);
     _pDb = nullptr;
     //_file_path = ""; we need file_path for reconnection
@@ -471,11 +533,8 @@ Gtk::TreeIter CtStorageSqlite::_node_from_db(const gint64 node_id,
         return Gtk::TreeIter{};
     }
 
-    // buffer for imported node should be loaded now because file will be closed
-    if (new_id != -1 and master_id <= 0/*no need for shared non master*/) {
-        nodeData.rTextBuffer = get_delayed_text_buffer(node_id, nodeData.syntax, nodeData.anchoredWidgets);
-    }
-
+    // (the buffer of an imported node is read later from the imported database, kept open)
+    CtTrace::counter_add(CtTraceCounter::NodesLoaded, 1);
     return _pCtMainWin->get_tree_store().append_node(&nodeData, &parent_iter);
 }
 
@@ -521,16 +580,258 @@ Glib::RefPtr<Gsv::Buffer> CtStorageSqlite::get_delayed_text_buffer(const gint64
     return rRetTextBuffer;
 }
 
-void CtStorageSqlite::_image_from_db(const gint64& nodeId, std::list<CtAnchoredWidget*>& anchoredWidgets) const
+bool CtStorageSqlite::get_delayed_node_xml(const gint64 node_id,
+                                           const std::string& syntax,
+                                           xmlpp::Element* p_node_node) const
 {
-    Sqlite3StmtAuto stmt{_pDb, "SELECT * FROM image WHERE node_id=? ORDER BY offset ASC"};
+    Sqlite3StmtAuto stmt{_pDb, "SELECT txt, is_richtxt, has_codebox, has_table, has_image FROM node WHERE node_id=?"};
     if (stmt.is_bad()) {
         spdlog::error("{}: {}", ERR_SQLITE_PREPV2, sqlite3_errmsg(_pDb));
-        return;
+        return false;
     }
-    sqlite3_bind_int64(stmt, 1, nodeId);
+    sqlite3_bind_int64(stmt, 1, node_id);
+    if (sqlite3_step(stmt) != SQLITE_ROW) {
+        spdlog::error("!! missing node properties for id {}", node_id);
+        return false;
+    }
+    const bool is_rich_text = CtConst::RICH_TEXT_ID == syntax;
+    if (is_rich_text != static_cast<bool>(sqlite3_column_int64(stmt, 1) & 0x01)) {
+        return false; // the node type changed since the last save
+    }
+    const char* textContent = safe_sqlite3_column_text(stmt, 0);
+    if (not is_rich_text) {
+        p_node_node->add_child("rich_text")->add_child_text(textContent);
+        return true;
+    }
+    xmlpp::DomParser parser;
+    if (not CtXmlHelper::safe_parse_memory(parser, textContent) or not parser.get_document()->get_root_node()) {
+        spdlog::error("!! xml read: {}", textContent);
+        return false;
+    }
+    for (xmlpp::Node* xml_slot : parser.get_document()->get_root_node()->get_children("rich_text")) {
+        p_node_node->import_node(xml_slot);
+    }
+    if (sqlite3_column_int64(stmt, 2) or sqlite3_column_int64(stmt, 3) or sqlite3_column_int64(stmt, 4)) {
+        return _widgets_xml_from_db(node_id, p_node_node);
+    }
+    return true;
+}
+
+bool CtStorageSqlite::release_text_buffer(const CtTreeIter&/*ct_tree_iter*/)
+{
+    // the text buffer is read from the database every time
+    return not _isDryRun;
+}
+
+bool CtStorageSqlite::adopt_saved_node(const gint64/*node_id*/)
+{
+    return not _isDryRun;
+}
+
+bool CtStorageSqlite::_widgets_xml_from_db(const gint64 nodeId, xmlpp::Element* p_node_node) const
+{
+    auto f_widget_element = [p_node_node](const char* name, sqlite3_stmt* stmt)->xmlpp::Element*{
+        xmlpp::Element* p_widget_node = p_node_node->add_child(name);
+        p_widget_node->set_attribute("char_offset", std::to_string(sqlite3_column_int64(stmt, 1)));
+        Glib::ustring justification = safe_sqlite3_column_text(stmt, 2);
+        if (justification.empty()) justification = CtConst::TAG_PROP_VAL_LEFT;
+        p_widget_node->set_attribute(CtConst::TAG_JUSTIFICATION, justification);
+        return p_widget_node;
+    };
+    {
+        Sqlite3StmtAuto stmt{_pDb, "SELECT * FROM codebox WHERE node_id=? ORDER BY offset ASC"};
+        if (stmt.is_bad()) {
+            spdlog::error("{}: {}", ERR_SQLITE_PREPV2, sqlite3_errmsg(_pDb));
+            return false;
+        }
+        sqlite3_bind_int64(stmt, 1, nodeId);
+        while (SQLITE_ROW == sqlite3_step(stmt)) {
+            xmlpp::Element* p_codebox_node = f_widget_element("codebox", stmt);
+            p_codebox_node->set_attribute("frame_width", std::to_string(sqlite3_column_int64(stmt, 5)));
+            p_codebox_node->set_attribute("frame_height", std::to_string(sqlite3_column_int64(stmt, 6)));
+            p_codebox_node->set_attribute("width_in_pixels", std::to_string(sqlite3_column_int64(stmt, 7)));
+            p_codebox_node->set_attribute("syntax_highlighting", safe_sqlite3_column_text(stmt, 4));
+            p_codebox_node->set_attribute("highlight_brackets", std::to_string(sqlite3_column_int64(stmt, 8)));
+            p_codebox_node->set_attribute("show_line_numbers", std::to_string(sqlite3_column_int64(stmt, 9)));
+            p_codebox_node->add_child_text(safe_sqlite3_column_text(stmt, 3));
+        }
+    }
+    {
+        Sqlite3StmtAuto stmt{_pDb, "SELECT * FROM grid WHERE node_id=? ORDER BY offset ASC"};
+        if (stmt.is_bad()) {
+            spdlog::error("{}: {}", ERR_SQLITE_PREPV2, sqlite3_errmsg(_pDb));
+            return false;
+        }
+        sqlite3_bind_int64(stmt, 1, nodeId);
+        while (SQLITE_ROW == sqlite3_step(stmt)) {
+            const char* textContent = safe_sqlite3_column_text(stmt, 3);
+            xmlpp::DomParser parser;
+            if (not CtXmlHelper::safe_parse_memory(parser, textContent) or not parser.get_document()->get_root_node()) {
+                spdlog::error("!! table xml read: {}", textContent);
+                return false;
+            }
+            // the stored table already holds col_widths, is_light and the rows
+            auto p_table_node = static_cast<xmlpp::Element*>(p_node_node->import_node(parser.get_document()->get_root_node()));
+            p_table_node->set_attribute("char_offset", std::to_string(sqlite3_column_int64(stmt, 1)));
+            Glib::ustring justification = safe_sqlite3_column_text(stmt, 2);
+            if (justification.empty()) justification = CtConst::TAG_PROP_VAL_LEFT;
+            p_table_node->set_attribute(CtConst::TAG_JUSTIFICATION, justification);
+            p_table_node->set_attribute("col_min", std::to_string(sqlite3_column_int64(stmt, 4)));
+            p_table_node->set_attribute("col_max", std::to_string(sqlite3_column_int64(stmt, 5)));
+        }
+    }
+    {
+        Sqlite3StmtAuto stmt{_pDb, "SELECT * FROM image WHERE node_id=? ORDER BY offset ASC"};
+        if (stmt.is_bad()) {
+            spdlog::error("{}: {}", ERR_SQLITE_PREPV2, sqlite3_errmsg(_pDb));
+            return false;
+        }
+        sqlite3_bind_int64(stmt, 1, nodeId);
+        while (SQLITE_ROW == sqlite3_step(stmt)) {
+            xmlpp::Element* p_image_node = f_widget_element("encoded_png", stmt);
+            const Glib::ustring anchorName = safe_sqlite3_column_text(stmt, 3);
+            if (not anchorName.empty()) {
+                p_image_node->set_attribute("anchor", anchorName);
+                continue;
+            }
+            const std::string fileName = safe_sqlite3_column_text(stmt, 5);
+            const void* pBlob = sqlite3_column_blob(stmt, 4);
+            const int blobSize = sqlite3_column_bytes(stmt, 4);
+            const std::string rawBlob(reinterpret_cast<const char*>(pBlob), static_cast<size_t>(blobSize));
+            if (fileName == CtImageLatex::LatexSpecialFilename) {
+                p_image_node->set_attribute("filename", fileName);
+                p_image_node->add_child_text(rawBlob);
+            }
+            else if (not fileName.empty()) {
+                p_image_node->set_attribute("filename", fileName);
+                p_image_node->set_attribute("time", std::to_string(sqlite3_column_int64(stmt, 7)));
+                p_image_node->add_child_text(Glib::Base64::encode(rawBlob));
+            }
+            else {
+                p_image_node->set_attribute("link", safe_sqlite3_column_text(stmt, 6));
+                p_image_node->add_child_text(Glib::Base64::encode(rawBlob));
+            }
+        }
+    }
+    return true;
+}
+
+void CtStorageSqlite::_widgets_xml_to_db(const gint64 node_id,
+                                         const xmlpp::Element* p_node_node,
+                                         bool& has_codebox,
+                                         bool& has_table,
+                                         bool& has_image)
+{
+    auto f_bind_offset_justification = [](sqlite3_stmt* stmt, const gint64 node_id, const xmlpp::Element* p_widget_node, std::string& justification){
+        justification = p_widget_node->get_attribute_value(CtConst::TAG_JUSTIFICATION);
+        sqlite3_bind_int64(stmt, 1, node_id);
+        sqlite3_bind_int64(stmt, 2, std::stoll(p_widget_node->get_attribute_value("char_offset")));
+        sqlite3_bind_text(stmt, 3, justification.c_str(), justification.size(), SQLITE_STATIC);
+    };
+    for (const xmlpp::Node* xml_slot : p_node_node->get_children()) {
+        auto p_widget_node = dynamic_cast<const xmlpp::Element*>(xml_slot);
+        if (not p_widget_node or p_widget_node->get_name() == "rich_text") {
+            continue;
+        }
+        std::string justification;
+        if (p_widget_node->get_name() == "codebox") {
+            Sqlite3StmtAuto stmt{_pDb, TABLE_CODEBOX_INSERT};
+            if (stmt.is_bad()) {
+                throw std::runtime_error(ERR_SQLITE_PREPV2 + sqlite3_errmsg(_pDb));
+            }
+            f_bind_offset_justification(stmt, node_id, p_widget_node, justification);
+            const auto p_text_node = p_widget_node->get_child_text();
+            const std::string codebox_txt = p_text_node ? p_text_node->get_content() : "";
+            const std::string syntax = p_widget_node->get_attribute_value("syntax_highlighting");
+            sqlite3_bind_text(stmt, 4, codebox_txt.c_str(), codebox_txt.size(), SQLITE_STATIC);
+            sqlite3_bind_text(stmt, 5, syntax.c_str(), syntax.size(), SQLITE_STATIC);
+            sqlite3_bind_int64(stmt, 6, std::stoll(p_widget_node->get_attribute_value("frame_width")));
+            sqlite3_bind_int64(stmt, 7, std::stoll(p_widget_node->get_attribute_value("frame_height")));
+            sqlite3_bind_int64(stmt, 8, CtStrUtil::is_str_true(p_widget_node->get_attribute_value("width_in_pixels")));
+            sqlite3_bind_int64(stmt, 9, CtStrUtil::is_str_true(p_widget_node->get_attribute_value("highlight_brackets")));
+            sqlite3_bind_int64(stmt, 10, CtStrUtil::is_str_true(p_widget_node->get_attribute_value("show_line_numbers")));
+            if (sqlite3_step(stmt) != SQLITE_DONE) {
+                throw std::runtime_error(ERR_SQLITE_STEP + sqlite3_errmsg(_pDb));
+            }
+            has_codebox = true;
+        }
+        else if (p_widget_node->get_name() == "table") {
+            Sqlite3StmtAuto stmt{_pDb, TABLE_TABLE_INSERT};
+            if (stmt.is_bad()) {
+                throw std::runtime_error(ERR_SQLITE_PREPV2 + sqlite3_errmsg(_pDb));
+            }
+            xmlpp::Document xml_doc;
+            xmlpp::Element* p_table_node = xml_doc.create_root_node("table");
+            p_table_node->set_attribute("col_widths", p_widget_node->get_attribute_value("col_widths"));
+            if (CtStrUtil::is_str_true(p_widget_node->get_attribute_value("is_light"))) {
+                p_table_node->set_attribute("is_light", "1");
+            }
+            for (const xmlpp::Node* xml_row : p_widget_node->get_children("row")) {
+                p_table_node->import_node(xml_row);
+            }
+            const std::string table_txt = xml_doc.write_to_string();
+            f_bind_offset_justification(stmt, node_id, p_widget_node, justification);
+            sqlite3_bind_text(stmt, 4, table_txt.c_str(), table_txt.size(), SQLITE_STATIC);
+            const gint64 colWidthDefault = std::stoll(p_widget_node->get_attribute_value("col_max"));
+            sqlite3_bind_int64(stmt, 5, colWidthDefault);
+            sqlite3_bind_int64(stmt, 6, colWidthDefault);
+            if (sqlite3_step(stmt) != SQLITE_DONE) {
+                throw std::runtime_error(ERR_SQLITE_STEP + sqlite3_errmsg(_pDb));
+            }
+            has_table = true;
+        }
+        else if (p_widget_node->get_name() == "encoded_png") {
+            Sqlite3StmtAuto stmt{_pDb, TABLE_IMAGE_INSERT};
+            if (stmt.is_bad()) {
+                throw std::runtime_error(ERR_SQLITE_PREPV2 + sqlite3_errmsg(_pDb));
+            }
+            f_bind_offset_justification(stmt, node_id, p_widget_node, justification);
+            const std::string anchor_name = p_widget_node->get_attribute_value("anchor");
+            const std::string file_name = p_widget_node->get_attribute_value("filename");
+            const std::string link = p_widget_node->get_attribute_value("link");
+            const std::string time_str = p_widget_node->get_attribute_value("time");
+            const auto p_text_node = p_widget_node->get_child_text();
+            std::string rawBlob = p_text_node ? p_text_node->get_content() : "";
+            if (anchor_name.empty() and file_name != CtImageLatex::LatexSpecialFilename) {
+                rawBlob = Glib::Base64::decode(rawBlob);
+            }
+            sqlite3_bind_text(stmt, 4, anchor_name.c_str(), anchor_name.size(), SQLITE_STATIC);
+            sqlite3_bind_blob(stmt, 5, rawBlob.c_str(), rawBlob.size(), SQLITE_STATIC);
+            sqlite3_bind_text(stmt, 6, file_name.c_str(), file_name.size(), SQLITE_STATIC);
+            sqlite3_bind_text(stmt, 7, link.c_str(), link.size(), SQLITE_STATIC);
+            sqlite3_bind_int64(stmt, 8, time_str.empty() ? 0 : std::stoll(time_str));
+            if (sqlite3_step(stmt) != SQLITE_DONE) {
+                throw std::runtime_error(ERR_SQLITE_STEP + sqlite3_errmsg(_pDb));
+            }
+            has_image = true;
+        }
+    }
+}
+
+void CtStorageSqlite::_image_from_db(const gint64& nodeId, std::list<CtAnchoredWidget*>& anchoredWidgets) const
+{
+    // the content of an embedded file is left in the row, only its length is read
+    auto uStmt = std::make_unique<Sqlite3StmtAuto>(_pDb, "SELECT node_id, offset, justification, anchor, "
+                                                         "CASE WHEN ifnull(filename, '') IN ('', ?) THEN png END, "
+                                                         "filename, link, time, length(png), rowid FROM image WHERE node_id=? ORDER BY offset ASC");
+    if (uStmt->is_bad()) {
+        // db from old version, no embedded files
+        uStmt.reset(new Sqlite3StmtAuto{_pDb, "SELECT *, rowid FROM image WHERE node_id=? ORDER BY offset ASC"});
+        if (uStmt->is_bad()) {
+            spdlog::error("{}: {}", ERR_SQLITE_PREPV2, sqlite3_errmsg(_pDb));
+            return;
+        }
+        sqlite3_bind_int64(*uStmt, 1, nodeId);
+    }
+    else {
+        sqlite3_bind_text(*uStmt, 1, CtImageLatex::LatexSpecialFilename.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int64(*uStmt, 2, nodeId);
+    }
+    sqlite3_stmt* stmt = *uStmt;
 
     while (SQLITE_ROW == sqlite3_step(stmt)) {
+        const sqlite3_int64 rowId = sqlite3_column_int64(stmt, sqlite3_column_count(stmt) - 1);
+        const size_t numWidgetsBefore = anchoredWidgets.size();
         int charOffset = sqlite3_column_int64(stmt, 1);
         Glib::ustring justification = safe_sqlite3_column_text(stmt, 2);
         if (justification.empty()) justification = CtConst::TAG_PROP_VAL_LEFT;
@@ -542,13 +843,15 @@ void CtStorageSqlite::_image_from_db(const gint64& nodeId, std::list<CtAnchoredW
         }
         else {
             fs::path fileName = safe_sqlite3_column_text(stmt, 5);
-            const void* pBlob = sqlite3_column_blob(stmt, 4);
-            const int blobSize = sqlite3_column_bytes(stmt, 4);
-            const std::string rawBlob(reinterpret_cast<const char*>(pBlob), static_cast<size_t>(blobSize));
+            auto f_raw_blob = [stmt]() {
+                const void* pBlob = sqlite3_column_blob(stmt, 4);
+                const int blobSize = sqlite3_column_bytes(stmt, 4);
+                return std::string(reinterpret_cast<const char*>(pBlob), static_cast<size_t>(blobSize));
+            };
             if (not fileName.empty()) {
                 if (fileName == CtImageLatex::LatexSpecialFilename) {
                     anchoredWidgets.push_back(new CtImageLatex{_pCtMainWin,
-                                                               rawBlob,
+                                                               f_raw_blob(),
                                                                charOffset,
                                                                justification,
                                                                CtImageEmbFile::get_next_unique_id()});
@@ -557,7 +860,7 @@ void CtStorageSqlite::_image_from_db(const gint64& nodeId, std::list<CtAnchoredW
                     const time_t timeSeconds = sqlite3_column_int64(stmt, 7);
                     anchoredWidgets.push_back(new CtImageEmbFile{_pCtMainWin,
                                                                  fileName,
-                                                                 rawBlob,
+                                                                 _pEmbFileRows->create_blob(nodeId, rowId, static_cast<size_t>(sqlite3_column_int64(stmt, 8))),
                                                                  timeSeconds,
                                                                  charOffset,
                                                                  justification,
@@ -566,15 +869,18 @@ void CtStorageSqlite::_image_from_db(const gint64& nodeId, std::list<CtAnchoredW
             }
             else {
                 const Glib::ustring link = safe_sqlite3_column_text(stmt, 6);
-                anchoredWidgets.push_back(new CtImagePng{_pCtMainWin, rawBlob, link, charOffset, justification});
+                anchoredWidgets.push_back(new CtImagePng{_pCtMainWin, f_raw_blob(), link, charOffset, justification});
             }
         }
+        if (anchoredWidgets.size() > numWidgetsBefore) {
+            _set_widget_row_ref(anchoredWidgets.back(), nodeId, rowId);
+        }
     }
 }
 
 void CtStorageSqlite::_codebox_from_db(const gint64& nodeId ,std::list<CtAnchoredWidget*>& anchoredWidgets) const
 {
-    Sqlite3StmtAuto stmt{_pDb, "SELECT * FROM codebox WHERE node_id=? ORDER BY offset ASC"};
+    Sqlite3StmtAuto stmt{_pDb, "SELECT *, rowid FROM codebox WHERE node_id=? ORDER BY offset ASC"};
     if (stmt.is_bad()) {
         spdlog::error("{}: {}", ERR_SQLITE_PREPV2, sqlite3_errmsg(_pDb));
         return;
@@ -604,12 +910,13 @@ void CtStorageSqlite::_codebox_from_db(const gint64& nodeId ,std::list<CtAnchore
                                                 widthInPixels,
                                                 highlightBrackets,
                                                 showLineNumbers));
+        _set_widget_row_ref(anchoredWidgets.back(), nodeId, sqlite3_column_int64(stmt, sqlite3_column_count(stmt) - 1));
     }
 }
 
 void CtStorageSqlite::_table_from_db(const gint64& nodeId, std::list<CtAnchoredWidget*>& anchoredWidgets) const
 {
-    Sqlite3StmtAuto stmt{_pDb, "SELECT * FROM grid WHERE node_id=? ORDER BY offset ASC"};
+    Sqlite3StmtAuto stmt{_pDb, "SELECT *, rowid FROM grid WHERE node_id=? ORDER BY offset ASC"};
     if (stmt.is_bad()) {
         spdlog::error("{}: {}", ERR_SQLITE_PREPV2, sqlite3_errmsg(_pDb));
         return;
@@ -638,6 +945,7 @@ void CtStorageSqlite::_table_from_db(const gint64& nodeId, std::list<CtAnchoredW
             else {
                 anchoredWidgets.push_back(new CtTableHeavy{_pCtMainWin, tableMatrix, colWidthDefault, charOffset, justification, tableColWidths});
             }
+            _set_widget_row_ref(anchoredWidgets.back(), nodeId, sqlite3_column_int64(stmt, sqlite3_column_count(stmt) - 1));
         }
         else {
             spdlog::error("!! table xml read: {}", textContent);
@@ -645,6 +953,108 @@ void CtStorageSqlite::_table_from_db(const gint64& nodeId, std::list<CtAnchoredW
     }
 }
 
+void CtStorageSqlite::_widgets_to_db_incremental(const gint64 node_id,
+                                                 const std::list<CtAnchoredWidget*>& anchoredWidgets,
+                                                 CtStorageCache* storage_cache)
+{
+    // the rows in the db for the node, the ones not claimed by any widget get deleted
+    std::unordered_map<std::string, std::unordered_set<sqlite3_int64>> rowIdsToRm;
+    for (const char* tableName : {"codebox", "grid", "image"}) {
+        std::unordered_set<sqlite3_int64>& rowIds = rowIdsToRm[tableName];
+        const std::string sqlCmd = fmt::format("SELECT rowid FROM {} WHERE node_id=?", tableName);
+        Sqlite3StmtAuto stmt{_pDb, sqlCmd.c_str()};
+        if (stmt.is_bad()) {
+            throw std::runtime_error(ERR_SQLITE_PREPV2 + sqlite3_errmsg(_pDb));
+        }
+        sqlite3_bind_int64(stmt, 1, node_id);
+        while (SQLITE_ROW == sqlite3_step(stmt)) {
+            rowIds.insert(sqlite3_column_int64(stmt, 0));
+        }
+    }
+    auto f_exec_on_row = [this](const std::string& sqlCmd, const sqlite3_int64 rowId, const int* pCharOffset, const std::string* pJustification) {
+        Sqlite3StmtAuto stmt{_pDb, sqlCmd.c_str()};
+        if (stmt.is_bad()) {
+            throw std::runtime_error(ERR_SQLITE_PREPV2 + sqlite3_errmsg(_pDb));
+        }
+        int bindIdx{1};
+        if (pCharOffset) {
+            sqlite3_bind_int64(stmt, bindIdx++, *pCharOffset);
+            sqlite3_bind_text(stmt, bindIdx++, pJustification->c_str(), pJustification->size(), SQLITE_STATIC);
+        }
+        sqlite3_bind_int64(stmt, bindIdx, rowId);
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            throw std::runtime_error(ERR_SQLITE_STEP + sqlite3_errmsg(_pDb));
+        }
+    };
+
+    auto f_delete_row = [this, &f_exec_on_row](const std::string& tableName, const sqlite3_int64 rowId) {
+        if ("image" == tableName) {
+            // an embedded file content still in use no longer reads from the row
+            _pEmbFileRows->detach_row(rowId);
+        }
+        f_exec_on_row(fmt::format("DELETE FROM {} WHERE rowid=?", tableName), rowId, nullptr, nullptr);
+    };
+
+    for (CtAnchoredWidget* pAnchoredWidget : anchoredWidgets) {
+        const char* tableName = _get_widget_table_name(pAnchoredWidget->get_type());
+        std::unordered_set<sqlite3_int64>& rowIds = rowIdsToRm.at(tableName);
+        const CtSqliteRowRef& rowRef = pAnchoredWidget->get_sqlite_row_ref();
+        const bool rowOwned = rowRef.dbUid == _dbUid and
+                              rowRef.nodeId == node_id and
+                              1u == rowIds.erase(rowRef.rowId);
+        if (rowOwned) {
+            if (rowRef.contentSignature == pAnchoredWidget->get_content_signature()) {
+                if (rowRef.charOffset != pAnchoredWidget->getOffset() or
+                    rowRef.justification != pAnchoredWidget->getJustification())
+                {
+                    // moved only, the content stays
+                    const int charOffset = pAnchoredWidget->getOffset();
+                    const std::string justification = pAnchoredWidget->getJustification();
+                    f_exec_on_row(fmt::format("UPDATE {} SET offset=?, justification=? WHERE rowid=?", tableName), rowRef.rowId, &charOffset, &justification);
+                    CtSqliteRowRef rowRefMoved = rowRef;
+                    rowRefMoved.charOffset = charOffset;
+                    rowRefMoved.justification = justification;
+                    pAnchoredWidget->set_sqlite_row_ref(rowRefMoved);
+                }
+                continue;
+            }
+            f_delete_row(tableName, rowRef.rowId);
+        }
+        if (not pAnchoredWidget->to_sqlite(_pDb, node_id, 0, storage_cache)) {
+            throw std::runtime_error("couldn't save widget");
+        }
+        _set_widget_row_ref(pAnchoredWidget, node_id, sqlite3_last_insert_rowid(_pDb));
+    }
+
+    for (const auto& currPair : rowIdsToRm) {
+        for (const sqlite3_int64 rowId : currPair.second) {
+            f_delete_row(currPair.first, rowId);
+        }
+    }
+}
+
+void CtStorageSqlite::_set_widget_row_ref(CtAnchoredWidget* pAnchoredWidget, const gint64 node_id, const sqlite3_int64 row_id) const
+{
+    CtSqliteRowRef rowRef;
+    rowRef.dbUid = _dbUid;
+    rowRef.nodeId = node_id;
+    rowRef.rowId = row_id;
+    rowRef.contentSignature = pAnchoredWidget->get_content_signature();
+    rowRef.charOffset = pAnchoredWidget->getOffset();
+    rowRef.justification = pAnchoredWidget->getJustification();
+    pAnchoredWidget->set_sqlite_row_ref(rowRef);
+}
+
+/*static*/const char* CtStorageSqlite::_get_widget_table_name(const CtAnchWidgType widgType)
+{
+    switch (widgType) {
+        case CtAnchWidgType::CodeBox: return "codebox";
+        case CtAnchWidgType::TableLight: [[fallthrough]];
+        case CtAnchWidgType::TableHeavy: return "grid";
+        default: return "image";
+    }
+}
+
 void CtStorageSqlite::_create_all_tables_in_db()
 {
     _exec_no_callback(TABLE_NODE_CREATE);
@@ -684,6 +1094,7 @@ void CtStorageSqlite::_write_node_to_db(const CtTreeIter* ct_tree_iter,
                                         const CtExporting export_type,
                                         const std::map<gint64, gint64>* pExpoMasterReassign)
 {
+    CtTrace::counter_add(CtTraceCounter::NodesSerialized, 1);
     const gint64 node_id = ct_tree_iter->get_node_id();
     gint64 master_id = ct_tree_iter->get_node_shared_master_id();
     if (CtExporting::SELECTED_TEXT == export_type or
@@ -749,21 +1160,52 @@ void CtStorageSqlite::_write_node_to_db(const CtTreeIter* ct_tree_iter,
         exclude_from_search |= 0x02;
     }
 
+    // content not loaded/modified, transcoded from the storage without creating the text buffer
+    std::unique_ptr<xmlpp::Document> pStoredXmlDoc;
+    if (node_state.buff and CtExporting::SELECTED_TEXT != export_type) {
+        pStoredXmlDoc = std::make_unique<xmlpp::Document>();
+        if (not _pCtMainWin->get_ct_storage()->get_stored_node_xml(*ct_tree_iter, pStoredXmlDoc->create_root_node("node"))) {
+            pStoredXmlDoc.reset();
+        }
+    }
+
     // write widgets
     bool has_codebox{false};
     bool has_table{false};
     bool has_image{false};
     if (node_state.buff) {
-        if (node_state.is_update_of_existing and ((is_richtxt & 0x01) or node_state.prop)) {
+        // the widgets rows of a loaded rich text node being saved in place are only touched where changed
+        const bool widgets_incremental = node_state.is_update_of_existing and
+                                         (is_richtxt & 0x01) and
+                                         not pStoredXmlDoc and
+                                         CtExporting::NONESAVE == export_type and
+                                         0 == start_offset and end_offset < 0;
+        // the rows written for the document (not for an export) are referenced by the widgets
+        const bool widgets_row_ref = (CtExporting::NONESAVE == export_type or CtExporting::NONESAVEAS == export_type) and
+                                     0 == start_offset and end_offset < 0;
+        if (node_state.is_update_of_existing and ((is_richtxt & 0x01) or node_state.prop) and not widgets_incremental) {
             // if it's a rich text or has property changed (maybe was a rich text) clear old widgets
             _exec_bind_int64(TABLE_CODEBOX_DELETE, node_id);
             _exec_bind_int64(TABLE_TABLE_DELETE, node_id);
+            _pEmbFileRows->detach_node(node_id);
             _exec_bind_int64(TABLE_IMAGE_DELETE, node_id);
         }
-        if (is_richtxt & 0x01) {
-            for (CtAnchoredWidget* pAnchoredWidget : ct_tree_iter->get_anchored_widgets(start_offset, end_offset)) {
-                if (not pAnchoredWidget->to_sqlite(_pDb, node_id, start_offset >= 0 ? -start_offset : 0, storage_cache))
-                    throw std::runtime_error("couldn't save widget");
+        if ((is_richtxt & 0x01) and pStoredXmlDoc) {
+            _widgets_xml_to_db(node_id, pStoredXmlDoc->get_root_node(), has_codebox, has_table, has_image);
+        }
+        else if (is_richtxt & 0x01) {
+            const std::list<CtAnchoredWidget*> anchoredWidgets = ct_tree_iter->get_anchored_widgets(start_offset, end_offset);
+            if (widgets_incremental) {
+                _widgets_to_db_incremental(node_id, anchoredWidgets, storage_cache);
+            }
+            for (CtAnchoredWidget* pAnchoredWidget : anchoredWidgets) {
+                if (not widgets_incremental) {
+                    if (not pAnchoredWidget->to_sqlite(_pDb, node_id, start_offset >= 0 ? -start_offset : 0, storage_cache))
+                        throw std::runtime_error("couldn't save widget");
+                    if (widgets_row_ref) {
+                        _set_widget_row_ref(pAnchoredWidget, node_id, sqlite3_last_insert_rowid(_pDb));
+                    }
+                }
                 switch (pAnchoredWidget->get_type()) {
                     case CtAnchWidgType::CodeBox: has_codebox = true; break;
                     case CtAnchWidgType::TableLight: [[fallthrough]];
@@ -798,7 +1240,27 @@ void CtStorageSqlite::_write_node_to_db(const CtTreeIter* ct_tree_iter,
     else if (node_state.buff) {
         // get buffer content
         std::string node_txt;
-        if (is_richtxt & 0x01) {
+        if (pStoredXmlDoc) {
+            if (is_richtxt & 0x01) {
+                xmlpp::Document xml_doc;
+                xml_doc.create_root_node("node");
+                for (xmlpp::Node* xml_slot : pStoredXmlDoc->get_root_node()->get_children("rich_text")) {
+                    xml_doc.get_root_node()->import_node(xml_slot);
+                }
+                node_txt = xml_doc.write_to_string();
+            }
+            else {
+                for (xmlpp::Node* xml_slot : pStoredXmlDoc->get_root_node()->get_children("rich_text")) {
+                    if (const xmlpp::TextNode* pTextNode = static_cast<xmlpp::Element*>(xml_slot)->get_child_text()) {
+                        node_txt += pTextNode->get_content();
+                    }
+                }
+            }
+        }
+        else if (not ct_tree_iter->get_node_text_buffer()) {
+            throw std::runtime_error(str::format(_("Failed to retrieve the content of the node '%s'"), ct_tree_iter->get_node_name()));
+        }
+        else if (is_richtxt & 0x01) {
             xmlpp::Document xml_doc;
             xml_doc.create_root_node("node");
             CtStorageXmlHelper{_pCtMainWin}.save_buffer_no_widgets_to_xml(xml_doc.get_root_node(),
@@ -814,6 +1276,10 @@ void CtStorageSqlite::_write_node_to_db(const CtTreeIter* ct_tree_iter,
                 node_txt = text_buffer->get_iter_at_offset(start_offset).get_text(text_buffer->get_iter_at_offset(end_offset));
             }
         }
+        if (CtExporting::NONESAVE == export_type) {
+            // for the verification after save, digested at the end of the save with the widgets rows
+            _nodesDigests[node_id].clear();
+        }
 
         // full node rewrite (buf + prop)
         if (node_state.prop) {
@@ -888,6 +1354,7 @@ void CtStorageSqlite::_remove_db_node_with_children(const gint64 node_id)
 {
     _exec_bind_int64(TABLE_CODEBOX_DELETE, node_id);
     _exec_bind_int64(TABLE_TABLE_DELETE, node_id);
+    _pEmbFileRows->detach_node(node_id);
     _exec_bind_int64(TABLE_IMAGE_DELETE, node_id);
     _exec_bind_int64(TABLE_NODE_DELETE, node_id);
     _exec_bind_int64(TABLE_CHILDREN_DELETE, node_id);
@@ -897,6 +1364,34 @@ void CtStorageSqlite::_remove_db_node_with_children(const gint64 node_id)
     }
 }
 
+void CtStorageSqlite::_digest_written_nodes()
+{
+    // the rows just written are read back, as the verification will do from the saved file
+    CtTraceSpan traceSpan{"nodes_digests"};
+    CtSqliteNodeDigest sqliteNodeDigest{_pDb};
+    Glib::ustring error;
+    for (auto it = _nodesDigests.begin(); it != _nodesDigests.end(); ) {
+        if (sqliteNodeDigest.get(it->first, it->second, error)) {
+            ++it;
+        }
+        else {
+            spdlog::error("!! {} {}", __FUNCTION__, error.raw());
+            it = _nodesDigests.erase(it); // not to be verified
+        }
+    }
+}
+
+gint64 CtStorageSqlite::_get_pragma_int64(const char* pragmaName)
+{
+    const std::string sqlCmd = std::string{"PRAGMA "} + pragmaName;
+    Sqlite3StmtAuto stmt{_pDb, sqlCmd.c_str()};
+    if (stmt.is_bad() or SQLITE_ROW != sqlite3_step(stmt)) {
+        spdlog::error("!! {} {}", sqlCmd, sqlite3_errmsg(_pDb));
+        return 0;
+    }
+    return sqlite3_column_int64(stmt, 0);
+}
+
 void CtStorageSqlite::_exec_no_callback(const char* sqlCmd)
 {
     char* p_err_msg{nullptr};
@@ -919,23 +1414,25 @@ void CtStorageSqlite::_exec_bind_int64(const char* sqlCmd, const gint64 bind_int
     }
 }
 
-void CtStorageSqlite::import_nodes(const fs::path& path, const Gtk::TreeIter& parent_iter)
+void CtStorageSqlite::import_nodes(const fs::path& path,
+                                   const Gtk::TreeIter& parent_iter,
+                                   std::multimap<gint64, gint64>& imported_ids_remap)
 {
     _open_db(path); // storage is temp so can just open db
     if (not _check_database_integrity()) return;
 
-    std::map<gint64,gint64> imported_ids_remap;
     std::list<CtTreeIter> nodes_shared_non_master;
     CtTreeStore& ct_tree_store = _pCtMainWin->get_tree_store();
+    gint64 next_node_id = ct_tree_store.node_id_get();
     std::function<void(const std::pair<gint64,gint64>& id_pair, const gint64 sequence, Gtk::TreeIter parent_iter)> f_nodes_from_db;
     f_nodes_from_db = [&](const std::pair<gint64,gint64>& id_pair, const gint64 sequence, Gtk::TreeIter parent_iter) {
-        const gint64 new_id = ct_tree_store.node_id_get();
+        const gint64 new_id = next_node_id++;
         Gtk::TreeIter new_iter = _node_from_db(id_pair.first,
                                                id_pair.second,
                                                sequence,
                                                parent_iter,
                                                new_id);
-        imported_ids_remap[id_pair.first] = new_id;
+        imported_ids_remap.emplace(id_pair.first, new_id);
         CtTreeIter node_iter = ct_tree_store.to_ct_tree_iter(new_iter);
         node_iter.pending_new_db_node();
         if (id_pair.second > 0) {
@@ -950,7 +1447,8 @@ void CtStorageSqlite::import_nodes(const fs::path& path, const Gtk::TreeIter& pa
     for (const std::pair<gint64,gint64>& node_id_pair : _get_children_node_ids_from_db(0)) {
         f_nodes_from_db(node_id_pair, ++sequence, parent_iter);
     }
-    _close_db();
+    // the database is kept open for the delayed read of the imported nodes,
+    // it is closed when this storage is destroyed
     for (CtTreeIter& ctTreeIter : nodes_shared_non_master) {
         // the shared node master id is remapped after the import
         const gint64 origMasterId = ctTreeIter.get_node_shared_master_id();
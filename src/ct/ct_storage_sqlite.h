@@ -30,11 +30,28 @@
 #include <gtksourceviewmm/buffer.h>
 #include <gtkmm/treeiter.h>
 #include <unordered_set>
+#include <atomic>
 
 class CtMainWin;
 class CtAnchoredWidget;
 class CtTreeIter;
 class CtStorageCache;
+class CtEmbFileSqliteRows;
+
+class Sqlite3StmtAuto
+{
+public:
+    Sqlite3StmtAuto(sqlite3* pDb, const char* sql) { _prepare(pDb, sql); }
+    ~Sqlite3StmtAuto() { sqlite3_finalize(_pStmt); }
+
+    operator sqlite3_stmt*() { return _pStmt; }
+    bool is_bad() { return not _pStmt; } // it could be operator bool(), but this way it's more explicit in conditions
+
+private:
+    bool _prepare(sqlite3* pDb, const char* sql) { return sqlite3_prepare_v2(pDb, sql, -1, &_pStmt, nullptr) == SQLITE_OK; }
+
+    sqlite3_stmt* _pStmt{nullptr};
+};
 
 class CtStorageSqlite : public CtStorageEntity
 {
@@ -45,7 +62,7 @@ public:
     ~CtStorageSqlite();
 
     void close_connect() override;
-    void reopen_connect() override;
+    void reopen_connect(const bool file_replaced) override;
     void test_connection() override;
     void try_reopen() override;
 
@@ -57,14 +74,23 @@ public:
                         const std::map<gint64, gint64>* pExpoMasterReassign = nullptr,
                         const int start_offset = 0,
                         const int end_offset = -1) override;
-    void vacuum() override;
-    void import_nodes(const fs::path& path, const Gtk::TreeIter& parent_iter) override;
+    bool vacuum(const std::function<bool()>& f_stop) override;
+    CtStorageFreeStats get_free_stats() override;
+    bool compact_step(const int maxPages) override;
+    void import_nodes(const fs::path& path,
+                      const Gtk::TreeIter& parent_iter,
+                      std::multimap<gint64, gint64>& imported_ids_remap) override;
 
     Glib::RefPtr<Gsv::Buffer> get_delayed_text_buffer(const gint64 node_id,
                                                       const std::string& syntax,
                                                       std::list<CtAnchoredWidget*>& widgets) const override;
+    bool get_delayed_node_xml(const gint64 node_id,
+                              const std::string& syntax,
+                              xmlpp::Element* p_node_node) const override;
+    bool release_text_buffer(const CtTreeIter& ct_tree_iter) override;
+    bool adopt_saved_node(const gint64 node_id) override;
 private:
-    void _open_db(const fs::path& path);
+    void _open_db(const fs::path& path, const bool keepDbUid = false);
     void _close_db();
     bool _check_database_integrity();
 
@@ -91,6 +117,17 @@ private:
     void                _image_from_db(const gint64& nodeId, std::list<CtAnchoredWidget*>& anchoredWidgets) const;
     void                _codebox_from_db(const gint64& nodeId, std::list<CtAnchoredWidget*>& anchoredWidgets) const;
     void                _table_from_db(const gint64& nodeId, std::list<CtAnchoredWidget*>& anchoredWidgets) const;
+    bool                _widgets_xml_from_db(const gint64 nodeId, xmlpp::Element* p_node_node) const;
+    void                _widgets_to_db_incremental(const gint64 node_id,
+                                                   const std::list<CtAnchoredWidget*>& anchoredWidgets,
+                                                   CtStorageCache* storage_cache);
+    void                _set_widget_row_ref(CtAnchoredWidget* pAnchoredWidget, const gint64 node_id, const sqlite3_int64 row_id) const;
+    static const char*  _get_widget_table_name(const CtAnchWidgType widgType);
+    void                _widgets_xml_to_db(const gint64 node_id,
+                                           const xmlpp::Element* p_node_node,
+                                           bool& has_codebox,
+                                           bool& has_table,
+                                           bool& has_image);
 
     void                _create_all_tables_in_db();
     void                _write_bookmarks_to_db(const std::list<gint64>& bookmarks);
@@ -106,7 +143,9 @@ private:
 
     std::list<std::pair<gint64,gint64>> _get_children_node_ids_from_db(const gint64 father_id);
     void                _remove_db_node_with_children(const gint64 node_id);
+    void                _digest_written_nodes();
 
+    gint64              _get_pragma_int64(const char* pragmaName);
     void                _exec_no_callback(const char* sqlCmd);
     void                _exec_bind_int64(const char* sqlCmd, const gint64 bind_int64);
 
@@ -137,4 +176,8 @@ private:
     CtMainWin*    _pCtMainWin;
     sqlite3*      _pDb{nullptr};
     fs::path      _file_path;
+    gint64        _dbUid{0}; // changes whenever the rowids of the widgets rows may have changed
+    std::shared_ptr<CtEmbFileSqliteRows> _pEmbFileRows; // the rows of the loaded embedded files
+
+    static std::atomic<gint64> _dbUidLast; // also incremented by the vacuum worker thread
 };
@@ -0,0 +1,324 @@
+/*
+ * ct_storage_verify.cc
+ *
+ * Copyright 2009-2024
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_storage_verify.h"
+#include "ct_misc_utils.h"
+#include "ct_logging.h"
+#include <sqlite3.h>
+#include <algorithm>
+#include <functional>
+#include <list>
+
+/*static*/const size_t CtStorageVerify::SAMPLED_NUM{64u};
+
+CtSqliteNodeDigest::CtSqliteNodeDigest(sqlite3* pDb)
+{
+    // the node row first, then the widgets in offset order (one widget per offset in a node)
+    for (const char* pQuery : {"SELECT txt FROM node WHERE node_id=?",
+                               "SELECT * FROM codebox WHERE node_id=? ORDER BY offset ASC",
+                               "SELECT * FROM grid WHERE node_id=? ORDER BY offset ASC",
+                               "SELECT * FROM image WHERE node_id=? ORDER BY offset ASC"})
+    {
+        sqlite3_stmt* pStmt{nullptr};
+        if (SQLITE_OK != sqlite3_prepare_v2(pDb, pQuery, -1, &pStmt, nullptr)) {
+            _error = std::string{pQuery} + " " + sqlite3_errmsg(pDb);
+            break;
+        }
+        _stmts.push_back(pStmt);
+    }
+}
+
+CtSqliteNodeDigest::~CtSqliteNodeDigest()
+{
+    for (sqlite3_stmt* pStmt : _stmts) {
+        sqlite3_finalize(pStmt);
+    }
+}
+
+bool CtSqliteNodeDigest::get(const gint64 node_id, std::string& digest, Glib::ustring& error)
+{
+    if (not _error.empty()) {
+        error = _error;
+        return false;
+    }
+    Glib::Checksum checksum{Glib::Checksum::ChecksumType::CHECKSUM_SHA256};
+    for (sqlite3_stmt* pStmt : _stmts) {
+        sqlite3_reset(pStmt);
+        sqlite3_bind_int64(pStmt, 1, node_id);
+        const bool isNodeRow = pStmt == _stmts.front();
+        int numRows{0};
+        int stepRet;
+        while (SQLITE_ROW == (stepRet = sqlite3_step(pStmt))) {
+            ++numRows;
+            const int numColumns = sqlite3_column_count(pStmt);
+            for (int column = 0; column < numColumns; ++column) {
+                // the integers are taken as text, the size separates the columns
+                const guchar* pData = static_cast<const guchar*>(sqlite3_column_blob(pStmt, column));
+                const int numBytes = sqlite3_column_bytes(pStmt, column);
+                checksum.update(std::to_string(numBytes) + ":");
+                if (pData and numBytes > 0) {
+                    checksum.update(pData, static_cast<gsize>(numBytes));
+                }
+            }
+        }
+        if (SQLITE_DONE != stepRet) {
+            error = std::string{"sqlite3_step "} + sqlite3_errstr(stepRet);
+            return false;
+        }
+        if (isNodeRow and 1 != numRows) {
+            error = "missing node " + std::to_string(node_id);
+            return false;
+        }
+        checksum.update("|");
+    }
+    digest = checksum.get_string();
+    return true;
+}
+
+/*static*/bool CtStorageVerify::_is_white_space(const Glib::ustring& text)
+{
+    // same as xmlIsBlankNode, formatting whitespace is not part of the payload
+    return std::string::npos == text.raw().find_first_not_of(" \t\n\r");
+}
+
+// the payload of a node is its elements (names and attributes) and non blank text,
+// the sub nodes excluded; the streaming reader in _verify_xml must hash the same way
+/*static*/void CtStorageVerify::add_xml_nodes_digests(const xmlpp::Element* pElement, CtNodesDigests& nodes_digests)
+{
+    auto f_update_element = [](const xmlpp::Element* pCurrElement, Glib::Checksum& checksum){
+        checksum.update("<" + pCurrElement->get_name().raw());
+        for (const xmlpp::Attribute* pAttribute : pCurrElement->get_attributes()) {
+            checksum.update(" " + pAttribute->get_name().raw() + "=" + pAttribute->get_value().raw());
+        }
+        checksum.update(">");
+    };
+    std::function<void(const xmlpp::Element*, Glib::Checksum*)> f_walk;
+    f_walk = [&](const xmlpp::Element* pParentElement, Glib::Checksum* pChecksum){
+        for (const xmlpp::Node* pNode : pParentElement->get_children()) {
+            if (auto pCurrElement = dynamic_cast<const xmlpp::Element*>(pNode)) {
+                if ("node" == pCurrElement->get_name()) {
+                    Glib::Checksum checksum{Glib::Checksum::ChecksumType::CHECKSUM_SHA256};
+                    f_update_element(pCurrElement, checksum);
+                    f_walk(pCurrElement, &checksum);
+                    const gint64 node_id = CtStrUtil::gint64_from_gstring(pCurrElement->get_attribute_value("unique_id").c_str());
+                    nodes_digests[node_id] = checksum.get_string();
+                }
+                else if (pChecksum) {
+                    f_update_element(pCurrElement, *pChecksum);
+                    f_walk(pCurrElement, pChecksum);
+                }
+            }
+            else if (auto pContentNode = dynamic_cast<const xmlpp::ContentNode*>(pNode)) {
+                if (pChecksum and
+                    (dynamic_cast<const xmlpp::TextNode*>(pNode) or dynamic_cast<const xmlpp::CdataNode*>(pNode)) and
+                    not _is_white_space(pContentNode->get_content()))
+                {
+                    pChecksum->update(pContentNode->get_content().raw());
+                }
+            }
+        }
+    };
+    f_walk(pElement, nullptr);
+}
+
+/*static*/std::unordered_set<gint64> CtStorageVerify::_get_nodes_to_check(const CtNodesDigests& nodes_digests, const CtSaveVerify save_verify)
+{
+    std::unordered_set<gint64> nodes_to_check;
+    switch (save_verify) {
+        case CtSaveVerify::FULL: {
+            for (const auto& currPair : nodes_digests) {
+                nodes_to_check.insert(currPair.first);
+            }
+        } break;
+        case CtSaveVerify::SAMPLED: {
+            const size_t step = std::max<size_t>(1u, nodes_digests.size() / SAMPLED_NUM);
+            size_t i{0};
+            for (const auto& currPair : nodes_digests) {
+                if (0u == (i++ % step)) {
+                    nodes_to_check.insert(currPair.first);
+                }
+            }
+        } break;
+        case CtSaveVerify::STRUCTURAL: {
+        } break;
+    }
+    return nodes_to_check;
+}
+
+/*static*/bool CtStorageVerify::verify(const fs::path& file_path,
+                                       const CtNodesDigests& nodes_digests,
+                                       const CtSaveVerify save_verify,
+                                       Glib::ustring& error)
+{
+    const std::unordered_set<gint64> nodes_to_check = _get_nodes_to_check(nodes_digests, save_verify);
+    switch (fs::get_doc_type_from_file_ext(file_path)) {
+        case CtDocType::SQLite: return _verify_sqlite(file_path, nodes_digests, nodes_to_check, error);
+        case CtDocType::XML: return _verify_xml(file_path, nodes_digests, nodes_to_check, error);
+        default: break;
+    }
+    error = "unexpected doc type " + file_path.string();
+    return false;
+}
+
+/*static*/bool CtStorageVerify::_verify_sqlite(const fs::path& file_path,
+                                               const CtNodesDigests& nodes_digests,
+                                               const std::unordered_set<gint64>& nodes_to_check,
+                                               Glib::ustring& error)
+{
+    sqlite3* pDb{nullptr};
+    auto on_scope_exit = scope_guard([&](void*) { sqlite3_close(pDb); });
+    if (SQLITE_OK != sqlite3_open_v2(file_path.c_str(), &pDb, SQLITE_OPEN_READONLY, nullptr)) {
+        error = "sqlite3_open_v2 " + file_path.string();
+        return false;
+    }
+    {
+        sqlite3_stmt* pStmt{nullptr};
+        if (SQLITE_OK != sqlite3_prepare_v2(pDb, "PRAGMA quick_check", -1, &pStmt, nullptr)) {
+            error = std::string{"PRAGMA quick_check "} + sqlite3_errmsg(pDb);
+            return false;
+        }
+        std::string quick_check;
+        if (SQLITE_ROW == sqlite3_step(pStmt)) {
+            const unsigned char* pText = sqlite3_column_text(pStmt, 0);
+            quick_check = pText ? reinterpret_cast<const char*>(pText) : "";
+        }
+        sqlite3_finalize(pStmt);
+        if ("ok" != quick_check) {
+            error = "quick_check: " + quick_check;
+            return false;
+        }
+    }
+    if (nodes_to_check.empty()) {
+        return true;
+    }
+    CtSqliteNodeDigest sqliteNodeDigest{pDb};
+    std::string digest;
+    for (const gint64 node_id : nodes_to_check) {
+        if (not sqliteNodeDigest.get(node_id, digest, error)) {
+            return false;
+        }
+        if (digest != nodes_digests.at(node_id)) {
+            error = "digest mismatch of node " + std::to_string(node_id);
+            return false;
+        }
+    }
+    return true;
+}
+
+/*static*/bool CtStorageVerify::_verify_xml(const fs::path& file_path,
+                                            const CtNodesDigests& nodes_digests,
+                                            const std::unordered_set<gint64>& nodes_to_check,
+                                            Glib::ustring& error)
+{
+    struct CtOpenNode
+    {
+        gint64 node_id;
+        std::unique_ptr<Glib::Checksum> pChecksum; // null if the node is not to be checked
+    };
+    std::list<CtOpenNode> open_nodes;
+    size_t num_checked{0};
+    auto f_close_node = [&]()->bool{
+        if (open_nodes.empty()) {
+            error = "unexpected end of node";
+            return false;
+        }
+        const CtOpenNode& open_node = open_nodes.back();
+        if (open_node.pChecksum) {
+            if (open_node.pChecksum->get_string() != nodes_digests.at(open_node.node_id)) {
+                error = "digest mismatch of node " + std::to_string(open_node.node_id);
+                return false;
+            }
+            ++num_checked;
+        }
+        open_nodes.pop_back();
+        return true;
+    };
+    try {
+        xmlpp::TextReader reader{file_path.string()};
+        while (reader.read()) {
+            switch (reader.get_node_type()) {
+                case xmlpp::TextReader::Element: {
+                    const bool is_empty = reader.is_empty_element();
+                    const Glib::ustring name = reader.get_name();
+                    Glib::Checksum* pChecksum{nullptr};
+                    if ("node" == name) {
+                        const gint64 node_id = CtStrUtil::gint64_from_gstring(reader.get_attribute("unique_id").c_str());
+                        open_nodes.push_back(CtOpenNode{node_id, nullptr});
+                        if (nodes_to_check.count(node_id)) {
+                            open_nodes.back().pChecksum = std::make_unique<Glib::Checksum>(Glib::Checksum::ChecksumType::CHECKSUM_SHA256);
+                        }
+                        pChecksum = open_nodes.back().pChecksum.get();
+                    }
+                    else if (not open_nodes.empty()) {
+                        pChecksum = open_nodes.back().pChecksum.get();
+                    }
+                    if (pChecksum) {
+                        pChecksum->update("<" + name.raw());
+                        if (reader.move_to_first_attribute()) {
+                            do {
+                                pChecksum->update(" " + reader.get_name().raw() + "=" + reader.get_value().raw());
+                            } while (reader.move_to_next_attribute());
+                            reader.move_to_element();
+                        }
+                        pChecksum->update(">");
+                    }
+                    if (is_empty and "node" == name and not f_close_node()) {
+                        return false;
+                    }
+                } break;
+                case xmlpp::TextReader::EndElement: {
+                    if ("node" == reader.get_name() and not f_close_node()) {
+                        return false;
+                    }
+                } break;
+                case xmlpp::TextReader::Text:
+                case xmlpp::TextReader::CDATA: {
+                    if (not open_nodes.empty() and open_nodes.back().pChecksum) {
+                        const Glib::ustring value = reader.get_value();
+                        if (not _is_white_space(value)) {
+                            open_nodes.back().pChecksum->update(value.raw());
+                        }
+                    }
+                } break;
+                default: break;
+            }
+        }
+        if (xmlpp::TextReader::Error == reader.get_read_state()) {
+            error = "xml read error";
+            return false;
+        }
+    }
+    catch (std::exception& e) {
+        error = e.what();
+        return false;
+    }
+    if (not open_nodes.empty()) {
+        error = "truncated document";
+        return false;
+    }
+    if (num_checked != nodes_to_check.size()) {
+        error = "missing nodes " + std::to_string(nodes_to_check.size() - num_checked);
+        return false;
+    }
+    return true;
+}
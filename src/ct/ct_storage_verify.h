@@ -0,0 +1,76 @@
+/*
+ * ct_storage_verify.h
+ *
+ * Copyright 2009-2024
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#pragma once
+
+#include "ct_types.h"
+#include "ct_filesystem.h"
+#include <libxml++/libxml++.h>
+#include <unordered_set>
+#include <vector>
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+// Digest of the payload of a node in a SQLite document: the txt and the rows of the widgets tables
+// (codebox, grid, image), read back from the database the same way after writing and when verifying
+class CtSqliteNodeDigest
+{
+public:
+    CtSqliteNodeDigest(sqlite3* pDb);
+    ~CtSqliteNodeDigest();
+
+    bool get(const gint64 node_id, std::string& digest, Glib::ustring& error);
+
+private:
+    std::vector<sqlite3_stmt*> _stmts;
+    Glib::ustring              _error;
+};
+
+// Post-save verification of a single file document: the structure is validated
+// with a streaming pass and the digests of the nodes payload taken at save time
+// are compared with the ones read back (all, a sample or none according to the mode)
+class CtStorageVerify
+{
+public:
+    static const size_t SAMPLED_NUM;
+
+    static void add_xml_nodes_digests(const xmlpp::Element* pElement, CtNodesDigests& nodes_digests);
+
+    static bool verify(const fs::path& file_path,
+                       const CtNodesDigests& nodes_digests,
+                       const CtSaveVerify save_verify,
+                       Glib::ustring& error);
+
+private:
+    static std::unordered_set<gint64> _get_nodes_to_check(const CtNodesDigests& nodes_digests, const CtSaveVerify save_verify);
+    static bool _verify_sqlite(const fs::path& file_path,
+                               const CtNodesDigests& nodes_digests,
+                               const std::unordered_set<gint64>& nodes_to_check,
+                               Glib::ustring& error);
+    static bool _verify_xml(const fs::path& file_path,
+                            const CtNodesDigests& nodes_digests,
+                            const std::unordered_set<gint64>& nodes_to_check,
+                            Glib::ustring& error);
+    static bool _is_white_space(const Glib::ustring& text);
+};
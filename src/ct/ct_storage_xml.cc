@@ -32,10 +32,13 @@
 #include "ct_main_win.h"
 #include "ct_storage_control.h"
 #include "ct_storage_multifile.h"
+#include "ct_storage_verify.h"
 #include "ct_logging.h"
+#include "ct_trace.h"
 
 bool CtStorageXml::populate_treestore(const fs::path& file_path, Glib::ustring& error)
 {
+    CtTraceSpan traceSpan{"populate_treestore"};
     try {
         // open file
         std::unique_ptr<xmlpp::DomParser> parser = CtStorageXml::get_parser(file_path);
@@ -113,6 +116,7 @@ bool CtStorageXml::save_treestore(const fs::path& file_path,
                                   const int start_offset/*= 0*/,
                                   const int end_offset/*=-1*/)
 {
+    CtTraceSpan traceSpan{"save_treestore"};
     try {
         xmlpp::Document xml_doc;
         xml_doc.create_root_node(CtConst::APP_NAME);
@@ -157,6 +161,12 @@ bool CtStorageXml::save_treestore(const fs::path& file_path,
                           end_offset);
         }
 
+        _nodesDigests.clear();
+        if (CtExporting::NONESAVE == export_type) {
+            // for the verification after save
+            CtStorageVerify::add_xml_nodes_digests(xml_doc.get_root_node(), _nodesDigests);
+        }
+
         // write file
         xml_doc.write_to_file_formatted(file_path.string());
 
@@ -168,14 +178,16 @@ bool CtStorageXml::save_treestore(const fs::path& file_path,
     }
 }
 
-void CtStorageXml::import_nodes(const fs::path& filepath, const Gtk::TreeIter& parent_iter)
+void CtStorageXml::import_nodes(const fs::path& filepath,
+                                const Gtk::TreeIter& parent_iter,
+                                std::multimap<gint64, gint64>& imported_ids_remap)
 {
     std::unique_ptr<xmlpp::DomParser> parser = CtStorageXml::get_parser(filepath);
 
     CtTreeStore& ct_tree_store = _pCtMainWin->get_tree_store();
+    gint64 next_node_id = ct_tree_store.node_id_get();
 
     std::list<CtTreeIter> nodes_shared_non_master;
-    std::map<gint64,gint64> imported_ids_remap;
     std::function<void(xmlpp::Element*, const gint64 sequence, Gtk::TreeIter)> f_nodes_from_xml;
     f_nodes_from_xml = [&](xmlpp::Element* xml_element, const gint64 sequence, Gtk::TreeIter parent_iter) {
         bool is_shared_non_master{false};
@@ -183,7 +195,7 @@ void CtStorageXml::import_nodes(const fs::path& filepath, const Gtk::TreeIter& p
             xml_element,
             sequence,
             parent_iter,
-            ct_tree_store.node_id_get(),
+            next_node_id++,
             nullptr/*pHasDuplicatedId*/,
             &is_shared_non_master,
             &imported_ids_remap,
@@ -239,6 +251,48 @@ Glib::RefPtr<Gsv::Buffer> CtStorageXml::get_delayed_text_buffer(const gint64 nod
     return ret_buffer;
 }
 
+bool CtStorageXml::get_delayed_node_xml(const gint64 node_id,
+                                        const std::string&/*syntax*/,
+                                        xmlpp::Element* p_node_node) const
+{
+    const auto it = _delayed_text_buffers.find(node_id);
+    if (_delayed_text_buffers.end() == it) {
+        return false; // the text buffer was already created
+    }
+    auto xml_element = dynamic_cast<xmlpp::Element*>(it->second->get_root_node()->get_first_child());
+    if (not xml_element) {
+        return false;
+    }
+    for (xmlpp::Node* xml_slot : xml_element->get_children()) {
+        if (dynamic_cast<xmlpp::Element*>(xml_slot) and xml_slot->get_name() != "node") {
+            p_node_node->import_node(xml_slot);
+        }
+    }
+    return true;
+}
+
+bool CtStorageXml::release_text_buffer(const CtTreeIter& ct_tree_iter)
+{
+    // back to the node content kept as xml, as after populate_treestore
+    auto node_buffer = std::make_shared<xmlpp::Document>();
+    xmlpp::Element* p_node_node = node_buffer->create_root_node("root")->add_child("node");
+    try {
+        CtStorageXmlHelper{_pCtMainWin}.node_content_to_xml(&ct_tree_iter, p_node_node, std::string{}/*multifile_dir*/, nullptr/*storage_cache*/);
+    }
+    catch (std::exception& e) {
+        spdlog::error("!! {} {}", __FUNCTION__, e.what());
+        return false;
+    }
+    _delayed_text_buffers[ct_tree_iter.get_node_id()] = node_buffer;
+    return true;
+}
+
+bool CtStorageXml::adopt_saved_node(const gint64 node_id)
+{
+    // the content was kept by the save
+    return _delayed_text_buffers.count(node_id) != 0;
+}
+
 void CtStorageXml::_nodes_to_xml(CtTreeIter* ct_tree_iter,
                                  xmlpp::Element* p_node_parent,
                                  CtStorageCache* storage_cache,
@@ -247,10 +301,6 @@ void CtStorageXml::_nodes_to_xml(CtTreeIter* ct_tree_iter,
                                  const int start_offset/*= 0*/,
                                  const int end_offset/*= -1*/)
 {
-    Glib::RefPtr<Gsv::Buffer> rTextBuffer = ct_tree_iter->get_node_text_buffer();
-    if (not rTextBuffer) {
-        throw std::runtime_error(str::format(_("Failed to retrieve the content of the node '%s'"), ct_tree_iter->get_node_name()));
-    }
     xmlpp::Element* p_node_node =  CtStorageXmlHelper{_pCtMainWin}.node_to_xml(
         ct_tree_iter,
         p_node_parent,
@@ -259,8 +309,20 @@ void CtStorageXml::_nodes_to_xml(CtTreeIter* ct_tree_iter,
         export_type,
         pExpoMasterReassign,
         start_offset,
-        end_offset
+        end_offset,
+        true/*from_storage*/
     );
+    if (CtExporting::NONESAVE == export_type and
+        not ct_tree_iter->get_node_buffer_already_loaded() and
+        ct_tree_iter->get_node_shared_master_id() <= 0 and
+        0 == _delayed_text_buffers.count(ct_tree_iter->get_node_id()))
+    {
+        // the content came from elsewhere (e.g. imported document), it is kept to be loaded from this storage
+        // (the sub nodes are not added yet)
+        auto node_buffer = std::make_shared<xmlpp::Document>();
+        node_buffer->create_root_node("root")->import_node(p_node_node);
+        _delayed_text_buffers[ct_tree_iter->get_node_id()] = node_buffer;
+    }
     if ( CtExporting::CURRENT_NODE != export_type and
          CtExporting::SELECTED_TEXT != export_type )
     {
@@ -314,8 +376,10 @@ xmlpp::Element* CtStorageXmlHelper::node_to_xml(const CtTreeIter* ct_tree_iter,
                                                 const CtExporting export_type,
                                                 const std::map<gint64, gint64>* pExpoMasterReassign/*= nullptr*/,
                                                 const int start_offset/*= 0*/,
-                                                const int end_offset/*= -1*/)
+                                                const int end_offset/*= -1*/,
+                                                const bool from_storage/*= false*/)
 {
+    CtTrace::counter_add(CtTraceCounter::NodesSerialized, 1);
     xmlpp::Element* p_node_node = p_node_parent->add_child("node");
     const gint64 my_node_id = ct_tree_iter->get_node_id();
     p_node_node->set_attribute("unique_id", std::to_string(my_node_id));
@@ -352,27 +416,71 @@ xmlpp::Element* CtStorageXmlHelper::node_to_xml(const CtTreeIter* ct_tree_iter,
         p_node_node->set_attribute("ts_creation", std::to_string(ct_tree_iter->get_node_creating_time()));
         p_node_node->set_attribute("ts_lastsave", std::to_string(ct_tree_iter->get_node_modification_time()));
 
-        Glib::RefPtr<Gsv::Buffer> buffer = ct_tree_iter->get_node_text_buffer();
-        save_buffer_no_widgets_to_xml(p_node_node, buffer, start_offset, end_offset, 'n');
-
-        for (CtAnchoredWidget* pAnchoredWidget : ct_tree_iter->get_anchored_widgets(start_offset, end_offset)) {
-            pAnchoredWidget->to_xml(p_node_node, start_offset > 0 ? -start_offset : 0, storage_cache, multifile_dir);
+        if (from_storage and
+            CtExporting::SELECTED_TEXT != export_type and
+            _pCtMainWin->get_ct_storage()->get_stored_node_xml(*ct_tree_iter, p_node_node))
+        {
+            // content not loaded/modified, transcoded without creating the text buffer
+            if (not multifile_dir.empty()) {
+                _stored_blobs_to_multifile(p_node_node, multifile_dir);
+            }
+            return p_node_node;
         }
+        node_content_to_xml(ct_tree_iter, p_node_node, multifile_dir, storage_cache, start_offset, end_offset);
     }
     return p_node_node;
 }
 
+void CtStorageXmlHelper::node_content_to_xml(const CtTreeIter* ct_tree_iter,
+                                             xmlpp::Element* p_node_node,
+                                             const std::string& multifile_dir,
+                                             CtStorageCache* storage_cache,
+                                             const int start_offset/*= 0*/,
+                                             const int end_offset/*= -1*/)
+{
+    Glib::RefPtr<Gsv::Buffer> buffer = ct_tree_iter->get_node_text_buffer();
+    if (not buffer) {
+        throw std::runtime_error(str::format(_("Failed to retrieve the content of the node '%s'"), ct_tree_iter->get_node_name()));
+    }
+    save_buffer_no_widgets_to_xml(p_node_node, buffer, start_offset, end_offset, 'n');
+
+    for (CtAnchoredWidget* pAnchoredWidget : ct_tree_iter->get_anchored_widgets(start_offset, end_offset)) {
+        pAnchoredWidget->to_xml(p_node_node, start_offset > 0 ? -start_offset : 0, storage_cache, multifile_dir);
+    }
+}
+
+void CtStorageXmlHelper::_stored_blobs_to_multifile(xmlpp::Element* p_node_node, const std::string& multifile_dir)
+{
+    for (xmlpp::Node* xml_slot : p_node_node->get_children("encoded_png")) {
+        auto p_image_node = static_cast<xmlpp::Element*>(xml_slot);
+        const Glib::ustring fileName = p_image_node->get_attribute_value("filename");
+        if (not p_image_node->get_attribute_value("anchor").empty() or
+            fileName == CtImageLatex::LatexSpecialFilename)
+        {
+            continue; // no binary
+        }
+        xmlpp::TextNode* pTextNode = p_image_node->get_child_text();
+        const std::string rawBlob = Glib::Base64::decode(pTextNode ? pTextNode->get_content() : "");
+        const std::string file_ext = fileName.empty() ? std::string{".png"} : fs::path{fileName.raw()}.extension().string();
+        p_image_node->set_attribute("sha256sum", CtStorageMultiFile::save_blob(rawBlob, multifile_dir, file_ext));
+        if (pTextNode) {
+            p_image_node->remove_child(pTextNode);
+        }
+    }
+}
+
 Gtk::TreeIter CtStorageXmlHelper::node_from_xml(const xmlpp::Element* xml_element,
                                                 const gint64 sequence,
                                                 const Gtk::TreeIter parent_iter,
                                                 const gint64 new_id,
                                                 bool* pHasDuplicatedId,
                                                 bool* pIsSharedNonMaster,
-                                                std::map<gint64,gint64>* pImportedIdsRemap,
+                                                std::multimap<gint64,gint64>* pImportedIdsRemap,
                                                 CtDelayedTextBufferMap& delayed_text_buffers,
                                                 const bool isDryRun,
                                                 const std::string& multifile_dir)
 {
+    CtTrace::counter_add(CtTraceCounter::NodesLoaded, 1);
     CtNodeData node_data{};
     const gint64 readNodeId = CtStrUtil::gint64_from_gstring(xml_element->get_attribute_value("unique_id").c_str());
     if (-1 == new_id) {
@@ -382,7 +490,7 @@ Gtk::TreeIter CtStorageXmlHelper::node_from_xml(const xmlpp::Element* xml_elemen
     else {
         // use the passed new_id
         node_data.nodeId = new_id;
-        if (pImportedIdsRemap) (*pImportedIdsRemap)[readNodeId] = new_id;
+        if (pImportedIdsRemap) pImportedIdsRemap->emplace(readNodeId, new_id); // not to lose a duplicated id
     }
     node_data.sharedNodesMasterId = CtStrUtil::gint64_from_gstring(xml_element->get_attribute_value("master_id").c_str());
     node_data.sequence = sequence;
@@ -424,11 +532,19 @@ Gtk::TreeIter CtStorageXmlHelper::node_from_xml(const xmlpp::Element* xml_elemen
             delayed_text_buffers[node_data.nodeId] = node_buffer;
         }
     }
-    else {
+    else if (delayed_text_buffers.count(readNodeId) != 0) {
         // (use the passed new_id)
-        // create buffer now because imported document will be closed
+        // duplicated id in the imported document, create buffer now
         node_data.rTextBuffer = create_buffer_and_widgets_from_xml(xml_element, node_data.syntax, node_data.anchoredWidgets, nullptr, -1, multifile_dir);
     }
+    else {
+        // (use the passed new_id)
+        // the imported document is kept open and the buffer created from it when needed,
+        // the node data is saved under the id in the imported document
+        auto node_buffer = std::make_shared<xmlpp::Document>();
+        node_buffer->create_root_node("root")->import_node(xml_element);
+        delayed_text_buffers[readNodeId] = node_buffer;
+    }
     return _pCtMainWin->get_tree_store().append_node(&node_data, &parent_iter);
 }
 
@@ -619,15 +735,27 @@ CtAnchoredWidget* CtStorageXmlHelper::_create_image_from_xml(xmlpp::Element* xml
         return new CtImageLatex{_pCtMainWin, encodedBlob, charOffset, justification, CtImageEmbFile::get_next_unique_id()};
     }
     std::string rawBlob;
+    std::shared_ptr<const CtEmbFileBlob> pEmbFileBlob;
     if (multifile_dir.empty()) {
         rawBlob = Glib::Base64::decode(encodedBlob);
     }
     else {
         const std::string sha256sum = xml_element->get_attribute_value("sha256sum");
-        if (not CtStorageMultiFile::read_blob(multifile_dir, sha256sum, rawBlob)) {
+        std::string blobFilepath;
+        if (not CtStorageMultiFile::get_blob_filepath(multifile_dir, sha256sum, blobFilepath)) {
             spdlog::warn("!! unexp not found {} in {}", sha256sum, multifile_dir);
             return nullptr;
         }
+        if (not file_name.empty()) {
+            // the embedded file is linked from the node directory rather than read
+            pEmbFileBlob = CtEmbFileBlob::create_from_file(blobFilepath, sha256sum);
+            if (not pEmbFileBlob) {
+                return nullptr;
+            }
+        }
+        else if (not CtStorageMultiFile::read_blob(multifile_dir, sha256sum, rawBlob)) {
+            return nullptr;
+        }
     }
     if (not file_name.empty()) {
         std::string timeStr = xml_element->get_attribute_value("time");
@@ -635,7 +763,10 @@ CtAnchoredWidget* CtStorageXmlHelper::_create_image_from_xml(xmlpp::Element* xml
             timeStr = "0";
         }
         const time_t timeInt = std::stoll(timeStr);
-        return new CtImageEmbFile{_pCtMainWin, file_name, rawBlob, timeInt, charOffset, justification, CtImageEmbFile::get_next_unique_id()};
+        if (not pEmbFileBlob) {
+            pEmbFileBlob = CtEmbFileBlob::create(rawBlob);
+        }
+        return new CtImageEmbFile{_pCtMainWin, file_name, pEmbFileBlob, timeInt, charOffset, justification, CtImageEmbFile::get_next_unique_id()};
     }
     const Glib::ustring link = xml_element->get_attribute_value("link");
     return new CtImagePng{_pCtMainWin, rawBlob, link, charOffset, justification};
@@ -50,10 +50,12 @@ public:
     {}
 
     void close_connect() override {}
-    void reopen_connect() override {}
+    void reopen_connect(const bool/*file_replaced*/) override {}
     void test_connection() override {}
     void try_reopen() override {}
-    void vacuum() override {}
+    bool vacuum(const std::function<bool()>& /*f_stop*/) override { return true; }
+    CtStorageFreeStats get_free_stats() override { return CtStorageFreeStats{}; }
+    bool compact_step(const int /*maxPages*/) override { return false; }
 
     static std::unique_ptr<xmlpp::DomParser> get_parser(const fs::path& file_path);
 
@@ -65,11 +67,18 @@ public:
                         const std::map<gint64, gint64>* pExpoMasterReassign = nullptr,
                         const int start_offset = 0,
                         const int end_offset = -1) override;
-    void import_nodes(const fs::path& path, const Gtk::TreeIter& parent_iter) override;
+    void import_nodes(const fs::path& path,
+                      const Gtk::TreeIter& parent_iter,
+                      std::multimap<gint64, gint64>& imported_ids_remap) override;
 
     Glib::RefPtr<Gsv::Buffer> get_delayed_text_buffer(const gint64 node_id,
                                                       const std::string& syntax,
                                                       std::list<CtAnchoredWidget*>& widgets) const override;
+    bool get_delayed_node_xml(const gint64 node_id,
+                              const std::string& syntax,
+                              xmlpp::Element* p_node_node) const override;
+    bool release_text_buffer(const CtTreeIter& ct_tree_iter) override;
+    bool adopt_saved_node(const gint64 node_id) override;
 private:
     void _nodes_to_xml(CtTreeIter* ct_tree_iter,
                        xmlpp::Element* p_node_parent,
@@ -98,14 +107,22 @@ public:
                                 const CtExporting export_type,
                                 const std::map<gint64, gint64>* pExpoMasterReassign = nullptr,
                                 const int start_offset = 0,
-                                const int end_offset = -1);
+                                const int end_offset = -1,
+                                const bool from_storage = false);
+    // the content slots of the node, from the text buffer and the widgets
+    void node_content_to_xml(const CtTreeIter* ct_tree_iter,
+                             xmlpp::Element* p_node_node,
+                             const std::string& multifile_dir,
+                             CtStorageCache* storage_cache,
+                             const int start_offset = 0,
+                             const int end_offset = -1);
     Gtk::TreeIter node_from_xml(const xmlpp::Element* xml_element,
                                 const gint64 sequence,
                                 const Gtk::TreeIter parent_iter,
                                 const gint64 new_id,
                                 bool* pHasDuplicatedId,
                                 bool* pIsSharedNonMaster,
-                                std::map<gint64,gint64>* pImportedIdsRemap,
+                                std::multimap<gint64,gint64>* pImportedIdsRemap,
                                 CtDelayedTextBufferMap& delayed_text_buffers,
                                 const bool isDryRun,
                                 const std::string& multifile_dir);
@@ -145,6 +162,7 @@ private:
     CtAnchoredWidget* _create_image_from_xml(xmlpp::Element* xml_element, int charOffset, const Glib::ustring& justification, const std::string& multifile_dir);
     CtAnchoredWidget* _create_codebox_from_xml(xmlpp::Element* xml_element, int charOffset, const Glib::ustring& justification);
     CtAnchoredWidget* _create_table_from_xml(xmlpp::Element* xml_element, int charOffset, const Glib::ustring& justification);
+    void              _stored_blobs_to_multifile(xmlpp::Element* p_node_node, const std::string& multifile_dir);
 
 private:
     CtMainWin* const _pCtMainWin;
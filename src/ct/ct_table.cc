@@ -54,6 +54,24 @@ std::shared_ptr<CtAnchoredWidgetState_TableCommon> CtTableCommon::get_state_comm
     return std::shared_ptr<CtAnchoredWidgetState_TableCommon>(new CtAnchoredWidgetState_TableCommon(this));
 }
 
+bool CtTableCommon::_state_shared_minor_fields_equal(const CtAnchoredWidgetState& state) const
+{
+    const auto& tableState = static_cast<const CtAnchoredWidgetState_TableCommon&>(state);
+    return tableState.colWidthDefault == _colWidthDefault and
+           tableState.colWidths == _colWidths and
+           tableState.currRow == current_row() and
+           tableState.currCol == current_column();
+}
+
+void CtTableCommon::_state_shared_minor_fields_set(CtAnchoredWidgetState& state) const
+{
+    auto& tableState = static_cast<CtAnchoredWidgetState_TableCommon&>(state);
+    tableState.colWidthDefault = _colWidthDefault;
+    tableState.colWidths = _colWidths;
+    tableState.currRow = current_row();
+    tableState.currCol = current_column();
+}
+
 void CtTableCommon::row_move_down(const size_t rowIdx)
 {
     if (rowIdx == get_num_rows()-1) {
@@ -263,6 +281,25 @@ bool CtTableCommon::to_sqlite(sqlite3* pDb, const gint64 node_id, const int offs
     return retVal;
 }
 
+size_t CtTableCommon::get_content_signature()
+{
+    // the cells and the fields written by to_sqlite, without building the xml
+    size_t signature = static_cast<size_t>(get_type());
+    _signature_combine(signature, static_cast<size_t>(_colWidthDefault));
+    for (const int colWidth : _colWidths) {
+        _signature_combine(signature, static_cast<size_t>(colWidth));
+    }
+    std::vector<std::vector<Glib::ustring>> rows;
+    write_strings_matrix(rows);
+    for (const std::vector<Glib::ustring>& row : rows) {
+        _signature_combine(signature, row.size());
+        for (const Glib::ustring& cell : row) {
+            _signature_combine(signature, std::hash<std::string>{}(cell.raw()));
+        }
+    }
+    return signature;
+}
+
 std::pair<size_t, size_t> CtTableCommon::get_row_idx_col_idx(const size_t cell_idx) const
 {
     const size_t num_columns = get_num_columns();
@@ -346,6 +383,9 @@ void CtTableHeavy::_new_text_cell_attach(const size_t rowIdx, const size_t colId
     }
     textView.signal_populate_popup().connect(sigc::mem_fun(*this, &CtTableCommon::on_cell_populate_popup));
     textView.signal_key_press_event().connect(sigc::mem_fun(*this, &CtTableCommon::on_cell_key_press_event), false);
+    pTextCell->get_buffer()->signal_changed().connect([this](){
+        _content_changed();
+    });
 
     _grid.attach(pTextCell->get_text_view(), colIdx, rowIdx, 1/*# cell horiz*/, 1/*# cell vert*/);
 
@@ -427,6 +467,7 @@ void CtTableHeavy::column_add(const size_t afterColIdx)
         _tableMatrix.at(rowIdx).insert(_tableMatrix.at(rowIdx).begin()+newColIdx, pTextCell);
         _new_text_cell_attach(rowIdx, newColIdx, pTextCell);
     }
+    _content_changed();
 }
 
 void CtTableHeavy::column_delete(const size_t colIdx)
@@ -440,6 +481,7 @@ void CtTableHeavy::column_delete(const size_t colIdx)
         delete static_cast<CtTextCell*>(tableRow.at(colIdx));
         tableRow.erase(tableRow.begin()+colIdx);
     }
+    _content_changed();
     if (_currentColumn == get_num_columns()) {
         --_currentColumn;
     }
@@ -460,6 +502,7 @@ void CtTableHeavy::column_move_left(const size_t colIdx, const bool/*from_move_r
         CtTextView& textView = static_cast<CtTextCell*>(_tableMatrix.at(rowIdx).at(colIdx))->get_text_view();
         _grid.attach(textView, colIdx, rowIdx, 1/*# cell horiz*/, 1/*# cell vert*/);
     }
+    _content_changed();
     _currentColumn = colIdxLeft;
 }
 
@@ -486,6 +529,7 @@ void CtTableHeavy::row_add(const size_t afterRowIdx, const std::vector<Glib::ust
         _tableMatrix.at(newRowIdx).push_back(pTextCell);
         _new_text_cell_attach(newRowIdx, colIdx, pTextCell);
     }
+    _content_changed();
 }
 
 void CtTableHeavy::row_delete(const size_t rowIdx)
@@ -498,6 +542,7 @@ void CtTableHeavy::row_delete(const size_t rowIdx)
         delete static_cast<CtTextCell*>(pTextCell);
     }
     _tableMatrix.erase(_tableMatrix.begin()+rowIdx);
+    _content_changed();
     if (_currentRow == get_num_rows()) {
         --_currentRow;
     }
@@ -532,6 +577,7 @@ void CtTableHeavy::row_move_up(const size_t rowIdx, const bool/*from_move_down*/
     _grid.remove_row(rowIdxUp);
     _grid.insert_row(rowIdx);
     std::swap(_tableMatrix[rowIdxUp], _tableMatrix[rowIdx]);
+    _content_changed();
     for (size_t colIdx = 0; colIdx < get_num_columns(); ++colIdx) {
         CtTextView& textView = static_cast<CtTextCell*>(_tableMatrix.at(rowIdx).at(colIdx))->get_text_view();
         _grid.attach(textView, colIdx, rowIdx, 1/*# cell horiz*/, 1/*# cell vert*/);
@@ -560,10 +606,11 @@ bool CtTableHeavy::_row_sort(const bool sortAsc)
     };
     auto pPrevState = std::static_pointer_cast<CtAnchoredWidgetState_TableHeavy>(get_state());
     std::sort(_tableMatrix.begin()+1, _tableMatrix.end(), f_need_swap);
+    _content_changed();
     auto pCurrState = std::static_pointer_cast<CtAnchoredWidgetState_TableHeavy>(get_state());
     std::list<size_t> changed;
     for (size_t rowIdx = 1; rowIdx < get_num_rows(); ++rowIdx) {
-        if (pPrevState->rows.at(rowIdx) != pCurrState->rows.at(rowIdx)) {
+        if (pPrevState->pRows->at(rowIdx) != pCurrState->pRows->at(rowIdx)) {
             changed.push_back(rowIdx);
             _grid.remove_row(rowIdx);
             _grid.insert_row(rowIdx);
@@ -59,6 +59,7 @@ public:
     }
     void to_xml(xmlpp::Element* p_node_parent, const int offset_adjustment, CtStorageCache* cache, const std::string& multifile_dir) override;
     bool to_sqlite(sqlite3* pDb, const gint64 node_id, const int offset_adjustment, CtStorageCache* cache) override;
+    size_t get_content_signature() override;
 
     // Build a table from csv; The input csv should be compatable with the excel csv format
     static void populate_table_matrix_from_csv(const std::string& filepath,
@@ -103,6 +104,11 @@ public:
     bool on_cell_key_press_event(GdkEventKey* event);
 
 protected:
+    // the content generation follows the cells and the rows/columns, the widths and the cursor are compared at each state
+    bool _has_content_generation() const override { return true; }
+    bool _state_shared_minor_fields_equal(const CtAnchoredWidgetState& state) const override;
+    void _state_shared_minor_fields_set(CtAnchoredWidgetState& state) const override;
+
     virtual void _populate_xml_rows_cells(xmlpp::Element* p_table_node) const = 0;
     virtual bool _row_sort(const bool sortAsc) = 0;
     virtual bool _on_cell_key_press_alt_or_ctrl_enter() { return false; /* propagate signal */ }
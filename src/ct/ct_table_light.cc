@@ -81,6 +81,19 @@ void CtTableLight::_reset(CtTableMatrix& tableMatrix)
         }
     }
     CtTableLight::_free_matrix(tableMatrix);
+    _content_changed();
+    _pListStore->signal_row_changed().connect([this](const Gtk::TreeModel::Path&, const Gtk::TreeModel::iterator&){
+        _content_changed();
+    });
+    _pListStore->signal_row_inserted().connect([this](const Gtk::TreeModel::Path&, const Gtk::TreeModel::iterator&){
+        _content_changed();
+    });
+    _pListStore->signal_row_deleted().connect([this](const Gtk::TreeModel::Path&){
+        _content_changed();
+    });
+    _pListStore->signal_rows_reordered().connect([this](const Gtk::TreeModel::Path&, const Gtk::TreeModel::iterator&, int*){
+        _content_changed();
+    });
 
     if (_pManagedTreeView) {
         _frame.remove();
@@ -0,0 +1,220 @@
+/*
+ * ct_text_stats.cc
+ *
+ * Copyright 2009-2024
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_text_stats.h"
+#include "ct_logging.h"
+#include <glibmm/main.h>
+#include <pango/pango.h>
+
+static const gchar* CT_TEXT_STATS_KEY{"ct-text-stats"};
+
+/*static*/CtTextStats* CtTextStats::get_for_buffer(const Glib::RefPtr<Gtk::TextBuffer>& rTextBuffer)
+{
+    if (not rTextBuffer) {
+        return nullptr;
+    }
+    CtTextStats* pTextStats = get_for_buffer_if_attached(rTextBuffer);
+    if (not pTextStats) {
+        pTextStats = new CtTextStats{rTextBuffer.get()};
+        g_object_set_data_full(G_OBJECT(rTextBuffer->gobj()), CT_TEXT_STATS_KEY, pTextStats, [](gpointer data){
+            delete static_cast<CtTextStats*>(data);
+        });
+    }
+    return pTextStats;
+}
+
+/*static*/CtTextStats* CtTextStats::get_for_buffer_if_attached(const Glib::RefPtr<Gtk::TextBuffer>& rTextBuffer)
+{
+    if (not rTextBuffer) {
+        return nullptr;
+    }
+    return static_cast<CtTextStats*>(g_object_get_data(G_OBJECT(rTextBuffer->gobj()), CT_TEXT_STATS_KEY));
+}
+
+/*static*/CtParagraphStats CtTextStats::count_paragraph(const Glib::ustring& text)
+{
+    CtParagraphStats paragraphStats;
+    paragraphStats.chars = static_cast<int>(text.size());
+    if (paragraphStats.chars > 0) {
+        PangoLogAttr* attrs = g_new0(PangoLogAttr, paragraphStats.chars + 1);
+        pango_get_log_attrs(text.c_str(), -1, 0,
+                            pango_language_from_string("C"),
+                            attrs,
+                            paragraphStats.chars + 1);
+        for (int i = 0; i < paragraphStats.chars; ++i) {
+            if (attrs[i].is_word_start) {
+                ++paragraphStats.words;
+            }
+        }
+        g_free(attrs);
+    }
+    return paragraphStats;
+}
+
+/*static*/CtTextTotals CtTextStats::count_text(const Glib::ustring& text)
+{
+    // the paragraphs are delimited as by the text buffer lines
+    CtTextTotals textTotals;
+    const gchar* pParagraph = text.c_str();
+    gint remainingBytes = static_cast<gint>(text.bytes());
+    for (;;) {
+        gint delimiterIndex{0};
+        gint nextParagraphStart{0};
+        pango_find_paragraph_boundary(pParagraph, remainingBytes, &delimiterIndex, &nextParagraphStart);
+        const CtParagraphStats paragraphStats = count_paragraph(Glib::ustring{pParagraph, pParagraph + delimiterIndex});
+        textTotals.words += paragraphStats.words;
+        textTotals.chars += paragraphStats.chars;
+        ++textTotals.lines;
+        if (nextParagraphStart == delimiterIndex) {
+            break; // no delimiter, last paragraph
+        }
+        pParagraph += nextParagraphStart;
+        remainingBytes -= nextParagraphStart;
+    }
+    textTotals.chars += textTotals.lines - 1;
+    return textTotals;
+}
+
+CtTextStats::CtTextStats(Gtk::TextBuffer* pTextBuffer)
+ : _pTextBuffer{pTextBuffer}
+{
+    // connected after the default handler, when the buffer content is already updated
+    _pTextBuffer->signal_insert().connect(sigc::mem_fun(*this, &CtTextStats::_on_insert_after), true/*after*/);
+    _pTextBuffer->signal_erase().connect(sigc::mem_fun(*this, &CtTextStats::_on_erase_before), false/*after*/);
+    _pTextBuffer->signal_erase().connect(sigc::mem_fun(*this, &CtTextStats::_on_erase_after), true/*after*/);
+    // the widgets are inserted without signal_insert
+    _pTextBuffer->signal_insert_child_anchor().connect(sigc::mem_fun(*this, &CtTextStats::_on_insert_anchor_after), true/*after*/);
+    _pTextBuffer->signal_insert_pixbuf().connect(sigc::mem_fun(*this, &CtTextStats::_on_insert_pixbuf_after), true/*after*/);
+}
+
+CtTextStats::~CtTextStats()
+{
+    _idleRecountConnection.disconnect();
+}
+
+void CtTextStats::_on_insert_after(const Gtk::TextIter& pos, const Glib::ustring& text, int /*bytes*/)
+{
+    // pos was revalidated by the default handler to point to the end of the inserted text
+    const int lastLine = pos.get_line();
+    const int firstLine = _pTextBuffer->get_iter_at_offset(pos.get_offset() - static_cast<int>(text.size())).get_line();
+    _recount_lines(firstLine, 1, lastLine - firstLine + 1);
+}
+
+void CtTextStats::_on_insert_anchor_after(const Gtk::TextIter& pos, const Glib::RefPtr<Gtk::TextChildAnchor>& /*anchor*/)
+{
+    _recount_lines(pos.get_line(), 1, 1);
+}
+
+void CtTextStats::_on_insert_pixbuf_after(const Gtk::TextIter& pos, const Glib::RefPtr<Gdk::Pixbuf>& /*pixbuf*/)
+{
+    _recount_lines(pos.get_line(), 1, 1);
+}
+
+void CtTextStats::_on_erase_before(const Gtk::TextIter& range_start, const Gtk::TextIter& range_end)
+{
+    _eraseNumLines = range_end.get_line() - range_start.get_line() + 1;
+}
+
+void CtTextStats::_on_erase_after(const Gtk::TextIter& range_start, const Gtk::TextIter& /*range_end*/)
+{
+    // range_start and range_end are now both at the erase point
+    _recount_lines(range_start.get_line(), _eraseNumLines, 1);
+}
+
+CtParagraphStats CtTextStats::_count_line(const int line)
+{
+    Gtk::TextIter iterStart = _pTextBuffer->get_iter_at_line(line);
+    Gtk::TextIter iterEnd = iterStart;
+    if (not iterEnd.ends_line()) {
+        iterEnd.forward_to_line_end();
+    }
+    return count_paragraph(iterStart.get_slice(iterEnd)); // with the 0xFFFC of the widgets anchors
+}
+
+void CtTextStats::_recount_lines(const int firstLine, const int numLinesBefore, const int numLinesAfter)
+{
+    if (_dirty) {
+        return; // a full recount is already due
+    }
+    if (firstLine < 0 or numLinesBefore < 1 or numLinesAfter < 1 or
+        static_cast<size_t>(firstLine + numLinesBefore) > _paragraphs.size())
+    {
+        _schedule_recount_all();
+        return;
+    }
+    for (int i = 0; i < numLinesBefore; ++i) {
+        _totWords -= _paragraphs[firstLine + i].words;
+        _totChars -= _paragraphs[firstLine + i].chars;
+    }
+    if (numLinesAfter > numLinesBefore) {
+        _paragraphs.insert(_paragraphs.begin() + firstLine, numLinesAfter - numLinesBefore, CtParagraphStats{});
+    }
+    else if (numLinesAfter < numLinesBefore) {
+        _paragraphs.erase(_paragraphs.begin() + firstLine, _paragraphs.begin() + firstLine + (numLinesBefore - numLinesAfter));
+    }
+    for (int i = 0; i < numLinesAfter; ++i) {
+        CtParagraphStats& paragraphStats = _paragraphs[firstLine + i];
+        paragraphStats = _count_line(firstLine + i);
+        _totWords += paragraphStats.words;
+        _totChars += paragraphStats.chars;
+    }
+    if (_paragraphs.size() != static_cast<size_t>(_pTextBuffer->get_line_count())) {
+        // e.g. a '\r' inserted right before a '\n' does not add a line
+        _schedule_recount_all();
+    }
+}
+
+void CtTextStats::_recount_all()
+{
+    _idleRecountConnection.disconnect();
+    const int numLines = _pTextBuffer->get_line_count();
+    _paragraphs.resize(numLines);
+    _totWords = 0;
+    _totChars = 0;
+    for (int line = 0; line < numLines; ++line) {
+        _paragraphs[line] = _count_line(line);
+        _totWords += _paragraphs[line].words;
+        _totChars += _paragraphs[line].chars;
+    }
+    _dirty = false;
+}
+
+void CtTextStats::_schedule_recount_all()
+{
+    _dirty = true;
+    if (not _idleRecountConnection.connected()) {
+        _idleRecountConnection = Glib::signal_idle().connect([this](){
+            if (_dirty) {
+                _recount_all();
+            }
+            return false; /* false for disconnect */
+        });
+    }
+}
+
+void CtTextStats::_ensure_up_to_date()
+{
+    if (_dirty) {
+        _recount_all();
+    }
+}
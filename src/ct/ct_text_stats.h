@@ -0,0 +1,84 @@
+/*
+ * ct_text_stats.h
+ *
+ * Copyright 2009-2024
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#pragma once
+
+#include <gtkmm/textbuffer.h>
+#include <vector>
+
+struct CtParagraphStats
+{
+    int words{0};
+    int chars{0};
+};
+
+struct CtTextTotals
+{
+    int words{0};
+    int chars{0};
+    int lines{0};
+};
+
+// Words/characters/lines of a text buffer, kept per paragraph and updated from the buffer
+// insert/erase signals (widgets included) so that only the touched paragraphs get recounted
+class CtTextStats
+{
+public:
+    // the stats are created on first request and owned by the text buffer
+    static CtTextStats* get_for_buffer(const Glib::RefPtr<Gtk::TextBuffer>& rTextBuffer);
+    static CtTextStats* get_for_buffer_if_attached(const Glib::RefPtr<Gtk::TextBuffer>& rTextBuffer);
+
+    static CtParagraphStats count_paragraph(const Glib::ustring& text);
+    // same totals as a text buffer holding the text, for the content that is not in a buffer
+    static CtTextTotals count_text(const Glib::ustring& text);
+
+    ~CtTextStats();
+
+    int get_words() { _ensure_up_to_date(); return _totWords; }
+    // the widgets anchors count one char each, as in the buffer char count
+    int get_chars() { _ensure_up_to_date(); return _totChars + get_lines() - 1; }
+    int get_lines() { _ensure_up_to_date(); return static_cast<int>(_paragraphs.size()); }
+
+private:
+    CtTextStats(Gtk::TextBuffer* pTextBuffer);
+
+    void _on_insert_after(const Gtk::TextIter& pos, const Glib::ustring& text, int bytes);
+    void _on_insert_anchor_after(const Gtk::TextIter& pos, const Glib::RefPtr<Gtk::TextChildAnchor>& anchor);
+    void _on_insert_pixbuf_after(const Gtk::TextIter& pos, const Glib::RefPtr<Gdk::Pixbuf>& pixbuf);
+    void _on_erase_before(const Gtk::TextIter& range_start, const Gtk::TextIter& range_end);
+    void _on_erase_after(const Gtk::TextIter& range_start, const Gtk::TextIter& range_end);
+
+    CtParagraphStats _count_line(const int line);
+    void _recount_lines(const int firstLine, const int numLinesBefore, const int numLinesAfter);
+    void _recount_all();
+    void _schedule_recount_all();
+    void _ensure_up_to_date();
+
+    Gtk::TextBuffer*              _pTextBuffer;
+    std::vector<CtParagraphStats> _paragraphs;
+    int                           _totWords{0};
+    int                           _totChars{0};
+    int                           _eraseNumLines{0};
+    bool                          _dirty{true};
+    sigc::connection              _idleRecountConnection;
+};
@@ -98,7 +98,7 @@ CtTextView::CtTextView(CtMainWin* pCtMainWin)
 
 void CtTextView::_set_highlight_current_line_enabled(const bool enabled)
 {
-    if (enabled) {
+    if (enabled and not _largeDocMode) {
         const bool isRichTextOrTable{CtConst::RICH_TEXT_ID == _syntaxHighlighting or
                                      CtConst::TABLE_CELL_TEXT_ID == _syntaxHighlighting};
         set_highlight_current_line(isRichTextOrTable ? _pCtConfig->rtHighlCurrLine : _pCtConfig->ptHighlCurrLine);
@@ -127,7 +127,17 @@ void CtTextView::setup_for_syntax(const std::string& syntax)
     if (new_class != "ct-view-code") get_style_context()->remove_class("ct-view-code");
     get_style_context()->add_class(new_class);
 
-    if (isRichTextOrTable) {
+    _apply_draw_spaces();
+}
+
+void CtTextView::_apply_draw_spaces()
+{
+    const bool isRichTextOrTable{CtConst::RICH_TEXT_ID == _syntaxHighlighting or
+                                 CtConst::TABLE_CELL_TEXT_ID == _syntaxHighlighting};
+    if (_largeDocMode) {
+        set_draw_spaces(static_cast<Gsv::DrawSpacesFlags>(0));
+    }
+    else if (isRichTextOrTable) {
         if (_pCtConfig->rtShowWhiteSpaces) {
             set_draw_spaces(Gsv::DRAW_SPACES_ALL & ~Gsv::DRAW_SPACES_NEWLINE);
         }
@@ -713,8 +723,57 @@ void CtTextView::set_spell_check(bool allow_on)
         // g_object_unref (gspell_checker); no need to unref because we keep it global
     }
     auto gspell_view = gspell_text_view_get_from_gtk_text_view(gtk_view);
-    gspell_text_view_set_inline_spell_checking(gspell_view, allow_on && _pCtConfig->enableSpellCheck);
-    gspell_text_view_set_enable_language_menu(gspell_view, allow_on && _pCtConfig->enableSpellCheck);
+    gspell_text_view_set_inline_spell_checking(gspell_view, allow_on && _pCtConfig->enableSpellCheck && !_largeDocMode);
+    gspell_text_view_set_enable_language_menu(gspell_view, allow_on && _pCtConfig->enableSpellCheck && !_largeDocMode);
+}
+
+bool CtTextView::large_doc_mode_needed(const int numChars) const
+{
+    if (CtConst::RICH_TEXT_ID == _syntaxHighlighting or CtConst::TABLE_CELL_TEXT_ID == _syntaxHighlighting) {
+        return false;
+    }
+    return _pCtConfig->ptLargeDocThreshold > 0 and numChars > _pCtConfig->ptLargeDocThreshold*1000;
+}
+
+// Above the thresholds (in thousands of characters) line wrapping, white spaces drawing,
+// current line and brackets highlighting and spell check are off while the syntax highlighting
+// is deferred to when the view is idle or, above the second threshold, off as well
+void CtTextView::large_doc_mode_apply(const int numChars)
+{
+    _largeDocHighlDeferConn.disconnect();
+    const bool wasLargeDocMode = _largeDocMode;
+    _largeDocMode = large_doc_mode_needed(numChars);
+    Glib::RefPtr<Gsv::Buffer> rTextBuffer = get_source_buffer();
+    if (_largeDocMode) {
+        set_wrap_mode(Gtk::WrapMode::WRAP_NONE);
+        set_draw_spaces(static_cast<Gsv::DrawSpacesFlags>(0));
+        set_highlight_current_line(false);
+        set_spell_check(false);
+        if (rTextBuffer) {
+            // flag for the highlighting properties to be reapplied next time the buffer is displayed
+            rTextBuffer->set_data(CtConst::LARGE_DOC_APPLIED_ID, (void*)1);
+            rTextBuffer->set_highlight_matching_brackets(false);
+            if (rTextBuffer->get_highlight_syntax()) {
+                rTextBuffer->set_highlight_syntax(false);
+                const bool noHighl = _pCtConfig->ptLargeDocNoHighlThreshold > 0 and
+                                     numChars > _pCtConfig->ptLargeDocNoHighlThreshold*1000;
+                if (not noHighl) {
+                    // the source view highlighting engine then proceeds in idle chunks
+                    _largeDocHighlDeferConn = Glib::signal_idle().connect([this, rTextBuffer](){
+                        if (_largeDocMode and get_buffer().get() == rTextBuffer.get()) {
+                            rTextBuffer->set_highlight_syntax(true);
+                        }
+                        return false; /* false for disconnect */
+                    }, Glib::PRIORITY_LOW);
+                }
+            }
+        }
+    }
+    else if (wasLargeDocMode) {
+        set_wrap_mode(_pCtConfig->lineWrapping ? Gtk::WrapMode::WRAP_WORD_CHAR : Gtk::WrapMode::WRAP_NONE);
+        _apply_draw_spaces();
+        _set_highlight_current_line_enabled(has_focus());
+    }
 }
 
 void CtTextView::synch_spell_check_change_from_gspell_right_click_menu()
@@ -37,6 +37,7 @@ class CtTextView : public Gsv::View
 {
 public:
     CtTextView(CtMainWin* pCtMainWin);
+    ~CtTextView() override { _largeDocHighlDeferConn.disconnect(); }
 
     void setup_for_syntax(const std::string& syntaxHighlighting); // pygtk: sourceview_set_properties
     void set_pixels_inside_wrap(int space_around_lines, int relative_wrapped_space);
@@ -55,6 +56,9 @@ public:
     void cursor_and_tooltips_reset();
     void zoom_text(const bool is_increase, const std::string& syntaxHighlighting);
     void set_spell_check(bool allow_on);
+    bool large_doc_mode_needed(const int numChars) const;
+    void large_doc_mode_apply(const int numChars);
+    bool get_large_doc_mode() const { return _largeDocMode; }
     void synch_spell_check_change_from_gspell_right_click_menu();
 
     void set_buffer(const Glib::RefPtr<Gtk::TextBuffer>& buffer);
@@ -98,6 +102,7 @@ private:
     /// Replace the char between iter_start and iter_end with another one
     void          _special_char_replace(Glib::ustring special_char, Gtk::TextIter iter_start, Gtk::TextIter iter_end);
     void          _set_highlight_current_line_enabled(const bool enabled);
+    void          _apply_draw_spaces();
 
     void on_drag_data_received(const Glib::RefPtr<Gdk::DragContext>& context,
                                int x,
@@ -126,4 +131,6 @@ private:
     CtColumnEdit _columnEdit;
     guint32      _todoRotateTime{0};
     std::string  _syntaxHighlighting;
+    bool         _largeDocMode{false};
+    sigc::connection _largeDocHighlDeferConn;
 };
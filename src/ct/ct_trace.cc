@@ -0,0 +1,257 @@
+/*
+ * ct_trace.cc
+ *
+ * Copyright 2009-2024
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+
+#include "ct_trace.h"
+#include "ct_logging.h"
+#include <glibmm/fileutils.h>
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+
+constexpr size_t TraceRingSize{16384u};    // events per thread
+constexpr size_t TraceMaxOperations{64u};
+constexpr size_t TraceSummaryTopSpans{3u};
+
+const std::array<const char*, static_cast<size_t>(CtTraceCounter::Num)> traceCountersNames{
+    "nodes loaded",
+    "nodes serialized",
+    "bytes written",
+    "widgets created",
+    "regex matches",
+    "undo states"
+};
+
+} // namespace
+
+struct CtTrace::ThreadBuffer
+{
+    int                tid{0};
+    std::mutex         mutex; // only contended while exporting
+    std::vector<Event> events;
+    size_t             next{0u};
+    bool               inUse{true}; // under _buffersMutex
+};
+
+// hands the buffer back to the registry when the thread exits
+struct CtTrace::ThreadBufferHolder
+{
+    ~ThreadBufferHolder()
+    {
+        if (pThreadBuffer) {
+            CtTrace::_release_thread_buffer(*pThreadBuffer);
+        }
+    }
+    std::shared_ptr<ThreadBuffer> pThreadBuffer;
+};
+
+/*static*/std::atomic<bool> CtTrace::_enabled{false};
+/*static*/std::array<std::atomic<gint64>, static_cast<size_t>(CtTraceCounter::Num)> CtTrace::_counters{};
+/*static*/std::mutex CtTrace::_buffersMutex;
+/*static*/std::vector<std::shared_ptr<CtTrace::ThreadBuffer>> CtTrace::_buffers;
+/*static*/std::mutex CtTrace::_operationsMutex;
+/*static*/std::deque<CtTrace::Operation> CtTrace::_operations;
+
+/*static*/void CtTrace::set_enabled(const bool enabled)
+{
+    _enabled.store(enabled, std::memory_order_relaxed);
+    spdlog::debug("trace {}", enabled ? "enabled" : "disabled");
+}
+
+/*static*/CtTrace::ThreadBuffer& CtTrace::_get_thread_buffer()
+{
+    // the registry keeps the buffer alive after the thread exits, for the export, and a new thread
+    // continues the ring of an exited one so that the buffers are as many as the concurrent threads
+    thread_local ThreadBufferHolder threadBufferHolder;
+    if (not threadBufferHolder.pThreadBuffer) {
+        std::lock_guard<std::mutex> lock{_buffersMutex};
+        for (const std::shared_ptr<ThreadBuffer>& pThreadBuffer : _buffers) {
+            if (not pThreadBuffer->inUse) {
+                pThreadBuffer->inUse = true;
+                threadBufferHolder.pThreadBuffer = pThreadBuffer;
+                break;
+            }
+        }
+        if (not threadBufferHolder.pThreadBuffer) {
+            auto pThreadBuffer = std::make_shared<ThreadBuffer>();
+            pThreadBuffer->events.resize(TraceRingSize);
+            pThreadBuffer->tid = static_cast<int>(_buffers.size()) + 1;
+            _buffers.push_back(pThreadBuffer);
+            threadBufferHolder.pThreadBuffer = pThreadBuffer;
+        }
+    }
+    return *threadBufferHolder.pThreadBuffer;
+}
+
+/*static*/void CtTrace::_release_thread_buffer(ThreadBuffer& threadBuffer)
+{
+    std::lock_guard<std::mutex> lock{_buffersMutex};
+    threadBuffer.inUse = false;
+}
+
+/*static*/void CtTrace::_add_event(const char* name, const gint64 startUs, const gint64 durUs)
+{
+    ThreadBuffer& threadBuffer = _get_thread_buffer();
+    std::lock_guard<std::mutex> lock{threadBuffer.mutex};
+    Event& event = threadBuffer.events[threadBuffer.next % TraceRingSize];
+    event.name = name;
+    event.startUs = startUs;
+    event.durUs = durUs;
+    ++threadBuffer.next;
+}
+
+/*static*/void CtTrace::_add_operation(Operation&& operation)
+{
+    spdlog::debug("trace {}", operation.summary);
+    std::lock_guard<std::mutex> lock{_operationsMutex};
+    _operations.push_back(std::move(operation));
+    if (_operations.size() > TraceMaxOperations) {
+        _operations.pop_front();
+    }
+}
+
+/*static*/std::string CtTrace::_get_top_spans_within(const gint64 startUs, const gint64 endUs)
+{
+    // the inner spans of the calling thread, summed up by name
+    std::unordered_map<std::string, gint64> spansDurUs;
+    ThreadBuffer& threadBuffer = _get_thread_buffer();
+    {
+        std::lock_guard<std::mutex> lock{threadBuffer.mutex};
+        const size_t numEvents = std::min(threadBuffer.next, TraceRingSize);
+        for (size_t i = 0; i < numEvents; ++i) {
+            const Event& event = threadBuffer.events[(threadBuffer.next - 1u - i) % TraceRingSize];
+            if (event.startUs < startUs) {
+                break; // older than the operation
+            }
+            if (event.startUs + event.durUs <= endUs) {
+                spansDurUs[event.name] += event.durUs;
+            }
+        }
+    }
+    std::vector<std::pair<std::string, gint64>> spansSorted{spansDurUs.begin(), spansDurUs.end()};
+    std::sort(spansSorted.begin(), spansSorted.end(), [](const auto& a, const auto& b){ return a.second > b.second; });
+    std::string ret;
+    for (size_t i = 0; i < spansSorted.size() and i < TraceSummaryTopSpans; ++i) {
+        ret += fmt::format("{}{} {} ms", ret.empty() ? "" : ", ", spansSorted[i].first, spansSorted[i].second/1000);
+    }
+    return ret;
+}
+
+/*static*/bool CtTrace::write_chrome_json(const fs::path& filepath)
+{
+    std::string json{"{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n"};
+    bool first{true};
+    auto f_add_event = [&](const char* name, const int tid, const gint64 startUs, const gint64 durUs, const std::string& args){
+        json += fmt::format("{}{{\"name\": \"{}\", \"ph\": \"X\", \"pid\": 1, \"tid\": {}, \"ts\": {}, \"dur\": {}{}}}",
+                            first ? "" : ",\n", name, tid, startUs, durUs, args);
+        first = false;
+    };
+    {
+        std::lock_guard<std::mutex> lock{_buffersMutex};
+        for (const std::shared_ptr<ThreadBuffer>& pThreadBuffer : _buffers) {
+            std::lock_guard<std::mutex> bufferLock{pThreadBuffer->mutex};
+            const size_t numEvents = std::min(pThreadBuffer->next, TraceRingSize);
+            for (size_t i = pThreadBuffer->next - numEvents; i < pThreadBuffer->next; ++i) {
+                const Event& event = pThreadBuffer->events[i % TraceRingSize];
+                f_add_event(event.name, pThreadBuffer->tid, event.startUs, event.durUs, "");
+            }
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock{_operationsMutex};
+        for (const Operation& operation : _operations) {
+            std::string args;
+            for (size_t c = 0; c < operation.counters.size(); ++c) {
+                args += fmt::format("{}\"{}\": {}", args.empty() ? "" : ", ", traceCountersNames.at(c), operation.counters.at(c));
+            }
+            f_add_event(operation.name, operation.tid, operation.startUs, operation.durUs, ", \"args\": {" + args + "}");
+        }
+    }
+    json += "\n]}\n";
+    try {
+        Glib::file_set_contents(filepath.string(), json);
+    }
+    catch (Glib::FileError& e) {
+        spdlog::error("!! {} {}", __FUNCTION__, e.what());
+        return false;
+    }
+    return true;
+}
+
+/*static*/std::vector<std::string> CtTrace::get_summaries()
+{
+    std::vector<std::string> summaries;
+    std::lock_guard<std::mutex> lock{_operationsMutex};
+    for (const Operation& operation : _operations) {
+        summaries.push_back(operation.summary);
+    }
+    return summaries;
+}
+
+/*static*/std::string CtTrace::get_last_summary()
+{
+    std::lock_guard<std::mutex> lock{_operationsMutex};
+    return _operations.empty() ? "" : _operations.back().summary;
+}
+
+CtTraceOperation::CtTraceOperation(const char* name)
+ : _name{name}
+ , _startUs{CtTrace::is_enabled() ? g_get_monotonic_time() : -1}
+{
+    if (_startUs >= 0) {
+        for (size_t c = 0; c < _countersStart.size(); ++c) {
+            _countersStart[c] = CtTrace::_counters[c].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+CtTraceOperation::~CtTraceOperation()
+{
+    if (_startUs < 0) {
+        return;
+    }
+    const gint64 endUs = g_get_monotonic_time();
+    CtTrace::Operation operation;
+    operation.name = _name;
+    operation.tid = CtTrace::_get_thread_buffer().tid;
+    operation.startUs = _startUs;
+    operation.durUs = endUs - _startUs;
+    operation.summary = fmt::format("{} {} ms", _name, operation.durUs/1000);
+    std::string countersStr;
+    for (size_t c = 0; c < operation.counters.size(); ++c) {
+        // the counters are process wide, other threads may have contributed
+        operation.counters[c] = CtTrace::_counters[c].load(std::memory_order_relaxed) - _countersStart[c];
+        if (operation.counters[c] != 0) {
+            countersStr += fmt::format("{}{} {}", countersStr.empty() ? "" : ", ", traceCountersNames.at(c), operation.counters[c]);
+        }
+    }
+    if (not countersStr.empty()) {
+        operation.summary += " (" + countersStr + ")";
+    }
+    const std::string topSpans = CtTrace::_get_top_spans_within(_startUs, endUs);
+    if (not topSpans.empty()) {
+        operation.summary += ": " + topSpans;
+    }
+    CtTrace::_add_operation(std::move(operation));
+}
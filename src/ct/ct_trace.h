@@ -0,0 +1,133 @@
+/*
+ * ct_trace.h
+ *
+ * Copyright 2009-2024
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#pragma once
+
+#include "ct_filesystem.h"
+#include <glib.h>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+enum class CtTraceCounter { NodesLoaded, NodesSerialized, BytesWritten, WidgetsCreated, RegexMatches, UndoStates, Num };
+
+// Lightweight performance tracing: when disabled (the default) a span costs an atomic load.
+// When enabled the spans are recorded into per thread ring buffers with the most recent events,
+// the buffer of an exited thread is taken over by the next new thread, the counters are process wide and the operations (load, save, search, export) keep a summary
+class CtTrace
+{
+public:
+    static bool is_enabled() { return _enabled.load(std::memory_order_relaxed); }
+    static void set_enabled(const bool enabled);
+
+    static void counter_add(const CtTraceCounter counter, const gint64 delta)
+    {
+        if (is_enabled()) {
+            _counters[static_cast<size_t>(counter)].fetch_add(delta, std::memory_order_relaxed);
+        }
+    }
+
+    // the recorded spans and operations in the Chrome trace event format (chrome://tracing, ui.perfetto.dev)
+    static bool write_chrome_json(const fs::path& filepath);
+
+    // the summaries of the most recent operations, oldest first
+    static std::vector<std::string> get_summaries();
+    static std::string              get_last_summary();
+
+private:
+    friend class CtTraceSpan;
+    friend class CtTraceOperation;
+
+    struct Event
+    {
+        const char* name{nullptr}; // string literal
+        gint64      startUs{0};
+        gint64      durUs{0};
+    };
+    struct ThreadBuffer;
+    struct ThreadBufferHolder;
+    struct Operation
+    {
+        const char*                                                   name{nullptr};
+        int                                                           tid{0};
+        gint64                                                        startUs{0};
+        gint64                                                        durUs{0};
+        std::array<gint64, static_cast<size_t>(CtTraceCounter::Num)> counters{};
+        std::string                                                   summary;
+    };
+
+    static ThreadBuffer& _get_thread_buffer();
+    static void          _release_thread_buffer(ThreadBuffer& threadBuffer);
+    static void          _add_event(const char* name, const gint64 startUs, const gint64 durUs);
+    static void          _add_operation(Operation&& operation);
+    static std::string   _get_top_spans_within(const gint64 startUs, const gint64 endUs);
+
+    static std::atomic<bool>                                                           _enabled;
+    static std::array<std::atomic<gint64>, static_cast<size_t>(CtTraceCounter::Num)> _counters;
+    static std::mutex                                                                  _buffersMutex;
+    static std::vector<std::shared_ptr<ThreadBuffer>>                                  _buffers;
+    static std::mutex                                                                  _operationsMutex;
+    static std::deque<Operation>                                                       _operations;
+};
+
+// records the time spent in the current scope
+class CtTraceSpan
+{
+public:
+    explicit CtTraceSpan(const char* name)
+     : _name{name}
+     , _startUs{CtTrace::is_enabled() ? g_get_monotonic_time() : -1}
+    {
+    }
+    ~CtTraceSpan()
+    {
+        if (_startUs >= 0) {
+            CtTrace::_add_event(_name, _startUs, g_get_monotonic_time() - _startUs);
+        }
+    }
+    CtTraceSpan(const CtTraceSpan&) = delete;
+    CtTraceSpan& operator=(const CtTraceSpan&) = delete;
+
+private:
+    const char*  _name;
+    const gint64 _startUs;
+};
+
+// a span that also takes the counters increments and the slowest inner spans into a summary
+class CtTraceOperation
+{
+public:
+    explicit CtTraceOperation(const char* name);
+    ~CtTraceOperation();
+    CtTraceOperation(const CtTraceOperation&) = delete;
+    CtTraceOperation& operator=(const CtTraceOperation&) = delete;
+
+private:
+    const char*                                                   _name;
+    const gint64                                                  _startUs;
+    std::array<gint64, static_cast<size_t>(CtTraceCounter::Num)> _countersStart{};
+};
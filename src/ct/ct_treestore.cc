@@ -28,6 +28,8 @@
 #include "ct_storage_control.h"
 #include "ct_actions.h"
 #include "ct_logging.h"
+#include "ct_text_stats.h"
+#include "ct_image.h"
 
 /*static*/bool CtTreeIter::_hitExclusionFromSearch{false};
 
@@ -505,6 +507,9 @@ Glib::RefPtr<Gsv::Buffer> CtTreeIter::get_node_text_buffer() const
                 }
                 row.set_value(_pColumns->colAnchoredWidgets, anchoredWidgetList);
                 row.set_value(_pColumns->rColTextBuffer, rRetTextBuffer);
+                if (rRetTextBuffer) {
+                    _pCtMainWin->get_nodes_buffers_lru().touch(nodeId, rRetTextBuffer, anchoredWidgetList.size());
+                }
             }
         }
         return rRetTextBuffer;
@@ -541,6 +546,35 @@ bool CtTreeIter::get_node_buffer_already_loaded() const
     return PANGO_WEIGHT_HEAVY == pangoWeight;
 }
 
+bool CtTreeIter::unload_node_text_buffer()
+{
+    if (*this) {
+        const gint64 masterId = (*this)->get_value(_pColumns->colSharedNodesMasterId);
+        if (masterId > 0) {
+            CtTreeIter masterIter = _pCtMainWin->get_tree_store().get_node_from_node_id(masterId);
+            if (masterIter) {
+                return masterIter.unload_node_text_buffer();
+            }
+            spdlog::error("!! {} master {}", __FUNCTION__, masterId);
+            (*this)->set_value(_pColumns->colSharedNodesMasterId, static_cast<gint64>(0));
+        }
+        if (not (*this)->get_value(_pColumns->rColTextBuffer)) {
+            return true; // not loaded
+        }
+        if (not _pCtMainWin->get_ct_storage()->release_node_buffer(*this)) {
+            return false;
+        }
+        for (CtAnchoredWidget* pWidget : (*this)->get_value(_pColumns->colAnchoredWidgets)) {
+            delete pWidget;
+        }
+        (*this)->set_value(_pColumns->colAnchoredWidgets, std::list<CtAnchoredWidget*>{});
+        (*this)->set_value(_pColumns->rColTextBuffer, Glib::RefPtr<Gsv::Buffer>{});
+        return true;
+    }
+    spdlog::error("!! {}", __FUNCTION__);
+    return false;
+}
+
 void CtTreeIter::remove_all_embedded_widgets()
 {
     if (*this) {
@@ -846,8 +880,10 @@ void CtTreeStore::text_view_apply_textbuffer(CtTreeIter& treeIter, CtTextView* p
 {
     if (not static_cast<bool>(treeIter)) {
         pTextView->set_buffer(Glib::RefPtr<Gsv::Buffer>{});
+        pTextView->large_doc_mode_apply(0);
         pTextView->set_spell_check(false);
         pTextView->set_sensitive(false);
+        _pCtMainWin->window_header_update_large_doc_icon(false);
         return;
     }
 
@@ -864,9 +900,14 @@ void CtTreeStore::text_view_apply_textbuffer(CtTreeIter& treeIter, CtTextView* p
     else spdlog::debug("Node {}[{}] > {}", nodeId, nodeMasterId, nodeName);
 
     Glib::RefPtr<Gsv::Buffer> rTextBuffer = treeIter.get_node_text_buffer();
-    _pCtMainWin->apply_syntax_highlighting(rTextBuffer, treeIter.get_node_syntax_highlighting(), false/*forceReApply*/);
+    // a buffer last displayed in large document mode has to get its highlighting properties back
+    const bool forceReApply = nullptr != rTextBuffer->get_data(CtConst::LARGE_DOC_APPLIED_ID);
+    rTextBuffer->set_data(CtConst::LARGE_DOC_APPLIED_ID, nullptr);
+    _pCtMainWin->apply_syntax_highlighting(rTextBuffer, treeIter.get_node_syntax_highlighting(), forceReApply);
     pTextView->setup_for_syntax(treeIter.get_node_syntax_highlighting());
     pTextView->set_buffer(rTextBuffer);
+    pTextView->large_doc_mode_apply(rTextBuffer->get_char_count());
+    _pCtMainWin->window_header_update_large_doc_icon(pTextView->get_large_doc_mode());
     pTextView->set_spell_check(treeIter.get_node_is_text());
     pTextView->set_sensitive(true);
     pTextView->set_editable(not treeIter.get_node_read_only());
@@ -1118,6 +1159,15 @@ void CtTreeStore::_on_textbuffer_modified_changed(Glib::RefPtr<Gtk::TextBuffer>
 
 void CtTreeStore::_on_textbuffer_insert(const Gtk::TextBuffer::iterator& pos, const Glib::ustring& text, int /*bytes*/)
 {
+    CtTextView& textView = _pCtMainWin->get_text_view();
+    if (not textView.get_large_doc_mode()) {
+        // switch before the insertion takes place, e.g. on paste of a huge log
+        const int numChars = pos.get_buffer()->get_char_count() + static_cast<int>(text.size());
+        if (textView.large_doc_mode_needed(numChars)) {
+            textView.large_doc_mode_apply(numChars);
+            _pCtMainWin->window_header_update_large_doc_icon(true);
+        }
+    }
     if (_pCtMainWin->user_active() and not _pCtMainWin->get_text_view().column_edit_get_own_insert_delete_active()) {
         _pCtMainWin->get_text_view().column_edit_text_inserted(pos, text);
         CtTreeIter currTreeIter = _pCtMainWin->curr_tree_iter();
@@ -1407,12 +1457,6 @@ bool CtTreeStore::populate_summary_info(CtSummaryInfo& summaryInfo)
             else {
                 ++summaryInfo.nodes_code_num;
             }
-            // ensure the node content is populated
-            Glib::RefPtr<Gsv::Buffer> rTextBuffer = ctTreeIter.get_node_text_buffer();
-            if (not rTextBuffer) {
-                error = str::format(_("Failed to retrieve the content of the node '%s'"), ctTreeIter.get_node_name());
-                return true; /* true for stop */
-            }
             const gint64 shared_master_id = ctTreeIter.get_node_shared_master_id();
             if (shared_master_id > 0) {
                 // shared non master
@@ -1424,8 +1468,19 @@ bool CtTreeStore::populate_summary_info(CtSummaryInfo& summaryInfo)
                 }
                 sharedNodesMap[shared_master_id].insert(ctTreeIter.get_node_id());
             }
-            else {
-                // non shared or shared master (data holder)
+            else if (ctTreeIter.get_node_buffer_already_loaded() or
+                     not _add_stored_node_summary_info(ctTreeIter, summaryInfo))
+            {
+                // non shared or shared master (data holder), the content is in the text buffer
+                Glib::RefPtr<Gsv::Buffer> rTextBuffer = ctTreeIter.get_node_text_buffer();
+                if (not rTextBuffer) {
+                    error = str::format(_("Failed to retrieve the content of the node '%s'"), ctTreeIter.get_node_name());
+                    return true; /* true for stop */
+                }
+                CtTextStats* pTextStats = CtTextStats::get_for_buffer(rTextBuffer);
+                summaryInfo.words_num += pTextStats->get_words();
+                summaryInfo.chars_num += pTextStats->get_chars();
+                summaryInfo.lines_num += pTextStats->get_lines();
                 for (CtAnchoredWidget* pAnchoredWidget : ctTreeIter.get_anchored_widgets_fast()) {
                     switch (pAnchoredWidget->get_type()) {
                         case CtAnchWidgType::CodeBox: ++summaryInfo.codeboxes_num; break;
@@ -1448,3 +1503,49 @@ bool CtTreeStore::populate_summary_info(CtSummaryInfo& summaryInfo)
     CtDialogs::error_dialog(error, *_pCtMainWin);
     return false;
 }
+
+bool CtTreeStore::_add_stored_node_summary_info(const CtTreeIter& ctTreeIter, CtSummaryInfo& summaryInfo)
+{
+    // the node content is counted from the storage rather than loaded in a text buffer
+    xmlpp::Document xmlDoc;
+    xmlpp::Element* p_node_node = xmlDoc.create_root_node("node");
+    if (not _pCtMainWin->get_ct_storage()->get_stored_node_xml(ctTreeIter, p_node_node)) {
+        return false;
+    }
+    Glib::ustring text;
+    int numWidgets{0};
+    for (xmlpp::Node* pXmlSlot : p_node_node->get_children()) {
+        auto pSlotElement = dynamic_cast<xmlpp::Element*>(pXmlSlot);
+        if (not pSlotElement) {
+            continue;
+        }
+        const Glib::ustring slotName = pSlotElement->get_name();
+        if ("rich_text" == slotName) {
+            if (xmlpp::TextNode* pTextNode = pSlotElement->get_child_text()) {
+                text += pTextNode->get_content();
+            }
+            continue;
+        }
+        if ("codebox" == slotName) ++summaryInfo.codeboxes_num;
+        else if ("table" == slotName) {
+            if (CtStrUtil::is_str_true(pSlotElement->get_attribute_value("is_light"))) ++summaryInfo.lighttables_num;
+            else ++summaryInfo.heavytables_num;
+        }
+        else if ("encoded_png" == slotName) {
+            const std::string fileName = pSlotElement->get_attribute_value("filename");
+            if (not pSlotElement->get_attribute_value("anchor").empty()) ++summaryInfo.anchors_num;
+            else if (CtImageLatex::LatexSpecialFilename == fileName) ++summaryInfo.latexes_num;
+            else if (not fileName.empty()) ++summaryInfo.embfile_num;
+            else ++summaryInfo.images_num;
+        }
+        else {
+            continue;
+        }
+        ++numWidgets;
+    }
+    const CtTextTotals textTotals = CtTextStats::count_text(text);
+    summaryInfo.words_num += textTotals.words;
+    summaryInfo.chars_num += textTotals.chars + numWidgets; // one anchor char per widget
+    summaryInfo.lines_num += textTotals.lines;
+    return true;
+}
@@ -126,6 +126,8 @@ public:
     void                      set_node_text_buffer(Glib::RefPtr<Gsv::Buffer> new_buffer, const std::string& new_syntax_highlighting);
     Glib::RefPtr<Gsv::Buffer> get_node_text_buffer() const;
     bool                      get_node_buffer_already_loaded() const;
+    // the text buffer and widgets are dropped, if the storage can give them again on the next get_node_text_buffer
+    bool                      unload_node_text_buffer();
 
     void                         remove_all_embedded_widgets();
     std::list<CtAnchoredWidget*> get_anchored_widgets_fast(const char doSort = 'n') const;
@@ -216,6 +218,7 @@ public:
 protected:
     Glib::RefPtr<Gdk::Pixbuf> _get_node_icon(int nodeDepth, const std::string &syntax, guint32 customIconId);
     void                      _iter_delete_anchored_widgets(const Gtk::TreeModel::Children& children);
+    bool                      _add_stored_node_summary_info(const CtTreeIter& ctTreeIter, CtSummaryInfo& summaryInfo);
 
     void _on_textbuffer_modified_changed(Glib::RefPtr<Gtk::TextBuffer> rTextBuffer);
     void _on_textbuffer_insert(const Gtk::TextBuffer::iterator& pos, const Glib::ustring& text, int bytes);
@@ -32,6 +32,7 @@
 #include <optional>
 #include <condition_variable>
 #include <type_traits>
+#include <functional>
 #include <glibmm/ustring.h>
 #include <gtksourceviewmm/buffer.h>
 #include "ct_const.h"
@@ -62,6 +63,8 @@ enum class CtDuplicateShared { None, Duplicate, Shared };
 
 enum class CtRestoreExpColl : int { FROM_STR=0, ALL_EXP=1, ALL_COLL=2 };
 
+enum class CtSaveVerify : int { FULL=0, SAMPLED=1, STRUCTURAL=2 };
+
 enum class CtMatchType { None, Content, NameNTags };
 
 class CtCodebox;
@@ -69,6 +72,7 @@ class CtMainWin;
 using CtPairCodeboxMainWin = std::pair<CtCodebox*, CtMainWin*>;
 namespace xmlpp {
 class Document;
+class Element;
 }
 using CtDelayedTextBufferMap = std::unordered_map<gint64, std::shared_ptr<xmlpp::Document>>;
 using CtCurrAttributesMap = std::unordered_map<std::string_view, std::string>;
@@ -272,6 +276,9 @@ struct CtStorageSyncPending
     std::unordered_set<gint64>                     nodes_to_rm_set;
 };
 
+// node id -> sha256sum of the node payload as written to disk
+using CtNodesDigests = std::unordered_map<gint64, std::string>;
+
 enum class CtBackupType { None, SingleFile, MultiFile };
 struct CtBackupEncryptData
 {
@@ -281,10 +288,19 @@ struct CtBackupEncryptData
     std::string file_path;
     std::string password;
     std::string extracted_copy;
+    CtNodesDigests nodes_digests;
+};
+
+struct CtStorageFreeStats
+{
+    gint64 totBytes{0};
+    gint64 freeBytes{0};            // reclaimable
+    bool   incrementalVacuum{false}; // reclaimable by compact_step, without a full vacuum
 };
 
 struct CtNodeData;
 class CtAnchoredWidget;
+class CtTreeIter;
 namespace Gtk { class TreeIter; }
 class CtStorageEntity
 {
@@ -293,7 +309,8 @@ public:
     virtual ~CtStorageEntity() = default;
 
     virtual void close_connect() = 0;
-    virtual void reopen_connect() = 0;
+    // file_replaced if the file was overwritten while the connection was closed (e.g. restored from the backup)
+    virtual void reopen_connect(const bool file_replaced) = 0;
     virtual void test_connection() = 0;
     virtual void try_reopen() = 0;
 
@@ -305,17 +322,41 @@ public:
                                 const std::map<gint64, gint64>* pExpoMasterReassign = nullptr,
                                 const int start_offset = 0,
                                 const int end_offset = -1) = 0;
-    virtual void vacuum() = 0;
-    virtual void import_nodes(const fs::path& path, const Gtk::TreeIter& parent_iter) = 0;
+    // full compaction, f_stop is polled from the calling thread and interrupts it returning false
+    virtual bool vacuum(const std::function<bool()>& f_stop) = 0;
+    virtual CtStorageFreeStats get_free_stats() = 0;
+    // reclaims up to maxPages free pages, false when there is nothing left to reclaim this way
+    virtual bool compact_step(const int maxPages) = 0;
+    // the imported nodes get new ids (ids in the imported document -> new ids, more than one new id if the
+    // imported document has duplicated ids, the first is the one for the links) and no text buffer but for
+    // the duplicated ids, their content is read later through get_delayed_node_xml with the ids in the imported document
+    virtual void import_nodes(const fs::path& path,
+                              const Gtk::TreeIter& parent_iter,
+                              std::multimap<gint64, gint64>& imported_ids_remap) = 0;
 
     virtual Glib::RefPtr<Gsv::Buffer> get_delayed_text_buffer(const gint64 node_id,
                                                               const std::string& syntax,
                                                               std::list<CtAnchoredWidget*>& widgets) const = 0;
+    // append the stored content of a node, as the slots of a <node> element of the xml document with the
+    // binaries inline, straight from the storage without creating a text buffer or widgets
+    virtual bool get_delayed_node_xml(const gint64 node_id,
+                                      const std::string& syntax,
+                                      xmlpp::Element* p_node_node) const = 0;
+    // the text buffer of a node with nothing to save is about to be unloaded, the storage gets ready to
+    // give it again through get_delayed_text_buffer (false if it cannot)
+    virtual bool release_text_buffer(const CtTreeIter& ct_tree_iter) = 0;
+    // a node saved without its text buffer ever being loaded (e.g. imported), the storage gets ready to
+    // give it through get_delayed_text_buffer (false if it cannot)
+    virtual bool adopt_saved_node(const gint64 node_id) = 0;
 
     void set_is_dry_run() { _isDryRun = true; }
 
+    // digests of the nodes written by the latest save
+    const CtNodesDigests& get_nodes_digests() const { return _nodesDigests; }
+
 protected:
     bool _isDryRun{false};
+    CtNodesDigests _nodesDigests;
 };
 
 struct CtStockIcon
@@ -338,6 +379,7 @@ struct CtExportOptions
     bool new_node_page{false};
     bool index_in_page{true};
     bool single_file{false};
+    int  jobs{0}; // worker threads, 0 for one per core
 };
 
 struct CtSummaryInfo
@@ -354,6 +396,9 @@ struct CtSummaryInfo
     size_t lighttables_num{0u};
     size_t codeboxes_num{0u};
     size_t anchors_num{0u};
+    size_t words_num{0u};
+    size_t chars_num{0u};
+    size_t lines_num{0u};
 };
 
 template<class F> auto scope_guard(F&& f) {
@@ -25,6 +25,7 @@
 #include "ct_main_win.h"
 #include <glib/gstdio.h>
 #include "ct_app.h"
+#include "ct_trace.h"
 
 CtTmp::~CtTmp()
 {
@@ -76,6 +77,7 @@ CtAnchoredWidget::CtAnchoredWidget(CtMainWin* pCtMainWin, const int charOffset,
  , _charOffset{charOffset}
  , _justification{justification}
 {
+    CtTrace::counter_add(CtTraceCounter::WidgetsCreated, 1);
     _frame.set_shadow_type(Gtk::ShadowType::SHADOW_NONE);
     signal_button_press_event().connect([this](GdkEventButton* /*pEvent*/){
         _pCtMainWin->curr_buffer()->place_cursor(_pCtMainWin->curr_buffer()->get_iter_at_child_anchor((_rTextChildAnchor)));
@@ -84,6 +86,29 @@ CtAnchoredWidget::CtAnchoredWidget(CtMainWin* pCtMainWin, const int charOffset,
     add(_frame);
 }
 
+std::shared_ptr<CtAnchoredWidgetState> CtAnchoredWidget::get_state_shared()
+{
+    if (not _has_content_generation()) {
+        return get_state();
+    }
+    if (not _pStateShared or _stateSharedGeneration != _contentGeneration) {
+        _pStateShared = get_state();
+        _stateSharedGeneration = _contentGeneration;
+    }
+    else if (_pStateShared->charOffset != _charOffset or
+             _pStateShared->justification != _justification or
+             not _state_shared_minor_fields_equal(*_pStateShared))
+    {
+        // moved but not changed, the copy shares the content with the previous state
+        std::shared_ptr<CtAnchoredWidgetState> pStateMoved = _pStateShared->copy();
+        pStateMoved->charOffset = _charOffset;
+        pStateMoved->justification = _justification;
+        _state_shared_minor_fields_set(*pStateMoved);
+        _pStateShared = pStateMoved;
+    }
+    return _pStateShared;
+}
+
 void CtAnchoredWidget::updateJustification(const Gtk::TextIter& textIter)
 {
     updateJustification(CtTextIterUtil::get_text_iter_alignment(textIter, _pCtMainWin));
@@ -51,6 +51,18 @@ class CtMainWin;
 class CtAnchoredWidgetState;
 class CtStorageCache;
 
+// the row of an anchored widget in a SQLite document as of the last load/save,
+// to rewrite on save only the widgets that changed or moved
+struct CtSqliteRowRef
+{
+    gint64        dbUid{0};
+    gint64        nodeId{0};
+    sqlite3_int64 rowId{0};
+    size_t        contentSignature{0};
+    int           charOffset{0};
+    std::string   justification;
+};
+
 class CtAnchoredWidget : public Gtk::EventBox
 {
 public:
@@ -67,6 +79,13 @@ public:
     virtual void set_modified_false() = 0;
     virtual CtAnchWidgType get_type() const = 0;
     virtual std::shared_ptr<CtAnchoredWidgetState> get_state() = 0;
+    // immutable state, reused by the undo steps until the content of the widget changes
+    std::shared_ptr<CtAnchoredWidgetState> get_state_shared();
+    // differs whenever the content (offset and justification excluded) changes
+    virtual size_t get_content_signature() { return _contentGeneration; }
+
+    const CtSqliteRowRef& get_sqlite_row_ref() const { return _sqliteRowRef; }
+    void set_sqlite_row_ref(const CtSqliteRowRef& sqliteRowRef) { _sqliteRowRef = sqliteRowRef; }
 
     void updateOffset(int charOffset) { _charOffset = charOffset; }
     void updateJustification(const std::string& justification) { _justification = justification; }
@@ -81,6 +100,17 @@ public:
 protected:
     void _on_frame_size_allocate(Gtk::Allocation& allocation);
 
+    // widgets calling _content_changed at every change of the content, the others get a new state every time
+    // (and override get_content_signature)
+    virtual bool _has_content_generation() const { return false; }
+    // the state fields out of the content generation (e.g. sizes, cursor), cheap to compare and to set on a copy
+    virtual bool _state_shared_minor_fields_equal(const CtAnchoredWidgetState& /*state*/) const { return true; }
+    virtual void _state_shared_minor_fields_set(CtAnchoredWidgetState& /*state*/) const {}
+    void _content_changed() { ++_contentGeneration; }
+    static void _signature_combine(size_t& signature, const size_t value) {
+        signature ^= value + 0x9e3779b97f4a7c15u + (signature << 6) + (signature >> 2);
+    }
+
 protected:
     CtMainWin* _pCtMainWin;
     int _charOffset;
@@ -89,6 +119,10 @@ protected:
     Gtk::Label _labelWidget;
     Glib::RefPtr<Gtk::TextChildAnchor> _rTextChildAnchor;
     Gtk::Allocation _lastAllocation;
+    size_t _contentGeneration{0};
+    size_t _stateSharedGeneration{0};
+    std::shared_ptr<CtAnchoredWidgetState> _pStateShared;
+    CtSqliteRowRef _sqliteRowRef;
 };
 
 class CtTreeView : public Gtk::TreeView
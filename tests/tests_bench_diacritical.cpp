@@ -0,0 +1,92 @@
+/*
+ * tests_bench_diacritical.cpp
+ *
+ * Copyright 2009-2024
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_misc_utils.h"
+#include "tests_common.h"
+#include "tests_bench_doc_gen.h"
+
+// NOTE: part of run_benchmarks, does not need a display
+
+// the former implementation, one regex replace per ascii letter
+static Glib::ustring _diacritical_to_ascii_regex_chain(const Glib::ustring& in_text)
+{
+    static std::list<std::pair<Glib::ustring, Glib::RefPtr<Glib::Regex>>> list_DiacrToAscii{
+        {"a", Glib::Regex::create("[àáâãäåāăąạ]")}, {"A", Glib::Regex::create("[ÀÁÂÃÄÅĀĂĄẠ]")},
+        {"b", Glib::Regex::create("[ḅ]")}, {"B", Glib::Regex::create("[Ḅ]")},
+        {"c", Glib::Regex::create("[çćĉċč]")}, {"C", Glib::Regex::create("[ÇĆĈĊČ]")},
+        {"d", Glib::Regex::create("[ďđḍ]")}, {"D", Glib::Regex::create("[ĎĐḌ]")},
+        {"e", Glib::Regex::create("[èéêëēĕėęěẹ]")}, {"E", Glib::Regex::create("[ÈÉÊËĒĔĖĘĚẸ]")},
+        {"g", Glib::Regex::create("[ĝğġģ]")}, {"G", Glib::Regex::create("[ĜĞĠĢ]")},
+        {"h", Glib::Regex::create("[ĥħḥ]")}, {"H", Glib::Regex::create("[ĤĦḤ]")},
+        {"i", Glib::Regex::create("[ìíîïĩīĭįıị]")}, {"I", Glib::Regex::create("[ÌÍÎÏĨĪĬĮİỊ]")},
+        {"j", Glib::Regex::create("[ĵ]")}, {"J", Glib::Regex::create("[Ĵ]")},
+        {"k", Glib::Regex::create("[ķḳ]")}, {"K", Glib::Regex::create("[ĶḲ]")},
+        {"l", Glib::Regex::create("[ĺļľŀłḷ]")}, {"L", Glib::Regex::create("[ĹĻĽĿŁḶ]")},
+        {"m", Glib::Regex::create("[ṃ]")}, {"M", Glib::Regex::create("[Ṃ]")},
+        {"n", Glib::Regex::create("[ñńņňŉṇ]")}, {"N", Glib::Regex::create("[ÑŃŅŇṆ]")},
+        {"o", Glib::Regex::create("[òóôõöøōŏőọ]")}, {"O", Glib::Regex::create("[ÒÓÔÕÖØŌŎŐỌ]")},
+        {"r", Glib::Regex::create("[ŕŗřṛ]")}, {"R", Glib::Regex::create("[ŔŖŘṚ]")},
+        {"s", Glib::Regex::create("[śŝşšṣ]")}, {"S", Glib::Regex::create("[ŚŜŞŠṢ]")},
+        {"t", Glib::Regex::create("[ţťŧṭ]")}, {"T", Glib::Regex::create("[ŢŤŦṬ]")},
+        {"u", Glib::Regex::create("[ùúûüũūŭůűųụ]")}, {"U", Glib::Regex::create("[ÙÚÛÜŨŪŬŮŰŲỤ]")},
+        {"w", Glib::Regex::create("[ŵẉ]")}, {"W", Glib::Regex::create("[ŴẈ]")},
+        {"y", Glib::Regex::create("[ýŷÿỵ]")}, {"Y", Glib::Regex::create("[ÝŶŸỴ]")},
+        {"z", Glib::Regex::create("[źżžẓ]")}, {"Z", Glib::Regex::create("[ŹŻŽẒ]")},
+    };
+    const Glib::RegexMatchFlags re_flags{static_cast<Glib::RegexMatchFlags>(0u)};
+    Glib::ustring tmp_str{in_text};
+    for (auto& currPair : list_DiacrToAscii) {
+        if (currPair.second->match(tmp_str, re_flags)) {
+            tmp_str = currPair.second->replace(tmp_str, 0/*start_position*/, currPair.first, re_flags);
+        }
+    }
+    return tmp_str;
+}
+
+TEST(BenchSuite, diacritical_fold_4MB_text)
+{
+    constexpr size_t targetBytes{4u*1024u*1024u};
+    const Glib::ustring paragraph{"Già perché lì può più, Łódź è a nord di Kraków. Plain ascii text line with no accents at all.\n"};
+    Glib::ustring text;
+    text.reserve(targetBytes + paragraph.bytes());
+    while (text.bytes() < targetBytes) {
+        text += paragraph;
+    }
+
+    CtBenchResults& results = pBenchEnv->results;
+    CtBenchResults::Clock::time_point start = CtBenchResults::Clock::now();
+    const Glib::ustring foldedRegexChain = _diacritical_to_ascii_regex_chain(text);
+    results.add("diacritical fold regex chain", start, text.bytes());
+
+    start = CtBenchResults::Clock::now();
+    const Glib::ustring foldedSinglePass = str::diacritical_to_ascii(text);
+    results.add("diacritical fold single pass", start, text.bytes());
+
+    start = CtBenchResults::Clock::now();
+    std::vector<int> origOffsets;
+    (void)str::diacritical_to_ascii(text, &origOffsets);
+    results.add("diacritical fold single pass with offsets", start, text.bytes());
+
+    ASSERT_TRUE(foldedRegexChain == foldedSinglePass);
+    ASSERT_EQ(text.size() + 1u, origOffsets.size());
+}
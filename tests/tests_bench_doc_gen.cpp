@@ -0,0 +1,353 @@
+/*
+ * tests_bench_doc_gen.cpp
+ *
+ * Copyright 2009-2024
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "tests_bench_doc_gen.h"
+#include "ct_misc_utils.h"
+#include "tests_common.h"
+#include <glibmm/base64.h>
+#include <glibmm/fileutils.h>
+#include <libxml++/libxml++.h>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+namespace {
+
+const std::vector<std::string> benchWords{
+    "lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing", "elit", "sed", "do",
+    "eiusmod", "tempor", "incididunt", "ut", "labore", "et", "dolore", "magna", "aliqua", "enim"
+};
+
+// the rich text attributes of the runs, as written by CtStorageXmlHelper
+const std::vector<std::pair<std::string, std::string>> benchTags{
+    {"weight", "heavy"},
+    {"style", "italic"},
+    {"foreground", "#ffff00000000"},
+    {"background", "#e6e6e6e6fafa"},
+    {"underline", "single"},
+    {"scale", "h2"},
+    {"family", "monospace"},
+    {"link", "webs https://www.giuspen.net/cherrytree/"}
+};
+
+const std::vector<std::string> benchCodeSyntaxes{"cpp", "python3", "sh", "xml"};
+
+unsigned bench_getenv_unsigned(const char* envVar, const unsigned defaultVal)
+{
+    const char* pValue = g_getenv(envVar);
+    if (not pValue or not *pValue) {
+        return defaultVal;
+    }
+    return static_cast<unsigned>(std::strtoul(pValue, nullptr, 10));
+}
+
+class CtBenchDocGen
+{
+public:
+    CtBenchDocGen(const CtBenchDocSpec& spec)
+     : _spec{spec}
+     , _randGen{spec.seed}
+    {
+        _encodedPng = Glib::Base64::encode(Glib::file_get_contents(Glib::build_filename(UT::unitTestsDataDir, "image_2x2.png")));
+        std::string embFileBlob(4096u, '\0');
+        for (size_t i = 0; i < embFileBlob.size(); ++i) {
+            embFileBlob[i] = static_cast<char>(i * 31u + 7u);
+        }
+        _encodedEmbFile = Glib::Base64::encode(embFileBlob);
+    }
+
+    size_t generate(const fs::path& ctd_filepath)
+    {
+        xmlpp::Document xml_doc;
+        xml_doc.create_root_node("cherrytree");
+        // breadth of each level so that the requested depth is reached with the requested number of nodes
+        unsigned levelBreadth{1u};
+        if (_spec.depth > 1u) {
+            while (_get_num_nodes(levelBreadth) < _spec.nodes) {
+                ++levelBreadth;
+            }
+        }
+        else {
+            levelBreadth = _spec.nodes;
+        }
+        while (_nodeId < _spec.nodes) {
+            _add_node(xml_doc.get_root_node(), 1u/*level*/, levelBreadth);
+        }
+        xml_doc.write_to_file_formatted(ctd_filepath.string());
+        return _numSearchMatches;
+    }
+
+private:
+    size_t _get_num_nodes(const unsigned levelBreadth) const
+    {
+        size_t tot{0u};
+        size_t levelNodes{1u};
+        for (unsigned level = 0; level < _spec.depth; ++level) {
+            levelNodes *= levelBreadth;
+            tot += levelNodes;
+        }
+        return tot;
+    }
+
+    unsigned _rand(const unsigned maxExcluded)
+    {
+        return std::uniform_int_distribution<unsigned>{0u, maxExcluded - 1u}(_randGen);
+    }
+
+    std::string _get_sentence(const unsigned numWords)
+    {
+        std::string sentence;
+        for (unsigned i = 0; i < numWords; ++i) {
+            if (not sentence.empty()) {
+                sentence += ' ';
+            }
+            if (_rand(50u) == 0u) {
+                sentence += BenchSearchWord;
+                ++_numSearchMatches;
+            }
+            else {
+                sentence += benchWords.at(_rand(benchWords.size()));
+            }
+        }
+        return sentence;
+    }
+
+    void _add_node(xmlpp::Element* p_parent, const unsigned level, const unsigned levelBreadth)
+    {
+        const unsigned nodeId = ++_nodeId;
+        xmlpp::Element* p_node = p_parent->add_child("node");
+        p_node->set_attribute("unique_id", std::to_string(nodeId));
+        p_node->set_attribute("master_id", "0");
+        p_node->set_attribute("name", "node " + std::to_string(nodeId) + " " + _get_sentence(2u));
+        // mostly rich text, some plain text and some code
+        const unsigned syntaxChoice = nodeId % 10u;
+        const std::string syntax = syntaxChoice < 7u ? "custom-colors" :
+                                   syntaxChoice < 9u ? "plain-text" : benchCodeSyntaxes.at(nodeId % benchCodeSyntaxes.size());
+        p_node->set_attribute("prog_lang", syntax);
+        p_node->set_attribute("tags", "");
+        p_node->set_attribute("readonly", "0");
+        p_node->set_attribute("nosearch_me", "0");
+        p_node->set_attribute("nosearch_ch", "0");
+        p_node->set_attribute("custom_icon_id", "0");
+        p_node->set_attribute("is_bold", "0");
+        p_node->set_attribute("foreground", "");
+        p_node->set_attribute("ts_creation", std::to_string(1600000000u + nodeId));
+        p_node->set_attribute("ts_lastsave", std::to_string(1600000000u + nodeId));
+        if ("custom-colors" == syntax) {
+            _add_rich_content(p_node);
+        }
+        else {
+            std::string text;
+            for (unsigned p = 0; p < _spec.paragraphs; ++p) {
+                text += _get_sentence(8u + _rand(8u)) + "\n";
+            }
+            p_node->add_child("rich_text")->add_child_text(text);
+        }
+        if (level < _spec.depth) {
+            for (unsigned i = 0; i < levelBreadth and _nodeId < _spec.nodes; ++i) {
+                _add_node(p_node, level + 1u, levelBreadth);
+            }
+        }
+    }
+
+    void _add_rich_content(xmlpp::Element* p_node)
+    {
+        // the widgets are placed at the end of evenly spaced paragraphs
+        const unsigned numWidgets = _spec.codeboxes + _spec.tables + _spec.images + _spec.embFiles;
+        std::vector<std::pair<unsigned/*paragraph*/, CtAnchWidgType>> widgetsAt;
+        unsigned w{0u};
+        auto f_add_widgets = [&](const unsigned num, const CtAnchWidgType type){
+            for (unsigned i = 0; i < num; ++i, ++w) {
+                widgetsAt.push_back(std::make_pair(_spec.paragraphs > 0u ? w * _spec.paragraphs / numWidgets : 0u, type));
+            }
+        };
+        f_add_widgets(_spec.codeboxes, CtAnchWidgType::CodeBox);
+        f_add_widgets(_spec.tables, CtAnchWidgType::TableHeavy);
+        f_add_widgets(_spec.images, CtAnchWidgType::ImagePng);
+        f_add_widgets(_spec.embFiles, CtAnchWidgType::ImageEmbFile);
+
+        std::vector<std::pair<int/*char_offset*/, CtAnchWidgType>> widgetsOffsets;
+        int charOffset{0};
+        auto f_add_text = [&](const std::string& text, const std::pair<std::string, std::string>* pTag){
+            xmlpp::Element* p_rich_text = p_node->add_child("rich_text");
+            if (pTag) {
+                p_rich_text->set_attribute(pTag->first, pTag->second);
+            }
+            p_rich_text->add_child_text(text);
+            charOffset += static_cast<int>(text.size()); // only ascii
+        };
+        size_t nextWidget{0u};
+        for (unsigned p = 0; p < _spec.paragraphs or nextWidget < widgetsAt.size(); ++p) {
+            if (p < _spec.paragraphs) {
+                for (unsigned t = 0; t < _spec.tagsPerParagraph; ++t) {
+                    f_add_text(_get_sentence(3u + _rand(5u)) + " ", nullptr);
+                    f_add_text(_get_sentence(1u + _rand(3u)), &benchTags.at(_rand(benchTags.size())));
+                    f_add_text(" ", nullptr);
+                }
+                f_add_text(_get_sentence(5u + _rand(5u)) + "\n", nullptr);
+            }
+            for (; nextWidget < widgetsAt.size() and widgetsAt[nextWidget].first <= p; ++nextWidget) {
+                // the char offset counts the anchors of the previous widgets
+                widgetsOffsets.push_back(std::make_pair(charOffset + static_cast<int>(nextWidget), widgetsAt[nextWidget].second));
+            }
+        }
+        for (const auto& widgetOffset : widgetsOffsets) {
+            switch (widgetOffset.second) {
+                case CtAnchWidgType::CodeBox: _add_codebox(p_node, widgetOffset.first); break;
+                case CtAnchWidgType::TableHeavy: _add_table(p_node, widgetOffset.first); break;
+                case CtAnchWidgType::ImagePng: _add_image(p_node, widgetOffset.first); break;
+                default: _add_emb_file(p_node, widgetOffset.first); break;
+            }
+        }
+    }
+
+    void _add_codebox(xmlpp::Element* p_node, const int charOffset)
+    {
+        xmlpp::Element* p_codebox = p_node->add_child("codebox");
+        p_codebox->set_attribute("char_offset", std::to_string(charOffset));
+        p_codebox->set_attribute("justification", "left");
+        p_codebox->set_attribute("frame_width", "500");
+        p_codebox->set_attribute("frame_height", "100");
+        p_codebox->set_attribute("width_in_pixels", "1");
+        p_codebox->set_attribute("syntax_highlighting", "cpp");
+        p_codebox->set_attribute("highlight_brackets", "1");
+        p_codebox->set_attribute("show_line_numbers", "0");
+        std::string code;
+        for (unsigned i = 0; i < 10u; ++i) {
+            code += "int var_" + std::to_string(i) + " = compute(" + std::to_string(_rand(1000u)) + "); // " + _get_sentence(4u) + "\n";
+        }
+        p_codebox->add_child_text(code);
+    }
+
+    void _add_table(xmlpp::Element* p_node, const int charOffset)
+    {
+        xmlpp::Element* p_table = p_node->add_child("table");
+        p_table->set_attribute("char_offset", std::to_string(charOffset));
+        p_table->set_attribute("justification", "left");
+        p_table->set_attribute("col_min", "60");
+        p_table->set_attribute("col_max", "60");
+        p_table->set_attribute("col_widths", "100,100,100");
+        if (++_numTables % 2u == 0u) {
+            p_table->set_attribute("is_light", "1");
+        }
+        // the header row is stored last
+        for (unsigned r = 0; r < 6u; ++r) {
+            xmlpp::Element* p_row = p_table->add_child("row");
+            for (unsigned c = 0; c < 3u; ++c) {
+                p_row->add_child("cell")->add_child_text(r < 5u ? _get_sentence(2u) : "header " + std::to_string(c));
+            }
+        }
+    }
+
+    void _add_image(xmlpp::Element* p_node, const int charOffset)
+    {
+        xmlpp::Element* p_image = p_node->add_child("encoded_png");
+        p_image->set_attribute("char_offset", std::to_string(charOffset));
+        p_image->set_attribute("justification", "left");
+        p_image->set_attribute("link", "");
+        p_image->add_child_text(_encodedPng);
+    }
+
+    void _add_emb_file(xmlpp::Element* p_node, const int charOffset)
+    {
+        xmlpp::Element* p_emb_file = p_node->add_child("encoded_png");
+        p_emb_file->set_attribute("char_offset", std::to_string(charOffset));
+        p_emb_file->set_attribute("justification", "left");
+        p_emb_file->set_attribute("filename", "file_" + std::to_string(_nodeId) + ".bin");
+        p_emb_file->set_attribute("time", "1600000000");
+        p_emb_file->add_child_text(_encodedEmbFile);
+    }
+
+    const CtBenchDocSpec& _spec;
+    std::mt19937          _randGen;
+    std::string           _encodedPng;
+    std::string           _encodedEmbFile;
+    unsigned              _nodeId{0u};
+    unsigned              _numTables{0u};
+    size_t                _numSearchMatches{0u};
+};
+
+} // namespace
+
+/*static*/CtBenchDocSpec CtBenchDocSpec::from_env()
+{
+    CtBenchDocSpec spec;
+    spec.nodes = bench_getenv_unsigned("CT_BENCH_NODES", spec.nodes);
+    spec.depth = std::max(1u, bench_getenv_unsigned("CT_BENCH_DEPTH", spec.depth));
+    spec.paragraphs = bench_getenv_unsigned("CT_BENCH_PARAGRAPHS", spec.paragraphs);
+    spec.tagsPerParagraph = bench_getenv_unsigned("CT_BENCH_TAGS", spec.tagsPerParagraph);
+    spec.codeboxes = bench_getenv_unsigned("CT_BENCH_CODEBOXES", spec.codeboxes);
+    spec.tables = bench_getenv_unsigned("CT_BENCH_TABLES", spec.tables);
+    spec.images = bench_getenv_unsigned("CT_BENCH_IMAGES", spec.images);
+    spec.embFiles = bench_getenv_unsigned("CT_BENCH_EMBFILES", spec.embFiles);
+    spec.seed = bench_getenv_unsigned("CT_BENCH_SEED", spec.seed);
+    return spec;
+}
+
+std::string CtBenchDocSpec::to_json() const
+{
+    return str::format("{\"nodes\": %s, \"depth\": %s, \"paragraphs\": %s, \"tags_per_paragraph\": %s, "
+                       "\"codeboxes\": %s, \"tables\": %s, \"images\": %s, \"emb_files\": %s, \"seed\": %s}",
+                       nodes, depth, paragraphs, tagsPerParagraph, codeboxes, tables, images, embFiles, seed);
+}
+
+size_t bench_generate_ctd(const CtBenchDocSpec& spec, const fs::path& ctd_filepath)
+{
+    return CtBenchDocGen{spec}.generate(ctd_filepath);
+}
+
+void CtBenchResults::add(const std::string& name, const Clock::time_point& start, const size_t count)
+{
+    CtBenchResult result;
+    result.name = name;
+    result.ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    result.count = count;
+    std::cout << "[bench] " << name << ": " << static_cast<long long>(result.ms) << " ms";
+    if (count) {
+        std::cout << " (" << count << ")";
+    }
+    std::cout << std::endl;
+    _results.push_back(result);
+}
+
+void CtBenchResults::write_json(const CtBenchDocSpec& spec) const
+{
+    std::ostringstream oss;
+    oss << "{\n  \"spec\": " << spec.to_json() << ",\n  \"results\": [";
+    for (size_t i = 0; i < _results.size(); ++i) {
+        oss << (i > 0u ? ",\n" : "\n") << "    {\"name\": \"" << _results[i].name << "\", \"ms\": " << _results[i].ms
+            << ", \"count\": " << _results[i].count << "}";
+    }
+    oss << "\n  ]\n}\n";
+    const char* pJsonPath = g_getenv("CT_BENCH_JSON");
+    if (pJsonPath and *pJsonPath) {
+        std::ofstream ofs{pJsonPath, std::ios::out | std::ios::trunc};
+        ofs << oss.str();
+    }
+    else {
+        std::cout << oss.str();
+    }
+}
@@ -0,0 +1,93 @@
+/*
+ * tests_bench_doc_gen.h
+ *
+ * Copyright 2009-2024
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#pragma once
+
+#include "ct_filesystem.h"
+#include "gtest/gtest.h"
+#include <chrono>
+#include <string>
+#include <vector>
+
+// What the synthetic benchmark document is made of, the same spec always gives the same document
+struct CtBenchDocSpec
+{
+    unsigned nodes{1000u};
+    unsigned depth{4u};              // max depth of the tree, 1 for top level nodes only
+    unsigned paragraphs{20u};        // per node
+    unsigned tagsPerParagraph{3u};   // rich text tags per paragraph of the rich text nodes
+    unsigned codeboxes{1u};          // per rich text node
+    unsigned tables{1u};             // per rich text node
+    unsigned images{1u};             // per rich text node
+    unsigned embFiles{1u};           // per rich text node
+    unsigned seed{1u};
+
+    // the defaults overridden by CT_BENCH_NODES, CT_BENCH_DEPTH, CT_BENCH_PARAGRAPHS, CT_BENCH_TAGS,
+    // CT_BENCH_CODEBOXES, CT_BENCH_TABLES, CT_BENCH_IMAGES, CT_BENCH_EMBFILES, CT_BENCH_SEED
+    static CtBenchDocSpec from_env();
+    std::string to_json() const;
+};
+
+// the word found in the text by the search benchmarks
+inline const char* BenchSearchWord{"needle"};
+
+// write the synthetic .ctd document, returns the number of matches of BenchSearchWord in it
+size_t bench_generate_ctd(const CtBenchDocSpec& spec, const fs::path& ctd_filepath);
+
+// The measurements of a run, printed while running and then written
+// as json to $CT_BENCH_JSON (or to stdout) so that builds can be compared
+class CtBenchResults
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    void add(const std::string& name, const Clock::time_point& start, const size_t count = 0u);
+    void write_json(const CtBenchDocSpec& spec) const;
+
+private:
+    struct CtBenchResult
+    {
+        std::string name;
+        double      ms{0.0};
+        size_t      count{0u};
+    };
+    std::vector<CtBenchResult> _results;
+};
+
+// The document and the results shared by the benchmarks of the run, the document is generated
+// before the first benchmark and the results are written after the last one
+class CtBenchEnvironment : public ::testing::Environment
+{
+public:
+    void SetUp() final;
+    void TearDown() final;
+
+    CtBenchDocSpec spec;
+    CtBenchResults results;
+    fs::path       tmpDirpath;
+    fs::path       ctdFilepath;
+    size_t         numSearchMatches{0u};
+};
+
+// registered with gtest in tests_bench_suite.cpp
+extern CtBenchEnvironment* const pBenchEnv;
@@ -0,0 +1,109 @@
+/*
+ * tests_bench_large_doc.cpp
+ *
+ * Copyright 2009-2024
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_app.h"
+#include "ct_misc_utils.h"
+#include "tests_common.h"
+#include "tests_bench_doc_gen.h"
+
+// NOTE: part of run_benchmarks, needs a display
+
+class BenchLargeDocCtApp : public CtApp
+{
+public:
+    BenchLargeDocCtApp()
+     : CtApp{"_bench_large_doc"}
+    {
+    }
+
+private:
+    void on_activate() final;
+
+    static void _flush_events();
+};
+
+/*static*/void BenchLargeDocCtApp::_flush_events()
+{
+    Glib::RefPtr<Glib::MainContext> rMainContext = Glib::MainContext::get_default();
+    while (rMainContext->pending()) {
+        rMainContext->iteration(false/*may_block*/);
+    }
+}
+
+void BenchLargeDocCtApp::on_activate()
+{
+    _on_startup();
+    CtMainWin* pWin = _create_window(false/*no_gui*/);
+    pWin->present();
+    _flush_events();
+
+    constexpr size_t targetBytes{50u*1024u*1024u};
+    std::string codeText;
+    codeText.reserve(targetBytes + 128u);
+    for (size_t i = 0; codeText.size() < targetBytes; ++i) {
+        codeText += "static int variable_" + std::to_string(i) + " = compute(" + std::to_string(i) + ", \"text\"); // comment\n";
+    }
+
+    CtBenchResults& results = pBenchEnv->results;
+    CtBenchResults::Clock::time_point start = CtBenchResults::Clock::now();
+    CtNodeData nodeData;
+    nodeData.nodeId = pWin->get_tree_store().node_id_get();
+    nodeData.name = "large code";
+    nodeData.syntax = "cpp";
+    nodeData.rTextBuffer = pWin->get_new_text_buffer(codeText);
+    const Gtk::TreeIter treeIter = pWin->get_tree_store().append_node(&nodeData);
+    results.add("large code node buffer load", start, codeText.size());
+
+    start = CtBenchResults::Clock::now();
+    pWin->get_tree_view().set_cursor_safe(treeIter);
+    _flush_events();
+    results.add("large code node select", start);
+    EXPECT_TRUE(pWin->get_text_view().get_large_doc_mode());
+
+    start = CtBenchResults::Clock::now();
+    Glib::RefPtr<Gtk::Adjustment> rVAdj = pWin->getScrolledwindowText().get_vadjustment();
+    constexpr int scrollSteps{100};
+    for (int i = 0; i <= scrollSteps; ++i) {
+        rVAdj->set_value((rVAdj->get_upper() - rVAdj->get_page_size()) * i / scrollSteps);
+        _flush_events();
+    }
+    results.add("large code node scroll", start, scrollSteps);
+
+    start = CtBenchResults::Clock::now();
+    Glib::RefPtr<Gtk::TextBuffer> rTextBuffer = pWin->get_text_view().get_buffer();
+    rTextBuffer->insert(rTextBuffer->end(), "int edited_at_end{0};\n");
+    _flush_events();
+    results.add("large code node edit at end", start);
+
+    pWin->force_exit() = true;
+    remove_window(*pWin);
+}
+
+TEST(BenchSuite, large_code_node_load_scroll_n_edit)
+{
+    BenchLargeDocCtApp benchCtApp{};
+    const std::vector<std::string> vec_args{"cherrytree"};
+    gchar** pp_args = CtStrUtil::vector_to_array(vec_args);
+    benchCtApp.run(vec_args.size(), pp_args);
+    g_strfreev(pp_args);
+}
@@ -0,0 +1,212 @@
+/*
+ * tests_bench_suite.cpp
+ *
+ * Copyright 2009-2024
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_app.h"
+#include "ct_actions.h"
+#include "ct_headless.h"
+#include "ct_storage_control.h"
+#include "ct_misc_utils.h"
+#include "tests_common.h"
+#include "tests_bench_doc_gen.h"
+
+// NOTE: built as the separate target run_benchmarks, not run by ctest, e.g.
+// CT_BENCH_NODES=5000 CT_BENCH_JSON=bench.json xvfb-run ./run_benchmarks
+// the BenchSuite.headless_* do not need a display
+
+void CtBenchEnvironment::SetUp()
+{
+    spec = CtBenchDocSpec::from_env();
+    gchar* pTmpDir = g_dir_make_tmp("ct_bench_XXXXXX", nullptr);
+    ASSERT_TRUE(pTmpDir);
+    tmpDirpath = pTmpDir;
+    g_free(pTmpDir);
+    ctdFilepath = tmpDirpath / "bench.ctd";
+    const CtBenchResults::Clock::time_point start = CtBenchResults::Clock::now();
+    numSearchMatches = bench_generate_ctd(spec, ctdFilepath);
+    results.add("generate ctd", start, spec.nodes);
+}
+
+void CtBenchEnvironment::TearDown()
+{
+    results.write_json(spec);
+    fs::remove_all(tmpDirpath);
+}
+
+CtBenchEnvironment* const pBenchEnv = static_cast<CtBenchEnvironment*>(::testing::AddGlobalTestEnvironment(new CtBenchEnvironment));
+
+class BenchSuiteCtApp : public CtApp
+{
+public:
+    BenchSuiteCtApp()
+     : CtApp{"_bench_suite"}
+    {
+        _no_gui = true;
+    }
+
+private:
+    void on_activate() final;
+
+    void _bench_open_n_save();
+    void _bench_edit_search_n_export();
+
+    static void _flush_events();
+};
+
+/*static*/void BenchSuiteCtApp::_flush_events()
+{
+    Glib::RefPtr<Glib::MainContext> rMainContext = Glib::MainContext::get_default();
+    while (rMainContext->pending()) {
+        rMainContext->iteration(false/*may_block*/);
+    }
+}
+
+void BenchSuiteCtApp::on_activate()
+{
+    _on_startup();
+    _bench_open_n_save();
+    _bench_edit_search_n_export();
+}
+
+void BenchSuiteCtApp::_bench_open_n_save()
+{
+    CtBenchResults& results = pBenchEnv->results;
+    CtMainWin* pWin = _create_window(true/*start_hidden*/);
+
+    CtBenchResults::Clock::time_point start = CtBenchResults::Clock::now();
+    ASSERT_TRUE(pWin->file_open(pBenchEnv->ctdFilepath, ""/*node_to_focus*/, ""/*anchor_to_focus*/));
+    _flush_events();
+    results.add("open ctd", start);
+
+    // the first save as only converts the nodes not loaded yet
+    for (const auto& docType : std::vector<std::pair<CtDocType, std::string>>{
+            {CtDocType::SQLite, "bench.ctb"},
+            {CtDocType::XML, "bench_save.ctd"},
+            {CtDocType::MultiFile, "bench_folder"}})
+    {
+        start = CtBenchResults::Clock::now();
+        Glib::ustring error;
+        std::unique_ptr<CtStorageControl> pStorage{CtStorageControl::save_as(
+            pWin, pBenchEnv->tmpDirpath / docType.second, docType.first, ""/*password*/, error, CtExporting::ALL_TREE)};
+        ASSERT_TRUE(pStorage) << error;
+        results.add("save as unloaded " + docType.second, start);
+    }
+
+    start = CtBenchResults::Clock::now();
+    CtSummaryInfo summaryInfo;
+    ASSERT_TRUE(pWin->get_tree_store().populate_summary_info(summaryInfo));
+    results.add("load all buffers", start, summaryInfo.nodes_rich_text_num + summaryInfo.nodes_plain_text_num + summaryInfo.nodes_code_num);
+
+    start = CtBenchResults::Clock::now();
+    {
+        Glib::ustring error;
+        std::unique_ptr<CtStorageControl> pStorage{CtStorageControl::save_as(
+            pWin, pBenchEnv->tmpDirpath / "bench_loaded.ctb", CtDocType::SQLite, ""/*password*/, error, CtExporting::ALL_TREE)};
+        ASSERT_TRUE(pStorage) << error;
+    }
+    results.add("save as loaded ctb", start);
+
+    pWin->force_exit() = true;
+    remove_window(*pWin);
+}
+
+void BenchSuiteCtApp::_bench_edit_search_n_export()
+{
+    CtBenchResults& results = pBenchEnv->results;
+    CtMainWin* pWin = _create_window(true/*start_hidden*/);
+
+    CtBenchResults::Clock::time_point start = CtBenchResults::Clock::now();
+    ASSERT_TRUE(pWin->file_open(pBenchEnv->tmpDirpath / "bench.ctb", ""/*node_to_focus*/, ""/*anchor_to_focus*/));
+    _flush_events();
+    results.add("open ctb", start);
+
+    // typing in one node, each step recorded in the undo history
+    CtTreeIter treeIter = pWin->get_tree_store().get_ct_iter_first();
+    ASSERT_TRUE(treeIter);
+    pWin->get_tree_view().set_cursor_safe(treeIter);
+    _flush_events();
+    constexpr size_t numEdits{200u};
+    start = CtBenchResults::Clock::now();
+    Glib::RefPtr<Gsv::Buffer> rTextBuffer = treeIter.get_node_text_buffer();
+    for (size_t i = 0; i < numEdits; ++i) {
+        rTextBuffer->insert(rTextBuffer->end(), "edited " + std::to_string(i) + "\n");
+        pWin->get_state_machine().update_state();
+    }
+    _flush_events();
+    results.add("edit n undo capture", start, numEdits);
+
+    // only the edited node is written
+    start = CtBenchResults::Clock::now();
+    ASSERT_TRUE(pWin->file_save(false/*need_vacuum*/));
+    results.add("save incremental ctb", start);
+
+    start = CtBenchResults::Clock::now();
+    const int numMatches = pWin->get_ct_actions()->find_in_all_nodes_auto(BenchSearchWord);
+    _flush_events();
+    results.add("find in all nodes", start, static_cast<size_t>(numMatches));
+
+    for (const auto& exportType : std::vector<std::string>{"txt", "html", "pdf"}) {
+        const fs::path exportDirpath = pBenchEnv->tmpDirpath / ("export_" + exportType);
+        g_mkdir_with_parents(exportDirpath.c_str(), 0755);
+        start = CtBenchResults::Clock::now();
+        if ("txt" == exportType) pWin->get_ct_actions()->export_to_txt_auto(exportDirpath.string(), true/*overwrite*/, false/*single_file*/);
+        else if ("html" == exportType) pWin->get_ct_actions()->export_to_html_auto(exportDirpath.string(), true/*overwrite*/, false/*single_file*/);
+        else pWin->get_ct_actions()->export_to_pdf_auto(exportDirpath.string(), true/*overwrite*/);
+        results.add("export " + exportType, start);
+    }
+
+    pWin->force_exit() = true;
+    remove_window(*pWin);
+}
+
+TEST(BenchSuite, headless_load_summary_n_export)
+{
+    CtBenchResults& results = pBenchEnv->results;
+    CtBenchResults::Clock::time_point start = CtBenchResults::Clock::now();
+    Glib::ustring error;
+    std::unique_ptr<CtHeadlessDoc> pHeadlessDoc = CtHeadlessDoc::load(pBenchEnv->ctdFilepath, error);
+    ASSERT_TRUE(pHeadlessDoc) << error;
+    results.add("headless load ctd", start);
+
+    start = CtBenchResults::Clock::now();
+    const CtSummaryInfo summaryInfo = pHeadlessDoc->get_summary_info();
+    const size_t numNodes = summaryInfo.nodes_rich_text_num + summaryInfo.nodes_plain_text_num + summaryInfo.nodes_code_num;
+    results.add("headless summary", start, numNodes);
+    ASSERT_EQ(pBenchEnv->spec.nodes, numNodes);
+
+    const fs::path exportDirpath = pBenchEnv->tmpDirpath / "headless_export";
+    g_mkdir_with_parents(exportDirpath.c_str(), 0755);
+    start = CtBenchResults::Clock::now();
+    CtExportOptions exportOptions;
+    exportOptions.single_file = true;
+    pHeadlessDoc->export_to_txt_auto(exportDirpath, true/*overwrite*/, exportOptions, "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~");
+    results.add("headless export txt", start);
+}
+
+TEST(BenchSuite, open_edit_save_search_n_export)
+{
+    BenchSuiteCtApp benchCtApp{};
+    const std::vector<std::string> vec_args{"cherrytree"};
+    gchar** pp_args = CtStrUtil::vector_to_array(vec_args);
+    benchCtApp.run(vec_args.size(), pp_args);
+    g_strfreev(pp_args);
+}
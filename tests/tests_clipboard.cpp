@@ -22,7 +22,10 @@
  */
 
 #include "ct_clipboard.h"
+#include "ct_parser.h"
+#include "ct_config.h"
 #include "tests_common.h"
+#include <gdkmm/wrap_init.h>
 
 TEST(ClipboardGroup, ms_clip_convert)
 {
@@ -43,3 +46,34 @@ TEST(ClipboardGroup, ms_clip_convert)
     ASSERT_STREQ(html.c_str(), converted_2.c_str());
 #endif
 }
+
+TEST(ClipboardGroup, html_images_to_xml)
+{
+    Gio::init();
+    Gdk::wrap_init();
+    const std::string imagePath{Glib::build_filename(UT::unitTestsDataDir, "image_2x2.png")};
+    const std::string imageRaw = Glib::file_get_contents(imagePath);
+    const std::string html = "<!DOCTYPE HTML><html><body>"
+        "ab<img src=\"image_2x2.png\">"
+        "cd<img src=\"missing_image.png\">"
+        "ef<img src=\"data:image/png;base64," + Glib::Base64::encode(imageRaw) + "\">"
+        "gh</body></html>";
+
+    CtConfig ct_config;
+    CtHtml2Xml html2xml{&ct_config};
+    html2xml.set_local_dir(UT::unitTestsDataDir);
+    html2xml.feed(html);
+
+    std::vector<const xmlpp::Element*> images;
+    for (const xmlpp::Node* pNode : html2xml.doc().get_root_node()->get_first_child("slot")->get_children("encoded_png")) {
+        images.push_back(static_cast<const xmlpp::Element*>(pNode));
+    }
+    // the missing image is dropped and the following offsets are moved back
+    ASSERT_EQ(2u, images.size());
+    ASSERT_STREQ("2", images.at(0)->get_attribute_value("char_offset").c_str());
+    ASSERT_STREQ("7", images.at(1)->get_attribute_value("char_offset").c_str());
+    // already png, the original bytes are kept
+    for (const xmlpp::Element* pImage : images) {
+        ASSERT_EQ(imageRaw, Glib::Base64::decode(pImage->get_child_text()->get_content()));
+    }
+}
@@ -23,6 +23,8 @@
 
 #include "ct_app.h"
 #include "ct_misc_utils.h"
+#include "ct_export2pdf.h"
+#include "ct_code_markup.h"
 #include "tests_common.h"
 
 class TestCtApp : public CtApp
@@ -36,15 +38,25 @@ public:
     }
     CtTmp* getCtTmp() { return _uCtTmp.get(); }
     void register_args(const std::vector<std::string>* pVecArgs) { _pVecArgs = pVecArgs; }
+    // run on a new window instead of an export from the arguments
+    void register_f_test(std::function<void(CtMainWin*)> f_test) { _f_test = f_test; }
 
 private:
     void on_activate() final;
 
     const std::vector<std::string>* _pVecArgs{nullptr};
+    std::function<void(CtMainWin*)> _f_test;
 };
 
 void TestCtApp::on_activate()
 {
+    if (_f_test) {
+        CtMainWin* pWin = _create_window(true/*start_hidden*/);
+        _f_test(pWin);
+        pWin->force_exit() = true;
+        remove_window(*pWin);
+        return;
+    }
     // NOTE: on windows/msys2 unit tests the passed arguments do not work so we end up here
     ASSERT_TRUE(_pVecArgs);
     if (_pVecArgs->at(2) == "--export_to_txt_dir") {
@@ -139,3 +151,214 @@ INSTANTIATE_TEST_CASE_P(
             std::make_tuple(UT::testCtbDocPath, "--export_to_html_dir"),
             std::make_tuple(UT::testCtdDocPath, "--export_to_html_dir"))
 );
+
+TEST(ExportsGroup, pdf_layouts_in_parallel_same_pagination)
+{
+    TestCtApp testCtApp{};
+    fs::path tmpDirpath = testCtApp.getCtTmp()->getHiddenDirPath("UT");
+    testCtApp.register_f_test([&tmpDirpath](CtMainWin* pWin){
+        ASSERT_TRUE(pWin->file_open(UT::testCtbDocPath, ""/*node_to_focus*/, ""/*anchor_to_focus*/, ""/*password*/));
+        CtPrint& ctPrint = pWin->get_ct_print();
+        ctPrint.set_layout_threads_max(1u);
+        pWin->get_ct_actions()->export_to_pdf_auto((tmpDirpath / "serial").string(), true/*overwrite*/);
+        const std::vector<std::vector<int>> pagesLinesYSerial = ctPrint.get_last_pages_lines_y();
+        ctPrint.set_layout_threads_max(8u);
+        pWin->get_ct_actions()->export_to_pdf_auto((tmpDirpath / "parallel").string(), true/*overwrite*/);
+        const std::vector<std::vector<int>> pagesLinesYParallel = ctPrint.get_last_pages_lines_y();
+        ctPrint.set_layout_threads_max(0u);
+        ASSERT_FALSE(pagesLinesYSerial.empty());
+        ASSERT_EQ(pagesLinesYSerial, pagesLinesYParallel);
+    });
+    const std::vector<std::string> vec_args{"cherrytree"};
+    gchar** pp_args = CtStrUtil::vector_to_array(vec_args);
+    testCtApp.run(vec_args.size(), pp_args);
+    g_strfreev(pp_args);
+}
+
+TEST(ExportsGroup, txt_nodes_formatted_in_parallel_same_output)
+{
+    TestCtApp testCtApp{};
+    fs::path tmpDirpath = testCtApp.getCtTmp()->getHiddenDirPath("UT");
+    testCtApp.register_f_test([&tmpDirpath](CtMainWin* pWin){
+        ASSERT_TRUE(pWin->file_open(UT::testCtbDocPath, ""/*node_to_focus*/, ""/*anchor_to_focus*/, ""/*password*/));
+        const std::string txtFilename = Glib::path_get_basename(UT::testCtbDocPath) + ".txt";
+        for (const char* subdir : {"serial", "parallel"}) {
+            ASSERT_EQ(0, g_mkdir_with_parents((tmpDirpath / subdir).c_str(), 0777));
+        }
+        pWin->get_ct_actions()->export_to_txt_auto((tmpDirpath / "serial").string(), true/*overwrite*/, true/*single_file*/, 1/*jobs*/);
+        pWin->get_ct_actions()->export_to_txt_auto((tmpDirpath / "parallel").string(), true/*overwrite*/, true/*single_file*/, 4/*jobs*/);
+        const std::string serialTxt = Glib::file_get_contents((tmpDirpath / "serial" / txtFilename).string());
+        const std::string parallelTxt = Glib::file_get_contents((tmpDirpath / "parallel" / txtFilename).string());
+        const std::string expectTxt = Glib::file_get_contents(Glib::build_filename(UT::unitTestsDataDir, "test.export.txt"));
+        ASSERT_FALSE(serialTxt.empty());
+        ASSERT_STREQ(serialTxt.c_str(), parallelTxt.c_str());
+#if defined(_WIN32)
+        ASSERT_STREQ(str::replace(expectTxt, "\n", "\r\n").c_str(), parallelTxt.c_str());
+#else
+        ASSERT_STREQ(expectTxt.c_str(), parallelTxt.c_str());
+#endif
+    });
+    const std::vector<std::string> vec_args{"cherrytree"};
+    gchar** pp_args = CtStrUtil::vector_to_array(vec_args);
+    testCtApp.run(vec_args.size(), pp_args);
+    g_strfreev(pp_args);
+}
+
+// the char by char serializer that CtCodeMarkup replaced, as reference
+static Glib::ustring former_code_markup(const Glib::RefPtr<Gsv::Buffer>& code_buffer,
+                                        const int sel_start,
+                                        const int sel_end,
+                                        const CtCodeMarkup::Target target,
+                                        const int tabs_to_spaces)
+{
+    Gtk::TextIter curr_iter = sel_start >= 0 ? code_buffer->get_iter_at_offset(sel_start) : code_buffer->begin();
+    Gtk::TextIter end_iter = sel_end >= 0 ? code_buffer->get_iter_at_offset(sel_end) : code_buffer->end();
+    code_buffer->ensure_highlight(curr_iter, end_iter);
+    const Glib::ustring indentation = str::repeat(CtConst::CHAR_SPACE, tabs_to_spaces);
+    Glib::ustring markup_text;
+    Glib::ustring former_tag_str = CtConst::COLOR_48_BLACK;
+    bool span_opened{false};
+    bool is_indentation{true};
+    for (;;) {
+        auto curr_tags = curr_iter.get_tags();
+        if (not curr_tags.empty()) {
+            Glib::ustring curr_tag_str = curr_tags[0]->property_foreground_gdk().get_value().to_string();
+            const int font_weight = curr_tags[0]->property_weight().get_value();
+            if (curr_tag_str == CtConst::COLOR_48_BLACK) {
+                if (former_tag_str != curr_tag_str) {
+                    former_tag_str = curr_tag_str;
+                    markup_text += "</span>";
+                    span_opened = false;
+                }
+            }
+            else if (former_tag_str != curr_tag_str) {
+                former_tag_str = curr_tag_str;
+                if (span_opened) markup_text += "</span>";
+                if (CtCodeMarkup::Target::Html == target) {
+                    const Glib::ustring color = CtRgbUtil::get_rgb24str_from_str_any(CtRgbUtil::rgb_to_no_white(curr_tag_str));
+                    markup_text += "<span style=\"color:" + color + ";font-weight:" + std::to_string(font_weight) + "\">";
+                }
+                else {
+                    markup_text += "<span foreground=\"" + curr_tag_str + "\" font_weight=\"" + std::to_string(font_weight) + "\">";
+                }
+                span_opened = true;
+            }
+        }
+        else if (span_opened) {
+            span_opened = false;
+            former_tag_str = CtConst::COLOR_48_BLACK;
+            markup_text += "</span>";
+        }
+        const gunichar curr_char = curr_iter.get_char();
+        if (tabs_to_spaces > 0 and is_indentation and '\t' == curr_char) {
+            markup_text += indentation;
+        }
+        else {
+            is_indentation = '\n' == curr_char;
+            markup_text += str::xml_escape(Glib::ustring(1, curr_char));
+        }
+        if (not curr_iter.forward_char() or (sel_end >= 0 and curr_iter.get_offset() >= sel_end)) {
+            if (span_opened) markup_text += "</span>";
+            break;
+        }
+    }
+    if (CtCodeMarkup::Target::Html == target) {
+        markup_text = str::replace(markup_text, CtConst::CHAR_NEWLINE, "<br />");
+    }
+    return markup_text;
+}
+
+TEST(ExportsGroup, code_markup_same_as_former_serializer)
+{
+    TestCtApp testCtApp{};
+    testCtApp.register_f_test([](CtMainWin* pWin){
+        const Glib::ustring codeText{
+            "#include <stdio.h>\n"
+            "// cpp comment with & \"quotes\" and 'apostrophes' àèìòù\n"
+            "int main(int argc, char* argv[])\n"
+            "{\n"
+            "\tif (argc > 1 && argv[1][0] == '<') {\n"
+            "\t\tprintf(\"%s &amp; <b>\\n\", argv[1]); /* c comment */\n"
+            "\t}\n"
+            "\treturn 0; // \tnot indentation\n"
+            "}\n"};
+        const int tabsWidth = pWin->get_ct_config()->tabsWidth;
+        Glib::RefPtr<Gsv::Buffer> rCodeBuffer = pWin->get_new_text_buffer(codeText);
+        pWin->apply_syntax_highlighting(rCodeBuffer, "cpp", false/*forceReApply*/);
+        CtCodeMarkup::cache_clear();
+
+        const Glib::ustring htmlMarkup = CtCodeMarkup::get_markup(pWin, rCodeBuffer, -1, -1, "cpp", CtCodeMarkup::Target::Html);
+        ASSERT_NE(std::string::npos, htmlMarkup.find("<span style=\"color:"));
+        ASSERT_STREQ(former_code_markup(rCodeBuffer, -1, -1, CtCodeMarkup::Target::Html, 0).c_str(), htmlMarkup.c_str());
+
+        const Glib::ustring pangoMarkup = CtCodeMarkup::get_markup(pWin, rCodeBuffer, -1, -1, "cpp", CtCodeMarkup::Target::Pango);
+        ASSERT_NE(std::string::npos, pangoMarkup.find("<span foreground=\""));
+        ASSERT_STREQ(former_code_markup(rCodeBuffer, -1, -1, CtCodeMarkup::Target::Pango, tabsWidth).c_str(), pangoMarkup.c_str());
+
+        // a selection starting and ending inside the highlighted runs
+        const int selStart = codeText.find("main");
+        const int selEnd = codeText.find("/* c comment") + 5;
+        ASSERT_STREQ(former_code_markup(rCodeBuffer, selStart, selEnd, CtCodeMarkup::Target::Html, 0).c_str(),
+                     CtCodeMarkup::get_markup(pWin, rCodeBuffer, selStart, selEnd, "cpp", CtCodeMarkup::Target::Html).c_str());
+
+        // plain text for pango is neither highlighted nor the tabs replaced
+        Glib::RefPtr<Gsv::Buffer> rPlainBuffer = pWin->get_new_text_buffer(codeText);
+        ASSERT_STREQ(str::xml_escape(codeText).c_str(),
+                     CtCodeMarkup::get_markup(pWin, rPlainBuffer, -1, -1, CtConst::PLAIN_TEXT_ID, CtCodeMarkup::Target::Pango).c_str());
+        ASSERT_EQ(4u, CtCodeMarkup::get_cache_num_entries());
+        CtCodeMarkup::cache_clear();
+    });
+    const std::vector<std::string> vec_args{"cherrytree"};
+    gchar** pp_args = CtStrUtil::vector_to_array(vec_args);
+    testCtApp.run(vec_args.size(), pp_args);
+    g_strfreev(pp_args);
+}
+
+TEST(ExportsGroup, code_markup_cache_hit_and_eviction)
+{
+    TestCtApp testCtApp{};
+    testCtApp.register_f_test([](CtMainWin* pWin){
+        // plain text for pango has the markup as large as the text, the cache holds up to 16MiB
+        auto f_get_markup = [pWin](const size_t bytes, const char ch)->Glib::ustring{
+            std::string text(bytes, ch);
+            for (size_t i = 99u; i < bytes; i += 100u) text[i] = '\n';
+            Glib::RefPtr<Gsv::Buffer> rBuffer = pWin->get_new_text_buffer(text);
+            const Glib::ustring markup = CtCodeMarkup::get_markup(pWin, rBuffer, -1, -1, CtConst::PLAIN_TEXT_ID, CtCodeMarkup::Target::Pango);
+            EXPECT_EQ(bytes, markup.bytes());
+            return markup;
+        };
+        const size_t MiB{1024u*1024u};
+        const size_t bytesA{35u*MiB/10u}, bytesB{36u*MiB/10u}, bytesC{37u*MiB/10u}, bytesD{38u*MiB/10u}, bytesE{39u*MiB/10u};
+        CtCodeMarkup::cache_clear();
+        (void)f_get_markup(bytesA, 'a');
+        (void)f_get_markup(bytesB, 'b');
+        (void)f_get_markup(bytesC, 'c');
+        (void)f_get_markup(bytesD, 'd');
+        ASSERT_EQ(4u, CtCodeMarkup::get_cache_num_entries());
+        ASSERT_EQ(bytesA+bytesB+bytesC+bytesD, CtCodeMarkup::get_cache_bytes());
+
+        // the same content from another buffer is a hit, A becomes the most recently used
+        (void)f_get_markup(bytesA, 'a');
+        ASSERT_EQ(4u, CtCodeMarkup::get_cache_num_entries());
+        ASSERT_EQ(bytesA+bytesB+bytesC+bytesD, CtCodeMarkup::get_cache_bytes());
+
+        // over 16MiB the least recently used B is evicted
+        (void)f_get_markup(bytesE, 'e');
+        ASSERT_EQ(4u, CtCodeMarkup::get_cache_num_entries());
+        ASSERT_EQ(bytesA+bytesC+bytesD+bytesE, CtCodeMarkup::get_cache_bytes());
+
+        // B is a miss, back in place of C
+        (void)f_get_markup(bytesB, 'b');
+        ASSERT_EQ(bytesA+bytesB+bytesD+bytesE, CtCodeMarkup::get_cache_bytes());
+
+        // a markup over a quarter of the cache is not kept
+        (void)f_get_markup(41u*MiB/10u, 'f');
+        ASSERT_EQ(bytesA+bytesB+bytesD+bytesE, CtCodeMarkup::get_cache_bytes());
+        CtCodeMarkup::cache_clear();
+        ASSERT_EQ(0u, CtCodeMarkup::get_cache_num_entries());
+    });
+    const std::vector<std::string> vec_args{"cherrytree"};
+    gchar** pp_args = CtStrUtil::vector_to_array(vec_args);
+    testCtApp.run(vec_args.size(), pp_args);
+    g_strfreev(pp_args);
+}
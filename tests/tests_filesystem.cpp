@@ -22,8 +22,10 @@
  */
 
 #include "ct_filesystem.h"
+#include "ct_storage_multifile.h"
 #include "tests_common.h"
 #include <glibmm.h>
+#include <glib/gstdio.h>
 
 TEST(FileSystemGroup, path_stem)
 {
@@ -205,6 +207,47 @@ TEST(FileSystemGroup, move)
     ASSERT_EQ(3, fs::remove_all(test_dir_path2));
 }
 
+TEST(FileSystemGroup, multifile_blobs)
+{
+    fs::path test_dir_path1 = fs::path{UT::unitTestsDataDir} / fs::path{"test_blob_dir1"};
+    fs::path test_dir_path2 = fs::path{UT::unitTestsDataDir} / fs::path{"test_blob_dir2"};
+    if (fs::exists(test_dir_path1)) fs::remove_all(test_dir_path1);
+    if (fs::exists(test_dir_path2)) fs::remove_all(test_dir_path2);
+    ASSERT_EQ(0, g_mkdir_with_parents(test_dir_path1.c_str(), 0755));
+    ASSERT_EQ(0, g_mkdir_with_parents(test_dir_path2.c_str(), 0755));
+
+    const std::string rawBlob{"blabla blob"};
+    const std::string sha256sum = CtStorageMultiFile::save_blob(rawBlob, test_dir_path1.string(), ".png");
+    ASSERT_EQ(64u, sha256sum.size());
+    ASSERT_TRUE(fs::is_regular_file(test_dir_path1 / fs::path{sha256sum + ".png"}));
+    // the same blob referenced from another node directory is an own copy
+    ASSERT_STREQ(sha256sum.c_str(), CtStorageMultiFile::save_blob(rawBlob, test_dir_path2.string(), ".png").c_str());
+    ASSERT_TRUE(fs::is_regular_file(test_dir_path2 / fs::path{sha256sum + ".png"}));
+    GStatBuf statBuf;
+    ASSERT_EQ(0, g_stat((test_dir_path2 / fs::path{sha256sum + ".png"}).c_str(), &statBuf));
+    ASSERT_EQ(1, statBuf.st_nlink);
+    ASSERT_STREQ(sha256sum.c_str(), CtStorageMultiFile::save_blob(rawBlob, test_dir_path2.string(), ".png").c_str());
+    ASSERT_EQ(1, fs::get_dir_entries(test_dir_path2).size());
+
+    std::string readBlob;
+    ASSERT_TRUE(CtStorageMultiFile::read_blob(test_dir_path2.string(), sha256sum, readBlob));
+    ASSERT_STREQ(rawBlob.c_str(), readBlob.c_str());
+    ASSERT_FALSE(CtStorageMultiFile::read_blob(test_dir_path2.string(), std::string(64, '0'), readBlob));
+
+    // a blob added from outside is found once the index is dropped
+    const std::string rawBlob2{"another blob"};
+    const std::string sha256sum2 = Glib::Checksum::compute_checksum(Glib::Checksum::ChecksumType::CHECKSUM_SHA256, rawBlob2);
+    Glib::file_set_contents((test_dir_path1 / fs::path{sha256sum2 + ".txt"}).string(), rawBlob2);
+    CtStorageMultiFile::blob_index_forget(test_dir_path1.string());
+    ASSERT_TRUE(CtStorageMultiFile::read_blob(test_dir_path1.string(), sha256sum2, readBlob));
+    ASSERT_STREQ(rawBlob2.c_str(), readBlob.c_str());
+
+    CtStorageMultiFile::blob_index_forget(test_dir_path1.string());
+    CtStorageMultiFile::blob_index_forget(test_dir_path2.string());
+    ASSERT_EQ(3, fs::remove_all(test_dir_path1));
+    ASSERT_EQ(2, fs::remove_all(test_dir_path2));
+}
+
 TEST(FileSystemGroup, relative)
 {
 #ifdef _WIN32
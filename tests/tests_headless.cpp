@@ -0,0 +1,104 @@
+/*
+ * tests_headless.cpp
+ *
+ * Copyright 2009-2024
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_headless.h"
+#include "ct_misc_utils.h"
+#include "tests_common.h"
+#include <glibmm.h>
+
+class HeadlessDocMultipleParametersTests : public ::testing::TestWithParam<std::string>
+{
+};
+
+TEST_P(HeadlessDocMultipleParametersTests, summary_info)
+{
+    Glib::ustring error;
+    std::unique_ptr<CtHeadlessDoc> pHeadlessDoc = CtHeadlessDoc::load(GetParam(), error);
+    ASSERT_TRUE(pHeadlessDoc) << error;
+    ASSERT_TRUE(error.empty());
+
+    const CtSummaryInfo summaryInfo = pHeadlessDoc->get_summary_info();
+    ASSERT_EQ(4u, summaryInfo.nodes_rich_text_num);
+    ASSERT_EQ(1u, summaryInfo.nodes_plain_text_num);
+    ASSERT_EQ(5u, summaryInfo.nodes_code_num);
+    ASSERT_EQ(2u, summaryInfo.nodes_shared_tot);
+    ASSERT_EQ(1u, summaryInfo.nodes_shared_groups);
+    ASSERT_EQ(1u, summaryInfo.images_num);
+    ASSERT_EQ(1u, summaryInfo.latexes_num);
+    ASSERT_EQ(1u, summaryInfo.embfile_num);
+    ASSERT_EQ(1u, summaryInfo.heavytables_num);
+    ASSERT_EQ(1u, summaryInfo.lighttables_num);
+    ASSERT_EQ(1u, summaryInfo.codeboxes_num);
+    ASSERT_EQ(1u, summaryInfo.anchors_num);
+    ASSERT_LT(0u, summaryInfo.words_num);
+    ASSERT_LT(summaryInfo.words_num, summaryInfo.chars_num);
+}
+
+TEST_P(HeadlessDocMultipleParametersTests, export_to_txt_single_file)
+{
+    Glib::ustring error;
+    std::unique_ptr<CtHeadlessDoc> pHeadlessDoc = CtHeadlessDoc::load(GetParam(), error);
+    ASSERT_TRUE(pHeadlessDoc) << error;
+
+    gchar* pTmpDir = g_dir_make_tmp("ct_headless_XXXXXX", nullptr);
+    ASSERT_TRUE(pTmpDir);
+    const fs::path tmpDirpath{pTmpDir};
+    g_free(pTmpDir);
+    CtExportOptions exportOptions;
+    exportOptions.single_file = true;
+    exportOptions.jobs = 2;
+    pHeadlessDoc->export_to_txt_auto(tmpDirpath, false/*overwrite*/, exportOptions, "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~");
+    const fs::path tmpFilepath = tmpDirpath / (Glib::path_get_basename(GetParam()) + ".txt");
+    ASSERT_TRUE(fs::is_regular_file(tmpFilepath));
+
+    const std::string expectTxt = Glib::file_get_contents(Glib::build_filename(UT::unitTestsDataDir, "test.export.txt"));
+    const std::string resultTxt = Glib::file_get_contents(tmpFilepath.string());
+#if defined(_WIN32)
+    ASSERT_STREQ(str::replace(expectTxt, "\n", "\r\n").c_str(), resultTxt.c_str());
+#else
+    ASSERT_STREQ(expectTxt.c_str(), resultTxt.c_str());
+#endif
+    ASSERT_NE(std::string::npos, resultTxt.find("# йцукенгшщз\n"));
+
+    // the node names are left out as from the window
+    exportOptions.include_node_name = false;
+    pHeadlessDoc->export_to_txt_auto(tmpDirpath, true/*overwrite*/, exportOptions, "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~");
+    const std::string resultNoNamesTxt = Glib::file_get_contents(tmpFilepath.string());
+    ASSERT_EQ(std::string::npos, resultNoNamesTxt.find("# йцукенгшщз\n"));
+    ASSERT_GT(resultTxt.size(), resultNoNamesTxt.size());
+    ASSERT_LT(0u, fs::remove_all(tmpDirpath));
+}
+
+INSTANTIATE_TEST_CASE_P(
+        HeadlessDocTests,
+        HeadlessDocMultipleParametersTests,
+        ::testing::Values(UT::testCtbDocPath, UT::testCtdDocPath));
+
+TEST(HeadlessDocGroup, not_supported)
+{
+    ASSERT_FALSE(CtHeadlessDoc::is_supported(UT::testCtzDocPath));
+    ASSERT_FALSE(CtHeadlessDoc::is_supported(UT::testMultiFilePath));
+    Glib::ustring error;
+    ASSERT_FALSE(CtHeadlessDoc::load(UT::testCtxDocPath, error));
+    ASSERT_FALSE(error.empty());
+}
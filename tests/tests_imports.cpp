@@ -0,0 +1,68 @@
+/*
+ * tests_imports.cpp
+ *
+ * Copyright 2009-2024
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_imports.h"
+#include "ct_config.h"
+#include "tests_common.h"
+
+namespace {
+
+class CtZimImportSerial : public CtZimImport
+{
+public:
+    using CtZimImport::CtZimImport;
+    std::unique_ptr<CtImporterInterface> clone() override { return nullptr; }
+};
+
+std::string imported_nodes_to_string(const CtImportedNode* pNode)
+{
+    std::string ret = pNode->node_name.raw();
+    if (pNode->xml_content->get_root_node()) {
+        ret += "(" + pNode->xml_content->write_to_string().raw() + ")";
+    }
+    for (const auto& pChild : pNode->children) {
+        ret += "[" + imported_nodes_to_string(pChild.get()) + "]";
+    }
+    return ret;
+}
+
+} // namespace (anonymous)
+
+TEST(ImportsGroup, traverse_dir_parallel_as_serial)
+{
+    CtConfig ct_config;
+    const fs::path zimDir{Glib::build_filename(UT::unitTestsDataDir, "ZimWiki")};
+
+    CtZimImportSerial importerSerial{&ct_config};
+    std::unique_ptr<CtImportedNode> pSerialNodes = CtImports::traverse_dir(zimDir, &importerSerial);
+    CtZimImport importerParallel{&ct_config};
+    std::unique_ptr<CtImportedNode> pParallelNodes = CtImports::traverse_dir(zimDir, &importerParallel);
+
+    ASSERT_TRUE(pSerialNodes);
+    ASSERT_TRUE(pParallelNodes);
+    // Home.txt joined with the Home directory
+    ASSERT_EQ(1u, pParallelNodes->children.size());
+    ASSERT_STREQ("Home", pParallelNodes->children.front()->node_name.c_str());
+    ASSERT_TRUE(pParallelNodes->children.front()->has_content());
+    ASSERT_EQ(imported_nodes_to_string(pSerialNodes.get()), imported_nodes_to_string(pParallelNodes.get()));
+}
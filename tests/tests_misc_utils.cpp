@@ -25,6 +25,8 @@
 #include "ct_const.h"
 #include "ct_filesystem.h"
 #include "tests_common.h"
+#include <gtkmm/treestore.h>
+#include <clocale>
 #include <thread>
 
 TEST(MiscUtilsGroup, get_encoding)
@@ -240,6 +242,81 @@ TEST(MiscUtilsGroup, natural_compare)
     ASSERT_TRUE(CtStrUtil::natural_compare("Alpha 2 B","Alpha 2") > 0);
 }
 
+TEST(MiscUtilsGroup, natural_sort_key)
+{
+    // same order as natural_compare on the lowercase text
+    const std::vector<Glib::ustring> texts{"", "a", "9", "1", "2", "3", "a1", "a2", "a1a2", "a1a3", "a1a0", "134", "122",
+                                           "12a3", "12a1", "12a0", "12a2", "aa", "aaa", "Alpha 2", "Alpha 2A", "Alpha 2 B",
+                                           "ab1", "1a", "B", "node 10", "Node 9", "node 09"};
+    for (const auto& left : texts) {
+        for (const auto& right : texts) {
+            const int cmp = CtStrUtil::natural_compare(left.lowercase(), right.lowercase());
+            const int keyCmp = CtStrUtil::natural_sort_key_compare(CtStrUtil::natural_sort_key(left), CtStrUtil::natural_sort_key(right));
+            ASSERT_EQ(cmp < 0, keyCmp < 0) << left << " " << right;
+            ASSERT_EQ(cmp > 0, keyCmp > 0) << left << " " << right;
+        }
+    }
+    // the leading zeros do not count, the case neither
+    ASSERT_EQ(0, CtStrUtil::natural_sort_key_compare(CtStrUtil::natural_sort_key("Node 007"), CtStrUtil::natural_sort_key("node 7")));
+    ASSERT_GT(0, CtStrUtil::natural_sort_key_compare(CtStrUtil::natural_sort_key("entry 2"), CtStrUtil::natural_sort_key("Entry 10")));
+}
+
+TEST(MiscUtilsGroup, natural_sort_key_with_locale_collation)
+{
+    // the collation of a whole run differs from the one character by character of natural_compare,
+    // e.g. en_US ignores the punctuation at the first level
+    const std::string prevLocale{setlocale(LC_COLLATE, nullptr)};
+    if (not setlocale(LC_COLLATE, "en_US.UTF-8")) {
+        GTEST_SKIP() << "en_US.UTF-8 not available";
+    }
+    auto on_scope_exit = scope_guard([&](void*) { setlocale(LC_COLLATE, prevLocale.c_str()); });
+    const std::vector<Glib::ustring> texts{"a-c", "ab", "a c", "ac", "a_b", "a.b", "a-1", "a1", "é", "e", "f",
+                                           "node-10", "node 9", "node10", "Ab", "a-C"};
+    for (const auto& left : texts) {
+        for (const auto& right : texts) {
+            const int cmp = CtStrUtil::natural_compare(left.casefold(), right.casefold());
+            const int keyCmp = CtStrUtil::natural_sort_key_compare(CtStrUtil::natural_sort_key(left), CtStrUtil::natural_sort_key(right));
+            ASSERT_EQ(cmp < 0, keyCmp < 0) << left << " " << right;
+            ASSERT_EQ(cmp > 0, keyCmp > 0) << left << " " << right;
+        }
+    }
+}
+
+TEST(MiscUtilsGroup, tree_levels_sort)
+{
+    Gtk::TreeModelColumnRecord columns;
+    Gtk::TreeModelColumn<Glib::ustring> nameColumn;
+    columns.add(nameColumn);
+    Glib::RefPtr<Gtk::TreeStore> rStore = Gtk::TreeStore::create(columns);
+    for (const char* name : {"node 10", "Node 9", "b", "a"}) {
+        rStore->append()->set_value(nameColumn, Glib::ustring{name});
+    }
+    Gtk::TreeIter parentIter = rStore->children().begin();
+    // x01 and x1 have the same sort key, the sort is stable
+    for (const char* name : {"x2", "x10", "x01", "x1"}) {
+        rStore->append(parentIter->children())->set_value(nameColumn, Glib::ustring{name});
+    }
+    auto f_names = [&](const Gtk::TreeNodeChildren& children)->std::vector<Glib::ustring>{
+        std::vector<Glib::ustring> names;
+        for (const Gtk::TreeRow& row : children) {
+            names.push_back(row.get_value(nameColumn));
+        }
+        return names;
+    };
+
+    ASSERT_TRUE(CtMiscUtil::tree_levels_sort(rStore, {Gtk::TreeIter{}, parentIter}, nameColumn, true/*ascending*/));
+    ASSERT_EQ(std::vector<Glib::ustring>({"a", "b", "Node 9", "node 10"}), f_names(rStore->children()));
+    // the parent iter is still valid after the reorder
+    ASSERT_EQ(Glib::ustring{"node 10"}, parentIter->get_value(nameColumn));
+    ASSERT_EQ(std::vector<Glib::ustring>({"x01", "x1", "x2", "x10"}), f_names(parentIter->children()));
+    // nothing to do if already in order
+    ASSERT_FALSE(CtMiscUtil::tree_levels_sort(rStore, {Gtk::TreeIter{}, parentIter}, nameColumn, true/*ascending*/));
+
+    ASSERT_TRUE(CtMiscUtil::tree_levels_sort(rStore, {Gtk::TreeIter{}}, nameColumn, false/*ascending*/));
+    ASSERT_EQ(std::vector<Glib::ustring>({"node 10", "Node 9", "b", "a"}), f_names(rStore->children()));
+    ASSERT_EQ(std::vector<Glib::ustring>({"x01", "x1", "x2", "x10"}), f_names(parentIter->children()));
+}
+
 TEST(MiscUtilsGroup, str__startswith)
 {
     ASSERT_TRUE(str::startswith("", ""));
@@ -336,6 +413,22 @@ TEST(MiscUtilsGroup, str__diacritical_to_ascii)
     ASSERT_STREQ("li", str::diacritical_to_ascii("lì").c_str());
     ASSERT_STREQ("puo", str::diacritical_to_ascii("può").c_str());
     ASSERT_STREQ("piu", str::diacritical_to_ascii("più").c_str());
+    ASSERT_STREQ("Lodz Dubrovnik Aarhus", str::diacritical_to_ascii("Łódź Dubrovnik Århus").c_str());
+    ASSERT_STREQ("Istanbul ozel Hoa Ngo", str::diacritical_to_ascii("İstanbul özel Hòa Ngọ").c_str());
+    ASSERT_STREQ("ΑΒΓ привет €", str::diacritical_to_ascii("ΑΒΓ привет €").c_str());
+    {
+        // decomposed 'e' + U+0301 and 'o' + U+0308
+        std::vector<int> origOffsets;
+        ASSERT_STREQ("cafe ol", str::diacritical_to_ascii("cafe\u0301 o\u0308l", &origOffsets).c_str());
+        ASSERT_EQ(std::vector<int>({0, 1, 2, 3, 5, 6, 8, 9}), origOffsets);
+        ASSERT_EQ(4, str::diacritical_folded_offset(origOffsets, 5));
+        ASSERT_EQ(7, str::diacritical_folded_offset(origOffsets, 9));
+    }
+    {
+        std::vector<int> origOffsets;
+        ASSERT_STREQ("perche", str::diacritical_to_ascii("perché", &origOffsets).c_str());
+        ASSERT_EQ(std::vector<int>({0, 1, 2, 3, 4, 5, 6}), origOffsets);
+    }
 }
 
 TEST(MiscUtilsGroup, vec_remove)
@@ -90,6 +90,28 @@ void TestCtApp::_run_test(const fs::path doc_filepath_from, const fs::path doc_f
     fs::path tmp_dirpath = pWin->get_ct_tmp()->getHiddenDirPath("UT");
     fs::path tmp_filepath = tmp_dirpath / doc_filepath_to.filename();
     CtDocType doc_type = CtDocEncrypt::None == docEncrypt_to ? CtDocType::MultiFile : fs::get_doc_type_from_file_ext(tmp_filepath);
+    {
+        // the nodes not loaded yet are converted without creating their text buffer
+        auto f_count_loaded = [pWin]()->size_t{
+            size_t numLoaded{0};
+            pWin->get_tree_store().get_store()->foreach([&](const Gtk::TreePath&, const Gtk::TreeIter& iter)->bool{
+                if (pWin->get_tree_store().to_ct_tree_iter(iter).get_node_buffer_already_loaded()) ++numLoaded;
+                return false; /* false for continue */
+            });
+            return numLoaded;
+        };
+        const size_t numLoadedBefore = f_count_loaded();
+        Glib::ustring error;
+        std::unique_ptr<CtStorageControl> pConvStorage{CtStorageControl::save_as(
+            pWin,
+            tmp_dirpath / ("conv_" + doc_filepath_to.filename().string()),
+            doc_type,
+            docEncrypt_to != CtDocEncrypt::True ? "" : UT::testPasswordBis,
+            error,
+            CtExporting::ALL_TREE)};
+        ASSERT_TRUE(pConvStorage);
+        ASSERT_EQ(numLoadedBefore, f_count_loaded());
+    }
     pWin->file_save_as(tmp_filepath.string(),
                        doc_type,
                        docEncrypt_to != CtDocEncrypt::True ? "" : UT::testPasswordBis);
@@ -106,6 +128,19 @@ void TestCtApp::_run_test(const fs::path doc_filepath_from, const fs::path doc_f
     ASSERT_TRUE(pWin2->file_open(tmp_filepath, ""/*file*/, ""/*anchor*/, docEncrypt_to != CtDocEncrypt::True ? "" : UT::testPasswordBis));
     // check tree
     _assert_tree_data(pWin2, false/*after_mods*/);
+    {
+        // the text buffers with nothing to save are unloaded and read again from the storage unchanged
+        size_t numUnloaded{0};
+        pWin2->get_tree_store().get_store()->foreach([&](const Gtk::TreePath&, const Gtk::TreeIter& iter)->bool{
+            CtTreeIter ctTreeIter = pWin2->get_tree_store().to_ct_tree_iter(iter);
+            if (ctTreeIter.get_node_buffer_already_loaded() and ctTreeIter.unload_node_text_buffer()) {
+                ++numUnloaded;
+            }
+            return false; /* false for continue */
+        });
+        ASSERT_GT(numUnloaded, 0u);
+        _assert_tree_data(pWin2, false/*after_mods*/);
+    }
 
     const CtStorageSyncPending* pCtStorageSyncPending = pWin2->get_ct_storage()->get_storage_sync_pending();
     {
@@ -645,8 +680,8 @@ void TestCtApp::_assert_tree_data(CtMainWin* pWin, const bool after_mods)
                     ASSERT_TRUE(pImageEmbFile);
                     ASSERT_STREQ("йцукенгшщз.txt", pImageEmbFile->get_file_name().c_str());
                     static const std::string embedded_file = Glib::Base64::decode("0LnRhtGD0LrQtdC90LPRiNGJ0LcK");
-                    ASSERT_EQ(embedded_file.size(), pImageEmbFile->get_raw_blob().size());
-                    ASSERT_EQ(embedded_file, pImageEmbFile->get_raw_blob());
+                    ASSERT_EQ(embedded_file.size(), pImageEmbFile->get_blob()->size());
+                    ASSERT_EQ(embedded_file, pImageEmbFile->get_blob()->get_raw_blob());
                     ASSERT_EQ(1565442560, pImageEmbFile->get_time());
                 } break;
                 case CtAnchWidgType::ImageLatex: {
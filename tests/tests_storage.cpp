@@ -0,0 +1,605 @@
+/*
+ * tests_storage.cpp
+ *
+ * Copyright 2009-2024
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_app.h"
+#include "ct_actions.h"
+#include "ct_misc_utils.h"
+#include "ct_storage_control.h"
+#include "ct_codebox.h"
+#include "ct_nodes_buffers_lru.h"
+#include "tests_common.h"
+#include <glib/gstdio.h>
+#include <sqlite3.h>
+
+// runs the test function from on_activate, with the application ready to create windows
+class TestStorageCtApp : public CtApp
+{
+public:
+    TestStorageCtApp(std::function<void(TestStorageCtApp&)> f_test)
+     : CtApp{"_test_storage"}
+     , _f_test{f_test}
+    {
+        _no_gui = true;
+    }
+
+    CtMainWin* create_window() { return _create_window(true/*start_hidden*/); }
+    void close_window(CtMainWin* pWin) {
+        pWin->force_exit() = true;
+        remove_window(*pWin);
+    }
+    fs::path get_tmp_dirpath() { return _uCtTmp->getHiddenDirPath("UT"); }
+
+    static void run_test(std::function<void(TestStorageCtApp&)> f_test) {
+        const std::vector<std::string> vec_args{"cherrytree"};
+        gchar** pp_args = CtStrUtil::vector_to_array(vec_args);
+        TestStorageCtApp testCtApp{f_test};
+        testCtApp.run(vec_args.size(), pp_args);
+        g_strfreev(pp_args);
+    }
+
+private:
+    void on_activate() final {
+        _on_startup();
+        _f_test(*this);
+    }
+
+    std::function<void(TestStorageCtApp&)> _f_test;
+};
+
+static std::string ctd_node(const gint64 node_id, const std::string& name, const std::string& text, const std::string& children = "")
+{
+    return fmt::format("<node unique_id=\"{}\" master_id=\"0\" name=\"{}\" prog_lang=\"custom-colors\" tags=\"\" readonly=\"0\" "
+                       "nosearch_me=\"0\" nosearch_ch=\"0\" custom_icon_id=\"0\" is_bold=\"0\" foreground=\"\" "
+                       "ts_creation=\"0\" ts_lastsave=\"0\"><rich_text>{}</rich_text>{}</node>", node_id, name, text, children);
+}
+
+static fs::path write_ctd(const fs::path& dirpath, const std::string& filename, const std::string& nodes)
+{
+    const fs::path filepath = dirpath / filename;
+    Glib::file_set_contents(filepath.string(), "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<cherrytree>" + nodes + "</cherrytree>\n");
+    return filepath;
+}
+
+static Glib::ustring node_text(CtMainWin* pWin, const Glib::ustring& node_name)
+{
+    CtTreeIter ctTreeIter = pWin->get_tree_store().get_node_from_node_name(node_name);
+    EXPECT_TRUE(ctTreeIter);
+    if (not ctTreeIter) return "";
+    return ctTreeIter.get_node_text_buffer()->get_text();
+}
+
+static void edit_node_text(CtMainWin* pWin, const Glib::ustring& node_name, const Glib::ustring& appended_text)
+{
+    CtTreeIter ctTreeIter = pWin->get_tree_store().get_node_from_node_name(node_name);
+    ASSERT_TRUE(ctTreeIter);
+    auto pTextBuffer = ctTreeIter.get_node_text_buffer();
+    pTextBuffer->insert(pTextBuffer->end(), appended_text);
+    pWin->update_window_save_needed(CtSaveNeededUpdType::nbuf, false/*new_machine_state*/, &ctTreeIter);
+}
+
+class ImportMultipleParametersTests : public ::testing::TestWithParam<std::string>
+{
+};
+
+TEST_P(ImportMultipleParametersTests, duplicated_ids_n_edit_then_save)
+{
+    const std::string target_ext = GetParam();
+    TestStorageCtApp::run_test([&target_ext](TestStorageCtApp& testCtApp){
+        const fs::path tmp_dirpath = testCtApp.get_tmp_dirpath();
+        const fs::path host_ctd = write_ctd(tmp_dirpath, "host.ctd", ctd_node(1, "host", "host text"));
+        // the node "second" has the same id of "first" (and of the host node)
+        const fs::path import_ctd = write_ctd(tmp_dirpath, "import.ctd",
+            ctd_node(1, "first", "first text") +
+            ctd_node(1, "second", "second text") +
+            ctd_node(2, "third", "third text", ctd_node(3, "fourth", "fourth text")));
+        const fs::path host_filepath = tmp_dirpath / ("host" + target_ext);
+        const CtDocType doc_type = target_ext.empty() ? CtDocType::MultiFile : fs::get_doc_type_from_file_ext(host_filepath);
+
+        CtMainWin* pWin = testCtApp.create_window();
+        ASSERT_TRUE(pWin->file_open(host_ctd, ""/*node_to_focus*/, ""/*anchor_to_focus*/, ""/*password*/));
+        pWin->file_save_as(host_filepath.string(), doc_type, ""/*password*/);
+
+        CtTreeIter hostIter = pWin->get_tree_store().get_node_from_node_name("host");
+        ASSERT_TRUE(hostIter);
+        pWin->get_ct_storage()->add_nodes_from_storage(import_ctd, hostIter, false/*is_folder*/);
+        ASSERT_TRUE(pWin->get_tree_store().get_node_from_node_name("first"));
+        ASSERT_TRUE(pWin->get_tree_store().get_node_from_node_name("second"));
+        ASSERT_NE(pWin->get_tree_store().get_node_from_node_name("first").get_node_id(),
+                  pWin->get_tree_store().get_node_from_node_name("second").get_node_id());
+
+        // "second" (duplicated id, buffer created at import) and "third" (loaded from the source) are edited,
+        // "first" and "fourth" are never loaded before the save
+        edit_node_text(pWin, "second", " edited");
+        edit_node_text(pWin, "third", " edited");
+        ASSERT_TRUE(pWin->file_save(false/*need_vacuum*/));
+
+        // after the save the nodes never loaded are read from the saved document
+        ASSERT_EQ(Glib::ustring{"first text"}, node_text(pWin, "first"));
+        ASSERT_EQ(Glib::ustring{"fourth text"}, node_text(pWin, "fourth"));
+
+        // edit again after the save, now that the source document is released
+        edit_node_text(pWin, "first", " edited");
+        ASSERT_TRUE(pWin->file_save(false/*need_vacuum*/));
+        testCtApp.close_window(pWin);
+
+        CtMainWin* pWin2 = testCtApp.create_window();
+        ASSERT_TRUE(pWin2->file_open(host_filepath, ""/*node_to_focus*/, ""/*anchor_to_focus*/, ""/*password*/));
+        ASSERT_EQ(Glib::ustring{"host text"}, node_text(pWin2, "host"));
+        ASSERT_EQ(Glib::ustring{"first text edited"}, node_text(pWin2, "first"));
+        ASSERT_EQ(Glib::ustring{"second text edited"}, node_text(pWin2, "second"));
+        ASSERT_EQ(Glib::ustring{"third text edited"}, node_text(pWin2, "third"));
+        ASSERT_EQ(Glib::ustring{"fourth text"}, node_text(pWin2, "fourth"));
+        testCtApp.close_window(pWin2);
+    });
+}
+
+INSTANTIATE_TEST_CASE_P(
+        ImportTests,
+        ImportMultipleParametersTests,
+        ::testing::Values(".ctb", ".ctd", ""/*multifile*/));
+
+// rowid -> offset of the widgets rows of a node, read with a separate connection
+static std::map<sqlite3_int64, int> sqlite_widgets_rows(const fs::path& filepath, const char* tableName, const gint64 node_id)
+{
+    std::map<sqlite3_int64, int> retRows;
+    sqlite3* pDb{nullptr};
+    EXPECT_EQ(SQLITE_OK, sqlite3_open_v2(filepath.c_str(), &pDb, SQLITE_OPEN_READONLY, nullptr));
+    sqlite3_stmt* pStmt{nullptr};
+    const std::string sqlCmd = fmt::format("SELECT rowid, offset FROM {} WHERE node_id={}", tableName, node_id);
+    EXPECT_EQ(SQLITE_OK, sqlite3_prepare_v2(pDb, sqlCmd.c_str(), -1, &pStmt, nullptr));
+    while (SQLITE_ROW == sqlite3_step(pStmt)) {
+        retRows[sqlite3_column_int64(pStmt, 0)] = sqlite3_column_int(pStmt, 1);
+    }
+    sqlite3_finalize(pStmt);
+    sqlite3_close(pDb);
+    return retRows;
+}
+
+TEST(SqliteRowRefsGroup, widgets_rows_updated_in_place_after_backup)
+{
+    TestStorageCtApp::run_test([](TestStorageCtApp& testCtApp){
+        const fs::path tmp_filepath = testCtApp.get_tmp_dirpath() / "row_refs.ctb";
+        CtMainWin* pWin = testCtApp.create_window();
+        // every save closes and reopens the database for the main backup
+        pWin->get_ct_config()->backupCopy = true;
+        pWin->get_ct_config()->backupNum = 3;
+        ASSERT_TRUE(pWin->file_open(UT::testCtbDocPath, ""/*node_to_focus*/, ""/*anchor_to_focus*/, ""/*password*/));
+        pWin->file_save_as(tmp_filepath.string(), CtDocType::SQLite, ""/*password*/);
+        testCtApp.close_window(pWin);
+
+        CtMainWin* pWin2 = testCtApp.create_window();
+        ASSERT_TRUE(pWin2->file_open(tmp_filepath, ""/*node_to_focus*/, ""/*anchor_to_focus*/, ""/*password*/));
+        CtTreeIter ctTreeIter = pWin2->get_tree_store().get_node_from_node_name("e");
+        ASSERT_TRUE(ctTreeIter);
+        pWin2->get_tree_view().set_cursor_safe(ctTreeIter);
+        const gint64 node_id = ctTreeIter.get_node_id();
+        auto pTextBuffer = ctTreeIter.get_node_text_buffer();
+        const auto codeboxRows0 = sqlite_widgets_rows(tmp_filepath, "codebox", node_id);
+        const auto gridRows0 = sqlite_widgets_rows(tmp_filepath, "grid", node_id);
+        const auto imageRows0 = sqlite_widgets_rows(tmp_filepath, "image", node_id);
+        ASSERT_FALSE(codeboxRows0.empty());
+        ASSERT_FALSE(gridRows0.empty());
+        ASSERT_FALSE(imageRows0.empty());
+
+        // UPDATE: the text inserted before all the widgets moves them, the rows stay
+        const Glib::ustring prefix{"moved "};
+        pTextBuffer->insert(pTextBuffer->begin(), prefix);
+        pWin2->update_window_save_needed(CtSaveNeededUpdType::nbuf, false/*new_machine_state*/, &ctTreeIter);
+        ASSERT_TRUE(pWin2->file_save(false/*need_vacuum*/));
+        for (const auto& rows0 : {std::make_pair("codebox", codeboxRows0), std::make_pair("grid", gridRows0), std::make_pair("image", imageRows0)}) {
+            const auto rows1 = sqlite_widgets_rows(tmp_filepath, rows0.first, node_id);
+            ASSERT_EQ(rows0.second.size(), rows1.size()) << rows0.first;
+            for (const auto& row0 : rows0.second) {
+                ASSERT_EQ(1u, rows1.count(row0.first)) << rows0.first;
+                ASSERT_EQ(row0.second + static_cast<int>(prefix.size()), rows1.at(row0.first)) << rows0.first;
+            }
+        }
+
+        // INSERT: a new codebox gets a new row, the other rows stay
+        pTextBuffer->insert(pTextBuffer->end(), " ");
+        auto pCodebox = new CtCodebox{pWin2, "new codebox", CtConst::PLAIN_TEXT_ID, 300, 100,
+                                      pTextBuffer->end().get_offset(), CtConst::TAG_PROP_VAL_LEFT,
+                                      true/*widthInPixels*/, false/*highlightBrackets*/, false/*showLineNumbers*/};
+        pCodebox->insertInTextBuffer(pTextBuffer);
+        pWin2->get_tree_store().addAnchoredWidgets(ctTreeIter, {pCodebox}, &pWin2->get_text_view());
+        pWin2->update_window_save_needed(CtSaveNeededUpdType::nbuf, false/*new_machine_state*/, &ctTreeIter);
+        ASSERT_TRUE(pWin2->file_save(false/*need_vacuum*/));
+        const auto codeboxRows2 = sqlite_widgets_rows(tmp_filepath, "codebox", node_id);
+        ASSERT_EQ(codeboxRows0.size() + 1u, codeboxRows2.size());
+        for (const auto& row0 : codeboxRows0) {
+            ASSERT_EQ(1u, codeboxRows2.count(row0.first));
+        }
+        ASSERT_EQ(gridRows0.size(), sqlite_widgets_rows(tmp_filepath, "grid", node_id).size());
+        ASSERT_EQ(imageRows0.size(), sqlite_widgets_rows(tmp_filepath, "image", node_id).size());
+
+        // DELETE: the row of a removed table goes, the other rows stay
+        int tableOffset{-1};
+        for (CtAnchoredWidget* pAnchoredWidget : ctTreeIter.get_anchored_widgets()) {
+            if (CtAnchWidgType::TableHeavy == pAnchoredWidget->get_type() or CtAnchWidgType::TableLight == pAnchoredWidget->get_type()) {
+                tableOffset = pAnchoredWidget->getOffset();
+                break;
+            }
+        }
+        ASSERT_GE(tableOffset, 0);
+        pTextBuffer->erase(pTextBuffer->get_iter_at_offset(tableOffset), pTextBuffer->get_iter_at_offset(tableOffset + 1));
+        pWin2->update_window_save_needed(CtSaveNeededUpdType::nbuf, false/*new_machine_state*/, &ctTreeIter);
+        ASSERT_TRUE(pWin2->file_save(false/*need_vacuum*/));
+        const auto gridRows3 = sqlite_widgets_rows(tmp_filepath, "grid", node_id);
+        ASSERT_EQ(gridRows0.size() - 1u, gridRows3.size());
+        for (const auto& row3 : gridRows3) {
+            ASSERT_EQ(1u, gridRows0.count(row3.first));
+        }
+        ASSERT_EQ(codeboxRows2, sqlite_widgets_rows(tmp_filepath, "codebox", node_id));
+        ASSERT_EQ(imageRows0.size(), sqlite_widgets_rows(tmp_filepath, "image", node_id).size());
+        testCtApp.close_window(pWin2);
+
+        CtMainWin* pWin3 = testCtApp.create_window();
+        ASSERT_TRUE(pWin3->file_open(tmp_filepath, ""/*node_to_focus*/, ""/*anchor_to_focus*/, ""/*password*/));
+        CtTreeIter ctTreeIter3 = pWin3->get_tree_store().get_node_from_node_name("e");
+        ASSERT_TRUE(ctTreeIter3);
+        ASSERT_EQ(codeboxRows2.size() + gridRows3.size() + imageRows0.size(), ctTreeIter3.get_anchored_widgets().size());
+        ASSERT_TRUE(str::startswith(ctTreeIter3.get_node_text_buffer()->get_text(), prefix));
+        testCtApp.close_window(pWin3);
+    });
+}
+
+TEST(VacuumGroup, stop_n_reentrance_while_vacuuming)
+{
+    TestStorageCtApp::run_test([](TestStorageCtApp& testCtApp){
+        const fs::path tmp_filepath = testCtApp.get_tmp_dirpath() / "vacuum.ctb";
+        CtMainWin* pWin = testCtApp.create_window();
+        pWin->get_ct_config()->backupCopy = false;
+        ASSERT_TRUE(pWin->file_open(UT::testCtbDocPath, ""/*node_to_focus*/, ""/*anchor_to_focus*/, ""/*password*/));
+        pWin->file_save_as(tmp_filepath.string(), CtDocType::SQLite, ""/*password*/);
+        {
+            // a big node so that the vacuum lasts long enough to process the events meanwhile
+            CtTreeIter ctTreeIter = pWin->get_tree_store().get_node_from_node_name("b");
+            ASSERT_TRUE(ctTreeIter);
+            auto pTextBuffer = ctTreeIter.get_node_text_buffer();
+            std::string bigText;
+            for (int i = 0; i < 512*1024; ++i) bigText += fmt::format("{:031}\n", i);
+            pTextBuffer->insert(pTextBuffer->end(), bigText);
+            pWin->update_window_save_needed(CtSaveNeededUpdType::nbuf, false/*new_machine_state*/, &ctTreeIter);
+            ASSERT_TRUE(pWin->file_save(false/*need_vacuum*/));
+        }
+        CtTreeIter ctTreeIterC = pWin->get_tree_store().get_node_from_node_name("c");
+        ASSERT_TRUE(ctTreeIterC);
+        if (ctTreeIterC.get_node_buffer_already_loaded()) {
+            ASSERT_TRUE(ctTreeIterC.unload_node_text_buffer());
+        }
+
+        bool vacuumSeen{false};
+        bool reentrantSaveRefused{false};
+        Glib::ustring textLoadedWhileVacuuming;
+        sigc::connection timeoutConnection = Glib::signal_timeout().connect([&]()->bool{
+            if (not pWin->get_status_bar().stopButton.get_visible()) {
+                return true; // not vacuuming yet
+            }
+            vacuumSeen = true;
+            EXPECT_TRUE(pWin->get_ct_storage()->is_saving());
+            edit_node_text(pWin, "e", " while vacuuming");
+            reentrantSaveRefused = not pWin->file_save(false/*need_vacuum*/);
+            // the node read from the storage stops the vacuum
+            textLoadedWhileVacuuming = node_text(pWin, "c");
+            pWin->get_status_bar().set_progress_stop(true);
+            return false;
+        }, 1);
+        ASSERT_TRUE(pWin->file_save(true/*need_vacuum*/));
+        timeoutConnection.disconnect();
+        ASSERT_TRUE(vacuumSeen);
+        ASSERT_TRUE(reentrantSaveRefused);
+        ASSERT_FALSE(textLoadedWhileVacuuming.empty());
+        ASSERT_FALSE(pWin->get_ct_storage()->is_saving());
+        ASSERT_FALSE(pWin->get_status_bar().stopButton.get_visible());
+        // the edit made while vacuuming is still to be saved
+        ASSERT_TRUE(pWin->get_file_save_needed());
+        ASSERT_TRUE(pWin->file_save(false/*need_vacuum*/));
+        testCtApp.close_window(pWin);
+
+        CtMainWin* pWin2 = testCtApp.create_window();
+        ASSERT_TRUE(pWin2->file_open(tmp_filepath, ""/*node_to_focus*/, ""/*anchor_to_focus*/, ""/*password*/));
+        ASSERT_TRUE(str::endswith(node_text(pWin2, "e"), " while vacuuming"));
+        ASSERT_EQ(textLoadedWhileVacuuming, node_text(pWin2, "c"));
+        testCtApp.close_window(pWin2);
+    });
+}
+
+TEST(NodesBuffersLruGroup, evict_over_budget)
+{
+    TestStorageCtApp::run_test([](TestStorageCtApp& testCtApp){
+        CtMainWin* pWin = testCtApp.create_window();
+        ASSERT_TRUE(pWin->file_open(UT::testCtbDocPath, ""/*node_to_focus*/, ""/*anchor_to_focus*/, ""/*password*/));
+        pWin->get_ct_config()->nodesBuffersBudgetMB = 1;
+        CtNodesBuffersLru& nodesBuffersLru = pWin->get_nodes_buffers_lru();
+        CtTreeStore& ctTreeStore = pWin->get_tree_store();
+
+        nodesBuffersLru.reset();
+        // every buffer is estimated well over the budget
+        auto f_load = [&](const Glib::ustring& node_name)->CtTreeIter{
+            CtTreeIter ctTreeIter = ctTreeStore.get_node_from_node_name(node_name);
+            EXPECT_TRUE(ctTreeIter);
+            nodesBuffersLru.touch(ctTreeIter.get_node_id_data_holder(), ctTreeIter.get_node_text_buffer(), 100u/*numWidgets*/);
+            return ctTreeIter;
+        };
+        CtTreeIter iterCurr = f_load("c");
+        pWin->get_tree_view().set_cursor_safe(iterCurr);
+        CtTreeIter iterModified = f_load("d");
+        iterModified.get_node_text_buffer()->set_modified(true);
+        CtTreeIter iterPending = f_load("b");
+        iterPending.get_node_text_buffer()->insert_at_cursor("pending");
+        pWin->update_window_save_needed(CtSaveNeededUpdType::nbuf, false/*new_machine_state*/, &iterPending);
+        iterPending.get_node_text_buffer()->set_modified(false); // only the pending save keeps it
+        CtTreeIter iterPlain1 = f_load("py");
+        CtTreeIter iterPlain2 = f_load("sh");
+        (void)f_load("html");
+        // the node removed is forgotten
+        ctTreeStore.get_store()->erase(ctTreeStore.get_node_from_node_name("html"));
+        ASSERT_EQ(6u, nodesBuffersLru.get_num_loaded());
+        iterPlain2 = ctTreeStore.get_node_from_node_name("sh");
+
+        // nothing is unloaded while held
+        nodesBuffersLru.hold();
+        ASSERT_EQ(0u, nodesBuffersLru.evict_over_budget());
+        ASSERT_TRUE(iterPlain1.get_node_buffer_already_loaded());
+        ASSERT_TRUE(iterPlain2.get_node_buffer_already_loaded());
+        nodesBuffersLru.unhold();
+
+        ASSERT_EQ(2u, nodesBuffersLru.evict_over_budget());
+        ASSERT_FALSE(iterPlain1.get_node_buffer_already_loaded());
+        ASSERT_FALSE(iterPlain2.get_node_buffer_already_loaded());
+        ASSERT_TRUE(iterCurr.get_node_buffer_already_loaded());
+        ASSERT_TRUE(iterModified.get_node_buffer_already_loaded());
+        ASSERT_TRUE(iterPending.get_node_buffer_already_loaded());
+        ASSERT_EQ(3u, nodesBuffersLru.get_num_loaded());
+        // the unloaded are read again from the storage
+        ASSERT_FALSE(iterPlain1.get_node_text_buffer()->get_text().empty());
+        testCtApp.close_window(pWin);
+    });
+}
+
+TEST(SubnodesPasteGroup, duplicated_delayed_nodes_saved_n_reopened)
+{
+    TestStorageCtApp::run_test([](TestStorageCtApp& testCtApp){
+        const fs::path tmp_filepath = testCtApp.get_tmp_dirpath() / "paste_round_trip.ctb";
+        CtMainWin* pWin = testCtApp.create_window();
+        ASSERT_TRUE(pWin->file_open(UT::testCtbDocPath, ""/*node_to_focus*/, ""/*anchor_to_focus*/, ""/*password*/));
+        pWin->file_save_as(tmp_filepath.string(), CtDocType::SQLite, ""/*password*/);
+        CtTreeStore& ctTreeStore = pWin->get_tree_store();
+        // the rich text node with widgets and the plain text node under "d"
+        for (const Glib::ustring& node_name : {"e", "йцукенгшщз"}) {
+            pWin->get_ct_actions()->node_move_after(ctTreeStore.get_node_from_node_name(node_name), ctTreeStore.get_node_from_node_name("d"));
+        }
+        ASSERT_TRUE(pWin->file_save(false/*need_vacuum*/));
+
+        auto f_node_content = [](CtTreeIter ctTreeIter)->std::string{
+            std::string content = ctTreeIter.get_node_name().raw() + "|" + ctTreeIter.get_node_syntax_highlighting() + "|" +
+                                  ctTreeIter.get_node_text_buffer()->get_text().raw();
+            for (CtAnchoredWidget* pAnchoredWidget : ctTreeIter.get_anchored_widgets()) {
+                content += fmt::format("|{}@{}", static_cast<int>(pAnchoredWidget->get_type()), pAnchoredWidget->getOffset());
+            }
+            return content;
+        };
+        auto f_subtree_contents = [&f_node_content](CtTreeStore& ctTreeStore, const Gtk::TreeIter& topIter)->std::vector<std::string>{
+            std::vector<std::string> contents{f_node_content(ctTreeStore.to_ct_tree_iter(topIter))};
+            for (const Gtk::TreeIter& child : topIter->children()) {
+                contents.push_back(f_node_content(ctTreeStore.to_ct_tree_iter(child)));
+            }
+            return contents;
+        };
+        CtTreeIter iterOrig = ctTreeStore.get_node_from_node_name("d");
+        ASSERT_TRUE(iterOrig);
+        const std::vector<std::string> contentsOrig = f_subtree_contents(ctTreeStore, iterOrig);
+        ASSERT_EQ(3u, contentsOrig.size());
+
+        pWin->get_tree_view().set_cursor_safe(iterOrig);
+        pWin->get_ct_actions()->node_subnodes_duplicate();
+        Gtk::TreeIter iterCopy = iterOrig;
+        ++iterCopy;
+        ASSERT_TRUE(iterCopy);
+        // only the top copy is visited, the others are saved from their xml
+        for (const Gtk::TreeIter& child : iterCopy->children()) {
+            ASSERT_FALSE(ctTreeStore.to_ct_tree_iter(child).get_node_buffer_already_loaded());
+        }
+        ASSERT_TRUE(pWin->file_save(false/*need_vacuum*/));
+        testCtApp.close_window(pWin);
+
+        CtMainWin* pWin2 = testCtApp.create_window();
+        ASSERT_TRUE(pWin2->file_open(tmp_filepath, ""/*node_to_focus*/, ""/*anchor_to_focus*/, ""/*password*/));
+        CtTreeStore& ctTreeStore2 = pWin2->get_tree_store();
+        std::vector<std::vector<std::string>> subtreesContents;
+        for (const Gtk::TreeIter& topIter : ctTreeStore2.get_store()->children()) {
+            if (ctTreeStore2.to_ct_tree_iter(topIter).get_node_name() == "d") {
+                subtreesContents.push_back(f_subtree_contents(ctTreeStore2, topIter));
+            }
+        }
+        ASSERT_EQ(2u, subtreesContents.size());
+        ASSERT_EQ(contentsOrig, subtreesContents.front());
+        ASSERT_EQ(contentsOrig, subtreesContents.back());
+        testCtApp.close_window(pWin2);
+    });
+}
+
+TEST(StateMachineGroup, undo_redo_across_spilled_states)
+{
+    TestStorageCtApp::run_test([](TestStorageCtApp& testCtApp){
+        CtMainWin* pWin = testCtApp.create_window();
+        ASSERT_TRUE(pWin->file_open(UT::testCtbDocPath, ""/*node_to_focus*/, ""/*anchor_to_focus*/, ""/*password*/));
+        pWin->get_ct_config()->undoRamStatesPerNode = 1;
+        CtStateMachine& stateMachine = pWin->get_state_machine();
+        CtTreeIter ctTreeIter = pWin->get_tree_store().get_node_from_node_name("b");
+        ASSERT_TRUE(ctTreeIter);
+        pWin->get_tree_view().set_cursor_safe(ctTreeIter);
+        const gint64 nodeId = ctTreeIter.get_node_id_data_holder();
+        stateMachine.update_state();
+        constexpr int numEdits{5};
+        for (int i = 1; i <= numEdits; ++i) {
+            auto pTextBuffer = ctTreeIter.get_node_text_buffer();
+            pTextBuffer->insert(pTextBuffer->end(), fmt::format("\nundo_step_{}", i));
+            stateMachine.update_state();
+        }
+        // only the last state is left in memory
+        ASSERT_LE(static_cast<size_t>(numEdits), stateMachine.get_num_spilled());
+
+        auto f_step_of = [](const std::shared_ptr<CtNodeState>& pState)->int{
+            for (int i = numEdits; i >= 1; --i) {
+                if (pState->buffer_xml_string.find(fmt::format("undo_step_{}", i)) != Glib::ustring::npos) {
+                    return i;
+                }
+            }
+            return 0;
+        };
+        for (int i = numEdits - 1; i >= 0; --i) {
+            std::shared_ptr<CtNodeState> pState = stateMachine.requested_state_previous(nodeId);
+            ASSERT_TRUE(pState);
+            ASSERT_EQ(-1, pState->spilledSlotId);
+            ASSERT_EQ(i, f_step_of(pState));
+        }
+        ASSERT_FALSE(stateMachine.requested_state_previous(nodeId));
+        for (int i = 1; i <= numEdits; ++i) {
+            std::shared_ptr<CtNodeState> pState = stateMachine.requested_state_subsequent(nodeId);
+            ASSERT_TRUE(pState);
+            ASSERT_EQ(i, f_step_of(pState));
+        }
+        ASSERT_TRUE(stateMachine.curr_index_is_last_index(nodeId));
+
+        // the spilled states cannot be read back once the arena is truncated,
+        // undo fails and stays on the current state
+        ASSERT_LT(0u, stateMachine.get_num_spilled());
+        const fs::path arenaDirpath = pWin->get_ct_tmp()->getHiddenDirPath("undo_states");
+        for (const fs::path& arenaFilepath : fs::get_dir_entries(arenaDirpath)) {
+            FILE* pFile = g_fopen(arenaFilepath.c_str(), "wb"); // in place, the arena keeps the file open
+            ASSERT_TRUE(pFile);
+            fclose(pFile);
+        }
+        ASSERT_FALSE(stateMachine.requested_state_previous(nodeId));
+        ASSERT_TRUE(stateMachine.curr_index_is_last_index(nodeId));
+        ASSERT_EQ(numEdits, f_step_of(stateMachine.requested_state_current(nodeId)));
+        testCtApp.close_window(pWin);
+    });
+}
+
+TEST(StateMachineGroup, codebox_n_table_states_shared_until_changed)
+{
+    TestStorageCtApp::run_test([](TestStorageCtApp& testCtApp){
+        CtMainWin* pWin = testCtApp.create_window();
+        {
+            CtCodebox codebox{pWin, "int a;\n", "cpp", 300/*frameWidth*/, 100/*frameHeight*/, 0/*charOffset*/, CtConst::TAG_PROP_VAL_LEFT,
+                              false/*widthInPixels*/, true/*highlightBrackets*/, false/*showLineNumbers*/};
+            auto pState1 = std::dynamic_pointer_cast<CtAnchoredWidgetState_Codebox>(codebox.get_state_shared());
+            ASSERT_TRUE(pState1);
+            ASSERT_EQ(pState1, codebox.get_state_shared());
+            // moved and with other line numbers, the content is shared
+            codebox.updateOffset(5);
+            codebox.set_show_line_numbers(true);
+            auto pState2 = std::dynamic_pointer_cast<CtAnchoredWidgetState_Codebox>(codebox.get_state_shared());
+            ASSERT_NE(pState1, pState2);
+            ASSERT_EQ(pState1->pContent, pState2->pContent);
+            ASSERT_EQ(5, pState2->charOffset);
+            ASSERT_TRUE(pState2->showNum);
+            ASSERT_FALSE(pState1->showNum);
+            // edited, a new content
+            codebox.get_buffer()->insert(codebox.get_buffer()->end(), "int b;\n");
+            auto pState3 = std::dynamic_pointer_cast<CtAnchoredWidgetState_Codebox>(codebox.get_state_shared());
+            ASSERT_NE(pState2->pContent, pState3->pContent);
+            ASSERT_STREQ("int a;\nint b;\n", pState3->pContent->c_str());
+        }
+        auto f_check_table = [](CtTableCommon& table, const std::function<void()>& f_edit_cell){
+            auto pState1 = std::dynamic_pointer_cast<CtAnchoredWidgetState_TableCommon>(table.get_state_shared());
+            ASSERT_TRUE(pState1);
+            ASSERT_EQ(pState1, table.get_state_shared());
+            // other cursor and column width, the cells are shared
+            table.set_current_row_column(1u, 1u);
+            table.set_col_width(150, 0u);
+            auto pState2 = std::dynamic_pointer_cast<CtAnchoredWidgetState_TableCommon>(table.get_state_shared());
+            ASSERT_NE(pState1, pState2);
+            ASSERT_EQ(pState1->pRows, pState2->pRows);
+            ASSERT_EQ(1u, pState2->currRow);
+            ASSERT_EQ(150, pState2->colWidths.at(0));
+            // edited cell and added row, new cells each time
+            f_edit_cell();
+            auto pState3 = std::dynamic_pointer_cast<CtAnchoredWidgetState_TableCommon>(table.get_state_shared());
+            ASSERT_NE(pState2->pRows, pState3->pRows);
+            ASSERT_STREQ("edited", pState3->pRows->at(1).at(0).c_str());
+            table.row_add(1u);
+            auto pState4 = std::dynamic_pointer_cast<CtAnchoredWidgetState_TableCommon>(table.get_state_shared());
+            ASSERT_NE(pState3->pRows, pState4->pRows);
+            ASSERT_EQ(3u, pState4->pRows->size());
+        };
+        {
+            CtTableMatrix tableMatrix{{new Glib::ustring{"h1"}, new Glib::ustring{"h2"}},
+                                      {new Glib::ustring{"c1"}, new Glib::ustring{"c2"}}};
+            CtTableLight tableLight{pWin, tableMatrix, 100/*colWidthDefault*/, 0/*charOffset*/, CtConst::TAG_PROP_VAL_LEFT, CtTableColWidths{}};
+            f_check_table(tableLight, [&tableLight](){ tableLight.set_cell_text(1u, 0u, "edited"); });
+        }
+        {
+            CtTableMatrix tableMatrix;
+            for (const char* row : {"h", "c"}) {
+                tableMatrix.push_back(CtTableRow{});
+                for (int col = 1; col <= 2; ++col) {
+                    tableMatrix.back().push_back(new CtTextCell{pWin, fmt::format("{}{}", row, col), CtConst::TABLE_CELL_TEXT_ID});
+                }
+            }
+            CtTableHeavy tableHeavy{pWin, tableMatrix, 100/*colWidthDefault*/, 0/*charOffset*/, CtConst::TAG_PROP_VAL_LEFT, CtTableColWidths{}};
+            f_check_table(tableHeavy, [&tableHeavy](){ tableHeavy.get_buffer(1u, 0u)->set_text("edited"); });
+        }
+        testCtApp.close_window(pWin);
+    });
+}
+
+TEST(SummaryInfoGroup, same_from_storage_n_from_buffers)
+{
+    TestStorageCtApp::run_test([](TestStorageCtApp& testCtApp){
+        for (const std::string& docPath : {UT::testCtbDocPath, UT::testCtdDocPath}) {
+            CtMainWin* pWin = testCtApp.create_window();
+            ASSERT_TRUE(pWin->file_open(docPath, ""/*node_to_focus*/, ""/*anchor_to_focus*/, ""/*password*/));
+            CtTreeStore& ctTreeStore = pWin->get_tree_store();
+            // the node with the widgets is counted from the storage
+            CtTreeIter iterWidgets = ctTreeStore.get_node_from_node_name("e");
+            ASSERT_TRUE(iterWidgets);
+            ASSERT_FALSE(iterWidgets.get_node_buffer_already_loaded());
+            CtSummaryInfo summaryStored{};
+            ASSERT_TRUE(ctTreeStore.populate_summary_info(summaryStored));
+            ASSERT_FALSE(iterWidgets.get_node_buffer_already_loaded());
+
+            ctTreeStore.get_store()->foreach([&](const Gtk::TreePath&/*treePath*/, const Gtk::TreeIter& treeIter)->bool{
+                EXPECT_TRUE(ctTreeStore.to_ct_tree_iter(treeIter).get_node_text_buffer());
+                return false; /* false for continue */
+            });
+            CtSummaryInfo summaryBuffers{};
+            ASSERT_TRUE(ctTreeStore.populate_summary_info(summaryBuffers));
+            ASSERT_LT(0u, summaryBuffers.words_num);
+            ASSERT_LT(0u, summaryBuffers.codeboxes_num);
+            ASSERT_EQ(summaryBuffers.words_num, summaryStored.words_num);
+            ASSERT_EQ(summaryBuffers.chars_num, summaryStored.chars_num);
+            ASSERT_EQ(summaryBuffers.lines_num, summaryStored.lines_num);
+            ASSERT_EQ(summaryBuffers.images_num, summaryStored.images_num);
+            ASSERT_EQ(summaryBuffers.embfile_num, summaryStored.embfile_num);
+            ASSERT_EQ(summaryBuffers.latexes_num, summaryStored.latexes_num);
+            ASSERT_EQ(summaryBuffers.anchors_num, summaryStored.anchors_num);
+            ASSERT_EQ(summaryBuffers.heavytables_num, summaryStored.heavytables_num);
+            ASSERT_EQ(summaryBuffers.lighttables_num, summaryStored.lighttables_num);
+            ASSERT_EQ(summaryBuffers.codeboxes_num, summaryStored.codeboxes_num);
+            testCtApp.close_window(pWin);
+        }
+    });
+}
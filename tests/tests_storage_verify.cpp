@@ -0,0 +1,123 @@
+/*
+ * tests_storage_verify.cpp
+ *
+ * Copyright 2009-2024
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_storage_verify.h"
+#include "ct_filesystem.h"
+#include "tests_common.h"
+#include <sqlite3.h>
+
+TEST(StorageVerifyGroup, xml_digests)
+{
+    // digests from the parsed document match the ones from the streaming reader
+    xmlpp::DomParser parser;
+    parser.parse_file(UT::testCtdDocPath);
+    CtNodesDigests nodes_digests;
+    CtStorageVerify::add_xml_nodes_digests(parser.get_document()->get_root_node(), nodes_digests);
+    ASSERT_FALSE(nodes_digests.empty());
+    Glib::ustring error;
+    ASSERT_TRUE(CtStorageVerify::verify(UT::testCtdDocPath, nodes_digests, CtSaveVerify::FULL, error));
+    ASSERT_TRUE(CtStorageVerify::verify(UT::testCtdDocPath, nodes_digests, CtSaveVerify::SAMPLED, error));
+
+    // written document
+    xmlpp::Document xml_doc;
+    xml_doc.create_root_node("cherrytree");
+    xmlpp::Element* p_node = xml_doc.get_root_node()->add_child("node");
+    p_node->set_attribute("name", "parent");
+    p_node->set_attribute("unique_id", "1");
+    p_node->add_child("rich_text")->add_child_text("some text & more");
+    xmlpp::Element* p_subnode = p_node->add_child("node");
+    p_subnode->set_attribute("name", "child");
+    p_subnode->set_attribute("unique_id", "2");
+    p_subnode->add_child("rich_text")->set_attribute("weight", "heavy");
+    nodes_digests.clear();
+    CtStorageVerify::add_xml_nodes_digests(xml_doc.get_root_node(), nodes_digests);
+    ASSERT_EQ(2u, nodes_digests.size());
+    ASSERT_STRNE(nodes_digests.at(1).c_str(), nodes_digests.at(2).c_str());
+    const std::string test_ctd_path = Glib::build_filename(UT::unitTestsDataDir, "test_verify.ctd");
+    xml_doc.write_to_file_formatted(test_ctd_path);
+    ASSERT_TRUE(CtStorageVerify::verify(test_ctd_path, nodes_digests, CtSaveVerify::FULL, error));
+
+    // content not matching what was written
+    CtNodesDigests nodes_digests_bad = nodes_digests;
+    nodes_digests_bad[2] = nodes_digests.at(1);
+    ASSERT_FALSE(CtStorageVerify::verify(test_ctd_path, nodes_digests_bad, CtSaveVerify::FULL, error));
+    ASSERT_TRUE(CtStorageVerify::verify(test_ctd_path, nodes_digests_bad, CtSaveVerify::STRUCTURAL, error));
+    nodes_digests_bad = nodes_digests;
+    nodes_digests_bad[3] = nodes_digests.at(1);
+    ASSERT_FALSE(CtStorageVerify::verify(test_ctd_path, nodes_digests_bad, CtSaveVerify::FULL, error));
+
+    // truncated document
+    const std::string written = Glib::file_get_contents(test_ctd_path);
+    Glib::file_set_contents(test_ctd_path, written.substr(0, written.size()/2));
+    ASSERT_FALSE(CtStorageVerify::verify(test_ctd_path, nodes_digests, CtSaveVerify::STRUCTURAL, error));
+    ASSERT_TRUE(fs::remove(test_ctd_path));
+}
+
+TEST(StorageVerifyGroup, sqlite_digests_with_widgets)
+{
+    Glib::ustring error;
+    ASSERT_TRUE(CtStorageVerify::verify(UT::testCtbDocPath, CtNodesDigests{}, CtSaveVerify::FULL, error));
+
+    const std::string test_ctb_path = Glib::build_filename(UT::unitTestsDataDir, "test_verify.ctb");
+    ASSERT_TRUE(fs::copy_file(UT::testCtbDocPath, test_ctb_path));
+    auto f_exec = [](sqlite3* pDb, const char* sqlCmd){
+        ASSERT_EQ(SQLITE_OK, sqlite3_exec(pDb, sqlCmd, nullptr, nullptr, nullptr)) << sqlCmd;
+    };
+    sqlite3* pDb{nullptr};
+    ASSERT_EQ(SQLITE_OK, sqlite3_open(test_ctb_path.c_str(), &pDb));
+    CtNodesDigests nodes_digests;
+    gint64 node_id_widgets{0};
+    {
+        CtSqliteNodeDigest sqliteNodeDigest{pDb};
+        sqlite3_stmt* pStmt{nullptr};
+        ASSERT_EQ(SQLITE_OK, sqlite3_prepare_v2(pDb, "SELECT node_id, has_codebox, has_table, has_image FROM node", -1, &pStmt, nullptr));
+        while (SQLITE_ROW == sqlite3_step(pStmt)) {
+            const gint64 node_id = sqlite3_column_int64(pStmt, 0);
+            if (sqlite3_column_int64(pStmt, 1) and sqlite3_column_int64(pStmt, 2) and sqlite3_column_int64(pStmt, 3)) {
+                node_id_widgets = node_id;
+            }
+            ASSERT_TRUE(sqliteNodeDigest.get(node_id, nodes_digests[node_id], error)) << error;
+        }
+        sqlite3_finalize(pStmt);
+        ASSERT_FALSE(sqliteNodeDigest.get(999999/*node_id*/, nodes_digests[0], error));
+        nodes_digests.erase(0);
+    }
+    ASSERT_LT(0, node_id_widgets);
+    ASSERT_EQ(SQLITE_OK, sqlite3_close(pDb));
+    ASSERT_TRUE(CtStorageVerify::verify(test_ctb_path, nodes_digests, CtSaveVerify::FULL, error)) << error;
+
+    // a change in any of the widgets tables is detected
+    for (const std::string sqlCmd : {"UPDATE codebox SET txt=txt||'x' WHERE node_id=",
+                                     "UPDATE grid SET col_max=col_max+1 WHERE node_id=",
+                                     "UPDATE image SET justification='right' WHERE node_id="})
+    {
+        ASSERT_TRUE(fs::remove(test_ctb_path));
+        ASSERT_TRUE(fs::copy_file(UT::testCtbDocPath, test_ctb_path));
+        ASSERT_EQ(SQLITE_OK, sqlite3_open(test_ctb_path.c_str(), &pDb));
+        f_exec(pDb, (sqlCmd + std::to_string(node_id_widgets)).c_str());
+        ASSERT_EQ(SQLITE_OK, sqlite3_close(pDb));
+        ASSERT_FALSE(CtStorageVerify::verify(test_ctb_path, nodes_digests, CtSaveVerify::FULL, error)) << sqlCmd;
+        ASSERT_TRUE(CtStorageVerify::verify(test_ctb_path, nodes_digests, CtSaveVerify::STRUCTURAL, error)) << sqlCmd;
+    }
+    ASSERT_TRUE(fs::remove(test_ctb_path));
+}
@@ -0,0 +1,109 @@
+/*
+ * tests_text_stats.cpp
+ *
+ * Copyright 2009-2024
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+#include "ct_text_stats.h"
+#include "tests_common.h"
+
+TEST(TextStatsGroup, incremental_counts)
+{
+    Glib::RefPtr<Gtk::TextBuffer> pTextBuffer = Gtk::TextBuffer::create();
+    pTextBuffer->set_text("one two\nthree");
+    CtTextStats* pTextStats = CtTextStats::get_for_buffer(pTextBuffer);
+    ASSERT_EQ(pTextStats, CtTextStats::get_for_buffer_if_attached(pTextBuffer));
+    ASSERT_EQ(3, pTextStats->get_words());
+    ASSERT_EQ(13, pTextStats->get_chars());
+    ASSERT_EQ(2, pTextStats->get_lines());
+    // insert within a paragraph
+    pTextBuffer->insert(pTextBuffer->get_iter_at_offset(3), " and a half");
+    ASSERT_EQ(6, pTextStats->get_words());
+    ASSERT_EQ(2, pTextStats->get_lines());
+    // insert splitting paragraphs
+    pTextBuffer->insert(pTextBuffer->get_iter_at_offset(3), "\nfour\n\nfive");
+    ASSERT_EQ(8, pTextStats->get_words());
+    ASSERT_EQ(5, pTextStats->get_lines());
+    // erase across paragraphs
+    pTextBuffer->erase(pTextBuffer->get_iter_at_line(1), pTextBuffer->get_iter_at_line(4));
+    ASSERT_EQ(2, pTextStats->get_words());
+    ASSERT_EQ(2, pTextStats->get_lines());
+    // the incremental counters match a full count of the same text
+    Glib::RefPtr<Gtk::TextBuffer> pTextBufferCheck = Gtk::TextBuffer::create();
+    pTextBufferCheck->set_text(pTextBuffer->get_text());
+    CtTextStats* pTextStatsCheck = CtTextStats::get_for_buffer(pTextBufferCheck);
+    ASSERT_EQ(pTextStatsCheck->get_words(), pTextStats->get_words());
+    ASSERT_EQ(pTextStatsCheck->get_chars(), pTextStats->get_chars());
+    ASSERT_EQ(pTextStatsCheck->get_chars(), pTextBuffer->get_char_count());
+    ASSERT_EQ(pTextStatsCheck->get_lines(), pTextStats->get_lines());
+    // empty buffer
+    pTextBuffer->set_text("");
+    ASSERT_EQ(0, pTextStats->get_words());
+    ASSERT_EQ(0, pTextStats->get_chars());
+    ASSERT_EQ(1, pTextStats->get_lines());
+}
+
+TEST(TextStatsGroup, anchors_counted_as_chars)
+{
+    Glib::RefPtr<Gtk::TextBuffer> pTextBuffer = Gtk::TextBuffer::create();
+    pTextBuffer->set_text("one two\nthree");
+    CtTextStats* pTextStats = CtTextStats::get_for_buffer(pTextBuffer);
+    ASSERT_EQ(13, pTextStats->get_chars());
+    (void)pTextBuffer->create_child_anchor(pTextBuffer->get_iter_at_offset(3));
+    (void)pTextBuffer->create_child_anchor(pTextBuffer->end());
+    ASSERT_EQ(15, pTextBuffer->get_char_count());
+    ASSERT_EQ(pTextBuffer->get_char_count(), pTextStats->get_chars());
+    ASSERT_EQ(2, pTextStats->get_lines());
+}
+
+TEST(TextStatsGroup, widgets_inserted_update_totals)
+{
+    Glib::RefPtr<Gtk::TextBuffer> pTextBuffer = Gtk::TextBuffer::create();
+    pTextBuffer->set_text("one two\nthree\nfour");
+    CtTextStats* pTextStats = CtTextStats::get_for_buffer(pTextBuffer);
+    ASSERT_EQ(4, pTextStats->get_words());
+    ASSERT_EQ(18, pTextStats->get_chars());
+    // the totals are up to date right after each widget, with no text edit in between
+    (void)pTextBuffer->create_child_anchor(pTextBuffer->get_iter_at_line(1));
+    ASSERT_EQ(19, pTextStats->get_chars());
+    pTextBuffer->insert_pixbuf(pTextBuffer->get_iter_at_offset(4), Gdk::Pixbuf::create(Gdk::COLORSPACE_RGB, false/*has_alpha*/, 8/*bits_per_sample*/, 4/*width*/, 4/*height*/));
+    ASSERT_EQ(20, pTextStats->get_chars());
+    ASSERT_EQ(pTextBuffer->get_char_count(), pTextStats->get_chars());
+    ASSERT_EQ(3, pTextStats->get_lines());
+    // the incremental counters match a full count of the same content
+    Glib::RefPtr<Gtk::TextBuffer> pTextBufferCheck = Gtk::TextBuffer::create();
+    pTextBufferCheck->set_text(pTextBuffer->get_slice(pTextBuffer->begin(), pTextBuffer->end()));
+    CtTextStats* pTextStatsCheck = CtTextStats::get_for_buffer(pTextBufferCheck);
+    ASSERT_EQ(pTextStatsCheck->get_words(), pTextStats->get_words());
+    ASSERT_EQ(pTextStatsCheck->get_chars(), pTextStats->get_chars());
+}
+
+TEST(TextStatsGroup, count_text_as_buffer)
+{
+    for (const char* text : {"", "one", "one two\nthree", "\n\nfour\n", "uno\r\ndue\rtre\nquattro", "йцу кен\nгш"}) {
+        Glib::RefPtr<Gtk::TextBuffer> pTextBuffer = Gtk::TextBuffer::create();
+        pTextBuffer->set_text(text);
+        CtTextStats* pTextStats = CtTextStats::get_for_buffer(pTextBuffer);
+        const CtTextTotals textTotals = CtTextStats::count_text(text);
+        ASSERT_EQ(pTextStats->get_words(), textTotals.words) << text;
+        ASSERT_EQ(pTextStats->get_chars(), textTotals.chars) << text;
+        ASSERT_EQ(pTextStats->get_lines(), textTotals.lines) << text;
+    }
+}
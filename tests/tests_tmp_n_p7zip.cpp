@@ -25,6 +25,9 @@
 #include "ct_p7za_iface.h"
 #include "config.h"
 #include "ct_filesystem.h"
+#include "ct_image.h"
+#include "ct_storage_sqlite.h"
+#include "ct_states_arena.h"
 #include "tests_common.h"
 
 #include <glib/gstdio.h>
@@ -59,6 +62,156 @@ TEST(TmpP7zipGroup, CTTmp_misc)
     ASSERT_FALSE(Glib::file_test(tempDirCtx, Glib::FILE_TEST_IS_DIR));
 }
 
+TEST(TmpP7zipGroup, EmbFileBlobSpill)
+{
+    const std::string smallBlob(1000u, 'a');
+    std::string largeBlob(CtEmbFileBlob::SpillThreshold + 1u, 'b');
+    largeBlob.back() = 'c';
+
+    std::shared_ptr<const CtEmbFileBlob> pSmall = CtEmbFileBlob::create(smallBlob);
+    ASSERT_FALSE(pSmall->is_spilled());
+    ASSERT_EQ(smallBlob.size(), pSmall->size());
+    ASSERT_EQ(smallBlob, pSmall->get_raw_blob());
+    ASSERT_EQ(Glib::Checksum::compute_checksum(Glib::Checksum::ChecksumType::CHECKSUM_SHA256, smallBlob), pSmall->get_sha256sum());
+
+    std::string spillFilepath;
+    {
+        std::shared_ptr<const CtEmbFileBlob> pLarge = CtEmbFileBlob::create(largeBlob);
+        ASSERT_TRUE(pLarge->is_spilled());
+        spillFilepath = pLarge->get_spill_filepath();
+        ASSERT_TRUE(Glib::file_test(spillFilepath, Glib::FILE_TEST_IS_REGULAR));
+        ASSERT_EQ(largeBlob.size(), pLarge->size());
+        ASSERT_EQ(largeBlob, pLarge->get_raw_blob());
+        ASSERT_EQ(Glib::Checksum::compute_checksum(Glib::Checksum::ChecksumType::CHECKSUM_SHA256, largeBlob), pLarge->get_sha256sum());
+
+        // a copy from file hashes the content in chunks and ends up with the same sha256sum
+        CtTmp ctTmp;
+        const std::string outFilepath = ctTmp.getHiddenFilePath("embfile.bin").string();
+        ASSERT_TRUE(pLarge->write_to_file(outFilepath));
+        std::shared_ptr<const CtEmbFileBlob> pFromFile = CtEmbFileBlob::create_from_file(outFilepath);
+        ASSERT_TRUE(pFromFile);
+        ASSERT_TRUE(pFromFile->is_spilled());
+        ASSERT_EQ(pLarge->get_sha256sum(), pFromFile->get_sha256sum());
+        ASSERT_EQ(largeBlob, pFromFile->get_raw_blob());
+
+        // a content addressed (multifile) blob is copied too, not sharing the inode with the storage
+        std::shared_ptr<const CtEmbFileBlob> pFromMultifile = CtEmbFileBlob::create_from_file(outFilepath, pLarge->get_sha256sum());
+        ASSERT_TRUE(pFromMultifile);
+        ASSERT_TRUE(pFromMultifile->is_spilled());
+        GStatBuf statBuf;
+        ASSERT_EQ(0, g_stat(outFilepath.c_str(), &statBuf));
+        ASSERT_EQ(1, statBuf.st_nlink);
+        ASSERT_EQ(largeBlob, pFromMultifile->get_raw_blob());
+    }
+    // the spill file goes with the last reference
+    ASSERT_FALSE(Glib::file_test(spillFilepath, Glib::FILE_TEST_EXISTS));
+
+    ASSERT_FALSE(CtEmbFileBlob::create_from_file(Glib::build_filename(Glib::get_tmp_dir(), "not_existing_embfile.bin")));
+}
+
+TEST(TmpP7zipGroup, EmbFileBlobSqliteRow)
+{
+    const std::string smallBlob(1000u, 'a');
+    std::string largeBlob(CtEmbFileBlob::SpillThreshold + 1u, 'b');
+    largeBlob.back() = 'c';
+
+    sqlite3* pDb{nullptr};
+    ASSERT_EQ(SQLITE_OK, sqlite3_open(":memory:", &pDb));
+    std::shared_ptr<CtEmbFileSqliteRows> pRows = std::make_shared<CtEmbFileSqliteRows>();
+    pRows->set_db(pDb, true/*ownDb*/);
+    ASSERT_EQ(SQLITE_OK, sqlite3_exec(pDb, CtStorageSqlite::TABLE_IMAGE_CREATE, nullptr, nullptr, nullptr));
+    auto f_insert_row = [pDb](const std::string& rawBlob, const int charOffset) {
+        Sqlite3StmtAuto stmt{pDb, CtStorageSqlite::TABLE_IMAGE_INSERT};
+        sqlite3_bind_int64(stmt, 1, 1/*node_id*/);
+        sqlite3_bind_int64(stmt, 2, charOffset);
+        sqlite3_bind_text(stmt, 3, "left", -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 4, "", -1, SQLITE_STATIC);
+        sqlite3_bind_blob(stmt, 5, rawBlob.c_str(), rawBlob.size(), SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 6, "file.bin", -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 7, "", -1, SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 8, 0);
+        EXPECT_EQ(SQLITE_DONE, sqlite3_step(stmt));
+        return sqlite3_last_insert_rowid(pDb);
+    };
+    const sqlite3_int64 smallRowId = f_insert_row(smallBlob, 3);
+    const sqlite3_int64 largeRowId = f_insert_row(largeBlob, 7);
+
+    // the content stays in the row, read in chunks also for the sha256sum
+    std::shared_ptr<const CtEmbFileBlob> pSmall = pRows->create_blob(1, smallRowId, smallBlob.size());
+    std::shared_ptr<const CtEmbFileBlob> pLarge = pRows->create_blob(1, largeRowId, largeBlob.size());
+    ASSERT_TRUE(pLarge->is_in_sqlite_row());
+    ASSERT_FALSE(pLarge->is_spilled());
+    ASSERT_EQ(largeBlob.size(), pLarge->size());
+    ASSERT_EQ(Glib::Checksum::compute_checksum(Glib::Checksum::ChecksumType::CHECKSUM_SHA256, largeBlob), pLarge->get_sha256sum());
+    ASSERT_EQ(largeBlob, pLarge->get_raw_blob());
+    ASSERT_TRUE(pLarge->has_same_content(*pRows->create_blob(1, largeRowId, largeBlob.size())));
+    ASSERT_FALSE(pLarge->has_same_content(*pSmall));
+
+    // the rows are found again after the rowids are renumbered
+    ASSERT_TRUE(pRows->remap_rowids([pDb](){
+        return SQLITE_OK == sqlite3_exec(pDb, "UPDATE image SET rowid=rowid+100", nullptr, nullptr, nullptr);
+    }));
+    ASSERT_EQ(smallBlob, pSmall->get_raw_blob());
+    ASSERT_EQ(largeBlob, pLarge->get_raw_blob());
+
+    // the content still in use leaves the rows before they are deleted
+    pRows->detach_row(smallRowId + 100);
+    pRows->detach_node(1);
+    ASSERT_EQ(SQLITE_OK, sqlite3_exec(pDb, "DELETE FROM image", nullptr, nullptr, nullptr));
+    ASSERT_FALSE(pSmall->is_in_sqlite_row());
+    ASSERT_FALSE(pSmall->is_spilled());
+    ASSERT_EQ(smallBlob, pSmall->get_raw_blob());
+    ASSERT_FALSE(pLarge->is_in_sqlite_row());
+    ASSERT_TRUE(pLarge->is_spilled());
+    ASSERT_EQ(largeBlob, pLarge->get_raw_blob());
+    ASSERT_FALSE(pRows->has_blobs());
+}
+
+TEST(TmpP7zipGroup, StatesArena)
+{
+    CtTmp ctTmp;
+    const fs::path arenaFilepath = ctTmp.getHiddenDirPath("undo_states") / "states_test";
+    std::vector<std::string> states;
+    std::vector<gint64> slotIds;
+    {
+        CtStatesArena statesArena{arenaFilepath};
+        for (size_t i = 0; i < 20; ++i) {
+            std::string state{"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<buffer>"};
+            for (size_t j = 0; j <= i*100; ++j) {
+                state += "<rich_text weight=\"heavy\">line " + std::to_string(j) + "</rich_text>";
+            }
+            state += "</buffer>";
+            states.push_back(state);
+            slotIds.push_back(statesArena.put(state));
+            ASSERT_GE(slotIds.back(), 0);
+        }
+        ASSERT_TRUE(Glib::file_test(arenaFilepath.string(), Glib::FILE_TEST_IS_REGULAR));
+        size_t totRawBytes{0};
+        for (const auto& state : states) totRawBytes += state.size();
+        ASSERT_LT(statesArena.get_file_bytes(), static_cast<gint64>(totRawBytes/4u));
+
+        // released slots leave the others readable
+        for (size_t i = 0; i < slotIds.size(); i += 2) {
+            statesArena.release(slotIds[i]);
+        }
+        ASSERT_EQ(slotIds.size()/2u, statesArena.get_num_slots());
+        for (size_t i = 1; i < slotIds.size(); i += 2) {
+            std::string state;
+            ASSERT_TRUE(statesArena.get(slotIds[i], state));
+            ASSERT_EQ(states[i], state);
+        }
+        std::string state;
+        ASSERT_FALSE(statesArena.get(slotIds[0], state));
+    }
+    // the file goes with the arena
+    ASSERT_FALSE(Glib::file_test(arenaFilepath.string(), Glib::FILE_TEST_EXISTS));
+
+    std::string compressed, decompressed;
+    ASSERT_TRUE(CtStatesArena::compress(states.back(), compressed));
+    ASSERT_TRUE(CtStatesArena::decompress(compressed, states.back().size(), decompressed));
+    ASSERT_EQ(states.back(), decompressed);
+}
+
 TEST(TmpP7zipGroup, P7zaIfaceMisc)
 {
     // extract our test archive
@@ -0,0 +1,110 @@
+/*
+ * tests_trace.cpp
+ *
+ * Copyright 2009-2024
+ * Giuseppe Penone <giuspen@gmail.com>
+ * Evgenii Gurianov <https://github.com/txe>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ */
+
+
+#include "ct_trace.h"
+#include "tests_common.h"
+#include <glibmm/fileutils.h>
+#include <set>
+#include <thread>
+
+TEST(TraceGroup, disabled_records_nothing)
+{
+    CtTrace::set_enabled(false);
+    const size_t numSummariesBefore = CtTrace::get_summaries().size();
+    {
+        CtTraceOperation traceOperation{"disabled_op"};
+        CtTraceSpan traceSpan{"disabled_span"};
+        CtTrace::counter_add(CtTraceCounter::NodesSerialized, 5);
+    }
+    ASSERT_EQ(numSummariesBefore, CtTrace::get_summaries().size());
+}
+
+TEST(TraceGroup, operation_summary_n_chrome_json)
+{
+    CtTrace::set_enabled(true);
+    {
+        CtTraceOperation traceOperation{"test_op"};
+        {
+            CtTraceSpan traceSpan{"test_inner_span"};
+            CtTrace::counter_add(CtTraceCounter::NodesSerialized, 3);
+        }
+        // a span in another thread goes to its own buffer
+        std::thread worker{[](){
+            CtTraceSpan traceSpan{"test_worker_span"};
+        }};
+        worker.join();
+    }
+    CtTrace::set_enabled(false);
+
+    const std::string summary = CtTrace::get_last_summary();
+    ASSERT_EQ(0u, summary.find("test_op "));
+    ASSERT_NE(std::string::npos, summary.find("nodes serialized 3"));
+    ASSERT_NE(std::string::npos, summary.find("test_inner_span"));
+    ASSERT_EQ(std::string::npos, summary.find("test_worker_span"));
+
+    gchar* pTmpDir = g_dir_make_tmp("ct_trace_XXXXXX", nullptr);
+    ASSERT_TRUE(pTmpDir);
+    const fs::path tmpDirpath{pTmpDir};
+    g_free(pTmpDir);
+    const fs::path jsonFilepath = tmpDirpath / "trace.json";
+    ASSERT_TRUE(CtTrace::write_chrome_json(jsonFilepath));
+    const std::string json = Glib::file_get_contents(jsonFilepath.string());
+    ASSERT_EQ(0u, json.find("{\"displayTimeUnit\": \"ms\", \"traceEvents\": ["));
+    ASSERT_NE(std::string::npos, json.find("\"name\": \"test_inner_span\", \"ph\": \"X\""));
+    ASSERT_NE(std::string::npos, json.find("\"name\": \"test_worker_span\", \"ph\": \"X\""));
+    ASSERT_NE(std::string::npos, json.find("\"nodes serialized\": 3"));
+    ASSERT_LT(0u, fs::remove_all(tmpDirpath));
+}
+
+TEST(TraceGroup, exited_threads_buffers_reused)
+{
+    CtTrace::set_enabled(true);
+    for (int i = 0; i < 20; ++i) {
+        // one thread at a time, each takes over the buffer of the previous one
+        std::thread worker{[](){
+            CtTraceSpan traceSpan{"test_sequential_span"};
+        }};
+        worker.join();
+    }
+    CtTrace::set_enabled(false);
+
+    gchar* pTmpDir = g_dir_make_tmp("ct_trace_XXXXXX", nullptr);
+    ASSERT_TRUE(pTmpDir);
+    const fs::path tmpDirpath{pTmpDir};
+    g_free(pTmpDir);
+    const fs::path jsonFilepath = tmpDirpath / "trace.json";
+    ASSERT_TRUE(CtTrace::write_chrome_json(jsonFilepath));
+    const std::string json = Glib::file_get_contents(jsonFilepath.string());
+    std::set<std::string> tids;
+    const std::string spanPrefix{"\"name\": \"test_sequential_span\", \"ph\": \"X\", \"pid\": 1, \"tid\": "};
+    size_t numSpans{0};
+    for (size_t pos = json.find(spanPrefix); std::string::npos != pos; pos = json.find(spanPrefix, pos + 1)) {
+        const size_t tidStart = pos + spanPrefix.size();
+        tids.insert(json.substr(tidStart, json.find(',', tidStart) - tidStart));
+        ++numSpans;
+    }
+    ASSERT_EQ(20u, numSpans);
+    ASSERT_EQ(1u, tids.size());
+    ASSERT_LT(0u, fs::remove_all(tmpDirpath));
+}